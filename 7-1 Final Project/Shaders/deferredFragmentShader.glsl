@@ -0,0 +1,99 @@
+#version 440 core
+
+// fragment shader for the lighting pass of the deferred path - reads the
+// surface of every pixel from the G-buffer and lights it once, with the
+// same lights, shadows, probes and lighting as the scene fragment shader.
+// Surfaces that the shader does not light only add their stored light.
+out vec4 outFragmentColor;
+
+#define MATERIAL_FROM_TABLE
+#include "lighting.glsl"
+
+// one material of the scene, with the layout of DEFERRED_MATERIAL
+struct DeferredMaterial
+{
+	// ambient color times the ambient strength
+	vec4 ambientColor;
+	vec4 diffuseColor;
+	// specular color and shininess
+	vec4 specularShininess;
+};
+
+layout (std430, binding = 3) readonly buffer DeferredMaterials
+{
+	DeferredMaterial deferredMaterials[];
+};
+
+// the G-buffer written by the geometry pass
+layout (binding = 9) uniform sampler2D gBufferDepth;
+// albedo, and one when the surface is lit by this pass
+layout (binding = 10) uniform sampler2D gBufferAlbedo;
+// world normal and material index
+layout (binding = 11) uniform sampler2D gBufferNormal;
+// light of unlit and lightmapped surfaces
+layout (binding = 12) uniform sampler2D gBufferEmission;
+
+uniform mat4 inverseViewProjection;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gBufferDepth, pixel, 0).r;
+	// the background keeps the clear color and depth
+	if (depth >= 1.0f)
+	{
+		discard;
+	}
+	gl_FragDepth = depth;
+
+	vec4 albedo = texelFetch(gBufferAlbedo, pixel, 0);
+	vec3 emission = texelFetch(gBufferEmission, pixel, 0).rgb;
+	if (albedo.a < 0.5f)
+	{
+		outFragmentColor = vec4(emission, 1.0f);
+		return;
+	}
+
+	vec4 normalMaterial = texelFetch(gBufferNormal, pixel, 0);
+	vec3 normal = normalize(normalMaterial.xyz);
+	DeferredMaterial stored = deferredMaterials[int(normalMaterial.w + 0.5f)];
+	material.ambientColor = stored.ambientColor.rgb;
+	material.ambientStrength = 1.0f;
+	material.diffuseColor = stored.diffuseColor.rgb;
+	material.specularColor = stored.specularShininess.rgb;
+	material.shininess = stored.specularShininess.w;
+
+	// the world position of the pixel from its depth
+	vec2 screenPosition = (vec2(pixel) + 0.5f) / vec2(textureSize(gBufferDepth, 0));
+	vec4 worldPoint = inverseViewProjection * vec4(vec3(screenPosition, depth) * 2.0f - 1.0f, 1.0f);
+	vec3 fragmentPosition = worldPoint.xyz / worldPoint.w;
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+
+	vec3 lighting = vec3(0.0f);
+	if (directionalLight.bActive)
+	{
+		// the shadows only hold back the diffuse and specular light
+		vec3 lightDirection = normalize(-directionalLight.direction);
+		lighting += CalculateAmbientLight(fragmentPosition, normal);
+		lighting += CalculateEnvironmentSpecular(normal, viewDirection);
+		lighting += CalculateShadow(fragmentPosition, normal, lightDirection) * CalculateLight(
+			lightDirection,
+			vec3(0.0f),
+			directionalLight.diffuse,
+			directionalLight.specular,
+			normal,
+			viewDirection);
+	}
+
+	uvec2 range = clusterRanges[FindCluster(fragmentPosition)];
+	for (uint i = 0u; i < range.y; i++)
+	{
+		lighting += CalculateClusterLight(
+			clusterLights[clusterLightIndices[range.x + i]],
+			fragmentPosition,
+			normal,
+			viewDirection);
+	}
+
+	outFragmentColor = vec4(lighting * albedo.rgb + emission, 1.0f);
+}
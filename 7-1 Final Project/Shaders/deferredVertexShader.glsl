@@ -0,0 +1,10 @@
+#version 440 core
+
+// vertex shader for the lighting pass of the deferred path - builds one
+// triangle that covers the whole screen from the vertex index, so no
+// vertex buffer is needed
+void main()
+{
+	vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+	gl_Position = vec4(corner * 2.0f - 1.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,173 @@
+#version 440 core
+
+// fragment shader for the scene - lights the objects with the material
+// of the object, the shadowed directional light, and the point and spot
+// lights of the light cluster that the fragment lies in.  The clusters
+// and their light lists are built by ClusteredLights in Source, so only
+// the few lights that reach a fragment are looped over.  The ambient
+// light comes from the baked irradiance probes, dimmed by the baked
+// ambient occlusion, and objects with baked lighting read all of it from
+// the lightmap instead.  The reflections come from the prefiltered
+// environment.
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+
+layout (location = 0) out vec4 outFragmentColor;
+// the other G-buffer targets, only written in the geometry pass - the
+// normal target also takes the revealage of the transparency pass
+layout (location = 1) out vec4 outNormal;
+layout (location = 2) out vec4 outEmission;
+
+#include "lighting.glsl"
+
+// lights whose range touches the bounds of the object, found on the
+// CPU for each draw, or a negative count to use the cluster lists
+const int MAX_OBJECT_LIGHTS = 8;
+uniform int objectLightCount = -1;
+uniform int objectLights[MAX_OBJECT_LIGHTS];
+
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// true while the depth of the objects is drawn into the shadow maps
+uniform bool bDepthOnly = false;
+
+// true while the opaque objects are drawn into the G-buffer, where
+// the lit surfaces keep their albedo, normal and material for the
+// lighting pass instead of being lit here
+uniform bool bGeometryPass = false;
+// index of the material in the table of the lighting pass
+uniform int materialIndex = 0;
+
+// true while the transparent objects are accumulated for the weighted
+// blended transparency, which needs no sorting of the objects
+uniform bool bTransparencyPass = false;
+// true while the opaque objects are drawn forward without blending, so
+// the see-through texels are cut out like in the geometry pass
+uniform bool bAlphaCutout = false;
+
+// baked lighting of the static objects, read from the rectangle of
+// the object in the atlas instead of evaluating the lights
+layout (binding = 14) uniform sampler2D lightmap;
+uniform bool bUseLightmap = false;
+// offset and scale from the object UVs to the atlas
+uniform vec4 lightmapRect;
+
+// fill the G-buffer targets, the alpha of the albedo marks the
+// surfaces that the lighting pass lights
+void WriteGeometry(vec3 albedo, vec3 normal, vec3 emission, bool bLit)
+{
+	outFragmentColor = vec4(albedo, bLit ? 1.0f : 0.0f);
+	outNormal = vec4(normal, float(materialIndex));
+	outEmission = vec4(emission, 1.0f);
+}
+
+// write the color of the fragment, or in the transparency pass its
+// premultiplied color weighted by its alpha and depth, and its coverage
+// into the revealage target, which blends to the product of what every
+// layer lets through
+void WriteColor(vec4 color)
+{
+	if (bTransparencyPass)
+	{
+		float weight = color.a * clamp(3.0e3f * pow(1.0f - gl_FragCoord.z, 3.0f), 1.0e-2f, 3.0e3f);
+		outFragmentColor = vec4(color.rgb * color.a, color.a) * weight;
+		outNormal = vec4(color.a);
+		return;
+	}
+	outFragmentColor = color;
+}
+
+void main()
+{
+	// only the depth is kept in the shadow passes
+	if (bDepthOnly)
+	{
+		return;
+	}
+
+	vec4 baseColor = bUseTexture ? texture(objectTexture, fragmentTextureCoordinate * UVscale) : objectColor;
+	// the G-buffer and the opaque pass do not blend, so see-through
+	// texels of the decals are cut out
+	if ((bGeometryPass || bAlphaCutout) && (baseColor.a < 0.5f))
+	{
+		discard;
+	}
+	if (bUseLighting == false)
+	{
+		if (bGeometryPass)
+		{
+			WriteGeometry(baseColor.rgb, normalize(fragmentVertexNormal), baseColor.rgb, false);
+			return;
+		}
+		WriteColor(baseColor);
+		return;
+	}
+
+	// the baked lighting holds the shadows and the bounced light,
+	// but no specular light
+	if (bUseLightmap)
+	{
+		vec3 bakedLighting = texture(lightmap, lightmapRect.xy + fragmentTextureCoordinate * lightmapRect.zw).rgb;
+		if (bGeometryPass)
+		{
+			WriteGeometry(baseColor.rgb, normalize(fragmentVertexNormal), bakedLighting * baseColor.rgb, false);
+			return;
+		}
+		WriteColor(vec4(bakedLighting * baseColor.rgb, baseColor.a));
+		return;
+	}
+
+	vec3 normal = normalize(fragmentVertexNormal);
+	if (bGeometryPass)
+	{
+		WriteGeometry(baseColor.rgb, normal, vec3(0.0f), true);
+		return;
+	}
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+
+	vec3 lighting = vec3(0.0f);
+	if (directionalLight.bActive)
+	{
+		// the shadows only hold back the diffuse and specular light
+		vec3 lightDirection = normalize(-directionalLight.direction);
+		lighting += CalculateAmbientLight(fragmentPosition, normal);
+		lighting += CalculateEnvironmentSpecular(normal, viewDirection);
+		lighting += CalculateShadow(fragmentPosition, normal, lightDirection) * CalculateLight(
+			lightDirection,
+			vec3(0.0f),
+			directionalLight.diffuse,
+			directionalLight.specular,
+			normal,
+			viewDirection);
+	}
+
+	if (objectLightCount >= 0)
+	{
+		for (int i = 0; i < objectLightCount; i++)
+		{
+			lighting += CalculateClusterLight(
+				clusterLights[objectLights[i]],
+				fragmentPosition,
+				normal,
+				viewDirection);
+		}
+	}
+	else
+	{
+		uvec2 range = clusterRanges[FindCluster(fragmentPosition)];
+		for (uint i = 0u; i < range.y; i++)
+		{
+			lighting += CalculateClusterLight(
+				clusterLights[clusterLightIndices[range.x + i]],
+				fragmentPosition,
+				normal,
+				viewDirection);
+		}
+	}
+
+	WriteColor(vec4(lighting * baseColor.rgb, baseColor.a));
+}
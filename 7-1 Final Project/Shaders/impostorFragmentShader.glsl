@@ -0,0 +1,420 @@
+#version 440 core
+
+// fragment shader for the ray cast impostors - intersects the ray through
+// the pixel with the exact shape, writes its depth and lights it with the
+// same object, material and light values as the scene fragment shader
+in vec3 objectPosition;
+flat in vec3 objectCamera;
+flat in vec3 objectViewDirection;
+flat in mat3 normalMatrix;
+
+layout (location = 0) out vec4 outFragmentColor;
+// the other G-buffer targets, only written in the geometry pass - the
+// normal target also takes the revealage of the transparency pass
+layout (location = 1) out vec4 outNormal;
+layout (location = 2) out vec4 outEmission;
+
+#include "lighting.glsl"
+
+// values of the IMPOSTOR_SHAPE enum
+const int IMPOSTOR_SHAPE_CONE = 0;
+const int IMPOSTOR_SHAPE_TORUS = 1;
+const int IMPOSTOR_SHAPE_SPHERE = 2;
+
+const float NO_HIT = 1.0e20f;
+
+// lights whose range touches the bounds of the object, found on the
+// CPU for each draw, or a negative count to use the cluster lists
+const int MAX_OBJECT_LIGHTS = 8;
+uniform int objectLightCount = -1;
+uniform int objectLights[MAX_OBJECT_LIGHTS];
+
+uniform int impostorShape = IMPOSTOR_SHAPE_CONE;
+// cone: bottom and top radius, torus: main and tube radius
+uniform vec2 shapeRadii = vec2(1.0f);
+
+uniform mat4 model;
+uniform mat4 projection;
+
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform bool bUseTexture = false;
+uniform bool bUseLighting = false;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+
+// true while the opaque objects are drawn into the G-buffer, where
+// the lit surfaces keep their albedo, normal and material for the
+// lighting pass instead of being lit here
+uniform bool bGeometryPass = false;
+// index of the material in the table of the lighting pass
+uniform int materialIndex = 0;
+
+// true while the transparent objects are accumulated for the weighted
+// blended transparency, which needs no sorting of the objects
+uniform bool bTransparencyPass = false;
+// true while the opaque objects are drawn forward without blending, so
+// the see-through texels are cut out like in the geometry pass
+uniform bool bAlphaCutout = false;
+
+// angle around an axis as a 0 to 1 texture coordinate
+float AngleToU(float y, float x)
+{
+	float u = atan(y, x) / (2.0f * PI);
+	return (u < 0.0f) ? u + 1.0f : u;
+}
+
+// cone standing on the XZ plane from y = 0 to y = 1, whose radius goes
+// from shapeRadii.x to shapeRadii.y - a cylinder when they are equal
+float IntersectCone(vec3 ro, vec3 rd, out vec3 normal, out vec2 uv)
+{
+	float bottomRadius = shapeRadii.x;
+	float slope = shapeRadii.y - shapeRadii.x;
+	float closest = NO_HIT;
+
+	// side: x*x + z*z = r(y)*r(y), with r(y) = bottomRadius + slope * y
+	float originRadius = bottomRadius + slope * ro.y;
+	float a = rd.x * rd.x + rd.z * rd.z - slope * slope * rd.y * rd.y;
+	float b = ro.x * rd.x + ro.z * rd.z - originRadius * slope * rd.y;
+	float c = ro.x * ro.x + ro.z * ro.z - originRadius * originRadius;
+	float h = b * b - a * c;
+	if ((h >= 0.0f) && (abs(a) > 1.0e-8f))
+	{
+		h = sqrt(h);
+		for (int i = 0; i < 2; i++)
+		{
+			float t = (-b + ((i == 0) ? -h : h)) / a;
+			vec3 p = ro + t * rd;
+			float radius = bottomRadius + slope * p.y;
+			if ((t > 0.0f) && (t < closest) && (p.y >= 0.0f) && (p.y <= 1.0f) && (radius >= 0.0f))
+			{
+				closest = t;
+				normal = normalize(vec3(p.x, -radius * slope, p.z));
+				uv = vec2(AngleToU(p.x, p.z), p.y);
+			}
+		}
+	}
+
+	// bottom and top caps
+	if (abs(rd.y) > 1.0e-8f)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			float capY = float(i);
+			float radius = bottomRadius + slope * capY;
+			float t = (capY - ro.y) / rd.y;
+			vec3 p = ro + t * rd;
+			if ((t > 0.0f) && (t < closest) && (dot(p.xz, p.xz) <= radius * radius))
+			{
+				closest = t;
+				normal = vec3(0.0f, (i == 0) ? -1.0f : 1.0f, 0.0f);
+				uv = vec2(0.5f) + 0.5f * p.xz / radius;
+			}
+		}
+	}
+
+	return closest;
+}
+
+// torus around the Z axis with main radius shapeRadii.x and tube radius
+// shapeRadii.y - the quartic is solved in closed form, then refined
+float IntersectTorus(vec3 ro, vec3 rd, out vec3 normal, out vec2 uv)
+{
+	float mainRadius = shapeRadii.x;
+	float tubeRadius = shapeRadii.y;
+	float outerRadius = mainRadius + tubeRadius;
+
+	// start the ray just before the bounding sphere, which keeps the
+	// quartic coefficients small enough for single precision
+	float n = dot(ro, rd);
+	float h = n * n - dot(ro, ro) + outerRadius * outerRadius;
+	if (h < 0.0f)
+	{
+		return NO_HIT;
+	}
+	float start = max(0.0f, -n - sqrt(h) - tubeRadius);
+	ro += start * rd;
+
+	float po = 1.0f;
+	float Ra2 = mainRadius * mainRadius;
+	float ra2 = tubeRadius * tubeRadius;
+	float m = dot(ro, ro);
+	n = dot(ro, rd);
+	float k = (m - ra2 - Ra2) / 2.0f;
+	float k3 = n;
+	float k2 = n * n + Ra2 * rd.z * rd.z + k;
+	float k1 = k * n + Ra2 * ro.z * rd.z;
+	float k0 = k * k + Ra2 * ro.z * ro.z - Ra2 * ra2;
+
+	// solve for 1/t instead when the cubic term nearly vanishes
+	if (abs(k3 * (k3 * k3 - k2) + k1) < 0.01f)
+	{
+		po = -1.0f;
+		float swap = k1;
+		k1 = k3;
+		k3 = swap;
+		k0 = 1.0f / k0;
+		k1 = k1 * k0;
+		k2 = k2 * k0;
+		k3 = k3 * k0;
+	}
+
+	float c2 = (2.0f * k2 - 3.0f * k3 * k3) / 3.0f;
+	float c1 = 2.0f * (k3 * (k3 * k3 - k2) + k1);
+	float c0 = (k3 * (k3 * (-3.0f * k3 * k3 + 4.0f * k2) - 8.0f * k1) + 4.0f * k0) / 3.0f;
+	float Q = c2 * c2 + c0;
+	float R = 3.0f * c0 * c2 - c2 * c2 * c2 - c1 * c1;
+	h = R * R - Q * Q * Q;
+
+	// one real root of the resolvent cubic
+	float z;
+	if (h < 0.0f)
+	{
+		float sQ = sqrt(Q);
+		z = 2.0f * sQ * cos(acos(R / (sQ * Q)) / 3.0f);
+	}
+	else
+	{
+		float sQ = pow(sqrt(h) + abs(R), 1.0f / 3.0f);
+		z = sign(R) * abs(sQ + Q / sQ);
+	}
+	z = c2 - z;
+
+	float d1 = z - 3.0f * c2;
+	float d2 = z * z - 3.0f * c0;
+	if (abs(d1) < 1.0e-4f)
+	{
+		if (d2 < 0.0f)
+		{
+			return NO_HIT;
+		}
+		d2 = sqrt(d2);
+	}
+	else
+	{
+		if (d1 < 0.0f)
+		{
+			return NO_HIT;
+		}
+		d1 = sqrt(d1 / 2.0f);
+		d2 = c1 / d1;
+	}
+
+	// the two quadratic factors of the quartic
+	float t = NO_HIT;
+	for (int i = 0; i < 2; i++)
+	{
+		float side = (i == 0) ? -1.0f : 1.0f;
+		h = d1 * d1 - z - side * d2;
+		if (h > 0.0f)
+		{
+			h = sqrt(h);
+			float t1 = side * d1 - h - k3;
+			float t2 = side * d1 + h - k3;
+			t1 = (po < 0.0f) ? 2.0f / t1 : t1;
+			t2 = (po < 0.0f) ? 2.0f / t2 : t2;
+			t = (t1 > 0.0f) ? min(t, t1) : t;
+			t = (t2 > 0.0f) ? min(t, t2) : t;
+		}
+	}
+	if (t >= NO_HIT)
+	{
+		return NO_HIT;
+	}
+
+	// Newton steps on the implicit surface remove the float error
+	for (int i = 0; i < 2; i++)
+	{
+		vec3 p = ro + t * rd;
+		float ring = max(length(p.xy), 1.0e-6f);
+		vec3 gradient = vec3(p.xy * (1.0f - mainRadius / ring), p.z);
+		float value = (ring - mainRadius) * (ring - mainRadius) + p.z * p.z - ra2;
+		float derivative = 2.0f * dot(gradient, rd);
+		if (abs(derivative) > 1.0e-6f)
+		{
+			t -= value / derivative;
+		}
+	}
+
+	vec3 p = ro + t * rd;
+	float ring = max(length(p.xy), 1.0e-6f);
+	normal = normalize(vec3(p.xy * (1.0f - mainRadius / ring), p.z));
+	uv = vec2(AngleToU(p.y, p.x), AngleToU(p.z, ring - mainRadius));
+
+	return start + t;
+}
+
+// sphere with a radius of one at the origin
+float IntersectSphere(vec3 ro, vec3 rd, out vec3 normal, out vec2 uv)
+{
+	float b = dot(ro, rd);
+	float h = b * b - dot(ro, ro) + 1.0f;
+	if (h < 0.0f)
+	{
+		return NO_HIT;
+	}
+	h = sqrt(h);
+	float t = (-b - h > 0.0f) ? -b - h : -b + h;
+	if (t <= 0.0f)
+	{
+		return NO_HIT;
+	}
+
+	vec3 p = ro + t * rd;
+	normal = normalize(p);
+	uv = vec2(AngleToU(p.x, p.z), 0.5f + asin(clamp(normal.y, -1.0f, 1.0f)) / PI);
+	return t;
+}
+
+// sample the object texture - the U seam of the curved shapes jumps from
+// one to zero, so the derivatives are also taken from a copy with the
+// seam on the opposite side and the smaller ones are used
+vec4 SampleObjectTexture(vec2 uv)
+{
+	vec2 seamUV = vec2(fract(uv.x + 0.5f), uv.y);
+	vec2 dx = dFdx(uv);
+	vec2 dy = dFdy(uv);
+	vec2 seamDx = dFdx(seamUV);
+	vec2 seamDy = dFdy(seamUV);
+	dx.x = (abs(seamDx.x) < abs(dx.x)) ? seamDx.x : dx.x;
+	dy.x = (abs(seamDy.x) < abs(dy.x)) ? seamDy.x : dy.x;
+
+	return textureGrad(objectTexture, uv * UVscale, dx * UVscale, dy * UVscale);
+}
+
+// fill the G-buffer targets, the alpha of the albedo marks the
+// surfaces that the lighting pass lights
+void WriteGeometry(vec3 albedo, vec3 normal, vec3 emission, bool bLit)
+{
+	outFragmentColor = vec4(albedo, bLit ? 1.0f : 0.0f);
+	outNormal = vec4(normal, float(materialIndex));
+	outEmission = vec4(emission, 1.0f);
+}
+
+// write the color of the fragment, or in the transparency pass its
+// premultiplied color weighted by its alpha and the depth of the hit,
+// and its coverage into the revealage target, which blends to the
+// product of what every layer lets through
+void WriteColor(vec4 color)
+{
+	if (bTransparencyPass)
+	{
+		float weight = color.a * clamp(3.0e3f * pow(1.0f - gl_FragDepth, 3.0f), 1.0e-2f, 3.0e3f);
+		outFragmentColor = vec4(color.rgb * color.a, color.a) * weight;
+		outNormal = vec4(color.a);
+		return;
+	}
+	outFragmentColor = color;
+}
+
+void main()
+{
+	// the ray through this pixel in object space
+	vec3 ro;
+	vec3 rd;
+	if (projection[2][3] == 0.0f)
+	{
+		rd = normalize(objectViewDirection);
+		ro = objectPosition - rd * dot(objectPosition - objectCamera, rd);
+	}
+	else
+	{
+		ro = objectCamera;
+		rd = normalize(objectPosition - objectCamera);
+	}
+
+	vec3 normal = vec3(0.0f, 1.0f, 0.0f);
+	vec2 uv = vec2(0.0f);
+	float t = NO_HIT;
+	if (impostorShape == IMPOSTOR_SHAPE_TORUS)
+	{
+		t = IntersectTorus(ro, rd, normal, uv);
+	}
+	else if (impostorShape == IMPOSTOR_SHAPE_SPHERE)
+	{
+		t = IntersectSphere(ro, rd, normal, uv);
+	}
+	else
+	{
+		t = IntersectCone(ro, rd, normal, uv);
+	}
+	if (t >= NO_HIT)
+	{
+		discard;
+	}
+
+	// depth of the hit, instead of the depth of the bounding box
+	vec3 hit = ro + t * rd;
+	vec4 clipPosition = projection * view * model * vec4(hit, 1.0f);
+	float ndcDepth = clipPosition.z / clipPosition.w;
+	if (ndcDepth < -1.0f)
+	{
+		discard;
+	}
+	gl_FragDepth = 0.5f * (gl_DepthRange.diff * ndcDepth + gl_DepthRange.near + gl_DepthRange.far);
+
+	vec4 baseColor = bUseTexture ? SampleObjectTexture(uv) : objectColor;
+	if ((bGeometryPass || bAlphaCutout) && (baseColor.a < 0.5f))
+	{
+		discard;
+	}
+	vec3 worldNormal = normalize(normalMatrix * normal);
+	if (bUseLighting == false)
+	{
+		if (bGeometryPass)
+		{
+			WriteGeometry(baseColor.rgb, worldNormal, baseColor.rgb, false);
+			return;
+		}
+		WriteColor(baseColor);
+		return;
+	}
+	if (bGeometryPass)
+	{
+		WriteGeometry(baseColor.rgb, worldNormal, vec3(0.0f), true);
+		return;
+	}
+
+	vec3 worldPosition = vec3(model * vec4(hit, 1.0f));
+	vec3 viewDirection = normalize(viewPosition - worldPosition);
+
+	vec3 lighting = vec3(0.0f);
+	if (directionalLight.bActive)
+	{
+		// the shadows only hold back the diffuse and specular light
+		vec3 lightDirection = normalize(-directionalLight.direction);
+		lighting += CalculateAmbientLight(worldPosition, worldNormal);
+		lighting += CalculateEnvironmentSpecular(worldNormal, viewDirection);
+		lighting += CalculateShadow(worldPosition, worldNormal, lightDirection) * CalculateLight(
+			lightDirection,
+			vec3(0.0f),
+			directionalLight.diffuse,
+			directionalLight.specular,
+			worldNormal,
+			viewDirection);
+	}
+	if (objectLightCount >= 0)
+	{
+		for (int i = 0; i < objectLightCount; i++)
+		{
+			lighting += CalculateClusterLight(
+				clusterLights[objectLights[i]],
+				worldPosition,
+				worldNormal,
+				viewDirection);
+		}
+	}
+	else
+	{
+		uvec2 range = clusterRanges[FindCluster(worldPosition)];
+		for (uint i = 0u; i < range.y; i++)
+		{
+			lighting += CalculateClusterLight(
+				clusterLights[clusterLightIndices[range.x + i]],
+				worldPosition,
+				worldNormal,
+				viewDirection);
+		}
+	}
+
+	WriteColor(vec4(lighting * baseColor.rgb, baseColor.a));
+}
\ No newline at end of file
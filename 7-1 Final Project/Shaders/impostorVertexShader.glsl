@@ -0,0 +1,33 @@
+#version 440 core
+
+// vertex shader for the ray cast impostors - draws the bounding box of a
+// curved shape and passes the values the fragment shader needs to cast a
+// ray through each pixel in the object space of the shape
+layout (location = 0) in vec3 inVertexPosition;
+
+out vec3 objectPosition;
+// camera position and view direction in object space
+flat out vec3 objectCamera;
+flat out vec3 objectViewDirection;
+// turns object space normals into world space normals
+flat out mat3 normalMatrix;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// object space bounds of the shape, the input is a unit cube
+uniform vec3 boundsMinimum;
+uniform vec3 boundsMaximum;
+
+void main()
+{
+	objectPosition = mix(boundsMinimum, boundsMaximum, inVertexPosition);
+
+	mat4 inverseModelView = inverse(view * model);
+	objectCamera = vec3(inverseModelView * vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	objectViewDirection = normalize(mat3(inverseModelView) * vec3(0.0f, 0.0f, -1.0f));
+	normalMatrix = transpose(inverse(mat3(model)));
+
+	gl_Position = projection * view * model * vec4(objectPosition, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,336 @@
+// lighting functions shared by the scene, impostor and deferred fragment
+// shaders, put in place of their #include "lighting.glsl" line when the
+// programs are compiled by ShaderProgram in Source.  Every lit path reads
+// the same lights, shadows, probes, occlusion and environment here, so
+// they can not drift apart.  A shader that fills in the material itself,
+// instead of reading it from the uniforms, defines MATERIAL_FROM_TABLE
+// before the include.
+
+const float PI = 3.14159265f;
+
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+struct DirectionalLight
+{
+	vec3 direction;
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+	bool bActive;
+};
+
+// one point or spot light, with the layout of CLUSTER_LIGHT
+struct ClusterLight
+{
+	// world position and range
+	vec4 positionRange;
+	// colors, with the cosines of the inner and outer spot angles
+	vec4 ambientCosInner;
+	vec4 diffuseCosOuter;
+	// specular color, with one for spot lights and zero for point lights
+	vec4 specularSpot;
+	// world direction of a spot light
+	vec4 direction;
+};
+
+// size of the cluster grid and the values that find a cluster
+layout (std140, binding = 0) uniform ClusterGrid
+{
+	// clusters along X, Y and depth, and the number of lights
+	uvec4 clusterCounts;
+	// depth slice = log(view depth) * x + y, viewport size in pixels
+	vec4 clusterParameters;
+};
+
+layout (std430, binding = 0) readonly buffer ClusterLights
+{
+	ClusterLight clusterLights[];
+};
+
+// first light index and light count of every cluster
+layout (std430, binding = 1) readonly buffer ClusterRanges
+{
+	uvec2 clusterRanges[];
+};
+
+layout (std430, binding = 2) readonly buffer ClusterLightIndices
+{
+	uint clusterLightIndices[];
+};
+
+// light space cascades of the directional light shadows
+layout (std140, binding = 1) uniform ShadowCascades
+{
+	// world space to shadow map texture coordinates and depth
+	mat4 shadowMatrices[4];
+	// far view depth of each cascade
+	vec4 cascadeSplits;
+	// world size of a shadow map texel in each cascade
+	vec4 cascadeTexelSizes;
+	// number of cascades, zero without shadows, and the size of a
+	// texel in texture coordinates
+	vec4 shadowParameters;
+};
+
+// one depth layer per cascade, compared when sampled
+layout (binding = 15) uniform sampler2DArrayShadow shadowMap;
+
+// grid of baked irradiance probes, built by IrradianceProbes in Source
+layout (std140, binding = 2) uniform IrradianceProbes
+{
+	// position of the first probe, with one when probes are baked
+	vec4 probeGridMinimum;
+	// probes per world unit along each axis
+	vec4 probeGridScale;
+	// probes along each axis, and texels per probe
+	vec4 probeCounts;
+};
+
+// the texels of every probe side by side along X, filtered between probes
+layout (binding = 13) uniform sampler3D probeCoefficients;
+
+// the prefiltered environment, set by ImageBasedLighting in Source
+layout (std140, binding = 3) uniform EnvironmentLighting
+{
+	// irradiance of the environment over pi, in the order of the probes
+	vec4 environmentHarmonics[9];
+	// one when the environment is loaded, the number of prefiltered
+	// levels, and the intensity
+	vec4 environmentParameters;
+};
+// equirectangular environment, blurred more at every level for
+// rougher surfaces
+layout (binding = 16) uniform sampler2D environmentSpecular;
+// scale and bias of the specular color by view angle and roughness
+layout (binding = 17) uniform sampler2D environmentBRDF;
+
+// the baked occlusion over the desk, set by AmbientOcclusion in Source
+layout (std140, binding = 4) uniform AmbientOcclusion
+{
+	// position of the first point, with one when the occlusion is baked
+	vec4 occlusionMinimum;
+	// points per world unit along each axis, and the spacing of the points
+	vec4 occlusionScale;
+	// points along each axis
+	vec4 occlusionCounts;
+};
+// open share of the space around every point, filtered between points
+layout (binding = 18) uniform sampler3D occlusionVisibility;
+
+uniform mat4 view;
+uniform vec3 viewPosition;
+uniform DirectionalLight directionalLight;
+
+#ifdef MATERIAL_FROM_TABLE
+// the material of the pixel, set by the shader before lighting it
+Material material;
+#else
+uniform Material material;
+#endif
+
+// ambient, diffuse and specular light from one light direction
+vec3 CalculateLight(vec3 lightDirection, vec3 ambient, vec3 diffuse, vec3 specular, vec3 normal, vec3 viewDirection)
+{
+	float diffuseImpact = max(dot(normal, lightDirection), 0.0f);
+	vec3 reflectDirection = reflect(-lightDirection, normal);
+	float specularImpact = pow(max(dot(viewDirection, reflectDirection), 0.0f), material.shininess);
+
+	return ambient * material.ambientColor * material.ambientStrength +
+		diffuse * diffuseImpact * material.diffuseColor +
+		specular * specularImpact * material.specularColor;
+}
+
+// diffuse light bounced onto a point from every direction, blended from the
+// eight probes around it and summed for the normal
+vec3 CalculateProbeIrradiance(vec3 worldPosition, vec3 normal)
+{
+	vec3 probe = clamp((worldPosition - probeGridMinimum.xyz) * probeGridScale.xyz, vec3(0.0f), probeCounts.xyz - 1.0f);
+	vec3 uvw = (probe + 0.5f) / vec3(probeCounts.x * probeCounts.w, probeCounts.yz);
+	float blockWidth = 1.0f / probeCounts.w;
+
+	vec4 probeTexels[7];
+	for (int i = 0; i < 7; i++)
+	{
+		probeTexels[i] = texture(probeCoefficients, uvw + vec3(blockWidth * float(i), 0.0f, 0.0f));
+	}
+
+	vec3 n = normal;
+	vec3 irradiance = 0.282095f * probeTexels[0].rgb;
+	irradiance += 0.488603f * n.y * vec3(probeTexels[0].a, probeTexels[1].rg);
+	irradiance += 0.488603f * n.z * vec3(probeTexels[1].ba, probeTexels[2].r);
+	irradiance += 0.488603f * n.x * probeTexels[2].gba;
+	irradiance += 1.092548f * n.x * n.y * probeTexels[3].rgb;
+	irradiance += 1.092548f * n.y * n.z * vec3(probeTexels[3].a, probeTexels[4].rg);
+	irradiance += 0.315392f * (3.0f * n.z * n.z - 1.0f) * vec3(probeTexels[4].ba, probeTexels[5].r);
+	irradiance += 1.092548f * n.x * n.z * probeTexels[5].gba;
+	irradiance += 0.546274f * (n.x * n.x - n.y * n.y) * probeTexels[6].rgb;
+
+	return max(irradiance, vec3(0.0f));
+}
+
+// irradiance of the environment for a normal, over pi like the probes
+vec3 CalculateEnvironmentIrradiance(vec3 n)
+{
+	vec3 irradiance = 0.282095f * environmentHarmonics[0].rgb;
+	irradiance += 0.488603f * n.y * environmentHarmonics[1].rgb;
+	irradiance += 0.488603f * n.z * environmentHarmonics[2].rgb;
+	irradiance += 0.488603f * n.x * environmentHarmonics[3].rgb;
+	irradiance += 1.092548f * n.x * n.y * environmentHarmonics[4].rgb;
+	irradiance += 1.092548f * n.y * n.z * environmentHarmonics[5].rgb;
+	irradiance += 0.315392f * (3.0f * n.z * n.z - 1.0f) * environmentHarmonics[6].rgb;
+	irradiance += 1.092548f * n.x * n.z * environmentHarmonics[7].rgb;
+	irradiance += 0.546274f * (n.x * n.x - n.y * n.y) * environmentHarmonics[8].rgb;
+
+	return max(irradiance, vec3(0.0f)) * environmentParameters.z;
+}
+
+// share of the ambient light that reaches a point, read one point
+// spacing out along the normal so the points inside the object are not
+// blended in.  The open side of a flat surface already sees half of the
+// sphere, so half counts as fully lit.
+float CalculateAmbientOcclusion(vec3 worldPosition, vec3 normal)
+{
+	if (occlusionMinimum.w < 0.5f)
+	{
+		return 1.0f;
+	}
+
+	vec3 point = (worldPosition + normal * occlusionScale.w - occlusionMinimum.xyz) * occlusionScale.xyz;
+	if (any(lessThan(point, vec3(0.0f))) || any(greaterThan(point, occlusionCounts.xyz - 1.0f)))
+	{
+		return 1.0f;
+	}
+	float visibility = texture(occlusionVisibility, (point + 0.5f) / occlusionCounts.xyz).r;
+	return clamp(2.0f * visibility, 0.0f, 1.0f);
+}
+
+// ambient light of the directional light, from the probes once they are
+// baked, or else from the environment, dimmed by the baked occlusion
+vec3 CalculateAmbientLight(vec3 worldPosition, vec3 normal)
+{
+	float occlusion = CalculateAmbientOcclusion(worldPosition, normal);
+	if (probeGridMinimum.w > 0.5f)
+	{
+		return CalculateProbeIrradiance(worldPosition, normal) * material.diffuseColor * occlusion;
+	}
+	if (environmentParameters.x > 0.5f)
+	{
+		return CalculateEnvironmentIrradiance(normal) * material.diffuseColor * occlusion;
+	}
+	return directionalLight.ambient * material.ambientColor * material.ambientStrength * occlusion;
+}
+
+// light of the environment reflected toward the viewer, read from the
+// level of the prefiltered environment that matches the roughness
+vec3 CalculateEnvironmentSpecular(vec3 normal, vec3 viewDirection)
+{
+	if (environmentParameters.x < 0.5f)
+	{
+		return vec3(0.0f);
+	}
+
+	// the same width of highlight as the Phong exponent
+	float roughness = clamp(sqrt(2.0f / (material.shininess + 2.0f)), 0.0f, 1.0f);
+	vec3 reflection = reflect(-viewDirection, normal);
+	vec2 uv = vec2(
+		atan(reflection.z, reflection.x) / (2.0f * PI) + 0.5f,
+		acos(clamp(-reflection.y, -1.0f, 1.0f)) / PI);
+	vec3 prefiltered = textureLod(environmentSpecular, uv, roughness * (environmentParameters.y - 1.0f)).rgb;
+
+	// the bias is the light of grazing angles, which a surface
+	// without a specular color does not have
+	vec2 brdf = texture(environmentBRDF, vec2(max(dot(normal, viewDirection), 0.0f), roughness)).rg;
+	vec3 specularColor = material.specularColor;
+	float grazing = clamp(50.0f * max(specularColor.r, max(specularColor.g, specularColor.b)), 0.0f, 1.0f);
+
+	return prefiltered * (specularColor * brdf.x + brdf.y * grazing) * environmentParameters.z;
+}
+
+// fraction of the directional light that reaches a point, filtered over
+// the texels around it
+float CalculateShadow(vec3 worldPosition, vec3 normal, vec3 lightDirection)
+{
+	int cascadeCount = int(shadowParameters.x);
+	float depth = -(view * vec4(worldPosition, 1.0f)).z;
+	int cascade = 0;
+	while ((cascade < cascadeCount) && (depth > cascadeSplits[cascade]))
+	{
+		cascade++;
+	}
+	if (cascade >= cascadeCount)
+	{
+		return 1.0f;
+	}
+
+	// move the point off the surface by about a texel, further where the
+	// light grazes the surface, so it does not shadow itself
+	float grazing = 1.0f - max(dot(normal, lightDirection), 0.0f);
+	vec3 offsetPosition = worldPosition + normal * cascadeTexelSizes[cascade] * (1.0f + 2.0f * grazing);
+	vec4 shadowPosition = shadowMatrices[cascade] * vec4(offsetPosition, 1.0f);
+	float shadowDepth = min(shadowPosition.z, 1.0f);
+
+	float lit = 0.0f;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			vec2 uv = shadowPosition.xy + vec2(x, y) * shadowParameters.y;
+			lit += texture(shadowMap, vec4(uv, float(cascade), shadowDepth));
+		}
+	}
+
+	return lit / 9.0f;
+}
+
+// index of the cluster that holds a fragment
+uint FindCluster(vec3 worldPosition)
+{
+	float depth = max(-(view * vec4(worldPosition, 1.0f)).z, 1.0e-4f);
+	float slice = clamp(log(depth) * clusterParameters.x + clusterParameters.y, 0.0f, float(clusterCounts.z) - 1.0f);
+	vec2 tile = clamp(
+		gl_FragCoord.xy / clusterParameters.zw * vec2(clusterCounts.xy),
+		vec2(0.0f),
+		vec2(clusterCounts.xy) - 1.0f);
+
+	return uint(tile.x) + clusterCounts.x * (uint(tile.y) + clusterCounts.y * uint(slice));
+}
+
+// light from a point or spot light, which fades out at its range
+vec3 CalculateClusterLight(ClusterLight light, vec3 worldPosition, vec3 normal, vec3 viewDirection)
+{
+	vec3 toLight = light.positionRange.xyz - worldPosition;
+	float distance = length(toLight);
+	float range = light.positionRange.w;
+	if (distance >= range)
+	{
+		return vec3(0.0f);
+	}
+
+	vec3 lightDirection = toLight / max(distance, 1.0e-4f);
+	float ratio = distance / range;
+	float fade = clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+	fade *= fade;
+
+	if (light.specularSpot.w > 0.5f)
+	{
+		float cosAngle = dot(-lightDirection, light.direction.xyz);
+		float cosInner = light.ambientCosInner.w;
+		float cosOuter = light.diffuseCosOuter.w;
+		fade *= clamp((cosAngle - cosOuter) / max(cosInner - cosOuter, 1.0e-4f), 0.0f, 1.0f);
+	}
+
+	return fade * CalculateLight(
+		lightDirection,
+		light.ambientCosInner.rgb,
+		light.diffuseCosOuter.rgb,
+		light.specularSpot.rgb,
+		normal,
+		viewDirection);
+}
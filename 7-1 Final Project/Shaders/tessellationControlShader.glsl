@@ -0,0 +1,53 @@
+#version 440 core
+
+// tessellation control shader for the tessellated shapes - the level of
+// each patch edge follows its length on the screen, so near shapes stay
+// smooth and far shapes use few triangles.  The level of an edge only
+// depends on its two corners, so the two patches that share an edge
+// split it the same way and no cracks open between them.
+layout (vertices = 4) out;
+
+in vec3 patchParameter[];
+in vec4 patchClipPosition[];
+
+out vec3 controlParameter[];
+
+uniform mat4 projection;
+// height of the viewport in pixels
+uniform float viewportHeight = 800.0f;
+// length in pixels of one tessellated edge segment
+uniform float edgePixels = 8.0f;
+// GL_MAX_TESS_GEN_LEVEL of the driver
+uniform float maxTessellationLevel = 64.0f;
+
+// place a clip space corner in pixels
+vec2 ToPixels(vec4 clipPosition)
+{
+	// the projection keeps the aspect ratio of the viewport
+	float aspect = projection[1][1] / projection[0][0];
+	vec2 ndc = clipPosition.xy / max(clipPosition.w, 1.0e-4f);
+	return ndc * 0.5f * vec2(viewportHeight * aspect, viewportHeight);
+}
+
+// tessellation level of the edge between two corners
+float EdgeLevel(int first, int second)
+{
+	float pixels = distance(ToPixels(patchClipPosition[first]), ToPixels(patchClipPosition[second]));
+	return clamp(pixels / edgePixels, 1.0f, maxTessellationLevel);
+}
+
+void main()
+{
+	controlParameter[gl_InvocationID] = patchParameter[gl_InvocationID];
+
+	if (gl_InvocationID == 0)
+	{
+		// the corners go around the patch from (0, 0) to (0, 1)
+		gl_TessLevelOuter[0] = EdgeLevel(0, 3);
+		gl_TessLevelOuter[1] = EdgeLevel(0, 1);
+		gl_TessLevelOuter[2] = EdgeLevel(1, 2);
+		gl_TessLevelOuter[3] = EdgeLevel(3, 2);
+		gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+		gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+	}
+}
@@ -0,0 +1,85 @@
+#version 440 core
+
+// tessellation evaluation shader for the tessellated shapes - every
+// generated vertex is placed on the exact surface of the shape, with
+// the same normal and texture coordinate as the generated meshes.  The
+// outputs match the scene vertex shader, so the scene fragment shader
+// lights the shapes.
+layout (quads, fractional_odd_spacing, ccw) in;
+
+in vec3 controlParameter[];
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// values of the TESSELLATION_PART enum
+const int TESSELLATION_PART_SIDE = 0;
+const int TESSELLATION_PART_TOP = 1;
+const int TESSELLATION_PART_BOTTOM = 2;
+const int TESSELLATION_PART_TORUS = 3;
+
+const float TWO_PI = 6.28318530718f;
+
+// cylinder: bottom and top radius, torus: main and tube radius
+uniform vec2 shapeRadii = vec2(1.0f);
+
+// point, normal and texture coordinate on the shape - the angles wrap
+// so that both sides of the U seam land on the same point
+void SurfacePoint(vec3 parameter, out vec3 position, out vec3 normal, out vec2 uv)
+{
+	int part = int(parameter.z + 0.5f);
+	float angle = TWO_PI * mod(parameter.x, 1.0f);
+	float s = sin(angle);
+	float c = cos(angle);
+
+	if (part == TESSELLATION_PART_TORUS)
+	{
+		float tubeAngle = TWO_PI * mod(parameter.y, 1.0f);
+		float ringRadius = shapeRadii.x + shapeRadii.y * cos(tubeAngle);
+		position = vec3(ringRadius * c, ringRadius * s, shapeRadii.y * sin(tubeAngle));
+		normal = vec3(cos(tubeAngle) * c, cos(tubeAngle) * s, sin(tubeAngle));
+		uv = parameter.xy;
+	}
+	else if ((part == TESSELLATION_PART_TOP) || (part == TESSELLATION_PART_BOTTOM))
+	{
+		bool bTop = (part == TESSELLATION_PART_TOP);
+		float radius = parameter.y * (bTop ? shapeRadii.y : shapeRadii.x);
+		position = vec3(radius * s, bTop ? 1.0f : 0.0f, radius * c);
+		normal = vec3(0.0f, bTop ? 1.0f : -1.0f, 0.0f);
+		uv = vec2(0.5f) + 0.5f * parameter.y * vec2(s, c);
+	}
+	else
+	{
+		// the side normal leans up as the radius narrows
+		float slope = shapeRadii.x - shapeRadii.y;
+		float radius = mix(shapeRadii.x, shapeRadii.y, parameter.y);
+		position = vec3(radius * s, parameter.y, radius * c);
+		normal = vec3(s, slope, c) / sqrt(1.0f + slope * slope);
+		uv = parameter.xy;
+	}
+}
+
+void main()
+{
+	vec2 t = gl_TessCoord.xy;
+	vec3 parameter = mix(
+		mix(controlParameter[0], controlParameter[1], t.x),
+		mix(controlParameter[3], controlParameter[2], t.x),
+		t.y);
+
+	vec3 position;
+	vec3 normal;
+	vec2 uv;
+	SurfacePoint(parameter, position, normal, uv);
+
+	gl_Position = projection * view * model * vec4(position, 1.0f);
+
+	fragmentPosition = vec3(model * vec4(position, 1.0f));
+	fragmentVertexNormal = mat3(transpose(inverse(model))) * normal;
+	fragmentTextureCoordinate = uv;
+}
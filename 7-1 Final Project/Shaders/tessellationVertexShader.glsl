@@ -0,0 +1,60 @@
+#version 440 core
+
+// vertex shader for the tessellated shapes - every vertex is a corner of
+// a coarse patch, given by its two surface parameters and the part of
+// the shape it lies on.  The corner is placed on the screen here so the
+// control shader can measure the patch edges in pixels.
+layout (location = 0) in vec3 inPatchParameter;
+
+out vec3 patchParameter;
+out vec4 patchClipPosition;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// values of the TESSELLATION_PART enum
+const int TESSELLATION_PART_SIDE = 0;
+const int TESSELLATION_PART_TOP = 1;
+const int TESSELLATION_PART_BOTTOM = 2;
+const int TESSELLATION_PART_TORUS = 3;
+
+const float TWO_PI = 6.28318530718f;
+
+// cylinder: bottom and top radius, torus: main and tube radius
+uniform vec2 shapeRadii = vec2(1.0f);
+
+// point on the shape - must match SurfacePoint() in the evaluation shader
+vec3 SurfacePosition(vec3 parameter)
+{
+	int part = int(parameter.z + 0.5f);
+	float angle = TWO_PI * mod(parameter.x, 1.0f);
+	float s = sin(angle);
+	float c = cos(angle);
+
+	if (part == TESSELLATION_PART_TORUS)
+	{
+		float tubeAngle = TWO_PI * mod(parameter.y, 1.0f);
+		float ringRadius = shapeRadii.x + shapeRadii.y * cos(tubeAngle);
+		return vec3(ringRadius * c, ringRadius * s, shapeRadii.y * sin(tubeAngle));
+	}
+	if (part == TESSELLATION_PART_TOP)
+	{
+		float radius = parameter.y * shapeRadii.y;
+		return vec3(radius * s, 1.0f, radius * c);
+	}
+	if (part == TESSELLATION_PART_BOTTOM)
+	{
+		float radius = parameter.y * shapeRadii.x;
+		return vec3(radius * s, 0.0f, radius * c);
+	}
+
+	float radius = mix(shapeRadii.x, shapeRadii.y, parameter.y);
+	return vec3(radius * s, parameter.y, radius * c);
+}
+
+void main()
+{
+	patchParameter = inPatchParameter;
+	patchClipPosition = projection * view * model * vec4(SurfacePosition(inPatchParameter), 1.0f);
+}
@@ -0,0 +1,28 @@
+#version 440 core
+
+// fragment shader for the composite step of the weighted blended
+// transparency - turns the weighted sum of the transparent layers of a
+// pixel into their average color, and blends it over the opaque scene by
+// how much of the scene the layers cover together.  The targets are
+// filled by the scene shaders and read by WeightedTransparency in Source.
+out vec4 outFragmentColor;
+
+// premultiplied color and alpha of the layers, summed by their weights
+layout (binding = 9) uniform sampler2D accumulationTexture;
+// product of the share of the scene that every layer lets through
+layout (binding = 10) uniform sampler2D revealageTexture;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+	float revealage = texelFetch(revealageTexture, texel, 0).r;
+	// no transparent layer covers this pixel
+	if (revealage >= 1.0f)
+	{
+		discard;
+	}
+
+	vec4 accumulation = texelFetch(accumulationTexture, texel, 0);
+	vec3 averageColor = accumulation.rgb / max(accumulation.a, 1.0e-5f);
+	outFragmentColor = vec4(averageColor, 1.0f - revealage);
+}
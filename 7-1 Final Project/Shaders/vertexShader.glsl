@@ -0,0 +1,198 @@
+#version 440 core
+
+// vertex shader for the scene meshes - the vertex attributes may be
+// stored as full floats, or in the compact HALF and SNORM16 formats
+// that are decoded with the per mesh values below.  Both compact
+// formats pass their positions in as the raw values of signed shorts.
+// The inputs are generated from VERTEX_SHADER_INPUTS in
+// Source/VertexLayout.h when the shader is loaded by ShaderProgram.
+// The procedural shapes read no inputs, their vertices are built from
+// gl_VertexID and the per draw procedural values below.
+#include "vertexInputs.glsl"
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// values of the VERTEX_FORMAT enum
+const int VERTEX_FORMAT_FLOAT32 = 0;
+const int VERTEX_FORMAT_HALF = 1;
+const int VERTEX_FORMAT_SNORM16 = 2;
+
+// format of the mesh, the compact formats have octahedral normals
+uniform int vertexFormat = VERTEX_FORMAT_FLOAT32;
+// decoded position = positionOffset + positionScale * stored position
+uniform vec3 positionOffset = vec3(0.0f);
+uniform vec3 positionScale = vec3(1.0f);
+
+// values of the PROCEDURAL_SHAPE enum
+const int PROCEDURAL_SHAPE_NONE = 0;
+const int PROCEDURAL_SHAPE_PLANE = 1;
+const int PROCEDURAL_SHAPE_BOX = 2;
+const int PROCEDURAL_SHAPE_CYLINDER = 3;
+
+const float TWO_PI = 6.28318530718f;
+
+// shape built from gl_VertexID, or none to read the vertex inputs
+uniform int proceduralShape = PROCEDURAL_SHAPE_NONE;
+// segments around the cylinder
+uniform int proceduralSegments = 36;
+// bottom and top radius of the cylinder
+uniform vec2 proceduralRadii = vec2(1.0f);
+
+// the two triangles of a quad, as signs of its U and V half axes
+const vec2 QUAD_CORNERS[6] = vec2[6](
+	vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f), vec2(1.0f, 1.0f),
+	vec2(-1.0f, -1.0f), vec2(1.0f, 1.0f), vec2(-1.0f, 1.0f));
+
+// center and half axes of the box sides, in the order back,
+// bottom, left, right, top, front of SceneMeshes::BoxSide
+const vec3 BOX_CENTERS[6] = vec3[6](
+	vec3(0.0f, 0.0f, -0.5f), vec3(0.0f, -0.5f, 0.0f), vec3(-0.5f, 0.0f, 0.0f),
+	vec3(0.5f, 0.0f, 0.0f), vec3(0.0f, 0.5f, 0.0f), vec3(0.0f, 0.0f, 0.5f));
+const vec3 BOX_U_AXES[6] = vec3[6](
+	vec3(-0.5f, 0.0f, 0.0f), vec3(0.5f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.5f),
+	vec3(0.0f, 0.0f, -0.5f), vec3(0.5f, 0.0f, 0.0f), vec3(0.5f, 0.0f, 0.0f));
+const vec3 BOX_V_AXES[6] = vec3[6](
+	vec3(0.0f, 0.5f, 0.0f), vec3(0.0f, 0.0f, 0.5f), vec3(0.0f, 0.5f, 0.0f),
+	vec3(0.0f, 0.5f, 0.0f), vec3(0.0f, 0.0f, -0.5f), vec3(0.0f, 0.5f, 0.0f));
+
+// ring step and top flag of the six vertices of a cylinder side quad
+const int SIDE_STEPS[6] = int[6](0, 1, 1, 0, 1, 0);
+const int SIDE_TOPS[6] = int[6](0, 0, 1, 0, 1, 1);
+
+// turn the stored position into the encoded position
+vec3 DecodePosition(vec3 stored)
+{
+	if (vertexFormat == VERTEX_FORMAT_HALF)
+	{
+		// the shorts hold the bits of half floats
+		uvec3 bits = uvec3(ivec3(stored) & 0xFFFF);
+		return vec3(unpackHalf2x16(bits.x).x, unpackHalf2x16(bits.y).x, unpackHalf2x16(bits.z).x);
+	}
+	if (vertexFormat == VERTEX_FORMAT_SNORM16)
+	{
+		return max(stored / 32767.0f, -1.0f);
+	}
+	return stored;
+}
+
+// unfold an octahedral encoded normal back onto the unit sphere
+vec3 DecodeOctahedralNormal(vec2 encoded)
+{
+	vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+	return normalize(normal);
+}
+
+// one vertex of a quad that faces along U cross V
+void QuadVertex(int corner, vec3 center, vec3 uAxis, vec3 vAxis, out vec3 position, out vec3 normal, out vec2 uv)
+{
+	vec2 signs = QUAD_CORNERS[corner];
+	position = center + signs.x * uAxis + signs.y * vAxis;
+	normal = normalize(cross(uAxis, vAxis));
+	uv = 0.5f * signs + 0.5f;
+}
+
+// one vertex of the cylinder - the side quads come first, then the
+// triangles of the top cap and of the bottom cap
+void CylinderVertex(int vertexID, out vec3 position, out vec3 normal, out vec2 uv)
+{
+	int segments = max(proceduralSegments, 3);
+	int sideVertices = 6 * segments;
+	int capVertices = 3 * segments;
+
+	int ringIndex;
+	bool bTop;
+	bool bCenter = false;
+	if (vertexID < sideVertices)
+	{
+		int corner = vertexID % 6;
+		ringIndex = vertexID / 6 + SIDE_STEPS[corner];
+		bTop = (SIDE_TOPS[corner] == 1);
+	}
+	else
+	{
+		int capVertex = vertexID - sideVertices;
+		bTop = (capVertex < capVertices);
+		capVertex = bTop ? capVertex : capVertex - capVertices;
+		int corner = capVertex % 3;
+		bCenter = (corner == 0);
+		// the bottom cap is wound the other way to face down
+		ringIndex = capVertex / 3 + (bTop ? corner - 1 : 2 - corner);
+	}
+
+	// the last ring vertex closes the seam with the exact first angle
+	float fraction = float(ringIndex) / float(segments);
+	float angle = TWO_PI * float(ringIndex % segments) / float(segments);
+	float s = sin(angle);
+	float c = cos(angle);
+	float height = bTop ? 1.0f : 0.0f;
+	float radius = bTop ? proceduralRadii.y : proceduralRadii.x;
+
+	if (vertexID < sideVertices)
+	{
+		// the side normal leans up as the radius narrows
+		float slope = proceduralRadii.x - proceduralRadii.y;
+		position = vec3(radius * s, height, radius * c);
+		normal = vec3(s, slope, c) / sqrt(1.0f + slope * slope);
+		uv = vec2(fraction, height);
+	}
+	else
+	{
+		position = bCenter ? vec3(0.0f, height, 0.0f) : vec3(radius * s, height, radius * c);
+		normal = vec3(0.0f, bTop ? 1.0f : -1.0f, 0.0f);
+		uv = bCenter ? vec2(0.5f) : vec2(0.5f + 0.5f * s, 0.5f + 0.5f * c);
+	}
+}
+
+// build the vertex of a procedural shape from its index
+void ProceduralVertex(int vertexID, out vec3 position, out vec3 normal, out vec2 uv)
+{
+	if (proceduralShape == PROCEDURAL_SHAPE_BOX)
+	{
+		int side = vertexID / 6;
+		QuadVertex(vertexID % 6, BOX_CENTERS[side], BOX_U_AXES[side], BOX_V_AXES[side], position, normal, uv);
+	}
+	else if (proceduralShape == PROCEDURAL_SHAPE_CYLINDER)
+	{
+		CylinderVertex(vertexID, position, normal, uv);
+	}
+	else
+	{
+		QuadVertex(vertexID % 6, vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f), position, normal, uv);
+	}
+}
+
+void main()
+{
+	vec3 position;
+	vec3 normal;
+	vec2 uv;
+	if (proceduralShape != PROCEDURAL_SHAPE_NONE)
+	{
+		ProceduralVertex(gl_VertexID, position, normal, uv);
+	}
+	else
+	{
+		position = positionOffset + positionScale * DecodePosition(inVertexPosition);
+		normal = inVertexNormal;
+		if (vertexFormat != VERTEX_FORMAT_FLOAT32)
+		{
+			normal = DecodeOctahedralNormal(inVertexNormal.xy);
+		}
+		uv = inTextureCoordinate;
+	}
+
+	gl_Position = projection * view * model * vec4(position, 1.0f);
+
+	fragmentPosition = vec3(model * vec4(position, 1.0f));
+	fragmentVertexNormal = mat3(transpose(inverse(model))) * normal;
+	fragmentTextureCoordinate = uv;
+}
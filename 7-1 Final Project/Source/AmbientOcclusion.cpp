@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.cpp
+// ============
+// hold the baked ambient occlusion volume for the shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AmbientOcclusion.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// binding points declared by the shaders
+	const GLuint g_OcclusionVolumeBinding = 4;
+	const GLuint g_OcclusionTextureUnit = 18;
+
+	/***********************************************************
+	 *  OCCLUSION_VOLUME_BLOCK
+	 *
+	 *  The std140 AmbientOcclusion block of the shaders.
+	 ***********************************************************/
+	struct OCCLUSION_VOLUME_BLOCK
+	{
+		// position of the first point, with one when the
+		// occlusion is uploaded
+		GLfloat minimum[4];
+		// points per world unit along each axis, and how far
+		// out along the normal the shaders read the volume
+		GLfloat scale[4];
+		// points along each axis
+		GLfloat counts[4];
+	};
+}
+
+/***********************************************************
+ *  AmbientOcclusion()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AmbientOcclusion::AmbientOcclusion()
+{
+	m_volumeBuffer = 0;
+	m_visibilityTexture = 0;
+}
+
+/***********************************************************
+ *  ~AmbientOcclusion()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AmbientOcclusion::~AmbientOcclusion()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating and binding the volume
+ *  block without occlusion, so the shaders leave the
+ *  ambient light alone until a volume is uploaded.
+ ***********************************************************/
+bool AmbientOcclusion::Create()
+{
+	Destroy();
+
+	OCCLUSION_VOLUME_BLOCK block = {};
+	glGenBuffers(1, &m_volumeBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_volumeBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_OcclusionVolumeBinding, m_volumeBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the occlusion and the
+ *  volume block.
+ ***********************************************************/
+void AmbientOcclusion::Destroy()
+{
+	if (m_visibilityTexture != 0)
+	{
+		glDeleteTextures(1, &m_visibilityTexture);
+	}
+	if (m_volumeBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_volumeBuffer);
+	}
+	m_visibilityTexture = 0;
+	m_volumeBuffer = 0;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for storing the open share of every
+ *  point of the passed in volume in a single channel 3D
+ *  texture and turning the occlusion on in the volume
+ *  block.  The volume is read one point spacing out from a
+ *  surface, so the filtering blends points in front of it
+ *  rather than the ones inside the object.
+ ***********************************************************/
+bool AmbientOcclusion::Upload(const OCCLUSION_VOLUME& volume)
+{
+	size_t pointCount = (size_t)volume.countX * (size_t)volume.countY * (size_t)volume.countZ;
+	if ((m_volumeBuffer == 0) || (pointCount == 0) || (volume.visibility.size() != pointCount))
+	{
+		std::cout << "ERROR: The ambient occlusion does not match its volume" << std::endl;
+		return(false);
+	}
+
+	// the scene textures, the G-buffer, the baked lighting, the
+	// shadows and the environment use the units below the volume
+	GLint textureUnits = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
+	if (textureUnits <= (GLint)g_OcclusionTextureUnit)
+	{
+		std::cout << "INFO: Only " << textureUnits << " texture units are available, the ambient occlusion is not used" << std::endl;
+		return(false);
+	}
+
+	std::vector<GLubyte> texels(pointCount);
+	for (size_t i = 0; i < pointCount; i++)
+	{
+		float visibility = std::min(std::max(volume.visibility[i], 0.0f), 1.0f);
+		texels[i] = (GLubyte)(visibility * 255.0f + 0.5f);
+	}
+
+	if (m_visibilityTexture == 0)
+	{
+		glGenTextures(1, &m_visibilityTexture);
+	}
+	glBindTexture(GL_TEXTURE_3D, m_visibilityTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_R8, volume.countX, volume.countY, volume.countZ, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	glm::vec3 extent = volume.maximum - volume.minimum;
+	glm::vec3 spacing(0.0f);
+	spacing.x = (volume.countX > 1) ? extent.x / (float)(volume.countX - 1) : 0.0f;
+	spacing.y = (volume.countY > 1) ? extent.y / (float)(volume.countY - 1) : 0.0f;
+	spacing.z = (volume.countZ > 1) ? extent.z / (float)(volume.countZ - 1) : 0.0f;
+
+	OCCLUSION_VOLUME_BLOCK block;
+	block.minimum[0] = volume.minimum.x;
+	block.minimum[1] = volume.minimum.y;
+	block.minimum[2] = volume.minimum.z;
+	block.minimum[3] = 1.0f;
+	block.scale[0] = (spacing.x > 0.0f) ? 1.0f / spacing.x : 0.0f;
+	block.scale[1] = (spacing.y > 0.0f) ? 1.0f / spacing.y : 0.0f;
+	block.scale[2] = (spacing.z > 0.0f) ? 1.0f / spacing.z : 0.0f;
+	block.scale[3] = std::max(spacing.x, std::max(spacing.y, spacing.z));
+	block.counts[0] = (float)volume.countX;
+	block.counts[1] = (float)volume.countY;
+	block.counts[2] = (float)volume.countZ;
+	block.counts[3] = 0.0f;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_volumeBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_OcclusionVolumeBinding, m_volumeBuffer);
+
+	glActiveTexture(GL_TEXTURE0 + g_OcclusionTextureUnit);
+	glBindTexture(GL_TEXTURE_3D, m_visibilityTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	return(true);
+}
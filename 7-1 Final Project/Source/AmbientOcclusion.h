@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.h
+// ============
+// hold the baked ambient occlusion volume for the shaders
+//
+//	The open share of every point of the volume is stored in one small
+//	3D texture over the desk.  The shaders read it a little way out
+//	along the normal of a point and dim the ambient light by it, so the
+//	corners and the gaps between the objects lose the light that the
+//	probes are too far apart to hold back.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightmapBaker.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  AmbientOcclusion
+ *
+ *  This class uploads a baked occlusion volume.  The shaders
+ *  read the volume from a fixed uniform block and texture
+ *  unit, and leave the ambient light alone until a volume
+ *  is uploaded.
+ ***********************************************************/
+class AmbientOcclusion
+{
+public:
+	// constructor
+	AmbientOcclusion();
+	// destructor
+	~AmbientOcclusion();
+
+	// create the volume block, with no occlusion
+	bool Create();
+	// free the occlusion and the volume block
+	void Destroy();
+
+	// upload the passed in baked volume
+	bool Upload(const OCCLUSION_VOLUME& volume);
+
+private:
+	GLuint m_volumeBuffer;
+	GLuint m_visibilityTexture;
+
+	// the occlusion cannot be shared between two objects
+	AmbientOcclusion(const AmbientOcclusion&);
+	AmbientOcclusion& operator=(const AmbientOcclusion&);
+};
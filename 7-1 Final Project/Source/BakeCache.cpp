@@ -0,0 +1,149 @@
+///////////////////////////////////////////////////////////////////////////////
+// bakecache.cpp
+// ============
+// store baked lighting data in cache files between runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BakeCache.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const char* g_CacheExtension = ".lmap";
+}
+
+/***********************************************************
+ *  GetBakeCacheFilename()
+ *
+ *  Get the path of the cache file for a hash.
+ ***********************************************************/
+std::string GetBakeCacheFilename(const char* cacheDirectory, const char* prefix, uint64_t hash)
+{
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)hash);
+	return(std::string(cacheDirectory) + "/" + prefix + hashText + g_CacheExtension);
+}
+
+/***********************************************************
+ *  StartBakeCacheHeader()
+ *
+ *  Fill in the parts of a cache header that every file
+ *  shares.
+ ***********************************************************/
+BAKE_CACHE_HEADER StartBakeCacheHeader(const char magic[4], uint32_t version, uint64_t hash)
+{
+	BAKE_CACHE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic, sizeof(header.magic));
+	header.version = version;
+	header.keyHash = hash;
+	return(header);
+}
+
+/***********************************************************
+ *  ReadBakeCacheFile()
+ *
+ *  Read the header and the floats of a cache file.  False
+ *  is returned when there is no file, or when it was not
+ *  written for the passed in magic, version and hash.
+ ***********************************************************/
+bool ReadBakeCacheFile(
+	const std::string& filename,
+	const char magic[4],
+	uint32_t version,
+	uint64_t hash,
+	BAKE_CACHE_HEADER& header,
+	std::vector<float>& values)
+{
+	MappedFile file;
+	if (file.Open(filename.c_str()) == false)
+	{
+		return(false);
+	}
+
+	if (file.GetSize() < sizeof(header))
+	{
+		std::cout << "ERROR: Bake cache file " << filename << " is too small" << std::endl;
+		return(false);
+	}
+	memcpy(&header, file.GetData(), sizeof(header));
+
+	size_t valueBytes = file.GetSize() - sizeof(header);
+	bool bValid =
+		(memcmp(header.magic, magic, sizeof(header.magic)) == 0) &&
+		(header.version == version) &&
+		(header.keyHash == hash) &&
+		(valueBytes % sizeof(float) == 0);
+	if (bValid == false)
+	{
+		std::cout << "INFO: Bake cache file " << filename << " is out of date or incomplete and will be baked again" << std::endl;
+		return(false);
+	}
+
+	values.resize(valueBytes / sizeof(float));
+	memcpy(values.data(), file.GetData() + sizeof(header), valueBytes);
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteBakeCacheFile()
+ *
+ *  Write the header and the floats of a cache file.  The
+ *  file is written under a temporary name first, so that a
+ *  partly written file is never read.
+ ***********************************************************/
+bool WriteBakeCacheFile(
+	const char* cacheDirectory,
+	const std::string& filename,
+	const BAKE_CACHE_HEADER& header,
+	const std::vector<float>& values)
+{
+#ifdef _WIN32
+	_mkdir(cacheDirectory);
+#else
+	mkdir(cacheDirectory, 0755);
+#endif
+
+	std::string temporaryName = filename + ".tmp";
+	std::ofstream file(temporaryName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR: Could not create bake cache file " << temporaryName << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)values.data(), (std::streamsize)(values.size() * sizeof(float)));
+	file.close();
+
+	if (!file)
+	{
+		std::cout << "ERROR: Could not write bake cache file " << temporaryName << std::endl;
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+
+	// rename does not replace an existing file on every platform
+	std::remove(filename.c_str());
+	if (std::rename(temporaryName.c_str(), filename.c_str()) != 0)
+	{
+		std::cout << "ERROR: Could not rename bake cache file " << temporaryName << std::endl;
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// bakecache.h
+// ============
+// store baked lighting data in cache files between runs
+//
+//	A cache file is a small header followed by the baked floats.  The
+//	file is named after a hash of everything the data was baked from,
+//	and the header repeats the hash with a magic and a version, so a
+//	file that no longer matches is baked again instead of being read.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  BAKE_CACHE_HEADER
+ *
+ *  The start of a cache file, followed by the baked floats.
+ *  The meaning of the sizes is up to the kind of data that
+ *  is stored.
+ ***********************************************************/
+struct BAKE_CACHE_HEADER
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t keyHash;
+	uint32_t sizes[4];
+};
+
+// get the path of the cache file for a hash
+std::string GetBakeCacheFilename(const char* cacheDirectory, const char* prefix, uint64_t hash);
+
+// fill in the parts of a cache header that every file shares
+BAKE_CACHE_HEADER StartBakeCacheHeader(const char magic[4], uint32_t version, uint64_t hash);
+
+// read the header and the floats of a cache file, returning false
+// when there is no file or it was written for other data
+bool ReadBakeCacheFile(
+	const std::string& filename,
+	const char magic[4],
+	uint32_t version,
+	uint64_t hash,
+	BAKE_CACHE_HEADER& header,
+	std::vector<float>& values);
+
+// write the header and the floats of a cache file, creating the
+// cache directory when needed
+bool WriteBakeCacheFile(
+	const char* cacheDirectory,
+	const std::string& filename,
+	const BAKE_CACHE_HEADER& header,
+	const std::vector<float>& values);
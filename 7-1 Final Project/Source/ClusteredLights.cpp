@@ -0,0 +1,610 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.cpp
+// ============
+// assign the point and spot lights of the scene to clusters of the view
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ClusteredLights.h"
+#include "FrameFences.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define CLUSTERED_LIGHTS_SSE 1
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// clusters across the screen and along the view depth
+	const int g_ClusterCountX = 16;
+	const int g_ClusterCountY = 9;
+	const int g_ClusterCountZ = 24;
+	const int g_ClusterCount = g_ClusterCountX * g_ClusterCountY * g_ClusterCountZ;
+
+	// the first depth slice starts here even when the projection
+	// reaches closer, so the slices stay useful
+	const float g_MinimumNearDepth = 0.05f;
+
+	// binding points declared by the shaders
+	const GLuint g_GridBinding = 0;
+	const GLuint g_LightBinding = 0;
+	const GLuint g_RangeBinding = 1;
+	const GLuint g_IndexBinding = 2;
+
+	const float g_Pi = 3.14159265358979323846f;
+
+	/***********************************************************
+	 *  CLUSTER_GRID
+	 *
+	 *  The std140 ClusterGrid block of the shaders.
+	 ***********************************************************/
+	struct CLUSTER_GRID
+	{
+		// clusters along X, Y and depth, and the number of lights
+		GLuint counts[4];
+		// depth slice = log(view depth) * [0] + [1], viewport size
+		GLfloat parameters[4];
+	};
+
+	/***********************************************************
+	 *  UnprojectPoint()
+	 *
+	 *  Turn a point in normalized device coordinates into a
+	 *  view space point.
+	 ***********************************************************/
+	glm::vec3 UnprojectPoint(const glm::mat4& inverseProjection, float x, float y, float z)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+		return(glm::vec3(point.x / point.w, point.y / point.w, point.z / point.w));
+	}
+
+	/***********************************************************
+	 *  PointAtDepth()
+	 *
+	 *  Find the point at a view depth on the line through two
+	 *  view space points.
+	 ***********************************************************/
+	glm::vec3 PointAtDepth(glm::vec3 nearPoint, glm::vec3 farPoint, float depth)
+	{
+		float t = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+		return(nearPoint + t * (farPoint - nearPoint));
+	}
+
+	/***********************************************************
+	 *  IsSameMatrix()
+	 *
+	 *  Compare every element of two matrices.
+	 ***********************************************************/
+	bool IsSameMatrix(const glm::mat4& a, const glm::mat4& b)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				if (a[i][j] != b[i][j])
+				{
+					return(false);
+				}
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  AddObjectLight()
+	 *
+	 *  Count a light that touches an object, and keep its index
+	 *  while there is room for it.
+	 ***********************************************************/
+	inline void AddObjectLight(GLint lightIndex, GLint* pIndices, int maxCount, int& count)
+	{
+		if (count < maxCount)
+		{
+			pIndices[count] = lightIndex;
+		}
+		count++;
+	}
+}
+
+/***********************************************************
+ *  ClusteredLights()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ClusteredLights::ClusteredLights()
+{
+	m_lightBuffer = 0;
+	m_lightBufferBytes = 0;
+	m_bLightsChanged = true;
+	m_boundsProjection = glm::mat4(1.0f);
+	m_nearDepth = g_MinimumNearDepth;
+	m_farDepth = 1.0f;
+}
+
+/***********************************************************
+ *  ~ClusteredLights()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ClusteredLights::~ClusteredLights()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the grid, light, range
+ *  and index buffers.  Until the first update every cluster
+ *  is empty, in every frame in flight.
+ ***********************************************************/
+void ClusteredLights::Create()
+{
+	Destroy();
+
+	glGenBuffers(1, &m_lightBuffer);
+	m_gridBuffer.Create(GL_UNIFORM_BUFFER, sizeof(CLUSTER_GRID));
+	m_rangeBuffer.Create(GL_SHADER_STORAGE_BUFFER, 2 * g_ClusterCount * sizeof(GLuint));
+	m_indexBuffer.Create(GL_SHADER_STORAGE_BUFFER, 0);
+
+	CLUSTER_GRID grid = {};
+	grid.counts[0] = g_ClusterCountX;
+	grid.counts[1] = g_ClusterCountY;
+	grid.counts[2] = g_ClusterCountZ;
+	grid.parameters[2] = 1.0f;
+	grid.parameters[3] = 1.0f;
+	m_ranges.assign(2 * g_ClusterCount, 0);
+	for (int frame = 0; frame < FRAMES_IN_FLIGHT; frame++)
+	{
+		m_gridBuffer.Upload(frame, g_GridBinding, &grid, sizeof(grid));
+		m_rangeBuffer.Upload(frame, g_RangeBinding, m_ranges.data(), m_ranges.size() * sizeof(GLuint));
+		m_indexBuffer.Upload(frame, g_IndexBinding, NULL, 0);
+	}
+
+	UploadBuffer(m_lightBuffer, m_lightBufferBytes, NULL, 0);
+	m_bLightsChanged = true;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_LightBinding, m_lightBuffer);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the cluster buffers.  The
+ *  lights are kept.
+ ***********************************************************/
+void ClusteredLights::Destroy()
+{
+	if (m_lightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	m_gridBuffer.Destroy();
+	m_rangeBuffer.Destroy();
+	m_indexBuffer.Destroy();
+	m_lightBufferBytes = 0;
+	m_clusterBounds.clear();
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a light that shines in
+ *  every direction, fading out at its range.
+ ***********************************************************/
+int ClusteredLights::AddPointLight(
+	glm::vec3 position,
+	float range,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	CLUSTER_LIGHT light;
+	light.positionRange = glm::vec4(position, std::max(range, 0.0f));
+	light.ambientCosInner = glm::vec4(ambient, 1.0f);
+	light.diffuseCosOuter = glm::vec4(diffuse, 1.0f);
+	light.specularSpot = glm::vec4(specular, 0.0f);
+	light.direction = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
+
+	m_lights.push_back(light);
+	AddLightSphere(position, light.positionRange.w);
+	m_bLightsChanged = true;
+
+	return((int)m_lights.size() - 1);
+}
+
+/***********************************************************
+ *  AddSpotLight()
+ *
+ *  This method is used for adding a light that shines in a
+ *  cone, fading from the inner angle to the outer angle and
+ *  out at its range.  The clusters treat it as a point light
+ *  of the same range.
+ ***********************************************************/
+int ClusteredLights::AddSpotLight(
+	glm::vec3 position,
+	glm::vec3 direction,
+	float range,
+	float innerAngle,
+	float outerAngle,
+	glm::vec3 ambient,
+	glm::vec3 diffuse,
+	glm::vec3 specular)
+{
+	outerAngle = std::max(outerAngle, innerAngle);
+
+	CLUSTER_LIGHT light;
+	light.positionRange = glm::vec4(position, std::max(range, 0.0f));
+	light.ambientCosInner = glm::vec4(ambient, std::cos(innerAngle * g_Pi / 180.0f));
+	light.diffuseCosOuter = glm::vec4(diffuse, std::cos(outerAngle * g_Pi / 180.0f));
+	light.specularSpot = glm::vec4(specular, 1.0f);
+	light.direction = glm::vec4(glm::normalize(direction), 0.0f);
+
+	m_lights.push_back(light);
+	AddLightSphere(position, light.positionRange.w);
+	m_bLightsChanged = true;
+
+	return((int)m_lights.size() - 1);
+}
+
+/***********************************************************
+ *  ClearLights()
+ *
+ *  This method is used for removing all of the lights.
+ ***********************************************************/
+void ClusteredLights::ClearLights()
+{
+	m_lights.clear();
+	m_sphereX.clear();
+	m_sphereY.clear();
+	m_sphereZ.clear();
+	m_sphereRangeSquared.clear();
+	m_bLightsChanged = true;
+}
+
+/***********************************************************
+ *  AddLightSphere()
+ *
+ *  This method is used for adding the sphere that a new
+ *  light reaches to the arrays tested by FindObjectLights().
+ *  A spot light is tested as a point light of the same
+ *  range.
+ ***********************************************************/
+void ClusteredLights::AddLightSphere(glm::vec3 position, float range)
+{
+	m_sphereX.push_back(position.x);
+	m_sphereY.push_back(position.y);
+	m_sphereZ.push_back(position.z);
+	m_sphereRangeSquared.push_back(range * range);
+}
+
+/***********************************************************
+ *  FindObjectLights()
+ *
+ *  This method is used for finding the lights whose range
+ *  touches the bounds of an object.  The object space box is
+ *  turned into a world space box around it, and the distance
+ *  from every light to the box is compared with its range,
+ *  four lights at a time.  When more lights touch the object
+ *  than fit, the count is still returned so that the caller
+ *  can go back to the light clusters.
+ ***********************************************************/
+int ClusteredLights::FindObjectLights(
+	const glm::mat4& model,
+	const glm::vec3& minimum,
+	const glm::vec3& maximum,
+	GLint* pIndices,
+	int maxCount) const
+{
+	// the world box holds the object box in any rotation
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	glm::vec3 extent = (maximum - minimum) * 0.5f;
+	glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent(0.0f);
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			worldExtent[row] += std::fabs(model[column][row]) * extent[column];
+		}
+	}
+	glm::vec3 boxMinimum = worldCenter - worldExtent;
+	glm::vec3 boxMaximum = worldCenter + worldExtent;
+
+	int count = 0;
+	size_t lightCount = m_sphereX.size();
+	size_t i = 0;
+#ifdef CLUSTERED_LIGHTS_SSE
+	__m128 minimumX = _mm_set1_ps(boxMinimum.x);
+	__m128 minimumY = _mm_set1_ps(boxMinimum.y);
+	__m128 minimumZ = _mm_set1_ps(boxMinimum.z);
+	__m128 maximumX = _mm_set1_ps(boxMaximum.x);
+	__m128 maximumY = _mm_set1_ps(boxMaximum.y);
+	__m128 maximumZ = _mm_set1_ps(boxMaximum.z);
+	__m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= lightCount; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&m_sphereX[i]);
+		__m128 y = _mm_loadu_ps(&m_sphereY[i]);
+		__m128 z = _mm_loadu_ps(&m_sphereZ[i]);
+
+		// distance from each center to the box along each axis,
+		// zero inside the box
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumX, x), _mm_sub_ps(x, maximumX)), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumY, y), _mm_sub_ps(y, maximumY)), zero);
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minimumZ, z), _mm_sub_ps(z, maximumZ)), zero);
+		__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_loadu_ps(&m_sphereRangeSquared[i])));
+		for (int lane = 0; (lane < 4) && (mask != 0); lane++)
+		{
+			if ((mask & (1 << lane)) != 0)
+			{
+				AddObjectLight((GLint)(i + lane), pIndices, maxCount, count);
+			}
+		}
+	}
+#endif
+	for (; i < lightCount; i++)
+	{
+		float dx = std::max(std::max(boxMinimum.x - m_sphereX[i], m_sphereX[i] - boxMaximum.x), 0.0f);
+		float dy = std::max(std::max(boxMinimum.y - m_sphereY[i], m_sphereY[i] - boxMaximum.y), 0.0f);
+		float dz = std::max(std::max(boxMinimum.z - m_sphereZ[i], m_sphereZ[i] - boxMaximum.z), 0.0f);
+		if (dx * dx + dy * dy + dz * dz <= m_sphereRangeSquared[i])
+		{
+			AddObjectLight((GLint)i, pIndices, maxCount, count);
+		}
+	}
+
+	return(count);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for assigning every light to the
+ *  clusters its range reaches in the passed in view, then
+ *  uploading the light lists of the clusters into the
+ *  regions of the passed in frame.  The lights themselves
+ *  are only uploaded after they change.
+ ***********************************************************/
+void ClusteredLights::Update(const glm::mat4& view, const glm::mat4& projection, int viewportHeight, int frame)
+{
+	if (m_lightBuffer == 0)
+	{
+		return;
+	}
+
+	if (m_clusterBounds.empty() || !IsSameMatrix(projection, m_boundsProjection))
+	{
+		BuildClusterBounds(projection);
+	}
+
+	m_pairs.clear();
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		const glm::vec4& positionRange = m_lights[i].positionRange;
+		glm::vec4 viewCenter = view * glm::vec4(positionRange.x, positionRange.y, positionRange.z, 1.0f);
+		AssignLight((GLuint)i, glm::vec3(viewCenter), positionRange.w, projection);
+	}
+
+	// sort the pairs by cluster with a counting sort
+	m_ranges.assign(2 * g_ClusterCount, 0);
+	for (size_t i = 0; i < m_pairs.size(); i++)
+	{
+		m_ranges[2 * m_pairs[i].cluster + 1]++;
+	}
+	GLuint offset = 0;
+	for (int cluster = 0; cluster < g_ClusterCount; cluster++)
+	{
+		m_ranges[2 * cluster] = offset;
+		offset += m_ranges[2 * cluster + 1];
+		m_ranges[2 * cluster + 1] = 0;
+	}
+	m_indices.resize(m_pairs.size());
+	for (size_t i = 0; i < m_pairs.size(); i++)
+	{
+		GLuint* range = &m_ranges[2 * m_pairs[i].cluster];
+		m_indices[range[0] + range[1]] = m_pairs[i].light;
+		range[1]++;
+	}
+
+	if (m_bLightsChanged)
+	{
+		UploadBuffer(m_lightBuffer, m_lightBufferBytes, m_lights.data(), m_lights.size() * sizeof(CLUSTER_LIGHT));
+		m_bLightsChanged = false;
+		// growing the buffer replaces its storage, so the binding
+		// point is set again
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_LightBinding, m_lightBuffer);
+	}
+	m_rangeBuffer.Upload(frame, g_RangeBinding, m_ranges.data(), m_ranges.size() * sizeof(GLuint));
+	m_indexBuffer.Upload(frame, g_IndexBinding, m_indices.data(), m_indices.size() * sizeof(GLuint));
+
+	// the projection keeps the aspect ratio of the viewport
+	float logDepthRatio = std::log(m_farDepth / m_nearDepth);
+	CLUSTER_GRID grid;
+	grid.counts[0] = g_ClusterCountX;
+	grid.counts[1] = g_ClusterCountY;
+	grid.counts[2] = g_ClusterCountZ;
+	grid.counts[3] = (GLuint)m_lights.size();
+	grid.parameters[0] = (float)g_ClusterCountZ / logDepthRatio;
+	grid.parameters[1] = -(float)g_ClusterCountZ * std::log(m_nearDepth) / logDepthRatio;
+	grid.parameters[2] = (float)viewportHeight * projection[1][1] / projection[0][0];
+	grid.parameters[3] = (float)viewportHeight;
+	m_gridBuffer.Upload(frame, g_GridBinding, &grid, sizeof(grid));
+}
+
+/***********************************************************
+ *  BuildClusterBounds()
+ *
+ *  This method is used for finding the view space box around
+ *  every cluster.  The depth slices grow exponentially from
+ *  the near depth to the far depth, so the clusters keep a
+ *  similar shape along the view.  Both perspective and
+ *  orthographic projections are handled by following the
+ *  line through each tile corner from the near plane to the
+ *  far plane.
+ ***********************************************************/
+void ClusteredLights::BuildClusterBounds(const glm::mat4& projection)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	m_nearDepth = std::max(-UnprojectPoint(inverseProjection, 0.0f, 0.0f, -1.0f).z, g_MinimumNearDepth);
+	m_farDepth = std::max(-UnprojectPoint(inverseProjection, 0.0f, 0.0f, 1.0f).z, m_nearDepth * 2.0f);
+	m_boundsProjection = projection;
+
+	// lines through the corners of the tiles
+	const int cornersX = g_ClusterCountX + 1;
+	const int cornersY = g_ClusterCountY + 1;
+	std::vector<glm::vec3> nearCorners(cornersX * cornersY);
+	std::vector<glm::vec3> farCorners(cornersX * cornersY);
+	for (int y = 0; y < cornersY; y++)
+	{
+		for (int x = 0; x < cornersX; x++)
+		{
+			float ndcX = -1.0f + 2.0f * (float)x / (float)g_ClusterCountX;
+			float ndcY = -1.0f + 2.0f * (float)y / (float)g_ClusterCountY;
+			nearCorners[y * cornersX + x] = UnprojectPoint(inverseProjection, ndcX, ndcY, -1.0f);
+			farCorners[y * cornersX + x] = UnprojectPoint(inverseProjection, ndcX, ndcY, 1.0f);
+		}
+	}
+
+	m_clusterBounds.resize(g_ClusterCount);
+	for (int z = 0; z < g_ClusterCountZ; z++)
+	{
+		float depths[2] =
+		{
+			m_nearDepth * std::pow(m_farDepth / m_nearDepth, (float)z / (float)g_ClusterCountZ),
+			m_nearDepth * std::pow(m_farDepth / m_nearDepth, (float)(z + 1) / (float)g_ClusterCountZ)
+		};
+
+		for (int y = 0; y < g_ClusterCountY; y++)
+		{
+			for (int x = 0; x < g_ClusterCountX; x++)
+			{
+				ClusterBounds& bounds = m_clusterBounds[x + g_ClusterCountX * (y + g_ClusterCountY * z)];
+				bounds.minimum = glm::vec3(1.0e30f);
+				bounds.maximum = glm::vec3(-1.0e30f);
+
+				for (int corner = 0; corner < 8; corner++)
+				{
+					int line = (y + ((corner >> 1) & 1)) * cornersX + x + (corner & 1);
+					glm::vec3 point = PointAtDepth(nearCorners[line], farCorners[line], depths[corner >> 2]);
+					bounds.minimum = glm::min(bounds.minimum, point);
+					bounds.maximum = glm::max(bounds.maximum, point);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDepthSlice()
+ *
+ *  This method is used for finding the depth slice that a
+ *  view depth falls in, the same way as the shaders.
+ ***********************************************************/
+int ClusteredLights::GetDepthSlice(float depth) const
+{
+	float slice = std::log(std::max(depth, m_nearDepth) / m_nearDepth) / std::log(m_farDepth / m_nearDepth);
+	return(std::min(std::max((int)(slice * (float)g_ClusterCountZ), 0), g_ClusterCountZ - 1));
+}
+
+/***********************************************************
+ *  AssignLight()
+ *
+ *  This method is used for adding a light to every cluster
+ *  whose box touches the sphere of its range.  Only the
+ *  depth slices the sphere spans are tested, and when the
+ *  sphere is in front of the camera only the tiles that its
+ *  projected box covers.
+ ***********************************************************/
+void ClusteredLights::AssignLight(GLuint lightIndex, glm::vec3 viewCenter, float range, const glm::mat4& projection)
+{
+	float closestDepth = -viewCenter.z - range;
+	float farthestDepth = -viewCenter.z + range;
+	if ((range <= 0.0f) || (farthestDepth < m_nearDepth) || (closestDepth > m_farDepth))
+	{
+		return;
+	}
+
+	int firstSlice = GetDepthSlice(closestDepth);
+	int lastSlice = GetDepthSlice(farthestDepth);
+
+	int firstX = 0;
+	int lastX = g_ClusterCountX - 1;
+	int firstY = 0;
+	int lastY = g_ClusterCountY - 1;
+	if (closestDepth > m_nearDepth)
+	{
+		glm::vec2 ndcMinimum(1.0e30f, 1.0e30f);
+		glm::vec2 ndcMaximum(-1.0e30f, -1.0e30f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 point(
+				viewCenter.x + ((corner & 1) ? range : -range),
+				viewCenter.y + ((corner & 2) ? range : -range),
+				viewCenter.z + ((corner & 4) ? range : -range));
+			glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+			glm::vec2 ndc(clip.x / clip.w, clip.y / clip.w);
+			ndcMinimum = glm::min(ndcMinimum, ndc);
+			ndcMaximum = glm::max(ndcMaximum, ndc);
+		}
+		if ((ndcMaximum.x < -1.0f) || (ndcMinimum.x > 1.0f) || (ndcMaximum.y < -1.0f) || (ndcMinimum.y > 1.0f))
+		{
+			return;
+		}
+
+		firstX = std::max((int)std::floor((ndcMinimum.x + 1.0f) * 0.5f * g_ClusterCountX), 0);
+		lastX = std::min((int)std::floor((ndcMaximum.x + 1.0f) * 0.5f * g_ClusterCountX), g_ClusterCountX - 1);
+		firstY = std::max((int)std::floor((ndcMinimum.y + 1.0f) * 0.5f * g_ClusterCountY), 0);
+		lastY = std::min((int)std::floor((ndcMaximum.y + 1.0f) * 0.5f * g_ClusterCountY), g_ClusterCountY - 1);
+	}
+
+	float rangeSquared = range * range;
+	for (int z = firstSlice; z <= lastSlice; z++)
+	{
+		for (int y = firstY; y <= lastY; y++)
+		{
+			for (int x = firstX; x <= lastX; x++)
+			{
+				GLuint cluster = (GLuint)(x + g_ClusterCountX * (y + g_ClusterCountY * z));
+				const ClusterBounds& bounds = m_clusterBounds[cluster];
+
+				glm::vec3 closest = glm::clamp(viewCenter, bounds.minimum, bounds.maximum);
+				glm::vec3 offset = closest - viewCenter;
+				if (glm::dot(offset, offset) <= rangeSquared)
+				{
+					ClusterPair pair = { cluster, lightIndex };
+					m_pairs.push_back(pair);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  UploadBuffer()
+ *
+ *  This method is used for copying data into the light
+ *  buffer.  The buffer grows to at least twice its size when
+ *  the data does not fit, and is never left empty so that it
+ *  can always be bound.
+ ***********************************************************/
+void ClusteredLights::UploadBuffer(GLuint buffer, size_t& capacity, const void* data, size_t bytes)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	if ((bytes > capacity) || (capacity == 0))
+	{
+		capacity = std::max(std::max(bytes, capacity * 2), (size_t)256);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)capacity, NULL, GL_DYNAMIC_DRAW);
+	}
+	if (bytes > 0)
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)bytes, data);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
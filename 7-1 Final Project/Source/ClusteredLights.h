@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+// clusteredlights.h
+// ============
+// assign the point and spot lights of the scene to clusters of the view
+//
+//	The view frustum is split into tiles across the screen and into
+//	depth slices that grow with the distance, and every light is added
+//	to the clusters that its range reaches.  The fragment shaders find
+//	their cluster from the pixel and the view depth, then only loop over
+//	the lights of that cluster, so the cost of a fragment follows the
+//	lights that reach it instead of all of the lights in the scene.
+//
+//	The clusters are built on the CPU every frame and read by the shaders
+//	from fixed buffer binding points, so every program that declares the
+//	cluster buffers sees the same lights.  Each frame in flight writes
+//	the clusters into its own region of the buffers, so a frame the GPU
+//	is still drawing keeps the clusters it was built with.
+//
+//	A draw can also be given the few lights whose range touches the bounds
+//	of its object, found four lights at a time from a copy of the light
+//	spheres laid out by component, so that its fragments skip the cluster
+//	lookup.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.h"
+
+#include <vector>
+
+// most lights passed to one draw, matching the shaders
+const int MAX_OBJECT_LIGHTS = 8;
+
+/***********************************************************
+ *  CLUSTER_LIGHT
+ *
+ *  One point or spot light, laid out like the ClusterLight
+ *  struct of the shaders.
+ ***********************************************************/
+struct CLUSTER_LIGHT
+{
+	// world position and range
+	glm::vec4 positionRange;
+	// colors, with the cosines of the inner and outer spot angles
+	glm::vec4 ambientCosInner;
+	glm::vec4 diffuseCosOuter;
+	// specular color, with one for spot lights
+	glm::vec4 specularSpot;
+	// world direction of a spot light
+	glm::vec4 direction;
+};
+
+/***********************************************************
+ *  ClusteredLights
+ *
+ *  This class holds the lights of the scene and the buffers
+ *  of the light clusters, which are rebuilt by Update() for
+ *  the view of each frame.
+ ***********************************************************/
+class ClusteredLights
+{
+public:
+	// constructor
+	ClusteredLights();
+	// destructor
+	~ClusteredLights();
+
+	// create the cluster buffers and bind them for the shaders
+	void Create();
+	// free the cluster buffers
+	void Destroy();
+
+	// add a light that shines in every direction up to its range,
+	// returning its index
+	int AddPointLight(
+		glm::vec3 position,
+		float range,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	// add a light that shines in a cone up to its range, with the
+	// angles in degrees, returning its index
+	int AddSpotLight(
+		glm::vec3 position,
+		glm::vec3 direction,
+		float range,
+		float innerAngle,
+		float outerAngle,
+		glm::vec3 ambient,
+		glm::vec3 diffuse,
+		glm::vec3 specular);
+	// remove all of the lights
+	void ClearLights();
+	size_t GetLightCount() const { return(m_lights.size()); }
+	const CLUSTER_LIGHT& GetLight(size_t index) const { return(m_lights[index]); }
+
+	// assign the lights to the clusters of the passed in view and
+	// upload the clusters for the next draws of the passed in
+	// frame in flight
+	void Update(const glm::mat4& view, const glm::mat4& projection, int viewportHeight, int frame);
+
+	// find the lights whose range touches the passed in object space
+	// box moved by the model matrix, writing up to maxCount indices,
+	// and return how many lights touch it
+	int FindObjectLights(
+		const glm::mat4& model,
+		const glm::vec3& minimum,
+		const glm::vec3& maximum,
+		GLint* pIndices,
+		int maxCount) const;
+
+private:
+	struct ClusterBounds
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+	};
+
+	// a light reaching a cluster
+	struct ClusterPair
+	{
+		GLuint cluster;
+		GLuint light;
+	};
+
+	// the lights only change between frames, while the clusters
+	// are written again every frame
+	GLuint m_lightBuffer;
+	StreamBuffer m_gridBuffer;
+	StreamBuffer m_rangeBuffer;
+	StreamBuffer m_indexBuffer;
+	// size in bytes of the light buffer, which only grows
+	size_t m_lightBufferBytes;
+
+	std::vector<CLUSTER_LIGHT> m_lights;
+	bool m_bLightsChanged;
+	// world centers and squared ranges of the lights, one array
+	// per component so that four lights are tested at once
+	std::vector<float> m_sphereX;
+	std::vector<float> m_sphereY;
+	std::vector<float> m_sphereZ;
+	std::vector<float> m_sphereRangeSquared;
+
+	// view space bounds of every cluster, and the projection they
+	// were built for with its near and far depths
+	std::vector<ClusterBounds> m_clusterBounds;
+	glm::mat4 m_boundsProjection;
+	float m_nearDepth;
+	float m_farDepth;
+
+	// reused every frame to avoid allocations - the ranges hold the
+	// first light index and the light count of every cluster
+	std::vector<ClusterPair> m_pairs;
+	std::vector<GLuint> m_ranges;
+	std::vector<GLuint> m_indices;
+
+	// rebuild the cluster bounds when the projection changes
+	void BuildClusterBounds(const glm::mat4& projection);
+	// add the sphere of a new light for FindObjectLights()
+	void AddLightSphere(glm::vec3 position, float range);
+	// add the clusters reached by a light to the pair list
+	void AssignLight(GLuint lightIndex, glm::vec3 viewCenter, float range, const glm::mat4& projection);
+	// get the depth slice that holds a view depth
+	int GetDepthSlice(float depth) const;
+	// copy data into the light buffer, growing it when needed
+	void UploadBuffer(GLuint buffer, size_t& capacity, const void* data, size_t bytes);
+
+	// the buffers cannot be shared between two objects
+	ClusteredLights(const ClusteredLights&);
+	ClusteredLights& operator=(const ClusteredLights&);
+};
@@ -0,0 +1,358 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredshading.cpp
+// ============
+// light the opaque objects once per pixel from a G-buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredShading.h"
+#include "ShaderProgram.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_DeferredVertexShader = "./Shaders/deferredVertexShader.glsl";
+	const char* g_DeferredFragmentShader = "./Shaders/deferredFragmentShader.glsl";
+
+	// binding points declared by the lighting pass shader
+	const GLuint g_MaterialBinding = 3;
+	const GLuint g_DepthTextureUnit = 9;
+	const GLuint g_AlbedoTextureUnit = 10;
+	const GLuint g_NormalTextureUnit = 11;
+	const GLuint g_EmissionTextureUnit = 12;
+
+	// albedo, normal with material, and emission
+	const GLsizei g_ColorTargetCount = 3;
+}
+
+/***********************************************************
+ *  DeferredShading()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredShading::DeferredShading()
+{
+	m_pShaderManager = NULL;
+	m_framebuffer = 0;
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_emissionTexture = 0;
+	m_depthTexture = 0;
+	m_materialBuffer = 0;
+	m_vao = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bBlendEnabled = GL_FALSE;
+}
+
+/***********************************************************
+ *  ~DeferredShading()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredShading::~DeferredShading()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the lighting pass shader
+ *  program and creating the material table.  The G-buffer
+ *  is created by the first geometry pass, when the size of
+ *  the viewport is known.  The current program is not
+ *  changed.
+ ***********************************************************/
+bool DeferredShading::Create()
+{
+	Destroy();
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	m_pShaderManager = new ShaderManager();
+	GLuint programID = LoadShaderProgram(m_pShaderManager, g_DeferredVertexShader, g_DeferredFragmentShader);
+
+	GLint linkStatus = GL_FALSE;
+	if (programID != 0)
+	{
+		glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+	}
+	glUseProgram((GLuint)currentProgram);
+	if (linkStatus != GL_TRUE)
+	{
+		std::cout << "ERROR: Could not load the deferred lighting shaders " << g_DeferredVertexShader << " and " << g_DeferredFragmentShader << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_materialBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the G-buffer, the
+ *  material table and the lighting pass program.
+ ***********************************************************/
+void DeferredShading::Destroy()
+{
+	DestroyTargets();
+
+	if (m_materialBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_materialBuffer);
+	}
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+	m_materialBuffer = 0;
+	m_vao = 0;
+
+	if (NULL != m_pShaderManager)
+	{
+		if (m_pShaderManager->m_programID != 0)
+		{
+			glDeleteProgram(m_pShaderManager->m_programID);
+		}
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for uploading the materials that the
+ *  index in the G-buffer refers to.
+ ***********************************************************/
+void DeferredShading::SetMaterials(const std::vector<DEFERRED_MATERIAL>& materials)
+{
+	if ((m_materialBuffer == 0) || (materials.size() == 0))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, materials.size() * sizeof(DEFERRED_MATERIAL), materials.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetViewParameters()
+ *
+ *  This method is used for setting the camera of the current
+ *  frame into the lighting pass, which turns the depth of
+ *  every pixel back into its world position.  The scene
+ *  shader is left as the current program.
+ ***********************************************************/
+void DeferredShading::SetViewParameters(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	m_pShaderManager->use();
+	m_pShaderManager->setMat4Value("view", view);
+	m_pShaderManager->setMat4Value("inverseViewProjection", glm::inverse(projection * view));
+	m_pShaderManager->setVec3Value("viewPosition", glm::vec3(glm::inverse(view)[3]));
+
+	glUseProgram((GLuint)currentProgram);
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for binding the G-buffer for the
+ *  geometry pass.  The targets follow the size of the
+ *  viewport, and blending is turned off because the alpha
+ *  of the albedo target marks the lit surfaces.
+ ***********************************************************/
+bool DeferredShading::BeginGeometryPass()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return(false);
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] != m_width) || (viewport[3] != m_height) || (m_framebuffer == 0))
+	{
+		if (CreateTargets(viewport[2], viewport[3]) == false)
+		{
+			return(false);
+		}
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	const GLenum drawBuffers[g_ColorTargetCount] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	glDrawBuffers(g_ColorTargetCount, drawBuffers);
+
+	const GLfloat clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearDepth = 1.0f;
+	for (GLint i = 0; i < g_ColorTargetCount; i++)
+	{
+		glClearBufferfv(GL_COLOR, i, clearColor);
+	}
+	glClearBufferfv(GL_DEPTH, 0, &clearDepth);
+
+	m_bBlendEnabled = glIsEnabled(GL_BLEND);
+	glDisable(GL_BLEND);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndGeometryPass()
+ *
+ *  This method is used for going back to the screen
+ *  framebuffer after the geometry pass.
+ ***********************************************************/
+void DeferredShading::EndGeometryPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (m_bBlendEnabled)
+	{
+		glEnable(GL_BLEND);
+	}
+}
+
+/***********************************************************
+ *  LightScene()
+ *
+ *  This method is used for drawing one triangle over the
+ *  screen with the lighting pass program.  Every pixel that
+ *  the geometry pass covered is lit and gets its depth, so
+ *  the transparent objects drawn next are hidden behind the
+ *  opaque ones.
+ ***********************************************************/
+void DeferredShading::LightScene()
+{
+	if ((NULL == m_pShaderManager) || (m_framebuffer == 0))
+	{
+		return;
+	}
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	const GLuint units[] = { g_DepthTextureUnit, g_AlbedoTextureUnit, g_NormalTextureUnit, g_EmissionTextureUnit };
+	const GLuint textures[] = { m_depthTexture, m_albedoTexture, m_normalTexture, m_emissionTexture };
+	for (int i = 0; i < 4; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + units[i]);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, g_MaterialBinding, m_materialBuffer);
+
+	m_pShaderManager->use();
+
+	// the pass replaces the color and the depth of the pixels
+	GLboolean bBlendEnabled = glIsEnabled(GL_BLEND);
+	glDisable(GL_BLEND);
+	glDepthFunc(GL_ALWAYS);
+
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glDepthFunc(GL_LESS);
+	if (bBlendEnabled)
+	{
+		glEnable(GL_BLEND);
+	}
+
+	glUseProgram((GLuint)currentProgram);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the G-buffer targets
+ *  and the framebuffer that writes them.
+ ***********************************************************/
+bool DeferredShading::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	// albedo with the lit flag, normal with the material index,
+	// and the light of unlit and lightmapped surfaces
+	const GLenum formats[g_ColorTargetCount] = { GL_RGBA8, GL_RGBA16F, GL_R11F_G11F_B10F };
+	GLuint* targets[g_ColorTargetCount] = { &m_albedoTexture, &m_normalTexture, &m_emissionTexture };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	for (int i = 0; i < g_ColorTargetCount; i++)
+	{
+		glGenTextures(1, targets[i]);
+		glBindTexture(GL_TEXTURE_2D, *targets[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, *targets[i], 0);
+	}
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: The G-buffer framebuffer is not complete" << std::endl;
+		DestroyTargets();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the G-buffer targets.
+ ***********************************************************/
+void DeferredShading::DestroyTargets()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+	}
+	GLuint* targets[] = { &m_albedoTexture, &m_normalTexture, &m_emissionTexture, &m_depthTexture };
+	for (int i = 0; i < 4; i++)
+	{
+		if (*targets[i] != 0)
+		{
+			glDeleteTextures(1, targets[i]);
+		}
+		*targets[i] = 0;
+	}
+	m_framebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredshading.h
+// ============
+// light the opaque objects once per pixel from a G-buffer
+//
+//	The geometry pass draws the opaque objects with the scene shaders
+//	into several targets at once - the albedo, the normal with the index
+//	of the material, the light of surfaces that are not lit by the
+//	shader, and the depth.  The lighting pass then runs the lighting of
+//	the scene shader once for every pixel over the whole screen, reading
+//	the lights of the pixel cluster, so overdrawn fragments are never
+//	lit.  Transparent objects are drawn forward afterwards, over the
+//	depth written by the lighting pass.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  DEFERRED_MATERIAL
+ *
+ *  A material of the lighting pass, in the std430 layout of
+ *  the DeferredMaterials buffer.  The G-buffer only keeps
+ *  the index of the material.
+ ***********************************************************/
+struct DEFERRED_MATERIAL
+{
+	// ambient color times the ambient strength
+	glm::vec4 ambientColor;
+	glm::vec4 diffuseColor;
+	// specular color and shininess
+	glm::vec4 specularShininess;
+};
+
+/***********************************************************
+ *  DeferredShading
+ *
+ *  This class holds the G-buffer, the material table and
+ *  the lighting pass program.  The light values are set on
+ *  the program returned by GetShaderManager() with the same
+ *  names as the scene shader.
+ ***********************************************************/
+class DeferredShading
+{
+public:
+	// constructor
+	DeferredShading();
+	// destructor
+	~DeferredShading();
+
+	// load the lighting pass shaders
+	bool Create();
+	// free the G-buffer, the material table and the program
+	void Destroy();
+
+	ShaderManager* GetShaderManager() { return(m_pShaderManager); }
+
+	// upload the materials that the G-buffer indexes
+	void SetMaterials(const std::vector<DEFERRED_MATERIAL>& materials);
+	// set the camera of the current frame into the lighting pass
+	void SetViewParameters(const glm::mat4& view, const glm::mat4& projection);
+
+	// bind and clear the G-buffer, sized to the current viewport,
+	// returning false when it could not be created
+	bool BeginGeometryPass();
+	// go back to the screen framebuffer
+	void EndGeometryPass();
+	// light every covered pixel of the G-buffer onto the screen
+	// and write its depth, the current program is not changed
+	void LightScene();
+
+private:
+	ShaderManager* m_pShaderManager;
+	GLuint m_framebuffer;
+	GLuint m_albedoTexture;
+	GLuint m_normalTexture;
+	GLuint m_emissionTexture;
+	GLuint m_depthTexture;
+	GLuint m_materialBuffer;
+	// the full screen triangle is built from the vertex index
+	GLuint m_vao;
+	int m_width;
+	int m_height;
+	// blending is turned off while the G-buffer is drawn
+	GLboolean m_bBlendEnabled;
+
+	// create the G-buffer targets with the passed in size
+	bool CreateTargets(int width, int height);
+	// free the G-buffer targets
+	void DestroyTargets();
+
+	// the G-buffer cannot be shared between two objects
+	DeferredShading(const DeferredShading&);
+	DeferredShading& operator=(const DeferredShading&);
+};
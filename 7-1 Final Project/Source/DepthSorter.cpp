@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthsorter.cpp
+// ============
+// order the transparent draws from the farthest to the nearest
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthSorter.h"
+
+#include <algorithm>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// values of one digit of the keys, and the digits per key
+	const int g_RadixSize = 256;
+	const int g_DigitCount = 2;
+	// the largest key, given to the nearest depth
+	const float g_MaximumKey = 65535.0f;
+}
+
+/***********************************************************
+ *  DepthSorter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthSorter::DepthSorter()
+{
+}
+
+/***********************************************************
+ *  SortBackToFront()
+ *
+ *  This method is used for sorting the indices of the
+ *  passed in depths.  Each depth becomes a key that grows
+ *  toward the camera, and the counts of both digits are
+ *  gathered in one pass over the keys.  Each digit is then
+ *  scattered in turn, the lowest first, and a digit that is
+ *  the same for every key is skipped.
+ ***********************************************************/
+const std::vector<uint32_t>& DepthSorter::SortBackToFront(const float* pDepths, size_t count)
+{
+	m_order.resize(count);
+	if (count == 0)
+	{
+		return(m_order);
+	}
+
+	float nearest = pDepths[0];
+	float farthest = pDepths[0];
+	for (size_t i = 1; i < count; i++)
+	{
+		nearest = std::min(nearest, pDepths[i]);
+		farthest = std::max(farthest, pDepths[i]);
+	}
+	float range = farthest - nearest;
+	float scale = (range > 0.0f) ? g_MaximumKey / range : 0.0f;
+
+	m_keys.resize(count);
+	m_swapKeys.resize(count);
+	m_swapOrder.resize(count);
+	// the loops work on plain pointers, which the compiler knows
+	// are not changed by the writes
+	uint16_t* pKeys = m_keys.data();
+	uint16_t* pSwapKeys = m_swapKeys.data();
+	uint32_t* pOrder = m_order.data();
+	uint32_t* pSwapOrder = m_swapOrder.data();
+
+	uint32_t counts[g_DigitCount][g_RadixSize];
+	std::memset(counts, 0, sizeof(counts));
+	for (size_t i = 0; i < count; i++)
+	{
+		float key = (farthest - pDepths[i]) * scale;
+		key = (key > 0.0f) ? ((key < g_MaximumKey) ? key : g_MaximumKey) : 0.0f;
+		uint16_t quantized = (uint16_t)(key + 0.5f);
+		pKeys[i] = quantized;
+		pOrder[i] = (uint32_t)i;
+		counts[0][quantized & 0xFF]++;
+		counts[1][quantized >> 8]++;
+	}
+
+	for (int digit = 0; digit < g_DigitCount; digit++)
+	{
+		int shift = digit * 8;
+		uint32_t* pCounts = counts[digit];
+		if (pCounts[(pKeys[0] >> shift) & 0xFF] == (uint32_t)count)
+		{
+			continue;
+		}
+
+		// turn the counts into the first slot of every value
+		uint32_t offset = 0;
+		for (int value = 0; value < g_RadixSize; value++)
+		{
+			uint32_t valueCount = pCounts[value];
+			pCounts[value] = offset;
+			offset += valueCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			uint16_t key = pKeys[i];
+			uint32_t slot = pCounts[(key >> shift) & 0xFF]++;
+			pSwapKeys[slot] = key;
+			pSwapOrder[slot] = pOrder[i];
+		}
+		std::swap(pKeys, pSwapKeys);
+		std::swap(pOrder, pSwapOrder);
+	}
+
+	// the sorted indices end up in the swap buffer after an odd
+	// number of passes
+	if (pOrder != m_order.data())
+	{
+		m_order.swap(m_swapOrder);
+	}
+
+	return(m_order);
+}
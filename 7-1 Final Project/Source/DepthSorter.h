@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthsorter.h
+// ============
+// order the transparent draws from the farthest to the nearest
+//
+//	The view depths are quantized to 16 bit keys over the range of the
+//	depths being sorted, so that a least significant digit radix sort
+//	orders them with two counting passes of one byte each.  The sort is
+//	stable, so draws closer together than a key step keep the order they
+//	were added in, and the memory is kept from one frame to the next.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  DepthSorter
+ *
+ *  This class holds the keys and the index buffers of the
+ *  radix sort, so that sorting every frame does not
+ *  allocate.
+ ***********************************************************/
+class DepthSorter
+{
+public:
+	// constructor
+	DepthSorter();
+
+	// get the indices of the passed in view depths ordered from
+	// the farthest to the nearest - the list is valid until the
+	// next sort
+	const std::vector<uint32_t>& SortBackToFront(const float* pDepths, size_t count);
+
+private:
+	std::vector<uint16_t> m_keys;
+	std::vector<uint16_t> m_swapKeys;
+	std::vector<uint32_t> m_order;
+	std::vector<uint32_t> m_swapOrder;
+};
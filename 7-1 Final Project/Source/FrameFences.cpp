@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// framefences.cpp
+// ============
+// let the CPU build a frame while the GPU is still drawing the ones before
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameFences.h"
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// longest single wait on a fence in nanoseconds, after which
+	// the wait is simply started again
+	const GLuint64 g_FenceTimeout = 100000000;
+	// seconds between two reports of the waits
+	const double g_ReportSeconds = 5.0;
+
+	// get the passed in clock duration in seconds
+	double ToSeconds(std::chrono::steady_clock::duration duration)
+	{
+		return(std::chrono::duration<double>(duration).count());
+	}
+}
+
+/***********************************************************
+ *  FrameFences()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameFences::FrameFences()
+{
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+	m_frameIndex = 0;
+	m_frameCount = 0;
+	m_stalledFrames = 0;
+	m_stallSeconds = 0.0;
+	m_longestStall = 0.0;
+	m_lastReport = Clock::now();
+}
+
+/***********************************************************
+ *  ~FrameFences()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameFences::~FrameFences()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the fences.  A deleted
+ *  fence that has not passed yet is freed by the driver
+ *  once it does.
+ ***********************************************************/
+void FrameFences::Destroy()
+{
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		if (m_fences[i] != NULL)
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = NULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving to the slot of the next
+ *  frame.  The fence of the frame that last used the slot
+ *  is checked first without waiting, and only when the GPU
+ *  is still drawing that frame are the commands flushed and
+ *  the wait timed.
+ ***********************************************************/
+int FrameFences::BeginFrame()
+{
+	m_frameIndex = (m_frameIndex + 1) % FRAMES_IN_FLIGHT;
+	m_frameCount++;
+
+	GLsync fence = m_fences[m_frameIndex];
+	if (fence != NULL)
+	{
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			Clock::time_point start = Clock::now();
+			do
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceTimeout);
+			} while (result == GL_TIMEOUT_EXPIRED);
+
+			double seconds = ToSeconds(Clock::now() - start);
+			m_stalledFrames++;
+			m_stallSeconds += seconds;
+			m_longestStall = std::max(m_longestStall, seconds);
+		}
+		if (result == GL_WAIT_FAILED)
+		{
+			std::cout << "ERROR: Failed to wait for the frame fence" << std::endl;
+		}
+
+		glDeleteSync(fence);
+		m_fences[m_frameIndex] = NULL;
+	}
+
+	ReportStalls(Clock::now());
+
+	return(m_frameIndex);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence that passes
+ *  once the GPU has run every command of the frame.
+ ***********************************************************/
+void FrameFences::EndFrame()
+{
+	if (m_fences[m_frameIndex] != NULL)
+	{
+		glDeleteSync(m_fences[m_frameIndex]);
+	}
+	m_fences[m_frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  ReportStalls()
+ *
+ *  This method is used for printing how often and for how
+ *  long the CPU waited for the GPU every few seconds, and
+ *  starting the next report over.
+ ***********************************************************/
+void FrameFences::ReportStalls(Clock::time_point now)
+{
+	if (ToSeconds(now - m_lastReport) < g_ReportSeconds)
+	{
+		return;
+	}
+
+	if (m_frameCount > 0)
+	{
+		std::cout << "INFO: Waited for the GPU in " << m_stalledFrames
+			<< " of " << m_frameCount << " frames, "
+			<< m_stallSeconds * 1000.0 / (double)m_frameCount
+			<< " ms per frame, longest " << m_longestStall * 1000.0
+			<< " ms" << std::endl;
+	}
+
+	m_lastReport = now;
+	m_frameCount = 0;
+	m_stalledFrames = 0;
+	m_stallSeconds = 0.0;
+	m_longestStall = 0.0;
+}
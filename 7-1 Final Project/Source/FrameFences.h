@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// framefences.h
+// ============
+// let the CPU build a frame while the GPU is still drawing the ones before
+//
+//	Every frame in flight has its own slot of the per frame resources,
+//	such as the regions of the stream buffers.  A fence is placed after
+//	the commands of each frame, and a slot is only handed out again once
+//	the fence of the frame that last used it has passed, so the CPU can
+//	run up to FRAMES_IN_FLIGHT frames ahead of the GPU without ever
+//	overwriting data that the GPU has yet to read.  The time spent
+//	waiting on the fences is measured, since it is the time the CPU
+//	was held up by the GPU.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+
+// most frames the CPU can be ahead of the GPU
+const int FRAMES_IN_FLIGHT = 3;
+
+/***********************************************************
+ *  FrameFences
+ *
+ *  This class holds one fence per frame in flight.
+ *  BeginFrame() is called before anything of a frame is
+ *  written, and EndFrame() after its last command.
+ ***********************************************************/
+class FrameFences
+{
+public:
+	// constructor
+	FrameFences();
+	// destructor
+	~FrameFences();
+
+	// wait until the slot of the next frame is free, and get it
+	int BeginFrame();
+	// place the fence after the commands of the current frame
+	void EndFrame();
+	// get the slot of the current frame
+	int GetFrameIndex() const { return(m_frameIndex); }
+
+	// free the fences, without waiting for them
+	void Destroy();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	GLsync m_fences[FRAMES_IN_FLIGHT];
+	int m_frameIndex;
+
+	// frames, frames that waited and time waited since the last
+	// report, and the longest single wait
+	int m_frameCount;
+	int m_stalledFrames;
+	double m_stallSeconds;
+	double m_longestStall;
+	Clock::time_point m_lastReport;
+
+	// print the waits every few seconds
+	void ReportStalls(Clock::time_point now);
+
+	// the fences cannot be shared between two objects
+	FrameFences(const FrameFences&);
+	FrameFences& operator=(const FrameFences&);
+};
@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// hold the frames to a steady rate and smooth the time between them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+#include <GL/glew.h>
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+// declaration of global variables
+namespace
+{
+	// most frame intervals kept between two reports
+	const size_t g_IntervalCapacity = 4096;
+	// fewest frame intervals that are worth reporting
+	const size_t g_MinimumReportedIntervals = 30;
+	// seconds between two reports of the frame intervals
+	const double g_ReportSeconds = 5.0;
+
+	// weight of the newest frame in the smoothed interval
+	const double g_SmoothingFactor = 0.1;
+	// longest frame interval that moves the camera, so a stall
+	// does not throw it across the scene
+	const double g_MaximumInterval = 0.1;
+	// smoothed interval before the first frame is timed
+	const double g_InitialInterval = 1.0 / 60.0;
+
+	// the spin before a deadline starts at this many seconds,
+	// grows to the longest a short sleep was seen to take, and
+	// shrinks back a little after every sleep
+	const double g_InitialSpinSeconds = 0.002;
+	const double g_MaximumSpinSeconds = 0.02;
+	const double g_SpinDecay = 0.99;
+
+	// get the passed in clock duration in seconds
+	double ToSeconds(std::chrono::steady_clock::duration duration)
+	{
+		return(std::chrono::duration<double>(duration).count());
+	}
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	m_targetFrameRate = 0.0;
+	m_lastFrame = Clock::now();
+	m_nextFrame = m_lastFrame;
+	m_bRunning = false;
+	m_spinSeconds = g_InitialSpinSeconds;
+	m_smoothedInterval = g_InitialInterval;
+	m_intervals.resize(g_IntervalCapacity, 0.0f);
+	m_intervalCount = 0;
+	m_nextInterval = 0;
+	m_lastReport = m_lastFrame;
+}
+
+/***********************************************************
+ *  SetSwapMode()
+ *
+ *  This method is used for setting the swap interval of the
+ *  current OpenGL context.  Adaptive sync waits for the
+ *  display like vsync, but swaps at once when the frame is
+ *  already late, and needs the swap control tear extension.
+ ***********************************************************/
+void FramePacer::SetSwapMode(SWAP_MODE mode)
+{
+	int swapInterval = 1;
+	if (mode == SWAP_MODE_OFF)
+	{
+		swapInterval = 0;
+	}
+	else if (mode == SWAP_MODE_ADAPTIVE)
+	{
+		if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+			glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		{
+			swapInterval = -1;
+		}
+		else
+		{
+			std::cout << "INFO: Adaptive vsync is not supported, using vsync" << std::endl;
+		}
+	}
+
+	glfwSwapInterval(swapInterval);
+}
+
+/***********************************************************
+ *  SetTargetFrameRate()
+ *
+ *  This method is used for setting the frame rate that the
+ *  frames are held to.  The next frame is timed from the
+ *  last one at the new rate.
+ ***********************************************************/
+void FramePacer::SetTargetFrameRate(double framesPerSecond)
+{
+	m_targetFrameRate = std::max(framesPerSecond, 0.0);
+	m_nextFrame = m_lastFrame;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  With a target
+ *  frame rate, each frame is due one period after the last
+ *  one was due, so that a frame that starts a little late
+ *  does not push back all of the frames after it.  A frame
+ *  that is more than a period late starts the timing over
+ *  instead of rushing to catch up.  The measured interval is
+ *  clamped the same as the smoothed one, so a stall such as
+ *  dragging the window is not made up for all at once.
+ ***********************************************************/
+float FramePacer::BeginFrame(float& measuredInterval)
+{
+	Clock::time_point now = Clock::now();
+	if (m_bRunning == false)
+	{
+		// the first frame has no interval to measure
+		m_bRunning = true;
+		m_lastFrame = now;
+		m_nextFrame = now;
+		measuredInterval = 0.0f;
+		return((float)m_smoothedInterval);
+	}
+
+	if (m_targetFrameRate > 0.0)
+	{
+		Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / m_targetFrameRate));
+		m_nextFrame += period;
+		if (m_nextFrame + period < now)
+		{
+			m_nextFrame = now;
+		}
+		WaitUntil(m_nextFrame);
+		now = Clock::now();
+	}
+
+	double interval = ToSeconds(now - m_lastFrame);
+	m_lastFrame = now;
+	RecordInterval(interval);
+
+	double clamped = std::min(interval, g_MaximumInterval);
+	m_smoothedInterval += (clamped - m_smoothedInterval) * g_SmoothingFactor;
+	measuredInterval = (float)clamped;
+
+	ReportIntervals(now);
+
+	return((float)m_smoothedInterval);
+}
+
+/***********************************************************
+ *  Restart()
+ *
+ *  This method is used for starting the timing over, so the
+ *  next frame is not measured from the last one.  The
+ *  smoothed interval is kept, since the frames are expected
+ *  to take as long as they did before the pause.
+ ***********************************************************/
+void FramePacer::Restart()
+{
+	m_bRunning = false;
+}
+
+/***********************************************************
+ *  WaitUntil()
+ *
+ *  This method is used for waiting until the passed in time.
+ *  A sleep can wake up late by as much as the resolution of
+ *  the system timer, so the wait sleeps in short steps only
+ *  while the deadline is further away than a step has lately
+ *  taken, and then spins for the rest.
+ ***********************************************************/
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+	for (;;)
+	{
+		Clock::time_point start = Clock::now();
+		if (ToSeconds(deadline - start) <= m_spinSeconds)
+		{
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		double slept = ToSeconds(Clock::now() - start);
+		m_spinSeconds = std::max(m_spinSeconds * g_SpinDecay, std::min(slept, g_MaximumSpinSeconds));
+	}
+
+	while (Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/***********************************************************
+ *  RecordInterval()
+ *
+ *  This method is used for keeping a frame interval.  When
+ *  the ring is full the oldest interval is replaced.
+ ***********************************************************/
+void FramePacer::RecordInterval(double seconds)
+{
+	m_intervals[m_nextInterval] = (float)seconds;
+	m_nextInterval = (m_nextInterval + 1) % g_IntervalCapacity;
+	m_intervalCount = std::min(m_intervalCount + 1, g_IntervalCapacity);
+}
+
+/***********************************************************
+ *  GetIntervalPercentiles()
+ *
+ *  This method is used for getting the median and the 99th
+ *  percentile of the frame intervals since the last report.
+ *  The median shows the frame rate and the 99th percentile
+ *  shows how long the worst frames take, so the further
+ *  apart they are the more unevenly the frames are paced.
+ ***********************************************************/
+bool FramePacer::GetIntervalPercentiles(double& median, double& percentile99) const
+{
+	if (m_intervalCount < g_MinimumReportedIntervals)
+	{
+		return(false);
+	}
+
+	std::vector<float> sorted(m_intervals.begin(), m_intervals.begin() + m_intervalCount);
+	size_t medianIndex = sorted.size() / 2;
+	size_t percentileIndex = (sorted.size() * 99) / 100;
+	std::nth_element(sorted.begin(), sorted.begin() + medianIndex, sorted.end());
+	median = sorted[medianIndex];
+	// the elements after the median are all at least as long
+	std::nth_element(sorted.begin() + medianIndex, sorted.begin() + percentileIndex, sorted.end());
+	percentile99 = sorted[percentileIndex];
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReportIntervals()
+ *
+ *  This method is used for printing the frame interval
+ *  percentiles every few seconds, and starting the next
+ *  report over with no intervals.
+ ***********************************************************/
+void FramePacer::ReportIntervals(Clock::time_point now)
+{
+	if (ToSeconds(now - m_lastReport) < g_ReportSeconds)
+	{
+		return;
+	}
+
+	double median = 0.0;
+	double percentile99 = 0.0;
+	if (GetIntervalPercentiles(median, percentile99))
+	{
+		std::cout << "INFO: Frame interval p50 " << median * 1000.0
+			<< " ms, p99 " << percentile99 * 1000.0
+			<< " ms over " << m_intervalCount << " frames" << std::endl;
+	}
+
+	m_lastReport = now;
+	m_intervalCount = 0;
+	m_nextInterval = 0;
+}
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// hold the frames to a steady rate and smooth the time between them
+//
+//	The buffer swap either waits for the display, tears when a frame is
+//	late with adaptive sync, or does not wait at all.  On top of that a
+//	target frame rate can be held by waiting out the rest of each frame,
+//	sleeping for most of it and spinning for the last moments, since a
+//	sleep can wake up later than asked.  Each frame gets the measured
+//	time since the last one, which the fixed updates use up so that no
+//	time is lost or counted twice, and a smoothed time for showing the
+//	frame rate.  The recent frame intervals are kept for reporting how
+//	evenly the frames are paced.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// how the buffer swap waits for the display
+enum SWAP_MODE
+{
+	SWAP_MODE_OFF,
+	SWAP_MODE_VSYNC,
+	SWAP_MODE_ADAPTIVE
+};
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class holds the frame timing of the render loop.
+ *  BeginFrame() is called once at the start of each drawn
+ *  frame.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+
+	// set how the buffer swap of the current OpenGL context
+	// waits for the display - adaptive falls back to waiting
+	// when the driver does not support it
+	void SetSwapMode(SWAP_MODE mode);
+	// set the frames per second to hold, zero for no limit
+	void SetTargetFrameRate(double framesPerSecond);
+
+	// wait for the start of the next frame, and get the smoothed
+	// time in seconds since the last frame - the measured time is
+	// set into measuredInterval, at most a tenth of a second and
+	// zero for the first frame after a restart
+	float BeginFrame(float& measuredInterval);
+	// start the timing over after no frames were drawn for a
+	// while, so the pause is not counted as a frame
+	void Restart();
+
+	// get the median and the 99th percentile of the recent frame
+	// intervals in seconds, false when too few were recorded
+	bool GetIntervalPercentiles(double& median, double& percentile99) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// the frames per second to hold, zero for no limit
+	double m_targetFrameRate;
+	// start of the last frame, and when the next one is due
+	Clock::time_point m_lastFrame;
+	Clock::time_point m_nextFrame;
+	// false until the first frame after a restart
+	bool m_bRunning;
+	// how long before a deadline the wait stops sleeping
+	double m_spinSeconds;
+	// smoothed time between frames in seconds
+	double m_smoothedInterval;
+
+	// the recent frame intervals in seconds, used as a ring
+	std::vector<float> m_intervals;
+	size_t m_intervalCount;
+	size_t m_nextInterval;
+	// when the intervals were last reported
+	Clock::time_point m_lastReport;
+
+	// sleep and then spin until the passed in time
+	void WaitUntil(Clock::time_point deadline);
+	// keep the passed in frame interval for the statistics
+	void RecordInterval(double seconds);
+	// print the interval percentiles every few seconds
+	void ReportIntervals(Clock::time_point now);
+};
@@ -0,0 +1,745 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagebasedlighting.cpp
+// ============
+// light the objects with a prefiltered environment image
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImageBasedLighting.h"
+#include "BakeCache.h"
+#include "LightmapBaker.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const char g_EnvironmentMagic[4] = { 'I', 'B', 'L', 'E' };
+	// increase when the prefiltering changes, so that older cache
+	// files are prefiltered again
+	const uint32_t g_EnvironmentCacheVersion = 1;
+
+	// size of the sharpest level of the prefiltered environment,
+	// and its number of levels down to the blurriest one
+	const int g_EnvironmentWidth = 256;
+	const int g_EnvironmentHeight = 128;
+	const int g_SpecularLevels = 6;
+	// samples of the specular lobe for every prefiltered texel
+	const int g_SpecularSampleCount = 128;
+	// size of the lookup table and the samples of every entry
+	const int g_BrdfSize = 64;
+	const int g_BrdfSampleCount = 256;
+	// samples across every texel when the loaded image is resized
+	const int g_ResampleCount = 4;
+
+	// binding points declared by the shaders
+	const GLuint g_EnvironmentBinding = 3;
+	const GLuint g_SpecularTextureUnit = 16;
+	const GLuint g_BrdfTextureUnit = 17;
+
+	// texels prefiltered per chunk of the shared pool
+	const size_t g_TexelsPerChunk = 64;
+
+	const float g_Pi = 3.14159265358979323846f;
+
+	/***********************************************************
+	 *  ENVIRONMENT_BLOCK
+	 *
+	 *  The std140 EnvironmentLighting block of the shaders.
+	 ***********************************************************/
+	struct ENVIRONMENT_BLOCK
+	{
+		// irradiance over pi as spherical harmonics
+		GLfloat harmonics[IRRADIANCE_PROBE_COEFFICIENTS][4];
+		// one when the environment is loaded, the number of
+		// prefiltered levels and the intensity
+		GLfloat parameters[4];
+	};
+
+	/***********************************************************
+	 *  ENVIRONMENT_IMAGE
+	 *
+	 *  One equirectangular image as linear RGB, row by row from
+	 *  straight down to straight up.
+	 ***********************************************************/
+	struct ENVIRONMENT_IMAGE
+	{
+		int width;
+		int height;
+		std::vector<float> texels;
+	};
+
+	/***********************************************************
+	 *  ENVIRONMENT_LIGHTING
+	 *
+	 *  The prefiltered levels, the irradiance and the lookup
+	 *  table, in the order they are stored in the cache.
+	 ***********************************************************/
+	struct ENVIRONMENT_LIGHTING
+	{
+		glm::vec3 harmonics[IRRADIANCE_PROBE_COEFFICIENTS];
+		std::vector<ENVIRONMENT_IMAGE> levels;
+		// scale and bias of the specular color, by the cosine of
+		// the view angle across and the roughness down
+		std::vector<float> brdf;
+	};
+
+	/***********************************************************
+	 *  GetDirection()
+	 *
+	 *  Get the direction at a point of the equirectangular
+	 *  layout, the same way as the shaders.
+	 ***********************************************************/
+	glm::vec3 GetDirection(float u, float v)
+	{
+		float angle = (u - 0.5f) * 2.0f * g_Pi;
+		float elevation = v * g_Pi;
+		float radius = std::sin(elevation);
+		return(glm::vec3(radius * std::cos(angle), -std::cos(elevation), radius * std::sin(angle)));
+	}
+
+	/***********************************************************
+	 *  SampleImage()
+	 *
+	 *  Read an image with bilinear filtering at a point of the
+	 *  layout, wrapping around and stopping at the poles.
+	 ***********************************************************/
+	glm::vec3 SampleImage(const ENVIRONMENT_IMAGE& image, float u, float v)
+	{
+		float x = u * (float)image.width - 0.5f;
+		float y = glm::clamp(v * (float)image.height - 0.5f, 0.0f, (float)(image.height - 1));
+		float xFloor = std::floor(x);
+		float yFloor = std::floor(y);
+		float xFraction = x - xFloor;
+		float yFraction = y - yFloor;
+
+		int x0 = ((int)xFloor % image.width + image.width) % image.width;
+		int x1 = (x0 + 1) % image.width;
+		int y0 = (int)yFloor;
+		int y1 = std::min(y0 + 1, image.height - 1);
+
+		const float* row0 = &image.texels[(size_t)y0 * (size_t)image.width * 3];
+		const float* row1 = &image.texels[(size_t)y1 * (size_t)image.width * 3];
+		glm::vec3 color(0.0f);
+		for (int c = 0; c < 3; c++)
+		{
+			float top = row0[x0 * 3 + c] + (row0[x1 * 3 + c] - row0[x0 * 3 + c]) * xFraction;
+			float bottom = row1[x0 * 3 + c] + (row1[x1 * 3 + c] - row1[x0 * 3 + c]) * xFraction;
+			color[c] = top + (bottom - top) * yFraction;
+		}
+
+		return(color);
+	}
+
+	/***********************************************************
+	 *  SampleDirection()
+	 *
+	 *  Read a chain of ever smaller images in a direction,
+	 *  blending the two levels around a fractional level.
+	 ***********************************************************/
+	glm::vec3 SampleDirection(const std::vector<ENVIRONMENT_IMAGE>& chain, glm::vec3 direction, float level)
+	{
+		float u = std::atan2(direction.z, direction.x) / (2.0f * g_Pi) + 0.5f;
+		float v = std::acos(glm::clamp(-direction.y, -1.0f, 1.0f)) / g_Pi;
+
+		level = glm::clamp(level, 0.0f, (float)(chain.size() - 1));
+		int level0 = (int)level;
+		int level1 = std::min(level0 + 1, (int)chain.size() - 1);
+		float fraction = level - (float)level0;
+
+		glm::vec3 color0 = SampleImage(chain[level0], u, v);
+		glm::vec3 color1 = SampleImage(chain[level1], u, v);
+		return(color0 + (color1 - color0) * fraction);
+	}
+
+	/***********************************************************
+	 *  GenerateSky()
+	 *
+	 *  Fill an image with a bright room color around the
+	 *  horizon, a darker floor, and a lamp in the direction of
+	 *  the directional light of the scene.  This is used when
+	 *  there is no environment file.
+	 ***********************************************************/
+	void GenerateSky(ENVIRONMENT_IMAGE& image)
+	{
+		const glm::vec3 floorColor(0.25f, 0.22f, 0.2f);
+		const glm::vec3 horizonColor(0.9f, 0.93f, 0.96f);
+		const glm::vec3 ceilingColor(0.7f, 0.78f, 0.9f);
+		const glm::vec3 lampColor(0.82f, 0.93f, 0.96f);
+		const glm::vec3 lampDirection = glm::normalize(glm::vec3(0.0f, 12.0f, 10.0f));
+
+		image.texels.resize((size_t)image.width * (size_t)image.height * 3);
+		for (int y = 0; y < image.height; y++)
+		{
+			for (int x = 0; x < image.width; x++)
+			{
+				glm::vec3 direction = GetDirection(((float)x + 0.5f) / (float)image.width, ((float)y + 0.5f) / (float)image.height);
+				glm::vec3 color = (direction.y < 0.0f) ?
+					horizonColor + (floorColor - horizonColor) * std::sqrt(-direction.y) :
+					horizonColor + (ceilingColor - horizonColor) * direction.y;
+				color = color + lampColor * (8.0f * std::pow(std::max(glm::dot(direction, lampDirection), 0.0f), 64.0f));
+
+				size_t texel = ((size_t)y * (size_t)image.width + (size_t)x) * 3;
+				image.texels[texel + 0] = color.x;
+				image.texels[texel + 1] = color.y;
+				image.texels[texel + 2] = color.z;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  ResampleImage()
+	 *
+	 *  Resize a loaded image to the size of the sharpest level,
+	 *  averaging several samples across every texel.
+	 ***********************************************************/
+	void ResampleImage(const ENVIRONMENT_IMAGE& source, ENVIRONMENT_IMAGE& image)
+	{
+		image.texels.resize((size_t)image.width * (size_t)image.height * 3);
+		ThreadPool::GetSharedPool().ParallelFor((size_t)image.height, 1,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; y++)
+				{
+					for (int x = 0; x < image.width; x++)
+					{
+						glm::vec3 color(0.0f);
+						for (int j = 0; j < g_ResampleCount; j++)
+						{
+							for (int i = 0; i < g_ResampleCount; i++)
+							{
+								float u = ((float)x + ((float)i + 0.5f) / (float)g_ResampleCount) / (float)image.width;
+								float v = ((float)y + ((float)j + 0.5f) / (float)g_ResampleCount) / (float)image.height;
+								color = color + SampleImage(source, u, v);
+							}
+						}
+						color = color * (1.0f / (float)(g_ResampleCount * g_ResampleCount));
+
+						size_t texel = (y * (size_t)image.width + (size_t)x) * 3;
+						image.texels[texel + 0] = color.x;
+						image.texels[texel + 1] = color.y;
+						image.texels[texel + 2] = color.z;
+					}
+				}
+			});
+	}
+
+	/***********************************************************
+	 *  HalveImage()
+	 *
+	 *  Get an image of half the size by averaging every two by
+	 *  two texels.
+	 ***********************************************************/
+	ENVIRONMENT_IMAGE HalveImage(const ENVIRONMENT_IMAGE& source)
+	{
+		ENVIRONMENT_IMAGE image;
+		image.width = std::max(source.width / 2, 1);
+		image.height = std::max(source.height / 2, 1);
+		image.texels.resize((size_t)image.width * (size_t)image.height * 3);
+		for (int y = 0; y < image.height; y++)
+		{
+			int y0 = std::min(y * 2, source.height - 1);
+			int y1 = std::min(y * 2 + 1, source.height - 1);
+			for (int x = 0; x < image.width; x++)
+			{
+				int x0 = std::min(x * 2, source.width - 1);
+				int x1 = std::min(x * 2 + 1, source.width - 1);
+				for (int c = 0; c < 3; c++)
+				{
+					image.texels[((size_t)y * (size_t)image.width + (size_t)x) * 3 + c] = 0.25f * (
+						source.texels[((size_t)y0 * (size_t)source.width + (size_t)x0) * 3 + c] +
+						source.texels[((size_t)y0 * (size_t)source.width + (size_t)x1) * 3 + c] +
+						source.texels[((size_t)y1 * (size_t)source.width + (size_t)x0) * 3 + c] +
+						source.texels[((size_t)y1 * (size_t)source.width + (size_t)x1) * 3 + c]);
+				}
+			}
+		}
+		return(image);
+	}
+
+	/***********************************************************
+	 *  GetHammersleyPoint()
+	 *
+	 *  Get the point of an evenly spread set of sample points
+	 *  over the unit square.
+	 ***********************************************************/
+	void GetHammersleyPoint(uint32_t index, uint32_t count, float& x, float& y)
+	{
+		uint32_t bits = index;
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+
+		x = (float)index / (float)count;
+		y = (float)bits * 2.3283064365386963e-10f;
+	}
+
+	/***********************************************************
+	 *  SampleHalfVector()
+	 *
+	 *  Pick a half vector around a normal, more often where the
+	 *  specular lobe of the roughness reflects the light.
+	 ***********************************************************/
+	glm::vec3 SampleHalfVector(float x, float y, float alpha, glm::vec3 normal)
+	{
+		float angle = 2.0f * g_Pi * x;
+		float cosTheta = std::sqrt((1.0f - y) / (1.0f + (alpha * alpha - 1.0f) * y));
+		float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+
+		glm::vec3 up = (std::fabs(normal.z) < 0.999f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+
+		return(glm::normalize(
+			tangent * (sinTheta * std::cos(angle)) +
+			bitangent * (sinTheta * std::sin(angle)) +
+			normal * cosTheta));
+	}
+
+	/***********************************************************
+	 *  PrefilterLevel()
+	 *
+	 *  Blur the environment for one roughness.  Every texel is
+	 *  the light reflected toward its own direction, summed
+	 *  over samples of the specular lobe.  The samples read
+	 *  smaller images where they are further apart, so that a
+	 *  few of them are enough without noise.
+	 ***********************************************************/
+	void PrefilterLevel(const std::vector<ENVIRONMENT_IMAGE>& chain, float roughness, ENVIRONMENT_IMAGE& image)
+	{
+		float alpha = roughness * roughness;
+		float texelSolidAngle = 4.0f * g_Pi / (float)(chain[0].width * chain[0].height);
+
+		size_t texelCount = (size_t)image.width * (size_t)image.height;
+		image.texels.resize(texelCount * 3);
+		ThreadPool::GetSharedPool().ParallelFor(texelCount, g_TexelsPerChunk,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					float u = ((float)(i % (size_t)image.width) + 0.5f) / (float)image.width;
+					float v = ((float)(i / (size_t)image.width) + 0.5f) / (float)image.height;
+					glm::vec3 normal = GetDirection(u, v);
+
+					glm::vec3 color(0.0f);
+					float weight = 0.0f;
+					for (int sample = 0; sample < g_SpecularSampleCount; sample++)
+					{
+						float x = 0.0f;
+						float y = 0.0f;
+						GetHammersleyPoint((uint32_t)sample, (uint32_t)g_SpecularSampleCount, x, y);
+						glm::vec3 halfVector = SampleHalfVector(x, y, alpha, normal);
+						float cosHalf = glm::dot(normal, halfVector);
+						glm::vec3 light = halfVector * (2.0f * cosHalf) - normal;
+						float cosLight = glm::dot(normal, light);
+						if (cosLight <= 0.0f)
+						{
+							continue;
+						}
+
+						// the view is along the normal, so the chance
+						// of the sample is a quarter of the lobe
+						float denominator = cosHalf * cosHalf * (alpha * alpha - 1.0f) + 1.0f;
+						float distribution = alpha * alpha / (g_Pi * denominator * denominator);
+						float sampleSolidAngle = 4.0f / ((float)g_SpecularSampleCount * std::max(distribution, 1.0e-6f));
+						float level = 0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f;
+
+						color = color + SampleDirection(chain, light, level) * cosLight;
+						weight += cosLight;
+					}
+					color = color * (1.0f / std::max(weight, 1.0e-6f));
+
+					image.texels[i * 3 + 0] = color.x;
+					image.texels[i * 3 + 1] = color.y;
+					image.texels[i * 3 + 2] = color.z;
+				}
+			});
+	}
+
+	/***********************************************************
+	 *  ProjectHarmonics()
+	 *
+	 *  Sum the light of every texel of an image into spherical
+	 *  harmonics, weighted by the solid angle of the texel, and
+	 *  blur them into the irradiance of a diffuse surface.
+	 ***********************************************************/
+	void ProjectHarmonics(const ENVIRONMENT_IMAGE& image, glm::vec3 harmonics[IRRADIANCE_PROBE_COEFFICIENTS])
+	{
+		std::vector<glm::vec3> rowSums((size_t)image.height * IRRADIANCE_PROBE_COEFFICIENTS, glm::vec3(0.0f));
+		ThreadPool::GetSharedPool().ParallelFor((size_t)image.height, 1,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; y++)
+				{
+					float v = ((float)y + 0.5f) / (float)image.height;
+					float solidAngle = (2.0f * g_Pi / (float)image.width) * (g_Pi / (float)image.height) * std::sin(v * g_Pi);
+					glm::vec3* pSums = &rowSums[y * IRRADIANCE_PROBE_COEFFICIENTS];
+					for (int x = 0; x < image.width; x++)
+					{
+						glm::vec3 direction = GetDirection(((float)x + 0.5f) / (float)image.width, v);
+						size_t texel = (y * (size_t)image.width + (size_t)x) * 3;
+						glm::vec3 light(image.texels[texel], image.texels[texel + 1], image.texels[texel + 2]);
+
+						float basis[IRRADIANCE_PROBE_COEFFICIENTS];
+						EvaluateIrradianceHarmonics(direction, basis);
+						for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+						{
+							pSums[j] += light * (basis[j] * solidAngle);
+						}
+					}
+				}
+			});
+
+		for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+		{
+			harmonics[j] = glm::vec3(0.0f);
+		}
+		for (size_t y = 0; y < (size_t)image.height; y++)
+		{
+			for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+			{
+				harmonics[j] += rowSums[y * IRRADIANCE_PROBE_COEFFICIENTS + j];
+			}
+		}
+		ConvolveIrradianceHarmonics(harmonics, 1.0f);
+	}
+
+	/***********************************************************
+	 *  IntegrateBrdf()
+	 *
+	 *  Fill the lookup table of the specular response.  Every
+	 *  entry holds the scale and the bias that the specular
+	 *  color gets for a view angle and a roughness, so the
+	 *  shaders only multiply it with the prefiltered light.
+	 ***********************************************************/
+	void IntegrateBrdf(std::vector<float>& brdf)
+	{
+		brdf.resize((size_t)g_BrdfSize * (size_t)g_BrdfSize * 2);
+		ThreadPool::GetSharedPool().ParallelFor((size_t)g_BrdfSize, 1,
+			[&](size_t begin, size_t end)
+			{
+				const glm::vec3 normal(0.0f, 0.0f, 1.0f);
+				for (size_t row = begin; row < end; row++)
+				{
+					float roughness = ((float)row + 0.5f) / (float)g_BrdfSize;
+					float alpha = roughness * roughness;
+					// the geometry term of image based lighting
+					float k = alpha / 2.0f;
+					for (int column = 0; column < g_BrdfSize; column++)
+					{
+						float cosView = ((float)column + 0.5f) / (float)g_BrdfSize;
+						glm::vec3 view(std::sqrt(1.0f - cosView * cosView), 0.0f, cosView);
+
+						float scale = 0.0f;
+						float bias = 0.0f;
+						for (int sample = 0; sample < g_BrdfSampleCount; sample++)
+						{
+							float x = 0.0f;
+							float y = 0.0f;
+							GetHammersleyPoint((uint32_t)sample, (uint32_t)g_BrdfSampleCount, x, y);
+							glm::vec3 halfVector = SampleHalfVector(x, y, alpha, normal);
+							float viewHalf = glm::dot(view, halfVector);
+							glm::vec3 light = halfVector * (2.0f * viewHalf) - view;
+
+							float cosLight = std::max(light.z, 0.0f);
+							float cosHalf = std::max(halfVector.z, 0.0f);
+							viewHalf = std::max(viewHalf, 0.0f);
+							if (cosLight <= 0.0f)
+							{
+								continue;
+							}
+
+							float geometry = (cosView / (cosView * (1.0f - k) + k)) * (cosLight / (cosLight * (1.0f - k) + k));
+							float visibility = geometry * viewHalf / std::max(cosHalf * cosView, 1.0e-6f);
+							float fresnel = std::pow(1.0f - viewHalf, 5.0f);
+							scale += (1.0f - fresnel) * visibility;
+							bias += fresnel * visibility;
+						}
+
+						size_t entry = (row * (size_t)g_BrdfSize + (size_t)column) * 2;
+						brdf[entry + 0] = scale / (float)g_BrdfSampleCount;
+						brdf[entry + 1] = bias / (float)g_BrdfSampleCount;
+					}
+				}
+			});
+	}
+
+	/***********************************************************
+	 *  GetCacheFloatCount()
+	 *
+	 *  Get the number of floats of a cache file with the
+	 *  current settings.
+	 ***********************************************************/
+	size_t GetCacheFloatCount()
+	{
+		size_t count = IRRADIANCE_PROBE_COEFFICIENTS * 3;
+		for (int level = 0; level < g_SpecularLevels; level++)
+		{
+			count += (size_t)(g_EnvironmentWidth >> level) * (size_t)(g_EnvironmentHeight >> level) * 3;
+		}
+		count += (size_t)g_BrdfSize * (size_t)g_BrdfSize * 2;
+		return(count);
+	}
+
+	/***********************************************************
+	 *  ReadLighting()
+	 *
+	 *  Split the floats of a cache file into the lighting.
+	 ***********************************************************/
+	void ReadLighting(const std::vector<float>& values, ENVIRONMENT_LIGHTING& lighting)
+	{
+		size_t offset = 0;
+		for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+		{
+			lighting.harmonics[j] = glm::vec3(values[offset], values[offset + 1], values[offset + 2]);
+			offset += 3;
+		}
+
+		lighting.levels.resize(g_SpecularLevels);
+		for (int level = 0; level < g_SpecularLevels; level++)
+		{
+			ENVIRONMENT_IMAGE& image = lighting.levels[level];
+			image.width = g_EnvironmentWidth >> level;
+			image.height = g_EnvironmentHeight >> level;
+			size_t count = (size_t)image.width * (size_t)image.height * 3;
+			image.texels.assign(values.begin() + offset, values.begin() + offset + count);
+			offset += count;
+		}
+
+		lighting.brdf.assign(values.begin() + offset, values.end());
+	}
+
+	/***********************************************************
+	 *  WriteLighting()
+	 *
+	 *  Put the lighting into the floats of a cache file.
+	 ***********************************************************/
+	void WriteLighting(const ENVIRONMENT_LIGHTING& lighting, std::vector<float>& values)
+	{
+		values.clear();
+		values.reserve(GetCacheFloatCount());
+		for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+		{
+			values.push_back(lighting.harmonics[j].x);
+			values.push_back(lighting.harmonics[j].y);
+			values.push_back(lighting.harmonics[j].z);
+		}
+		for (size_t level = 0; level < lighting.levels.size(); level++)
+		{
+			values.insert(values.end(), lighting.levels[level].texels.begin(), lighting.levels[level].texels.end());
+		}
+		values.insert(values.end(), lighting.brdf.begin(), lighting.brdf.end());
+	}
+}
+
+/***********************************************************
+ *  ImageBasedLighting()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImageBasedLighting::ImageBasedLighting()
+{
+	m_environmentBuffer = 0;
+	m_specularTexture = 0;
+	m_brdfTexture = 0;
+}
+
+/***********************************************************
+ *  ~ImageBasedLighting()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImageBasedLighting::~ImageBasedLighting()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for preparing the environment
+ *  lighting and binding it for the shaders.  The block is
+ *  bound first with the lighting turned off, so the shaders
+ *  keep their other ambient light when the environment
+ *  cannot be used.  The lighting is read from the cache
+ *  when the environment did not change, otherwise it is
+ *  prefiltered in parallel and stored for the next start.
+ ***********************************************************/
+bool ImageBasedLighting::Create(const char* environmentFile, const char* cacheDirectory, float intensity)
+{
+	Destroy();
+
+	ENVIRONMENT_BLOCK block = {};
+	glGenBuffers(1, &m_environmentBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_environmentBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_EnvironmentBinding, m_environmentBuffer);
+
+	// the scene textures, the G-buffer, the baked lighting and
+	// the shadows use the units below the environment
+	GLint textureUnits = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureUnits);
+	if (textureUnits <= (GLint)g_BrdfTextureUnit)
+	{
+		std::cout << "INFO: Only " << textureUnits << " texture units are available, the environment lighting is not used" << std::endl;
+		return(false);
+	}
+
+	// the sharpest level is resized from the loaded image, or
+	// generated when there is no image
+	ENVIRONMENT_IMAGE image;
+	image.width = g_EnvironmentWidth;
+	image.height = g_EnvironmentHeight;
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	float* pixels = stbi_loadf(environmentFile, &width, &height, &colorChannels, 3);
+	if (NULL != pixels)
+	{
+		ENVIRONMENT_IMAGE source;
+		source.width = width;
+		source.height = height;
+		source.texels.assign(pixels, pixels + (size_t)width * (size_t)height * 3);
+		stbi_image_free(pixels);
+		ResampleImage(source, image);
+	}
+	else
+	{
+		std::cout << "INFO: Environment image " << environmentFile << " was not found, a generated sky is used instead" << std::endl;
+		GenerateSky(image);
+	}
+
+	MESH_CACHE_KEY key("environment lighting");
+	key.AddParameter(g_EnvironmentWidth);
+	key.AddParameter(g_EnvironmentHeight);
+	key.AddParameter(g_SpecularLevels);
+	key.AddParameter(g_SpecularSampleCount);
+	key.AddParameter(g_BrdfSize);
+	key.AddParameter(g_BrdfSampleCount);
+	for (size_t i = 0; i < image.texels.size(); i++)
+	{
+		key.AddParameter(image.texels[i]);
+	}
+	std::string filename = GetBakeCacheFilename(cacheDirectory, "environment_", key.hash);
+
+	ENVIRONMENT_LIGHTING lighting;
+	BAKE_CACHE_HEADER header;
+	std::vector<float> values;
+	if (ReadBakeCacheFile(filename, g_EnvironmentMagic, g_EnvironmentCacheVersion, key.hash, header, values) &&
+		(values.size() == GetCacheFloatCount()))
+	{
+		ReadLighting(values, lighting);
+	}
+	else
+	{
+		std::cout << "INFO: Prefiltering the environment lighting" << std::endl;
+
+		// smaller and smaller copies, read by the samples of the
+		// rougher levels
+		std::vector<ENVIRONMENT_IMAGE> chain(1, image);
+		while ((chain.back().width > 1) && (chain.back().height > 1))
+		{
+			chain.push_back(HalveImage(chain.back()));
+		}
+
+		lighting.levels.resize(g_SpecularLevels);
+		lighting.levels[0] = image;
+		for (int level = 1; level < g_SpecularLevels; level++)
+		{
+			lighting.levels[level].width = g_EnvironmentWidth >> level;
+			lighting.levels[level].height = g_EnvironmentHeight >> level;
+			PrefilterLevel(chain, (float)level / (float)(g_SpecularLevels - 1), lighting.levels[level]);
+		}
+		ProjectHarmonics(image, lighting.harmonics);
+		IntegrateBrdf(lighting.brdf);
+
+		header = StartBakeCacheHeader(g_EnvironmentMagic, g_EnvironmentCacheVersion, key.hash);
+		header.sizes[0] = (uint32_t)g_EnvironmentWidth;
+		header.sizes[1] = (uint32_t)g_EnvironmentHeight;
+		header.sizes[2] = (uint32_t)g_SpecularLevels;
+		header.sizes[3] = (uint32_t)g_BrdfSize;
+		WriteLighting(lighting, values);
+		WriteBakeCacheFile(cacheDirectory, filename, header, values);
+	}
+
+	glGenTextures(1, &m_specularTexture);
+	glBindTexture(GL_TEXTURE_2D, m_specularTexture);
+	glTexStorage2D(GL_TEXTURE_2D, g_SpecularLevels, GL_RGB16F, g_EnvironmentWidth, g_EnvironmentHeight);
+	for (int level = 0; level < g_SpecularLevels; level++)
+	{
+		const ENVIRONMENT_IMAGE& levelImage = lighting.levels[level];
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, levelImage.width, levelImage.height, GL_RGB, GL_FLOAT, levelImage.texels.data());
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(1, &m_brdfTexture);
+	glBindTexture(GL_TEXTURE_2D, m_brdfTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG16F, g_BrdfSize, g_BrdfSize);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, g_BrdfSize, g_BrdfSize, GL_RG, GL_FLOAT, lighting.brdf.data());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+	{
+		block.harmonics[j][0] = lighting.harmonics[j].x;
+		block.harmonics[j][1] = lighting.harmonics[j].y;
+		block.harmonics[j][2] = lighting.harmonics[j].z;
+		block.harmonics[j][3] = 0.0f;
+	}
+	block.parameters[0] = 1.0f;
+	block.parameters[1] = (float)g_SpecularLevels;
+	block.parameters[2] = intensity;
+	block.parameters[3] = 0.0f;
+	glBindBuffer(GL_UNIFORM_BUFFER, m_environmentBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + g_SpecularTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_specularTexture);
+	glActiveTexture(GL_TEXTURE0 + g_BrdfTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_brdfTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the textures and the
+ *  block of the environment lighting.
+ ***********************************************************/
+void ImageBasedLighting::Destroy()
+{
+	GLuint* textures[] = { &m_specularTexture, &m_brdfTexture };
+	for (int i = 0; i < 2; i++)
+	{
+		if (*textures[i] != 0)
+		{
+			glDeleteTextures(1, textures[i]);
+		}
+		*textures[i] = 0;
+	}
+	if (m_environmentBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_environmentBuffer);
+	}
+	m_environmentBuffer = 0;
+}
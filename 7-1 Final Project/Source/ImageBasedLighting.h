@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagebasedlighting.h
+// ============
+// light the objects with a prefiltered environment image
+//
+//	An HDR environment in the equirectangular layout is loaded, or a
+//	sky is generated when there is no file, and turned into the three
+//	parts of image based lighting on the CPU - a mip chain that is
+//	blurred more at every level for rougher surfaces, the irradiance as
+//	spherical harmonics for the diffuse light, and a lookup table of the
+//	specular response by view angle and roughness.  The work is split
+//	across the shared thread pool and kept in a cache file, so it only
+//	runs again after the environment or the settings change, and the
+//	shaders read the results with a few texture lookups.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ImageBasedLighting
+ *
+ *  This class prepares and uploads the environment lighting.
+ *  The shaders read it from a fixed uniform block and
+ *  texture units, and keep their other ambient light until
+ *  it is created.
+ ***********************************************************/
+class ImageBasedLighting
+{
+public:
+	// constructor
+	ImageBasedLighting();
+	// destructor
+	~ImageBasedLighting();
+
+	// load the environment, or read its lighting from the cache,
+	// and bind it for the shaders scaled by the passed in intensity
+	bool Create(const char* environmentFile, const char* cacheDirectory, float intensity);
+	// free the environment lighting
+	void Destroy();
+
+private:
+	GLuint m_environmentBuffer;
+	GLuint m_specularTexture;
+	GLuint m_brdfTexture;
+
+	// the textures cannot be shared between two objects
+	ImageBasedLighting(const ImageBasedLighting&);
+	ImageBasedLighting& operator=(const ImageBasedLighting&);
+};
@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// irradianceprobes.cpp
+// ============
+// hold the baked irradiance probes for the shaders
+///////////////////////////////////////////////////////////////////////////////
+
+#include "IrradianceProbes.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// binding points declared by the shaders
+	const GLuint g_ProbeGridBinding = 2;
+	const GLuint g_ProbeTextureUnit = 13;
+
+	// texels that hold the nine colors of a probe
+	const int g_TexelsPerProbe = (IRRADIANCE_PROBE_COEFFICIENTS * 3 + 3) / 4;
+
+	/***********************************************************
+	 *  PROBE_GRID_BLOCK
+	 *
+	 *  The std140 IrradianceProbes block of the shaders.
+	 ***********************************************************/
+	struct PROBE_GRID_BLOCK
+	{
+		// position of the first probe, with one when probes
+		// are uploaded
+		GLfloat minimum[4];
+		// probes per world unit along each axis
+		GLfloat scale[4];
+		// probes along each axis
+		GLfloat counts[4];
+	};
+}
+
+/***********************************************************
+ *  IrradianceProbes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+IrradianceProbes::IrradianceProbes()
+{
+	m_gridBuffer = 0;
+	m_coefficientTexture = 0;
+}
+
+/***********************************************************
+ *  ~IrradianceProbes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+IrradianceProbes::~IrradianceProbes()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating and binding the grid
+ *  block without probes, so the shaders keep the flat
+ *  ambient light until a grid is uploaded.
+ ***********************************************************/
+bool IrradianceProbes::Create()
+{
+	Destroy();
+
+	PROBE_GRID_BLOCK block = {};
+	glGenBuffers(1, &m_gridBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_gridBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(block), &block, GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_ProbeGridBinding, m_gridBuffer);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the probes and the grid
+ *  block.
+ ***********************************************************/
+void IrradianceProbes::Destroy()
+{
+	if (m_coefficientTexture != 0)
+	{
+		glDeleteTextures(1, &m_coefficientTexture);
+	}
+	if (m_gridBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_gridBuffer);
+	}
+	m_coefficientTexture = 0;
+	m_gridBuffer = 0;
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for packing the coefficients of the
+ *  passed in grid into the 3D texture and turning the probes
+ *  on in the grid block.  The nine colors of a probe are
+ *  stored in order across seven RGBA texels, and each texel
+ *  of a probe goes into its own block of the texture along
+ *  X, so that filtering blends the same texel of each probe.
+ ***********************************************************/
+bool IrradianceProbes::Upload(const IRRADIANCE_PROBE_GRID& grid)
+{
+	size_t probeCount = (size_t)grid.countX * (size_t)grid.countY * (size_t)grid.countZ;
+	if ((m_gridBuffer == 0) || (probeCount == 0) ||
+		(grid.coefficients.size() != probeCount * IRRADIANCE_PROBE_COEFFICIENTS))
+	{
+		std::cout << "ERROR: The irradiance probes do not match their grid" << std::endl;
+		return(false);
+	}
+
+	int width = grid.countX * g_TexelsPerProbe;
+	std::vector<GLfloat> texels((size_t)width * (size_t)grid.countY * (size_t)grid.countZ * 4, 0.0f);
+	for (size_t probe = 0; probe < probeCount; probe++)
+	{
+		size_t x = probe % (size_t)grid.countX;
+		size_t row = probe / (size_t)grid.countX;
+		const glm::vec3* pCoefficients = &grid.coefficients[probe * IRRADIANCE_PROBE_COEFFICIENTS];
+		for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS * 3; j++)
+		{
+			int block = j / 4;
+			size_t texel = row * (size_t)width + (size_t)block * (size_t)grid.countX + x;
+			texels[texel * 4 + (size_t)(j % 4)] = pCoefficients[j / 3][j % 3];
+		}
+	}
+
+	if (m_coefficientTexture == 0)
+	{
+		glGenTextures(1, &m_coefficientTexture);
+	}
+	glBindTexture(GL_TEXTURE_3D, m_coefficientTexture);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, width, grid.countY, grid.countZ, 0, GL_RGBA, GL_FLOAT, texels.data());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	glm::vec3 extent = grid.maximum - grid.minimum;
+	PROBE_GRID_BLOCK block;
+	block.minimum[0] = grid.minimum.x;
+	block.minimum[1] = grid.minimum.y;
+	block.minimum[2] = grid.minimum.z;
+	block.minimum[3] = 1.0f;
+	block.scale[0] = (extent.x > 0.0f) ? (float)(grid.countX - 1) / extent.x : 0.0f;
+	block.scale[1] = (extent.y > 0.0f) ? (float)(grid.countY - 1) / extent.y : 0.0f;
+	block.scale[2] = (extent.z > 0.0f) ? (float)(grid.countZ - 1) / extent.z : 0.0f;
+	block.scale[3] = 0.0f;
+	block.counts[0] = (float)grid.countX;
+	block.counts[1] = (float)grid.countY;
+	block.counts[2] = (float)grid.countZ;
+	block.counts[3] = (float)g_TexelsPerProbe;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_gridBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_ProbeGridBinding, m_gridBuffer);
+
+	glActiveTexture(GL_TEXTURE0 + g_ProbeTextureUnit);
+	glBindTexture(GL_TEXTURE_3D, m_coefficientTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	return(true);
+}
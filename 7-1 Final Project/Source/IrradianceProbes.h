@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// irradianceprobes.h
+// ============
+// hold the baked irradiance probes for the shaders
+//
+//	The spherical harmonics of every probe are packed into one 3D
+//	texture, seven texels per probe laid side by side along X, so the
+//	hardware blends the eight probes around a point with seven lookups.
+//	The shaders sum the blended coefficients for the normal of a point,
+//	which replaces the flat ambient light of the directional light with
+//	the light bounced by the scene.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightmapBaker.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  IrradianceProbes
+ *
+ *  This class uploads a baked probe grid.  The shaders read
+ *  the grid from a fixed uniform block and texture unit, and
+ *  keep the flat ambient light until a grid is uploaded.
+ ***********************************************************/
+class IrradianceProbes
+{
+public:
+	// constructor
+	IrradianceProbes();
+	// destructor
+	~IrradianceProbes();
+
+	// create the grid block, with no probes
+	bool Create();
+	// free the probes and the grid block
+	void Destroy();
+
+	// upload the passed in baked grid
+	bool Upload(const IRRADIANCE_PROBE_GRID& grid);
+
+private:
+	GLuint m_gridBuffer;
+	GLuint m_coefficientTexture;
+
+	// the probes cannot be shared between two objects
+	IrradianceProbes(const IrradianceProbes&);
+	IrradianceProbes& operator=(const IrradianceProbes&);
+};
@@ -0,0 +1,1533 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.cpp
+// ============
+// bake the lighting of the static objects into a lightmap atlas
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightmapBaker.h"
+#include "BakeCache.h"
+#include "MeshCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	const char g_LightmapMagic[4] = { 'L', 'M', 'A', 'P' };
+	const char g_ProbeMagic[4] = { 'S', 'H', 'P', 'G' };
+	const char g_OcclusionMagic[4] = { 'A', 'O', 'V', 'L' };
+
+	// the atlas is at least this wide, the receivers are packed
+	// into rows across it
+	const int g_AtlasWidth = 1024;
+	// a receiver side is kept within these sizes in texels
+	const int g_MinimumReceiverSize = 4;
+	const int g_MaximumReceiverSize = 1024;
+	// empty texels around every receiver, filled by dilation so
+	// that the filtering never reaches another receiver
+	const int g_ReceiverPadding = 2;
+
+	// triangles in a leaf of the hierarchy
+	const GLuint g_LeafTriangles = 4;
+	// depth of the traversal stack
+	const int g_StackSize = 64;
+	// rays start this far off the surface so they do not hit it
+	const float g_RayOffset = 1.0e-3f;
+	const float g_NoHit = 1.0e30f;
+
+	// texels baked per chunk of the shared pool
+	const size_t g_TexelsPerChunk = 64;
+
+	// paths traced from every probe, over the whole sphere
+	const int g_ProbeSampleCount = 512;
+	// a probe with more of its paths starting at the back of a
+	// triangle than this lies inside an object
+	const float g_InvalidProbeBackFaces = 0.25f;
+
+	// rays cast from every point of the occlusion volume, over the
+	// whole sphere
+	const int g_OcclusionSampleCount = 128;
+	// points baked per chunk of the shared pool
+	const size_t g_OcclusionPointsPerChunk = 16;
+
+	const float g_Pi = 3.14159265358979323846f;
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  Step a xorshift generator and return a number from zero
+	 *  up to one.
+	 ***********************************************************/
+	float NextRandom(uint32_t& state)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return((float)(state >> 8) * (1.0f / 16777216.0f));
+	}
+
+	/***********************************************************
+	 *  SampleCosineDirection()
+	 *
+	 *  Pick a direction around a normal, more often near the
+	 *  normal in the same way as the light it gathers.
+	 ***********************************************************/
+	glm::vec3 SampleCosineDirection(glm::vec3 normal, uint32_t& random)
+	{
+		glm::vec3 tangent = (std::fabs(normal.x) > 0.5f) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		tangent = glm::normalize(glm::cross(tangent, normal));
+		glm::vec3 bitangent = glm::cross(normal, tangent);
+
+		float radiusSquared = NextRandom(random);
+		float angle = 2.0f * g_Pi * NextRandom(random);
+		float radius = std::sqrt(radiusSquared);
+
+		return(
+			tangent * (radius * std::cos(angle)) +
+			bitangent * (radius * std::sin(angle)) +
+			normal * std::sqrt(std::max(1.0f - radiusSquared, 0.0f)));
+	}
+
+	/***********************************************************
+	 *  SampleSphereDirection()
+	 *
+	 *  Pick a direction with the same chance over the whole
+	 *  sphere.
+	 ***********************************************************/
+	glm::vec3 SampleSphereDirection(uint32_t& random)
+	{
+		float z = 1.0f - 2.0f * NextRandom(random);
+		float angle = 2.0f * g_Pi * NextRandom(random);
+		float radius = std::sqrt(std::max(1.0f - z * z, 0.0f));
+
+		return(glm::vec3(radius * std::cos(angle), radius * std::sin(angle), z));
+	}
+
+	/***********************************************************
+	 *  GetLightFade()
+	 *
+	 *  Get how much of a point or spot light reaches a point,
+	 *  the same way as the scene fragment shader.
+	 ***********************************************************/
+	float GetLightFade(const CLUSTER_LIGHT& light, glm::vec3 toLight, float distance)
+	{
+		float range = light.positionRange.w;
+		if (distance >= range)
+		{
+			return(0.0f);
+		}
+
+		float ratio = distance / range;
+		float fade = glm::clamp(1.0f - ratio * ratio * ratio * ratio, 0.0f, 1.0f);
+		fade *= fade;
+
+		if (light.specularSpot.w > 0.5f)
+		{
+			glm::vec3 direction(light.direction.x, light.direction.y, light.direction.z);
+			float cosAngle = -glm::dot(toLight, direction);
+			float cosInner = light.ambientCosInner.w;
+			float cosOuter = light.diffuseCosOuter.w;
+			fade *= glm::clamp((cosAngle - cosOuter) / std::max(cosInner - cosOuter, 1.0e-4f), 0.0f, 1.0f);
+		}
+
+		return(fade);
+	}
+
+	/***********************************************************
+	 *  HitsBox()
+	 *
+	 *  Test a ray against a box, up to the passed in distance.
+	 ***********************************************************/
+	bool HitsBox(glm::vec3 minimum, glm::vec3 maximum, glm::vec3 origin, glm::vec3 inverseDirection, float distance)
+	{
+		float nearX = (minimum.x - origin.x) * inverseDirection.x;
+		float farX = (maximum.x - origin.x) * inverseDirection.x;
+		float nearY = (minimum.y - origin.y) * inverseDirection.y;
+		float farY = (maximum.y - origin.y) * inverseDirection.y;
+		float nearZ = (minimum.z - origin.z) * inverseDirection.z;
+		float farZ = (maximum.z - origin.z) * inverseDirection.z;
+
+		float enter = std::max(std::max(std::min(nearX, farX), std::min(nearY, farY)), std::min(nearZ, farZ));
+		float exit = std::min(std::min(std::max(nearX, farX), std::max(nearY, farY)), std::max(nearZ, farZ));
+
+		return((enter <= exit) && (exit >= 0.0f) && (enter <= distance));
+	}
+
+	/***********************************************************
+	 *  GetInverseDirection()
+	 *
+	 *  Get the inverse of every component of a ray direction,
+	 *  keeping zero components finite.
+	 ***********************************************************/
+	glm::vec3 GetInverseDirection(glm::vec3 direction)
+	{
+		const float tiny = 1.0e-20f;
+		return(glm::vec3(
+			1.0f / ((std::fabs(direction.x) > tiny) ? direction.x : tiny),
+			1.0f / ((std::fabs(direction.y) > tiny) ? direction.y : tiny),
+			1.0f / ((std::fabs(direction.z) > tiny) ? direction.z : tiny)));
+	}
+
+	/***********************************************************
+	 *  AddVector()
+	 *
+	 *  Add the components of a vector to a cache key.
+	 ***********************************************************/
+	void AddVector(MESH_CACHE_KEY& key, glm::vec3 value)
+	{
+		key.AddParameter(value.x);
+		key.AddParameter(value.y);
+		key.AddParameter(value.z);
+	}
+
+	void AddVector(MESH_CACHE_KEY& key, glm::vec4 value)
+	{
+		key.AddParameter(value.x);
+		key.AddParameter(value.y);
+		key.AddParameter(value.z);
+		key.AddParameter(value.w);
+	}
+}
+
+/***********************************************************
+ *  EvaluateIrradianceHarmonics()
+ *
+ *  Get the second order spherical harmonic functions in a
+ *  direction, in the order the shaders read them.
+ ***********************************************************/
+void EvaluateIrradianceHarmonics(glm::vec3 direction, float basis[IRRADIANCE_PROBE_COEFFICIENTS])
+{
+	float x = direction.x;
+	float y = direction.y;
+	float z = direction.z;
+
+	basis[0] = 0.282095f;
+	basis[1] = 0.488603f * y;
+	basis[2] = 0.488603f * z;
+	basis[3] = 0.488603f * x;
+	basis[4] = 1.092548f * x * y;
+	basis[5] = 1.092548f * y * z;
+	basis[6] = 0.315392f * (3.0f * z * z - 1.0f);
+	basis[7] = 1.092548f * x * z;
+	basis[8] = 0.546274f * (x * x - y * y);
+}
+
+/***********************************************************
+ *  ConvolveIrradianceHarmonics()
+ *
+ *  Scale the summed light of the samples by the solid angle
+ *  of one sample, and blur it the way a diffuse surface
+ *  does - the cosine lobe keeps less of the higher bands,
+ *  and a pi is taken out of the light.
+ ***********************************************************/
+void ConvolveIrradianceHarmonics(glm::vec3 coefficients[IRRADIANCE_PROBE_COEFFICIENTS], float sampleWeight)
+{
+	const float bandScales[IRRADIANCE_PROBE_COEFFICIENTS] = {
+		1.0f,
+		2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+		0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+	for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+	{
+		coefficients[j] *= sampleWeight * bandScales[j];
+	}
+}
+
+/***********************************************************
+ *  LightmapBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightmapBaker::LightmapBaker()
+{
+	m_texelsPerUnit = 8.0f;
+	m_sampleCount = 64;
+	m_bounceCount = 2;
+	Clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the objects and
+ *  lights, keeping the baking settings.
+ ***********************************************************/
+void LightmapBaker::Clear()
+{
+	m_triangles.clear();
+	m_receivers.clear();
+	m_sortedTriangles.clear();
+	m_nodes.clear();
+	m_lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_lightAmbient = glm::vec3(0.0f);
+	m_lightDiffuse = glm::vec3(0.0f);
+	m_lights.clear();
+}
+
+/***********************************************************
+ *  AddOccluder()
+ *
+ *  This method is used for adding the triangles of an object
+ *  in world space.  They block the light and bounce it with
+ *  the passed in color.
+ ***********************************************************/
+void LightmapBaker::AddOccluder(const MESH_DATA& mesh, const glm::mat4& model, glm::vec3 albedo)
+{
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		glm::vec3 corners[3];
+		for (int j = 0; j < 3; j++)
+		{
+			glm::vec4 position = model * glm::vec4(mesh.positions[mesh.indices[i + j]], 1.0f);
+			corners[j] = glm::vec3(position.x, position.y, position.z);
+		}
+
+		Triangle triangle;
+		triangle.vertex = corners[0];
+		triangle.edge1 = corners[1] - corners[0];
+		triangle.edge2 = corners[2] - corners[0];
+		glm::vec3 normal = glm::cross(triangle.edge1, triangle.edge2);
+		if (glm::dot(normal, normal) <= 0.0f)
+		{
+			continue;
+		}
+		triangle.normal = glm::normalize(normal);
+		triangle.albedo = albedo;
+		m_triangles.push_back(triangle);
+	}
+	m_sortedTriangles.clear();
+	m_nodes.clear();
+}
+
+/***********************************************************
+ *  AddReceiver()
+ *
+ *  This method is used for adding an object that gets its
+ *  own rectangle of the atlas.  The object also blocks and
+ *  bounces the light.  The material colors are the ones the
+ *  shader would light the object with.
+ ***********************************************************/
+int LightmapBaker::AddReceiver(
+	const MESH_DATA& mesh,
+	const glm::mat4& model,
+	glm::vec3 albedo,
+	glm::vec3 ambientColor,
+	glm::vec3 diffuseColor)
+{
+	AddOccluder(mesh, model, albedo);
+
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+
+	Receiver receiver;
+	receiver.positions.resize(mesh.positions.size());
+	receiver.normals.resize(mesh.positions.size());
+	for (size_t i = 0; i < mesh.positions.size(); i++)
+	{
+		glm::vec4 position = model * glm::vec4(mesh.positions[i], 1.0f);
+		receiver.positions[i] = glm::vec3(position.x, position.y, position.z);
+		receiver.normals[i] = glm::normalize(normalMatrix * mesh.normals[i]);
+	}
+	receiver.uvs = mesh.uvs;
+	receiver.indices = mesh.indices;
+	receiver.ambientColor = ambientColor;
+	receiver.diffuseColor = diffuseColor;
+	receiver.width = 0;
+	receiver.height = 0;
+	receiver.x = 0;
+	receiver.y = 0;
+	m_receivers.push_back(receiver);
+
+	return((int)m_receivers.size() - 1);
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for setting the directional light,
+ *  with the direction that its light travels in.
+ ***********************************************************/
+void LightmapBaker::SetDirectionalLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse)
+{
+	m_lightDirection = glm::normalize(direction);
+	m_lightAmbient = ambient;
+	m_lightDiffuse = diffuse;
+}
+
+/***********************************************************
+ *  AddLight()
+ *
+ *  This method is used for adding a point or spot light.
+ ***********************************************************/
+void LightmapBaker::AddLight(const CLUSTER_LIGHT& light)
+{
+	m_lights.push_back(light);
+}
+
+/***********************************************************
+ *  SetTexelsPerUnit()
+ *
+ *  This method is used for setting how many texels cover a
+ *  world unit of a receiver.
+ ***********************************************************/
+void LightmapBaker::SetTexelsPerUnit(float texels)
+{
+	m_texelsPerUnit = std::max(texels, 0.01f);
+}
+
+/***********************************************************
+ *  SetSampleCount()
+ *
+ *  This method is used for setting how many paths are traced
+ *  from every texel to gather the bounced light.
+ ***********************************************************/
+void LightmapBaker::SetSampleCount(int samples)
+{
+	m_sampleCount = std::max(samples, 0);
+}
+
+/***********************************************************
+ *  SetBounceCount()
+ *
+ *  This method is used for setting how many times a path can
+ *  bounce off the objects.
+ ***********************************************************/
+void LightmapBaker::SetBounceCount(int bounces)
+{
+	m_bounceCount = std::max(bounces, 0);
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for getting the atlas of the current
+ *  scene.  It is read from the cache when the scene did not
+ *  change, otherwise every texel is baked in parallel and
+ *  the atlas is stored for the next start.
+ ***********************************************************/
+bool LightmapBaker::Bake(const char* cacheDirectory, LIGHTMAP_ATLAS& atlas)
+{
+	if (m_receivers.size() == 0)
+	{
+		return(false);
+	}
+
+	uint64_t hash = GetSceneHash();
+	std::string filename = GetBakeCacheFilename(cacheDirectory, "lightmap_", hash);
+
+	BAKE_CACHE_HEADER header;
+	std::vector<float> values;
+	if (ReadBakeCacheFile(filename, g_LightmapMagic, LIGHTMAP_CACHE_VERSION, hash, header, values))
+	{
+		size_t rectFloats = (size_t)header.sizes[2] * 4;
+		size_t texelFloats = (size_t)header.sizes[0] * (size_t)header.sizes[1] * 3;
+		if ((header.sizes[2] == m_receivers.size()) && (values.size() == rectFloats + texelFloats))
+		{
+			atlas.width = (int)header.sizes[0];
+			atlas.height = (int)header.sizes[1];
+			atlas.receiverRects.resize(header.sizes[2]);
+			for (size_t i = 0; i < atlas.receiverRects.size(); i++)
+			{
+				atlas.receiverRects[i] = glm::vec4(values[4 * i], values[4 * i + 1], values[4 * i + 2], values[4 * i + 3]);
+			}
+			atlas.texels.assign(values.begin() + rectFloats, values.end());
+			return(true);
+		}
+		std::cout << "INFO: Lightmap cache file " << filename << " does not match the scene and will be baked again" << std::endl;
+	}
+
+	std::cout << "INFO: Baking the lightmaps of " << m_receivers.size() << " receivers over " << m_triangles.size() << " triangles" << std::endl;
+
+	if (m_nodes.size() == 0)
+	{
+		BuildBvh();
+	}
+	LayoutAtlas(atlas);
+
+	std::vector<Texel> texels;
+	RasterizeReceivers(atlas, texels);
+
+	atlas.texels.assign((size_t)atlas.width * (size_t)atlas.height * 3, 0.0f);
+	ThreadPool::GetSharedPool().ParallelFor(texels.size(), g_TexelsPerChunk,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				const Texel& texel = texels[i];
+				if (texel.receiver < 0)
+				{
+					continue;
+				}
+				const Receiver& receiver = m_receivers[texel.receiver];
+
+				// every texel has its own sequence, so the result
+				// does not depend on how the texels are shared out
+				uint32_t random = (uint32_t)i * 2654435761u + 1u;
+				random = (random == 0) ? 1u : random;
+
+				glm::vec3 origin = texel.position + texel.normal * g_RayOffset;
+				glm::vec3 lighting =
+					CalculateAmbientLight(texel.position, receiver) +
+					receiver.diffuseColor * (
+						CalculateDirectLight(origin, texel.normal) +
+						CalculateIndirectLight(origin, texel.normal, random));
+
+				atlas.texels[3 * i + 0] = lighting.x;
+				atlas.texels[3 * i + 1] = lighting.y;
+				atlas.texels[3 * i + 2] = lighting.z;
+			}
+		});
+
+	DilateAtlas(atlas, texels);
+
+	header = StartBakeCacheHeader(g_LightmapMagic, LIGHTMAP_CACHE_VERSION, hash);
+	header.sizes[0] = (uint32_t)atlas.width;
+	header.sizes[1] = (uint32_t)atlas.height;
+	header.sizes[2] = (uint32_t)atlas.receiverRects.size();
+	values.clear();
+	for (size_t i = 0; i < atlas.receiverRects.size(); i++)
+	{
+		values.push_back(atlas.receiverRects[i].x);
+		values.push_back(atlas.receiverRects[i].y);
+		values.push_back(atlas.receiverRects[i].z);
+		values.push_back(atlas.receiverRects[i].w);
+	}
+	values.insert(values.end(), atlas.texels.begin(), atlas.texels.end());
+	WriteBakeCacheFile(cacheDirectory, filename, header, values);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BakeProbes()
+ *
+ *  This method is used for getting the probes of the passed
+ *  in grid.  They are read from the cache when the scene and
+ *  the grid did not change, otherwise every probe traces
+ *  paths over the whole sphere in parallel.  The light of
+ *  the paths is turned into spherical harmonics, and blurred
+ *  the way a diffuse surface blurs it, so the shaders only
+ *  sum the coefficients for a normal.
+ ***********************************************************/
+bool LightmapBaker::BakeProbes(const char* cacheDirectory, IRRADIANCE_PROBE_GRID& grid)
+{
+	if ((grid.countX <= 0) || (grid.countY <= 0) || (grid.countZ <= 0))
+	{
+		return(false);
+	}
+	size_t probeCount = (size_t)grid.countX * (size_t)grid.countY * (size_t)grid.countZ;
+
+	MESH_CACHE_KEY key("irradiance probes");
+	key.AddParameter(GetSceneHash());
+	AddVector(key, grid.minimum);
+	AddVector(key, grid.maximum);
+	key.AddParameter(grid.countX);
+	key.AddParameter(grid.countY);
+	key.AddParameter(grid.countZ);
+	key.AddParameter(g_ProbeSampleCount);
+	std::string filename = GetBakeCacheFilename(cacheDirectory, "probes_", key.hash);
+
+	BAKE_CACHE_HEADER header;
+	std::vector<float> values;
+	if (ReadBakeCacheFile(filename, g_ProbeMagic, LIGHTMAP_CACHE_VERSION, key.hash, header, values) &&
+		(values.size() == probeCount * IRRADIANCE_PROBE_COEFFICIENTS * 3))
+	{
+		grid.coefficients.resize(probeCount * IRRADIANCE_PROBE_COEFFICIENTS);
+		for (size_t i = 0; i < grid.coefficients.size(); i++)
+		{
+			grid.coefficients[i] = glm::vec3(values[3 * i], values[3 * i + 1], values[3 * i + 2]);
+		}
+		return(true);
+	}
+
+	std::cout << "INFO: Baking " << probeCount << " irradiance probes over " << m_triangles.size() << " triangles" << std::endl;
+
+	if (m_nodes.size() == 0)
+	{
+		BuildBvh();
+	}
+
+	const float sampleWeight = 4.0f * g_Pi / (float)g_ProbeSampleCount;
+
+	glm::vec3 spacing(0.0f);
+	spacing.x = (grid.countX > 1) ? (grid.maximum.x - grid.minimum.x) / (float)(grid.countX - 1) : 0.0f;
+	spacing.y = (grid.countY > 1) ? (grid.maximum.y - grid.minimum.y) / (float)(grid.countY - 1) : 0.0f;
+	spacing.z = (grid.countZ > 1) ? (grid.maximum.z - grid.minimum.z) / (float)(grid.countZ - 1) : 0.0f;
+
+	grid.coefficients.assign(probeCount * IRRADIANCE_PROBE_COEFFICIENTS, glm::vec3(0.0f));
+	std::vector<unsigned char> valid(probeCount, 0);
+	ThreadPool::GetSharedPool().ParallelFor(probeCount, 1,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				int x = (int)(i % (size_t)grid.countX);
+				int y = (int)((i / (size_t)grid.countX) % (size_t)grid.countY);
+				int z = (int)(i / ((size_t)grid.countX * (size_t)grid.countY));
+				glm::vec3 position = grid.minimum + glm::vec3((float)x * spacing.x, (float)y * spacing.y, (float)z * spacing.z);
+
+				uint32_t random = (uint32_t)i * 2654435761u + 0x68E31DA4u;
+				random = (random == 0) ? 1u : random;
+
+				glm::vec3* pCoefficients = &grid.coefficients[i * IRRADIANCE_PROBE_COEFFICIENTS];
+				int backFaces = 0;
+				for (int sample = 0; sample < g_ProbeSampleCount; sample++)
+				{
+					glm::vec3 direction = SampleSphereDirection(random);
+					bool bBackFace = false;
+					// the ambient light of the directional light
+					// arrives from every direction
+					glm::vec3 light = TracePath(position, direction, random, bBackFace) + m_lightAmbient;
+					backFaces += bBackFace ? 1 : 0;
+
+					float basis[IRRADIANCE_PROBE_COEFFICIENTS];
+					EvaluateIrradianceHarmonics(direction, basis);
+					for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+					{
+						pCoefficients[j] += light * basis[j];
+					}
+				}
+
+				ConvolveIrradianceHarmonics(pCoefficients, sampleWeight);
+				valid[i] = ((float)backFaces <= g_InvalidProbeBackFaces * (float)g_ProbeSampleCount) ? 1 : 0;
+			}
+		});
+
+	FillInvalidProbes(grid, valid);
+
+	header = StartBakeCacheHeader(g_ProbeMagic, LIGHTMAP_CACHE_VERSION, key.hash);
+	header.sizes[0] = (uint32_t)grid.countX;
+	header.sizes[1] = (uint32_t)grid.countY;
+	header.sizes[2] = (uint32_t)grid.countZ;
+	values.resize(grid.coefficients.size() * 3);
+	for (size_t i = 0; i < grid.coefficients.size(); i++)
+	{
+		values[3 * i + 0] = grid.coefficients[i].x;
+		values[3 * i + 1] = grid.coefficients[i].y;
+		values[3 * i + 2] = grid.coefficients[i].z;
+	}
+	WriteBakeCacheFile(cacheDirectory, filename, header, values);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BakeOcclusion()
+ *
+ *  This method is used for getting the ambient occlusion of
+ *  the passed in volume, from the cache when the scene and
+ *  the volume did not change.  Otherwise every point casts
+ *  rays over the whole sphere in parallel and keeps the
+ *  share of them that get past the occlusion distance.  The
+ *  points inside objects, which mostly see the backs of
+ *  triangles, take the values of the points next to them.
+ ***********************************************************/
+bool LightmapBaker::BakeOcclusion(const char* cacheDirectory, OCCLUSION_VOLUME& volume)
+{
+	if ((volume.countX <= 0) || (volume.countY <= 0) || (volume.countZ <= 0) || (volume.distance <= 0.0f))
+	{
+		return(false);
+	}
+	size_t pointCount = (size_t)volume.countX * (size_t)volume.countY * (size_t)volume.countZ;
+
+	MESH_CACHE_KEY key("ambient occlusion");
+	key.AddParameter(GetSceneHash());
+	AddVector(key, volume.minimum);
+	AddVector(key, volume.maximum);
+	key.AddParameter(volume.countX);
+	key.AddParameter(volume.countY);
+	key.AddParameter(volume.countZ);
+	key.AddParameter(volume.distance);
+	key.AddParameter(g_OcclusionSampleCount);
+	std::string filename = GetBakeCacheFilename(cacheDirectory, "occlusion_", key.hash);
+
+	BAKE_CACHE_HEADER header;
+	if (ReadBakeCacheFile(filename, g_OcclusionMagic, LIGHTMAP_CACHE_VERSION, key.hash, header, volume.visibility) &&
+		(volume.visibility.size() == pointCount))
+	{
+		return(true);
+	}
+
+	std::cout << "INFO: Baking the ambient occlusion of " << pointCount << " points over " << m_triangles.size() << " triangles" << std::endl;
+
+	if (m_nodes.size() == 0)
+	{
+		BuildBvh();
+	}
+
+	glm::vec3 spacing(0.0f);
+	spacing.x = (volume.countX > 1) ? (volume.maximum.x - volume.minimum.x) / (float)(volume.countX - 1) : 0.0f;
+	spacing.y = (volume.countY > 1) ? (volume.maximum.y - volume.minimum.y) / (float)(volume.countY - 1) : 0.0f;
+	spacing.z = (volume.countZ > 1) ? (volume.maximum.z - volume.minimum.z) / (float)(volume.countZ - 1) : 0.0f;
+
+	volume.visibility.assign(pointCount, 1.0f);
+	std::vector<unsigned char> valid(pointCount, 0);
+	ThreadPool::GetSharedPool().ParallelFor(pointCount, g_OcclusionPointsPerChunk,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				int x = (int)(i % (size_t)volume.countX);
+				int y = (int)((i / (size_t)volume.countX) % (size_t)volume.countY);
+				int z = (int)(i / ((size_t)volume.countX * (size_t)volume.countY));
+				glm::vec3 position = volume.minimum + glm::vec3((float)x * spacing.x, (float)y * spacing.y, (float)z * spacing.z);
+
+				uint32_t random = (uint32_t)i * 2654435761u + 0x2C1B3C6Du;
+				random = (random == 0) ? 1u : random;
+
+				int open = 0;
+				int backFaces = 0;
+				for (int sample = 0; sample < g_OcclusionSampleCount; sample++)
+				{
+					glm::vec3 direction = SampleSphereDirection(random);
+					float distance = 0.0f;
+					GLuint hit = 0;
+					if (!FindClosestHit(position, direction, distance, hit) || (distance >= volume.distance))
+					{
+						open++;
+						continue;
+					}
+					if (glm::dot(m_sortedTriangles[hit].normal, direction) > 0.0f)
+					{
+						backFaces++;
+					}
+				}
+
+				volume.visibility[i] = (float)open / (float)g_OcclusionSampleCount;
+				valid[i] = ((float)backFaces <= g_InvalidProbeBackFaces * (float)g_OcclusionSampleCount) ? 1 : 0;
+			}
+		});
+
+	FillInvalidOcclusion(volume, valid);
+
+	header = StartBakeCacheHeader(g_OcclusionMagic, LIGHTMAP_CACHE_VERSION, key.hash);
+	header.sizes[0] = (uint32_t)volume.countX;
+	header.sizes[1] = (uint32_t)volume.countY;
+	header.sizes[2] = (uint32_t)volume.countZ;
+	WriteBakeCacheFile(cacheDirectory, filename, header, volume.visibility);
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetSceneHash()
+ *
+ *  This method is used for hashing the settings, triangles,
+ *  receivers and lights - everything the atlas depends on.
+ ***********************************************************/
+uint64_t LightmapBaker::GetSceneHash() const
+{
+	MESH_CACHE_KEY key("lightmap");
+	key.AddParameter((int)LIGHTMAP_CACHE_VERSION);
+	key.AddParameter(m_texelsPerUnit);
+	key.AddParameter(m_sampleCount);
+	key.AddParameter(m_bounceCount);
+
+	key.AddParameter((int)m_triangles.size());
+	for (size_t i = 0; i < m_triangles.size(); i++)
+	{
+		AddVector(key, m_triangles[i].vertex);
+		AddVector(key, m_triangles[i].edge1);
+		AddVector(key, m_triangles[i].edge2);
+		AddVector(key, m_triangles[i].albedo);
+	}
+
+	key.AddParameter((int)m_receivers.size());
+	for (size_t i = 0; i < m_receivers.size(); i++)
+	{
+		const Receiver& receiver = m_receivers[i];
+		key.AddParameter((int)receiver.positions.size());
+		key.AddParameter((int)receiver.indices.size());
+		for (size_t j = 0; j < receiver.positions.size(); j++)
+		{
+			AddVector(key, receiver.positions[j]);
+			AddVector(key, receiver.normals[j]);
+			key.AddParameter(receiver.uvs[j].x);
+			key.AddParameter(receiver.uvs[j].y);
+		}
+		for (size_t j = 0; j < receiver.indices.size(); j++)
+		{
+			key.AddParameter((int)receiver.indices[j]);
+		}
+		AddVector(key, receiver.ambientColor);
+		AddVector(key, receiver.diffuseColor);
+	}
+
+	AddVector(key, m_lightDirection);
+	AddVector(key, m_lightAmbient);
+	AddVector(key, m_lightDiffuse);
+	key.AddParameter((int)m_lights.size());
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		AddVector(key, m_lights[i].positionRange);
+		AddVector(key, m_lights[i].ambientCosInner);
+		AddVector(key, m_lights[i].diffuseCosOuter);
+		AddVector(key, m_lights[i].specularSpot);
+		AddVector(key, m_lights[i].direction);
+	}
+
+	return(key.hash);
+}
+
+/***********************************************************
+ *  BuildBvh()
+ *
+ *  This method is used for building the bounding volume
+ *  hierarchy over all of the triangles.  A copy of the
+ *  triangles is reordered so that every node holds a range
+ *  of them.
+ ***********************************************************/
+void LightmapBaker::BuildBvh()
+{
+	m_nodes.clear();
+	m_sortedTriangles = m_triangles;
+	if (m_sortedTriangles.size() == 0)
+	{
+		return;
+	}
+
+	m_nodes.reserve(2 * m_sortedTriangles.size() / g_LeafTriangles + 1);
+	BvhNode root;
+	root.first = 0;
+	root.count = (GLuint)m_sortedTriangles.size();
+	m_nodes.push_back(root);
+	SplitNode(0);
+}
+
+/***********************************************************
+ *  SplitNode()
+ *
+ *  This method is used for bounding the triangles of a node
+ *  and splitting them at the middle of their centers along
+ *  the longest axis, until a few triangles are left.
+ ***********************************************************/
+void LightmapBaker::SplitNode(GLuint nodeIndex)
+{
+	GLuint first = m_nodes[nodeIndex].first;
+	GLuint count = m_nodes[nodeIndex].count;
+
+	glm::vec3 minimum(g_NoHit);
+	glm::vec3 maximum(-g_NoHit);
+	glm::vec3 centerMinimum(g_NoHit);
+	glm::vec3 centerMaximum(-g_NoHit);
+	for (GLuint i = first; i < first + count; i++)
+	{
+		const Triangle& triangle = m_sortedTriangles[i];
+		glm::vec3 second = triangle.vertex + triangle.edge1;
+		glm::vec3 third = triangle.vertex + triangle.edge2;
+		minimum = glm::min(minimum, glm::min(triangle.vertex, glm::min(second, third)));
+		maximum = glm::max(maximum, glm::max(triangle.vertex, glm::max(second, third)));
+
+		glm::vec3 center = triangle.vertex + (triangle.edge1 + triangle.edge2) / 3.0f;
+		centerMinimum = glm::min(centerMinimum, center);
+		centerMaximum = glm::max(centerMaximum, center);
+	}
+	m_nodes[nodeIndex].minimum = minimum;
+	m_nodes[nodeIndex].maximum = maximum;
+
+	if (count <= g_LeafTriangles)
+	{
+		return;
+	}
+
+	glm::vec3 extent = centerMaximum - centerMinimum;
+	int axis = 0;
+	if ((extent.y > extent.x) && (extent.y >= extent.z))
+	{
+		axis = 1;
+	}
+	else if ((extent.z > extent.x) && (extent.z > extent.y))
+	{
+		axis = 2;
+	}
+	float middle = 0.5f * (centerMinimum[axis] + centerMaximum[axis]);
+
+	std::vector<Triangle>::iterator begin = m_sortedTriangles.begin() + first;
+	std::vector<Triangle>::iterator end = begin + count;
+	std::vector<Triangle>::iterator split = std::partition(begin, end,
+		[axis, middle](const Triangle& triangle)
+		{
+			glm::vec3 center = triangle.vertex + (triangle.edge1 + triangle.edge2) / 3.0f;
+			return(center[axis] < middle);
+		});
+
+	// the centers are too close to split in the middle, so the
+	// triangles are split in half by their order along the axis
+	GLuint leftCount = (GLuint)(split - begin);
+	if ((leftCount == 0) || (leftCount == count))
+	{
+		leftCount = count / 2;
+		std::nth_element(begin, begin + leftCount, end,
+			[axis](const Triangle& a, const Triangle& b)
+			{
+				return((a.vertex[axis] + (a.edge1[axis] + a.edge2[axis]) / 3.0f) <
+					(b.vertex[axis] + (b.edge1[axis] + b.edge2[axis]) / 3.0f));
+			});
+	}
+
+	GLuint leftIndex = (GLuint)m_nodes.size();
+	BvhNode left;
+	left.first = first;
+	left.count = leftCount;
+	BvhNode right;
+	right.first = first + leftCount;
+	right.count = count - leftCount;
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+
+	m_nodes[nodeIndex].first = leftIndex;
+	m_nodes[nodeIndex].count = 0;
+
+	SplitNode(leftIndex);
+	SplitNode(leftIndex + 1);
+}
+
+/***********************************************************
+ *  FindClosestHit()
+ *
+ *  This method is used for finding the closest triangle
+ *  that a ray hits.  Both sides of a triangle are hit.
+ ***********************************************************/
+bool LightmapBaker::FindClosestHit(glm::vec3 origin, glm::vec3 direction, float& distance, GLuint& triangle) const
+{
+	distance = g_NoHit;
+	if (m_nodes.size() == 0)
+	{
+		return(false);
+	}
+
+	glm::vec3 inverseDirection = GetInverseDirection(direction);
+	GLuint stack[g_StackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+		if (!HitsBox(node.minimum, node.maximum, origin, inverseDirection, distance))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			if (stackSize + 2 <= g_StackSize)
+			{
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+			continue;
+		}
+
+		for (GLuint i = node.first; i < node.first + node.count; i++)
+		{
+			const Triangle& candidate = m_sortedTriangles[i];
+			glm::vec3 p = glm::cross(direction, candidate.edge2);
+			float determinant = glm::dot(candidate.edge1, p);
+			if (std::fabs(determinant) < 1.0e-12f)
+			{
+				continue;
+			}
+			float inverseDeterminant = 1.0f / determinant;
+			glm::vec3 s = origin - candidate.vertex;
+			float u = glm::dot(s, p) * inverseDeterminant;
+			if ((u < 0.0f) || (u > 1.0f))
+			{
+				continue;
+			}
+			glm::vec3 q = glm::cross(s, candidate.edge1);
+			float v = glm::dot(direction, q) * inverseDeterminant;
+			if ((v < 0.0f) || (u + v > 1.0f))
+			{
+				continue;
+			}
+			float t = glm::dot(candidate.edge2, q) * inverseDeterminant;
+			if ((t > 0.0f) && (t < distance))
+			{
+				distance = t;
+				triangle = i;
+			}
+		}
+	}
+
+	return(distance < g_NoHit);
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for finding whether anything lies on
+ *  a ray before the passed in distance.
+ ***********************************************************/
+bool LightmapBaker::IsOccluded(glm::vec3 origin, glm::vec3 direction, float distance) const
+{
+	if (m_nodes.size() == 0)
+	{
+		return(false);
+	}
+
+	glm::vec3 inverseDirection = GetInverseDirection(direction);
+	GLuint stack[g_StackSize];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const BvhNode& node = m_nodes[stack[--stackSize]];
+		if (!HitsBox(node.minimum, node.maximum, origin, inverseDirection, distance))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			if (stackSize + 2 <= g_StackSize)
+			{
+				stack[stackSize++] = node.first;
+				stack[stackSize++] = node.first + 1;
+			}
+			continue;
+		}
+
+		for (GLuint i = node.first; i < node.first + node.count; i++)
+		{
+			const Triangle& candidate = m_sortedTriangles[i];
+			glm::vec3 p = glm::cross(direction, candidate.edge2);
+			float determinant = glm::dot(candidate.edge1, p);
+			if (std::fabs(determinant) < 1.0e-12f)
+			{
+				continue;
+			}
+			float inverseDeterminant = 1.0f / determinant;
+			glm::vec3 s = origin - candidate.vertex;
+			float u = glm::dot(s, p) * inverseDeterminant;
+			if ((u < 0.0f) || (u > 1.0f))
+			{
+				continue;
+			}
+			glm::vec3 q = glm::cross(s, candidate.edge1);
+			float v = glm::dot(direction, q) * inverseDeterminant;
+			if ((v < 0.0f) || (u + v > 1.0f))
+			{
+				continue;
+			}
+			float t = glm::dot(candidate.edge2, q) * inverseDeterminant;
+			if ((t > 0.0f) && (t < distance))
+			{
+				return(true);
+			}
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  LayoutAtlas()
+ *
+ *  This method is used for generating the lightmap UVs.  The
+ *  size of each receiver rectangle follows the world length
+ *  that its UVs span, so the texels are about the same size
+ *  on every receiver.  The rectangles are packed into rows,
+ *  tallest first, and the offset and scale that turn the
+ *  UVs of a receiver into atlas UVs are kept.
+ ***********************************************************/
+void LightmapBaker::LayoutAtlas(LIGHTMAP_ATLAS& atlas)
+{
+	int widest = 0;
+	for (size_t i = 0; i < m_receivers.size(); i++)
+	{
+		Receiver& receiver = m_receivers[i];
+
+		// the world length of one UV unit along each axis
+		float lengthU = 0.0f;
+		float lengthV = 0.0f;
+		for (size_t j = 0; j + 2 < receiver.indices.size(); j += 3)
+		{
+			GLuint a = receiver.indices[j];
+			GLuint b = receiver.indices[j + 1];
+			GLuint c = receiver.indices[j + 2];
+			glm::vec3 edge1 = receiver.positions[b] - receiver.positions[a];
+			glm::vec3 edge2 = receiver.positions[c] - receiver.positions[a];
+			glm::vec2 uvEdge1 = receiver.uvs[b] - receiver.uvs[a];
+			glm::vec2 uvEdge2 = receiver.uvs[c] - receiver.uvs[a];
+			float determinant = uvEdge1.x * uvEdge2.y - uvEdge2.x * uvEdge1.y;
+			if (std::fabs(determinant) < 1.0e-12f)
+			{
+				continue;
+			}
+			glm::vec3 alongU = (edge1 * uvEdge2.y - edge2 * uvEdge1.y) / determinant;
+			glm::vec3 alongV = (edge2 * uvEdge1.x - edge1 * uvEdge2.x) / determinant;
+			lengthU = std::max(lengthU, glm::length(alongU));
+			lengthV = std::max(lengthV, glm::length(alongV));
+		}
+
+		receiver.width = std::min(std::max((int)std::ceil(lengthU * m_texelsPerUnit), g_MinimumReceiverSize), g_MaximumReceiverSize);
+		receiver.height = std::min(std::max((int)std::ceil(lengthV * m_texelsPerUnit), g_MinimumReceiverSize), g_MaximumReceiverSize);
+		widest = std::max(widest, receiver.width + 2 * g_ReceiverPadding);
+	}
+
+	std::vector<size_t> order(m_receivers.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(),
+		[this](size_t a, size_t b)
+		{
+			return(m_receivers[a].height > m_receivers[b].height);
+		});
+
+	atlas.width = std::max(g_AtlasWidth, widest);
+	int x = 0;
+	int y = 0;
+	int rowHeight = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		Receiver& receiver = m_receivers[order[i]];
+		int paddedWidth = receiver.width + 2 * g_ReceiverPadding;
+		int paddedHeight = receiver.height + 2 * g_ReceiverPadding;
+		if (x + paddedWidth > atlas.width)
+		{
+			x = 0;
+			y += rowHeight;
+			rowHeight = 0;
+		}
+		receiver.x = x + g_ReceiverPadding;
+		receiver.y = y + g_ReceiverPadding;
+		x += paddedWidth;
+		rowHeight = std::max(rowHeight, paddedHeight);
+	}
+	// rows of four texels keep the uploads aligned
+	atlas.height = (y + rowHeight + 3) / 4 * 4;
+
+	atlas.receiverRects.resize(m_receivers.size());
+	for (size_t i = 0; i < m_receivers.size(); i++)
+	{
+		const Receiver& receiver = m_receivers[i];
+		atlas.receiverRects[i] = glm::vec4(
+			(float)receiver.x / (float)atlas.width,
+			(float)receiver.y / (float)atlas.height,
+			(float)receiver.width / (float)atlas.width,
+			(float)receiver.height / (float)atlas.height);
+	}
+}
+
+/***********************************************************
+ *  RasterizeReceivers()
+ *
+ *  This method is used for drawing the triangles of every
+ *  receiver into its atlas rectangle, keeping the world
+ *  position and normal at the center of each covered texel.
+ ***********************************************************/
+void LightmapBaker::RasterizeReceivers(const LIGHTMAP_ATLAS& atlas, std::vector<Texel>& texels) const
+{
+	Texel empty;
+	empty.position = glm::vec3(0.0f);
+	empty.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+	empty.receiver = -1;
+	texels.assign((size_t)atlas.width * (size_t)atlas.height, empty);
+
+	for (size_t r = 0; r < m_receivers.size(); r++)
+	{
+		const Receiver& receiver = m_receivers[r];
+		for (size_t j = 0; j + 2 < receiver.indices.size(); j += 3)
+		{
+			GLuint corners[3] = { receiver.indices[j], receiver.indices[j + 1], receiver.indices[j + 2] };
+			glm::vec2 points[3];
+			for (int k = 0; k < 3; k++)
+			{
+				glm::vec2 uv = receiver.uvs[corners[k]];
+				points[k] = glm::vec2(
+					(float)receiver.x + uv.x * (float)receiver.width,
+					(float)receiver.y + uv.y * (float)receiver.height);
+			}
+
+			float area = (points[1].x - points[0].x) * (points[2].y - points[0].y) -
+				(points[2].x - points[0].x) * (points[1].y - points[0].y);
+			if (std::fabs(area) < 1.0e-12f)
+			{
+				continue;
+			}
+
+			int minimumX = std::max((int)std::floor(std::min(points[0].x, std::min(points[1].x, points[2].x))), receiver.x);
+			int maximumX = std::min((int)std::ceil(std::max(points[0].x, std::max(points[1].x, points[2].x))), receiver.x + receiver.width - 1);
+			int minimumY = std::max((int)std::floor(std::min(points[0].y, std::min(points[1].y, points[2].y))), receiver.y);
+			int maximumY = std::min((int)std::ceil(std::max(points[0].y, std::max(points[1].y, points[2].y))), receiver.y + receiver.height - 1);
+
+			for (int py = minimumY; py <= maximumY; py++)
+			{
+				for (int px = minimumX; px <= maximumX; px++)
+				{
+					glm::vec2 center((float)px + 0.5f, (float)py + 0.5f);
+					float weights[3];
+					for (int k = 0; k < 3; k++)
+					{
+						const glm::vec2& a = points[(k + 1) % 3];
+						const glm::vec2& b = points[(k + 2) % 3];
+						weights[k] = ((b.x - a.x) * (center.y - a.y) - (center.x - a.x) * (b.y - a.y)) / area;
+					}
+					if ((weights[0] < -1.0e-4f) || (weights[1] < -1.0e-4f) || (weights[2] < -1.0e-4f))
+					{
+						continue;
+					}
+
+					Texel& texel = texels[(size_t)py * (size_t)atlas.width + (size_t)px];
+					texel.position =
+						receiver.positions[corners[0]] * weights[0] +
+						receiver.positions[corners[1]] * weights[1] +
+						receiver.positions[corners[2]] * weights[2];
+					texel.normal = glm::normalize(
+						receiver.normals[corners[0]] * weights[0] +
+						receiver.normals[corners[1]] * weights[1] +
+						receiver.normals[corners[2]] * weights[2]);
+					texel.receiver = (int)r;
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  CalculateDirectLight()
+ *
+ *  This method is used for adding up the diffuse light that
+ *  reaches a point straight from every light, with a shadow
+ *  ray toward each light.
+ ***********************************************************/
+glm::vec3 LightmapBaker::CalculateDirectLight(glm::vec3 position, glm::vec3 normal) const
+{
+	glm::vec3 light(0.0f);
+
+	glm::vec3 toSun = -m_lightDirection;
+	float sunImpact = glm::dot(normal, toSun);
+	if ((sunImpact > 0.0f) && !IsOccluded(position, toSun, g_NoHit))
+	{
+		light += m_lightDiffuse * sunImpact;
+	}
+
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		const CLUSTER_LIGHT& pointLight = m_lights[i];
+		glm::vec3 toLight = glm::vec3(pointLight.positionRange.x, pointLight.positionRange.y, pointLight.positionRange.z) - position;
+		float distance = glm::length(toLight);
+		if (distance < 1.0e-4f)
+		{
+			continue;
+		}
+		toLight /= distance;
+
+		float impact = glm::dot(normal, toLight);
+		float fade = GetLightFade(pointLight, toLight, distance);
+		if ((impact <= 0.0f) || (fade <= 0.0f) || IsOccluded(position, toLight, distance))
+		{
+			continue;
+		}
+		light += glm::vec3(pointLight.diffuseCosOuter.x, pointLight.diffuseCosOuter.y, pointLight.diffuseCosOuter.z) * (impact * fade);
+	}
+
+	return(light);
+}
+
+/***********************************************************
+ *  CalculateIndirectLight()
+ *
+ *  This method is used for gathering the light bounced onto
+ *  a point, with paths that start in random directions
+ *  around the normal.
+ ***********************************************************/
+glm::vec3 LightmapBaker::CalculateIndirectLight(glm::vec3 position, glm::vec3 normal, uint32_t& random) const
+{
+	if ((m_sampleCount == 0) || (m_bounceCount == 0))
+	{
+		return(glm::vec3(0.0f));
+	}
+
+	glm::vec3 light(0.0f);
+	for (int sample = 0; sample < m_sampleCount; sample++)
+	{
+		bool bBackFace = false;
+		light += TracePath(position, SampleCosineDirection(normal, random), random, bBackFace);
+	}
+
+	return(light / (float)m_sampleCount);
+}
+
+/***********************************************************
+ *  TracePath()
+ *
+ *  This method is used for following a path from a point.
+ *  At every object it hits the direct light there is added,
+ *  dimmed by the colors of the objects on the way, and the
+ *  path bounces on in a random direction around the normal.
+ ***********************************************************/
+glm::vec3 LightmapBaker::TracePath(glm::vec3 origin, glm::vec3 direction, uint32_t& random, bool& bBackFace) const
+{
+	glm::vec3 light(0.0f);
+	glm::vec3 throughput(1.0f);
+	bBackFace = false;
+
+	for (int bounce = 0; bounce < m_bounceCount; bounce++)
+	{
+		float distance = 0.0f;
+		GLuint hit = 0;
+		if (!FindClosestHit(origin, direction, distance, hit))
+		{
+			break;
+		}
+
+		const Triangle& triangle = m_sortedTriangles[hit];
+		bool bBehind = (glm::dot(triangle.normal, direction) > 0.0f);
+		if (bounce == 0)
+		{
+			bBackFace = bBehind;
+		}
+		glm::vec3 hitNormal = bBehind ? -triangle.normal : triangle.normal;
+		glm::vec3 hitPosition = origin + direction * distance + hitNormal * g_RayOffset;
+
+		throughput = throughput * triangle.albedo;
+		light += throughput * CalculateDirectLight(hitPosition, hitNormal);
+
+		origin = hitPosition;
+		direction = SampleCosineDirection(hitNormal, random);
+	}
+
+	return(light);
+}
+
+/***********************************************************
+ *  CalculateAmbientLight()
+ *
+ *  This method is used for adding up the ambient light of
+ *  the lights with the ambient color of a receiver, the same
+ *  way as the scene fragment shader.
+ ***********************************************************/
+glm::vec3 LightmapBaker::CalculateAmbientLight(glm::vec3 position, const Receiver& receiver) const
+{
+	glm::vec3 light = m_lightAmbient;
+
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		const CLUSTER_LIGHT& pointLight = m_lights[i];
+		glm::vec3 toLight = glm::vec3(pointLight.positionRange.x, pointLight.positionRange.y, pointLight.positionRange.z) - position;
+		float distance = glm::length(toLight);
+		if (distance < 1.0e-4f)
+		{
+			continue;
+		}
+		float fade = GetLightFade(pointLight, toLight / distance, distance);
+		light += glm::vec3(pointLight.ambientCosInner.x, pointLight.ambientCosInner.y, pointLight.ambientCosInner.z) * fade;
+	}
+
+	return(light * receiver.ambientColor);
+}
+
+/***********************************************************
+ *  DilateAtlas()
+ *
+ *  This method is used for filling the empty texels next to
+ *  the covered ones with the average of their neighbors, a
+ *  ring at a time, as far as the padding reaches.
+ ***********************************************************/
+void LightmapBaker::DilateAtlas(LIGHTMAP_ATLAS& atlas, const std::vector<Texel>& texels) const
+{
+	std::vector<unsigned char> filled(texels.size());
+	for (size_t i = 0; i < texels.size(); i++)
+	{
+		filled[i] = (texels[i].receiver >= 0) ? 1 : 0;
+	}
+
+	std::vector<float> source;
+	std::vector<unsigned char> sourceFilled;
+	for (int pass = 0; pass < g_ReceiverPadding + 1; pass++)
+	{
+		source = atlas.texels;
+		sourceFilled = filled;
+
+		for (int y = 0; y < atlas.height; y++)
+		{
+			for (int x = 0; x < atlas.width; x++)
+			{
+				size_t index = (size_t)y * (size_t)atlas.width + (size_t)x;
+				if (sourceFilled[index])
+				{
+					continue;
+				}
+
+				glm::vec3 sum(0.0f);
+				int count = 0;
+				for (int dy = -1; dy <= 1; dy++)
+				{
+					for (int dx = -1; dx <= 1; dx++)
+					{
+						int nx = x + dx;
+						int ny = y + dy;
+						if ((nx < 0) || (ny < 0) || (nx >= atlas.width) || (ny >= atlas.height))
+						{
+							continue;
+						}
+						size_t neighbor = (size_t)ny * (size_t)atlas.width + (size_t)nx;
+						if (sourceFilled[neighbor])
+						{
+							sum += glm::vec3(source[3 * neighbor], source[3 * neighbor + 1], source[3 * neighbor + 2]);
+							count++;
+						}
+					}
+				}
+
+				if (count > 0)
+				{
+					sum /= (float)count;
+					atlas.texels[3 * index + 0] = sum.x;
+					atlas.texels[3 * index + 1] = sum.y;
+					atlas.texels[3 * index + 2] = sum.z;
+					filled[index] = 1;
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  FillInvalidProbes()
+ *
+ *  This method is used for replacing the probes that lie
+ *  inside objects, which only see the backs of triangles,
+ *  with the average of the valid probes next to them.  The
+ *  probes are filled a layer at a time until none are left
+ *  that have a valid neighbor.
+ ***********************************************************/
+void LightmapBaker::FillInvalidProbes(IRRADIANCE_PROBE_GRID& grid, std::vector<unsigned char>& valid) const
+{
+	const int offsets[6][3] = {
+		{ -1, 0, 0 }, { 1, 0, 0 },
+		{ 0, -1, 0 }, { 0, 1, 0 },
+		{ 0, 0, -1 }, { 0, 0, 1 } };
+
+	bool bFilled = true;
+	while (bFilled)
+	{
+		bFilled = false;
+		std::vector<unsigned char> source = valid;
+
+		for (int z = 0; z < grid.countZ; z++)
+		{
+			for (int y = 0; y < grid.countY; y++)
+			{
+				for (int x = 0; x < grid.countX; x++)
+				{
+					size_t index = (size_t)x + (size_t)grid.countX * ((size_t)y + (size_t)grid.countY * (size_t)z);
+					if (source[index])
+					{
+						continue;
+					}
+
+					glm::vec3 sum[IRRADIANCE_PROBE_COEFFICIENTS];
+					for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+					{
+						sum[j] = glm::vec3(0.0f);
+					}
+					int count = 0;
+					for (int k = 0; k < 6; k++)
+					{
+						int nx = x + offsets[k][0];
+						int ny = y + offsets[k][1];
+						int nz = z + offsets[k][2];
+						if ((nx < 0) || (ny < 0) || (nz < 0) || (nx >= grid.countX) || (ny >= grid.countY) || (nz >= grid.countZ))
+						{
+							continue;
+						}
+						size_t neighbor = (size_t)nx + (size_t)grid.countX * ((size_t)ny + (size_t)grid.countY * (size_t)nz);
+						if (source[neighbor])
+						{
+							for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+							{
+								sum[j] += grid.coefficients[neighbor * IRRADIANCE_PROBE_COEFFICIENTS + j];
+							}
+							count++;
+						}
+					}
+
+					if (count > 0)
+					{
+						for (int j = 0; j < IRRADIANCE_PROBE_COEFFICIENTS; j++)
+						{
+							grid.coefficients[index * IRRADIANCE_PROBE_COEFFICIENTS + j] = sum[j] / (float)count;
+						}
+						valid[index] = 1;
+						bFilled = true;
+					}
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  FillInvalidOcclusion()
+ *
+ *  This method is used for replacing the points of the
+ *  occlusion volume that lie inside objects with the
+ *  average of the valid points next to them, a layer at a
+ *  time like the probes.  Without it the points inside the
+ *  objects would darken the open points that are blended
+ *  with them.
+ ***********************************************************/
+void LightmapBaker::FillInvalidOcclusion(OCCLUSION_VOLUME& volume, std::vector<unsigned char>& valid) const
+{
+	const int offsets[6][3] = {
+		{ -1, 0, 0 }, { 1, 0, 0 },
+		{ 0, -1, 0 }, { 0, 1, 0 },
+		{ 0, 0, -1 }, { 0, 0, 1 } };
+
+	bool bFilled = true;
+	while (bFilled)
+	{
+		bFilled = false;
+		std::vector<unsigned char> source = valid;
+
+		for (int z = 0; z < volume.countZ; z++)
+		{
+			for (int y = 0; y < volume.countY; y++)
+			{
+				for (int x = 0; x < volume.countX; x++)
+				{
+					size_t index = (size_t)x + (size_t)volume.countX * ((size_t)y + (size_t)volume.countY * (size_t)z);
+					if (source[index])
+					{
+						continue;
+					}
+
+					float sum = 0.0f;
+					int count = 0;
+					for (int k = 0; k < 6; k++)
+					{
+						int nx = x + offsets[k][0];
+						int ny = y + offsets[k][1];
+						int nz = z + offsets[k][2];
+						if ((nx < 0) || (ny < 0) || (nz < 0) || (nx >= volume.countX) || (ny >= volume.countY) || (nz >= volume.countZ))
+						{
+							continue;
+						}
+						size_t neighbor = (size_t)nx + (size_t)volume.countX * ((size_t)ny + (size_t)volume.countY * (size_t)nz);
+						if (source[neighbor])
+						{
+							sum += volume.visibility[neighbor];
+							count++;
+						}
+					}
+
+					if (count > 0)
+					{
+						volume.visibility[index] = sum / (float)count;
+						valid[index] = 1;
+						bFilled = true;
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.h
+// ============
+// bake the lighting of the static objects into a lightmap atlas
+//
+//	The static objects are collected into one triangle list with a
+//	bounding volume hierarchy over it.  Every texel of a receiver is lit
+//	by the directional light and the point and spot lights with traced
+//	shadows, and by the light that bounces off the other objects, which
+//	is found by tracing random paths from the texel.  The texels are
+//	shared across all of the processor cores.
+//
+//	Each receiver gets a rectangle of one atlas, so the shader reads
+//	the lighting of a receiver with a single lookup instead of
+//	evaluating the lights.  The same paths also fill a grid of
+//	irradiance probes, which hold the light arriving from every
+//	direction as spherical harmonics, for the objects without a
+//	lightmap, and a finer volume of ambient occlusion holds how much of
+//	the space around each point is closed off by nearby objects.  All
+//	of them are kept in cache files named after a hash of the scene, so
+//	the baking only runs again after the objects, the materials or the
+//	lights change.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ClusteredLights.h"
+#include "MeshData.h"
+
+#include <cstdint>
+#include <vector>
+
+// increase when the baking changes, so that older cache files are
+// baked again
+const uint32_t LIGHTMAP_CACHE_VERSION = 1;
+
+// coefficients of the second order spherical harmonics per probe
+const int IRRADIANCE_PROBE_COEFFICIENTS = 9;
+
+/***********************************************************
+ *  LIGHTMAP_ATLAS
+ *
+ *  The baked lighting of all of the receivers, and where
+ *  each receiver lies in the atlas.
+ ***********************************************************/
+struct LIGHTMAP_ATLAS
+{
+	int width;
+	int height;
+	// lighting of every texel as linear RGB, row by row - the
+	// shader multiplies it by the color of the object
+	std::vector<float> texels;
+	// offset and scale from the UVs of each receiver to the atlas
+	std::vector<glm::vec4> receiverRects;
+};
+
+/***********************************************************
+ *  IRRADIANCE_PROBE_GRID
+ *
+ *  A box of evenly spaced probes.  The bounds and counts are
+ *  set before baking, and every probe gets the coefficients
+ *  of the diffuse light it would reflect toward any normal,
+ *  divided by pi like the light colors of the shaders.
+ ***********************************************************/
+struct IRRADIANCE_PROBE_GRID
+{
+	// positions of the first and the last probe
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+	int countX;
+	int countY;
+	int countZ;
+	// IRRADIANCE_PROBE_COEFFICIENTS colors per probe, with the
+	// probes ordered along X, then Y, then Z
+	std::vector<glm::vec3> coefficients;
+};
+
+/***********************************************************
+ *  OCCLUSION_VOLUME
+ *
+ *  A box of evenly spaced points, set before baking like
+ *  the probe grid.  Every point gets the share of the
+ *  directions around it that travel the occlusion distance
+ *  without hitting an object.
+ ***********************************************************/
+struct OCCLUSION_VOLUME
+{
+	// positions of the first and the last point
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+	int countX;
+	int countY;
+	int countZ;
+	// objects further away than this do not darken a point
+	float distance;
+	// open share of every point from zero up to one, with the
+	// points ordered along X, then Y, then Z
+	std::vector<float> visibility;
+};
+
+// get the spherical harmonic functions of a direction, in the order
+// the shaders read them
+void EvaluateIrradianceHarmonics(glm::vec3 direction, float basis[IRRADIANCE_PROBE_COEFFICIENTS]);
+// turn the summed light of evenly spread samples, each weighted by
+// the passed in solid angle, into the coefficients of a probe
+void ConvolveIrradianceHarmonics(glm::vec3 coefficients[IRRADIANCE_PROBE_COEFFICIENTS], float sampleWeight);
+
+/***********************************************************
+ *  LightmapBaker
+ *
+ *  This class collects the static objects and the lights of
+ *  the scene and bakes the lighting of the receivers.  It
+ *  only runs on the CPU.
+ ***********************************************************/
+class LightmapBaker
+{
+public:
+	// constructor
+	LightmapBaker();
+
+	// remove all of the objects and lights
+	void Clear();
+
+	// add an object that blocks and bounces the light, with the
+	// passed in color of its diffuse reflection
+	void AddOccluder(const MESH_DATA& mesh, const glm::mat4& model, glm::vec3 albedo);
+	// add an object that also gets a rectangle of the atlas - its
+	// UVs must cover every point of its surface only once.  The
+	// index of the receiver in the atlas is returned.
+	int AddReceiver(
+		const MESH_DATA& mesh,
+		const glm::mat4& model,
+		glm::vec3 albedo,
+		glm::vec3 ambientColor,
+		glm::vec3 diffuseColor);
+
+	// set the direction that the directional light travels in
+	void SetDirectionalLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse);
+	// add a point or spot light
+	void AddLight(const CLUSTER_LIGHT& light);
+
+	// set the texel density, the number of paths traced from each
+	// texel and the number of times a path bounces
+	void SetTexelsPerUnit(float texels);
+	void SetSampleCount(int samples);
+	void SetBounceCount(int bounces);
+
+	// read the atlas of the scene from the cache directory, or bake
+	// it and store it there
+	bool Bake(const char* cacheDirectory, LIGHTMAP_ATLAS& atlas);
+	// the same for the probes of the passed in grid
+	bool BakeProbes(const char* cacheDirectory, IRRADIANCE_PROBE_GRID& grid);
+	// the same for the ambient occlusion of the passed in volume
+	bool BakeOcclusion(const char* cacheDirectory, OCCLUSION_VOLUME& volume);
+
+private:
+	// a triangle ready for ray tests
+	struct Triangle
+	{
+		glm::vec3 vertex;
+		glm::vec3 edge1;
+		glm::vec3 edge2;
+		glm::vec3 normal;
+		glm::vec3 albedo;
+	};
+
+	// a receiver in world space with its material
+	struct Receiver
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+		std::vector<GLuint> indices;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		// size and first texel of its rectangle in the atlas
+		int width;
+		int height;
+		int x;
+		int y;
+	};
+
+	// a node of the hierarchy - leaves hold a range of triangles,
+	// other nodes the index of their first child
+	struct BvhNode
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+		GLuint first;
+		GLuint count;
+	};
+
+	// the surface point of a texel
+	struct Texel
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		int receiver;
+	};
+
+	std::vector<Triangle> m_triangles;
+	std::vector<Receiver> m_receivers;
+	// the triangles reordered for the hierarchy, so the order they
+	// were added in and the scene hash do not change
+	std::vector<Triangle> m_sortedTriangles;
+	std::vector<BvhNode> m_nodes;
+
+	glm::vec3 m_lightDirection;
+	glm::vec3 m_lightAmbient;
+	glm::vec3 m_lightDiffuse;
+	std::vector<CLUSTER_LIGHT> m_lights;
+
+	float m_texelsPerUnit;
+	int m_sampleCount;
+	int m_bounceCount;
+
+	// hash of everything that changes the baked atlas
+	uint64_t GetSceneHash() const;
+
+	// build the hierarchy over all of the triangles
+	void BuildBvh();
+	void SplitNode(GLuint nodeIndex);
+	// find the closest triangle along a ray, or any triangle
+	// before the passed in distance
+	bool FindClosestHit(glm::vec3 origin, glm::vec3 direction, float& distance, GLuint& triangle) const;
+	bool IsOccluded(glm::vec3 origin, glm::vec3 direction, float distance) const;
+
+	// size the receiver rectangles and pack them into the atlas
+	void LayoutAtlas(LIGHTMAP_ATLAS& atlas);
+	// find the surface point of every texel covered by a receiver
+	void RasterizeReceivers(const LIGHTMAP_ATLAS& atlas, std::vector<Texel>& texels) const;
+	// light reaching a point straight from the lights
+	glm::vec3 CalculateDirectLight(glm::vec3 position, glm::vec3 normal) const;
+	// light bounced onto a point by the other objects
+	glm::vec3 CalculateIndirectLight(glm::vec3 position, glm::vec3 normal, uint32_t& random) const;
+	// light arriving at a point along one random path, and whether
+	// the path starts at the back of a triangle
+	glm::vec3 TracePath(glm::vec3 origin, glm::vec3 direction, uint32_t& random, bool& bBackFace) const;
+	// ambient light of the lights, with the material of a receiver
+	glm::vec3 CalculateAmbientLight(glm::vec3 position, const Receiver& receiver) const;
+	// spread the covered texels into the empty ones around them,
+	// so that filtering does not blend in black
+	void DilateAtlas(LIGHTMAP_ATLAS& atlas, const std::vector<Texel>& texels) const;
+	// give the probes inside objects the light of the probes next
+	// to them
+	void FillInvalidProbes(IRRADIANCE_PROBE_GRID& grid, std::vector<unsigned char>& valid) const;
+	// the same for the points of the occlusion volume
+	void FillInvalidOcclusion(OCCLUSION_VOLUME& volume, std::vector<unsigned char>& valid) const;
+};
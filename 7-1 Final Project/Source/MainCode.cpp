@@ -1,5 +1,6 @@
 #include <iostream>         // error handling and output
-#include <cstdlib>          // EXIT_FAILURE
+#include <cstdlib>          // EXIT_FAILURE, atof
+#include <cstring>          // strcmp, strncmp
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -11,8 +12,8 @@
 
 #include "SceneManager.h"
 #include "ViewManager.h"
-#include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderProgram.h"
 
 // Namespace for declaring global variables
 namespace
@@ -23,6 +24,18 @@ namespace
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 
+	// command line option that draws every frame, for benchmarks,
+	// instead of only the frames after something changed
+	const char* const CONTINUOUS_OPTION = "--continuous";
+	// command line options that hold the frames to a rate, such as
+	// --fps=60, and choose whether the swap waits for the display
+	// with --vsync=off, --vsync=on or --vsync=adaptive
+	const char* const FPS_OPTION = "--fps=";
+	const char* const VSYNC_OPTION = "--vsync=";
+	// command line option that imports an OBJ or GLB file into the
+	// scene, such as --mesh=./Meshes/statue.glb
+	const char* const MESH_OPTION = "--mesh=";
+
 	// scene manager object for managing the 3D scene prepare and render
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
@@ -60,26 +73,71 @@ int main(int argc, char* argv[])
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
 
+	const char* importedMeshFile = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], CONTINUOUS_OPTION) == 0)
+		{
+			g_ViewManager->SetContinuousRendering(true);
+		}
+		else if (strncmp(argv[i], FPS_OPTION, strlen(FPS_OPTION)) == 0)
+		{
+			g_ViewManager->SetTargetFrameRate(atof(argv[i] + strlen(FPS_OPTION)));
+		}
+		else if (strncmp(argv[i], VSYNC_OPTION, strlen(VSYNC_OPTION)) == 0)
+		{
+			const char* mode = argv[i] + strlen(VSYNC_OPTION);
+			if (strcmp(mode, "off") == 0)
+			{
+				g_ViewManager->SetSwapMode(SWAP_MODE_OFF);
+			}
+			else if (strcmp(mode, "adaptive") == 0)
+			{
+				g_ViewManager->SetSwapMode(SWAP_MODE_ADAPTIVE);
+			}
+			else
+			{
+				g_ViewManager->SetSwapMode(SWAP_MODE_VSYNC);
+			}
+		}
+		else if (strncmp(argv[i], MESH_OPTION, strlen(MESH_OPTION)) == 0)
+		{
+			importedMeshFile = argv[i] + strlen(MESH_OPTION);
+		}
+	}
+
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+	// load the shader code from the GLSL files in the Shaders folder -
+	// the vertex shader decodes the compact vertex formats and the
+	// fragment shader reads the lights of the view clusters, with the
+	// lighting code shared with the other lit shaders included
+	LoadShaderProgram(
+		g_ShaderManager,
+		"./Shaders/vertexShader.glsl",
+		"./Shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetImportedMeshFile(importedMeshFile);
 	g_SceneManager->PrepareScene();
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		// handle the GLFW events, sleeping until one arrives when
+		// nothing changed, so an idle scene is not drawn again
+		if (g_ViewManager->WaitForRedraw() == false)
+		{
+			continue;
+		}
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -89,16 +147,27 @@ int main(int argc, char* argv[])
 
 		// convert from 3D object space to 2D view
 		g_ViewManager->PrepareSceneView();
+		// the CPU can be a few frames ahead of the GPU, so the
+		// buffers of the frame are only written once the GPU is
+		// done with them
+		g_SceneManager->BeginFrame();
+		g_SceneManager->SetViewParameters(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix(),
+			g_ViewManager->GetViewportHeight());
+		g_SceneManager->SetImpostorRendering(g_ViewManager->IsImpostorRendering());
+		g_SceneManager->SetTessellatedRendering(g_ViewManager->IsTessellatedRendering());
+		g_SceneManager->SetDeferredRendering(g_ViewManager->IsDeferredRendering());
+		g_SceneManager->SetSortedTransparency(g_ViewManager->IsSortedTransparency());
+		g_SceneManager->SetProceduralShapes(g_ViewManager->IsProceduralShapes());
 
 		// refresh the 3D scene
 		g_SceneManager->RenderScene();
+		g_SceneManager->EndFrame();
 
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
 	}
 
 	// clear the allocated manager objects from memory
@@ -0,0 +1,162 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.cpp
+// ============
+// map a file into memory for reading without copying it
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  MappedFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MappedFile::MappedFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+#else
+	m_fileDescriptor = -1;
+#endif
+}
+
+/***********************************************************
+ *  ~MappedFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping the whole of the passed
+ *  in file into memory as read only.  An empty file cannot
+ *  be mapped.
+ ***********************************************************/
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	if ((GetFileSizeEx(file, &fileSize) == FALSE) || (fileSize.QuadPart == 0) ||
+		((unsigned long long)fileSize.QuadPart > (unsigned long long)(size_t)-1))
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	void* pView = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (pView == NULL)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return(false);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_pData = (const unsigned char*)pView;
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	int fileDescriptor = open(filename, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return(false);
+	}
+
+	struct stat fileStatus;
+	if ((fstat(fileDescriptor, &fileStatus) != 0) || (fileStatus.st_size <= 0))
+	{
+		close(fileDescriptor);
+		return(false);
+	}
+
+	void* pView = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (pView == MAP_FAILED)
+	{
+		close(fileDescriptor);
+		return(false);
+	}
+
+	m_fileDescriptor = fileDescriptor;
+	m_pData = (const unsigned char*)pView;
+	m_size = (size_t)fileStatus.st_size;
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapped memory and
+ *  closing the file.
+ ***********************************************************/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_size);
+	}
+	if (m_fileDescriptor >= 0)
+	{
+		close(m_fileDescriptor);
+	}
+	m_fileDescriptor = -1;
+#endif
+
+	m_pData = NULL;
+	m_size = 0;
+}
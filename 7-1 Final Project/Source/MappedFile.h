@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////
+// mappedfile.h
+// ============
+// map a file into memory for reading without copying it
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+/***********************************************************
+ *  MappedFile
+ *
+ *  This class maps a whole file into memory as read only.
+ *  The mapping is released when the object is destroyed.
+ ***********************************************************/
+class MappedFile
+{
+public:
+	// constructor
+	MappedFile();
+	// destructor
+	~MappedFile();
+
+	// map the passed in file, returns false if it cannot be read
+	bool Open(const char* filename);
+	// release the mapping
+	void Close();
+
+	// get the mapped bytes and their count
+	const unsigned char* GetData() const { return(m_pData); }
+	size_t GetSize() const { return(m_size); }
+
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#else
+	int m_fileDescriptor;
+#endif
+
+	// a mapping cannot be shared between two objects
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
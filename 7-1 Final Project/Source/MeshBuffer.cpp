@@ -0,0 +1,266 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.cpp
+// ============
+// store many meshes in one shared vertex buffer and one shared index buffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshBuffer.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// smallest sizes of the shared buffers, in vertices and indices
+	const size_t g_MinimumVertexCapacity = 64 * 1024;
+	const size_t g_MinimumIndexCapacity = 256 * 1024;
+
+	/***********************************************************
+	 *  ResizeBuffer()
+	 *
+	 *  Replace a buffer with a larger one that starts with a
+	 *  copy of its contents.  The copy stays on the GPU.
+	 ***********************************************************/
+	void ResizeBuffer(GLuint& buffer, size_t oldBytes, size_t newBytes)
+	{
+		GLuint newBuffer = 0;
+		glGenBuffers(1, &newBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)newBytes, NULL, GL_STATIC_DRAW);
+
+		if (buffer != 0)
+		{
+			if (oldBytes > 0)
+			{
+				glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (GLsizeiptr)oldBytes);
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			}
+			glDeleteBuffers(1, &buffer);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		buffer = newBuffer;
+	}
+}
+
+/***********************************************************
+ *  MeshBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshBuffer::MeshBuffer()
+{
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_stride = 0;
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+}
+
+/***********************************************************
+ *  ~MeshBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshBuffer::~MeshBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the vertex array object
+ *  and declaring the attribute formats of the passed in
+ *  vertex layout on it.  The buffers are created by the
+ *  first mesh that is added.
+ ***********************************************************/
+void MeshBuffer::Create(VERTEX_LAYOUT layout)
+{
+	Destroy();
+
+	m_stride = GetVertexLayoutStride(layout);
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+	SetupVertexFormat(layout);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the vertex array object
+ *  and the shared buffers.  Every mesh in them is lost.
+ ***********************************************************/
+void MeshBuffer::Destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_vertexCapacity = 0;
+	m_indexCapacity = 0;
+	m_freeVertices.clear();
+	m_freeIndices.clear();
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for copying the vertices and indices
+ *  of a mesh into free space in the shared buffers.  The
+ *  indices are not changed, the mesh is drawn with its base
+ *  vertex instead.
+ ***********************************************************/
+bool MeshBuffer::Add(
+	const void* vertexData,
+	size_t vertexCount,
+	const GLuint* indices,
+	size_t indexCount,
+	MESH_BUFFER_RANGE& range)
+{
+	range.baseVertex = 0;
+	range.vertexCount = 0;
+	range.firstIndex = 0;
+	range.indexCount = 0;
+
+	if ((m_vao == 0) || (vertexCount == 0) || (indexCount == 0))
+	{
+		return(false);
+	}
+
+	size_t firstVertex = Allocate(m_freeVertices, vertexCount, false);
+	size_t firstIndex = Allocate(m_freeIndices, indexCount, true);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_vertexBuffer);
+	glBufferSubData(
+		GL_COPY_WRITE_BUFFER,
+		(GLintptr)(firstVertex * m_stride),
+		(GLsizeiptr)(vertexCount * m_stride),
+		vertexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glBufferSubData(
+		GL_COPY_WRITE_BUFFER,
+		(GLintptr)(firstIndex * sizeof(GLuint)),
+		(GLsizeiptr)(indexCount * sizeof(GLuint)),
+		indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	range.baseVertex = (GLint)firstVertex;
+	range.vertexCount = (GLuint)vertexCount;
+	range.firstIndex = (GLuint)firstIndex;
+	range.indexCount = (GLuint)indexCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Remove()
+ *
+ *  This method is used for releasing the space of a mesh.
+ *  The buffers keep their size.
+ ***********************************************************/
+void MeshBuffer::Remove(MESH_BUFFER_RANGE& range)
+{
+	if (range.indexCount > 0)
+	{
+		Release(m_freeVertices, (size_t)range.baseVertex, range.vertexCount);
+		Release(m_freeIndices, range.firstIndex, range.indexCount);
+	}
+
+	range.baseVertex = 0;
+	range.vertexCount = 0;
+	range.firstIndex = 0;
+	range.indexCount = 0;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for taking the first free block that
+ *  is large enough.  When there is none, the buffer at least
+ *  doubles in size and is attached to the vertex array
+ *  object again.
+ ***********************************************************/
+size_t MeshBuffer::Allocate(std::vector<FreeBlock>& freeList, size_t count, bool bIndices)
+{
+	for (size_t i = 0; i < freeList.size(); i++)
+	{
+		if (freeList[i].count >= count)
+		{
+			size_t offset = freeList[i].offset;
+			freeList[i].offset += count;
+			freeList[i].count -= count;
+			if (freeList[i].count == 0)
+			{
+				freeList.erase(freeList.begin() + i);
+			}
+			return(offset);
+		}
+	}
+
+	size_t& capacity = bIndices ? m_indexCapacity : m_vertexCapacity;
+	size_t unitBytes = bIndices ? sizeof(GLuint) : (size_t)m_stride;
+	size_t newCapacity = std::max(
+		std::max(capacity * 2, capacity + count),
+		bIndices ? g_MinimumIndexCapacity : g_MinimumVertexCapacity);
+
+	ResizeBuffer(bIndices ? m_indexBuffer : m_vertexBuffer, capacity * unitBytes, newCapacity * unitBytes);
+	Release(freeList, capacity, newCapacity - capacity);
+	capacity = newCapacity;
+
+	glBindVertexArray(m_vao);
+	glBindVertexBuffer(VERTEX_BUFFER_BINDING, m_vertexBuffer, 0, m_stride);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBindVertexArray(0);
+
+	return(Allocate(freeList, count, bIndices));
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for adding a block to a free list,
+ *  merging it with the free blocks on either side.
+ ***********************************************************/
+void MeshBuffer::Release(std::vector<FreeBlock>& freeList, size_t offset, size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	size_t i = 0;
+	while ((i < freeList.size()) && (freeList[i].offset < offset))
+	{
+		i++;
+	}
+
+	FreeBlock block = { offset, count };
+	freeList.insert(freeList.begin() + i, block);
+
+	// merge with the following block, then with the previous one
+	if ((i + 1 < freeList.size()) && (freeList[i].offset + freeList[i].count == freeList[i + 1].offset))
+	{
+		freeList[i].count += freeList[i + 1].count;
+		freeList.erase(freeList.begin() + i + 1);
+	}
+	if ((i > 0) && (freeList[i - 1].offset + freeList[i - 1].count == freeList[i].offset))
+	{
+		freeList[i - 1].count += freeList[i].count;
+		freeList.erase(freeList.begin() + i);
+	}
+}
\ No newline at end of file
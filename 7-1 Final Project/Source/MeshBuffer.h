@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshbuffer.h
+// ============
+// store many meshes in one shared vertex buffer and one shared index buffer
+//
+//	Every MeshBuffer owns a single vertex array object with the attribute
+//	formats of one vertex layout, declared once when it is created.  The
+//	meshes are sub-allocated from its buffers and drawn with a base vertex,
+//	so switching between them does not change any OpenGL binding.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "VertexLayout.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MESH_BUFFER_RANGE
+ *
+ *  The place of one mesh inside the shared buffers.
+ ***********************************************************/
+struct MESH_BUFFER_RANGE
+{
+	// first vertex of the mesh, added to every index when drawn
+	GLint baseVertex;
+	GLuint vertexCount;
+	// first index of the mesh in the shared index buffer
+	GLuint firstIndex;
+	GLuint indexCount;
+};
+
+/***********************************************************
+ *  MeshBuffer
+ *
+ *  This class holds the vertex array object and the shared
+ *  buffers for all of the meshes read with one vertex layout.
+ *  The buffers grow when they are full, and the space of a
+ *  removed mesh is reused by the meshes added after it.
+ ***********************************************************/
+class MeshBuffer
+{
+public:
+	// constructor
+	MeshBuffer();
+	// destructor
+	~MeshBuffer();
+
+	// create the vertex array object for the passed in vertex layout
+	void Create(VERTEX_LAYOUT layout);
+	// free the vertex array object and the buffers
+	void Destroy();
+
+	// copy a mesh into the shared buffers and return its place
+	bool Add(
+		const void* vertexData,
+		size_t vertexCount,
+		const GLuint* indices,
+		size_t indexCount,
+		MESH_BUFFER_RANGE& range);
+	// release the space of a mesh so it can be reused
+	void Remove(MESH_BUFFER_RANGE& range);
+
+	// bind the vertex array object, the buffers are bound with it
+	void Bind() const { glBindVertexArray(m_vao); }
+	GLuint GetVAO() const { return(m_vao); }
+
+private:
+	struct FreeBlock
+	{
+		size_t offset;
+		size_t count;
+	};
+
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLsizei m_stride;
+
+	// sizes in vertices and indices
+	size_t m_vertexCapacity;
+	size_t m_indexCapacity;
+	// unused space, sorted by offset
+	std::vector<FreeBlock> m_freeVertices;
+	std::vector<FreeBlock> m_freeIndices;
+
+	// take space from a free list, growing the buffer when needed
+	size_t Allocate(std::vector<FreeBlock>& freeList, size_t count, bool bIndices);
+	// return space to a free list
+	void Release(std::vector<FreeBlock>& freeList, size_t offset, size_t count);
+
+	// the buffers cannot be shared between two objects
+	MeshBuffer(const MeshBuffer&);
+	MeshBuffer& operator=(const MeshBuffer&);
+};
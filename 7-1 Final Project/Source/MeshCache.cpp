@@ -0,0 +1,440 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.cpp
+// ============
+// store processed meshes on disk so they are not rebuilt at every start
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const char g_CacheMagic[4] = { 'M', 'S', 'H', 'C' };
+	const char* g_CacheExtension = ".mesh";
+
+	// every section of a cache file starts on this boundary
+	const uint64_t g_SectionAlignment = 16;
+
+	// FNV-1a 64-bit hash constants
+	const uint64_t g_HashOffsetBasis = 14695981039346656037ULL;
+	const uint64_t g_HashPrime = 1099511628211ULL;
+
+	/***********************************************************
+	 *  MESH_CACHE_HEADER
+	 *
+	 *  Start of every cache file.  The sizes of the stored
+	 *  structures are kept so that a file written by a build
+	 *  with a different layout is rejected.
+	 ***********************************************************/
+	struct MESH_CACHE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t keyHash;
+		uint32_t headerSize;
+		uint32_t vertexFormat;
+		uint32_t vertexStride;
+		uint32_t lodSize;
+		uint32_t meshletSize;
+		uint32_t reserved;
+		float positionOffset[3];
+		float positionScale[3];
+		float boundsMinimum[3];
+		float boundsMaximum[3];
+		float boundsCenter[3];
+		float boundsRadius;
+		uint64_t vertexOffset;
+		uint64_t vertexBytes;
+		uint64_t indexOffset;
+		uint64_t indexCount;
+		uint64_t lodOffset;
+		uint64_t lodCount;
+		uint64_t meshletOffset;
+		uint64_t meshletCount;
+	};
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Add bytes to an FNV-1a hash.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= g_HashPrime;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  AlignOffset()
+	 *
+	 *  Round a file offset up to the section alignment.
+	 ***********************************************************/
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return((offset + g_SectionAlignment - 1) / g_SectionAlignment * g_SectionAlignment);
+	}
+
+	/***********************************************************
+	 *  IsSectionValid()
+	 *
+	 *  Check that a section is aligned and lies inside the file.
+	 ***********************************************************/
+	bool IsSectionValid(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+	{
+		if (((offset % g_SectionAlignment) != 0) || (offset > fileSize))
+		{
+			return(false);
+		}
+		if ((elementSize != 0) && (count > (fileSize - offset) / elementSize))
+		{
+			return(false);
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  WriteSection()
+	 *
+	 *  Pad the file to the offset of a section and write it.
+	 ***********************************************************/
+	void WriteSection(std::ofstream& file, uint64_t& position, uint64_t offset, const void* pData, size_t size)
+	{
+		static const char padding[16] = {};
+		if (offset > position)
+		{
+			file.write(padding, (std::streamsize)(offset - position));
+		}
+		if (size > 0)
+		{
+			file.write((const char*)pData, (std::streamsize)size);
+		}
+		position = offset + size;
+	}
+
+	/***********************************************************
+	 *  CreateCacheDirectory()
+	 *
+	 *  Create the cache directory, when it does not exist yet.
+	 ***********************************************************/
+	void CreateCacheDirectory(const std::string& directory)
+	{
+#ifdef _WIN32
+		_mkdir(directory.c_str());
+#else
+		mkdir(directory.c_str(), 0755);
+#endif
+	}
+}
+
+/***********************************************************
+ *  MESH_CACHE_KEY()
+ *
+ *  The constructor for the key - the cache version and the
+ *  mesh name are the first values in the hash.
+ ***********************************************************/
+MESH_CACHE_KEY::MESH_CACHE_KEY(const char* meshName)
+{
+	name = meshName;
+	hash = g_HashOffsetBasis;
+	hash = HashBytes(hash, &MESH_CACHE_VERSION, sizeof(MESH_CACHE_VERSION));
+	hash = HashBytes(hash, name.data(), name.size() + 1);
+}
+
+/***********************************************************
+ *  AddParameter()
+ *
+ *  This method is used for adding an integer parameter to
+ *  the key.
+ ***********************************************************/
+void MESH_CACHE_KEY::AddParameter(int value)
+{
+	int32_t stored = (int32_t)value;
+	hash = HashBytes(hash, &stored, sizeof(stored));
+}
+
+/***********************************************************
+ *  AddParameter()
+ *
+ *  This method is used for adding a 64-bit parameter, such
+ *  as a file size or time, to the key.
+ ***********************************************************/
+void MESH_CACHE_KEY::AddParameter(uint64_t value)
+{
+	hash = HashBytes(hash, &value, sizeof(value));
+}
+
+/***********************************************************
+ *  AddParameter()
+ *
+ *  This method is used for adding a floating point parameter
+ *  to the key.
+ ***********************************************************/
+void MESH_CACHE_KEY::AddParameter(float value)
+{
+	hash = HashBytes(hash, &value, sizeof(value));
+}
+
+/***********************************************************
+ *  AddParameter()
+ *
+ *  This method is used for adding a text parameter, such as
+ *  a file name, to the key.
+ ***********************************************************/
+void MESH_CACHE_KEY::AddParameter(const char* text)
+{
+	hash = HashBytes(hash, text, strlen(text) + 1);
+}
+
+/***********************************************************
+ *  GetMeshCacheView()
+ *
+ *  This function is used for pointing a view at the buffers
+ *  of a processed mesh that is held in memory, so that it
+ *  can be uploaded the same way as a cached mesh.
+ ***********************************************************/
+void GetMeshCacheView(const PROCESSED_MESH& mesh, MESH_CACHE_VIEW& view)
+{
+	view.format = mesh.vertices.format;
+	view.stride = mesh.vertices.stride;
+	view.positionOffset = mesh.vertices.positionOffset;
+	view.positionScale = mesh.vertices.positionScale;
+	view.bounds = mesh.bounds;
+	view.vertexData = mesh.vertices.data.data();
+	view.vertexBytes = mesh.vertices.data.size();
+	view.indices = mesh.indices.data();
+	view.indexCount = mesh.indices.size();
+	view.lods = mesh.lods.data();
+	view.lodCount = mesh.lods.size();
+	view.meshlets = mesh.meshlets.data();
+	view.meshletCount = mesh.meshlets.size();
+}
+
+/***********************************************************
+ *  MeshCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshCache::MeshCache(const char* directory)
+{
+	m_directory = directory;
+}
+
+/***********************************************************
+ *  ~MeshCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshCache::~MeshCache()
+{
+	Close();
+}
+
+/***********************************************************
+ *  GetFilename()
+ *
+ *  This method is used for getting the path of the cache
+ *  file that belongs to a key.
+ ***********************************************************/
+std::string MeshCache::GetFilename(const MESH_CACHE_KEY& key) const
+{
+	char hashText[17];
+	snprintf(hashText, sizeof(hashText), "%016llx", (unsigned long long)key.hash);
+	return(m_directory + "/" + key.name + "_" + hashText + g_CacheExtension);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for releasing the mapped cache file.
+ ***********************************************************/
+void MeshCache::Close()
+{
+	m_file.Close();
+}
+
+/***********************************************************
+ *  Read()
+ *
+ *  This method is used for mapping the cache file of a key
+ *  and pointing the view at the buffers inside it.  Returns
+ *  false when there is no file for the key, or when the file
+ *  was written by another version or is damaged.
+ ***********************************************************/
+bool MeshCache::Read(const MESH_CACHE_KEY& key, MESH_CACHE_VIEW& view)
+{
+	std::string filename = GetFilename(key);
+	if (m_file.Open(filename.c_str()) == false)
+	{
+		return(false);
+	}
+
+	const unsigned char* pData = m_file.GetData();
+	uint64_t fileSize = m_file.GetSize();
+
+	MESH_CACHE_HEADER header;
+	if (fileSize < sizeof(header))
+	{
+		std::cout << "ERROR: Mesh cache file " << filename << " is too small" << std::endl;
+		m_file.Close();
+		return(false);
+	}
+	memcpy(&header, pData, sizeof(header));
+
+	bool bValid =
+		(memcmp(header.magic, g_CacheMagic, sizeof(g_CacheMagic)) == 0) &&
+		(header.version == MESH_CACHE_VERSION) &&
+		(header.keyHash == key.hash) &&
+		(header.headerSize == sizeof(MESH_CACHE_HEADER)) &&
+		(header.vertexFormat <= VERTEX_FORMAT_SNORM16) &&
+		(header.vertexStride == (uint32_t)GetVertexStride((VERTEX_FORMAT)header.vertexFormat)) &&
+		(header.lodSize == sizeof(MESH_LOD)) &&
+		(header.meshletSize == sizeof(MESHLET));
+
+	bValid = bValid &&
+		IsSectionValid(header.vertexOffset, header.vertexBytes, 1, fileSize) &&
+		((header.vertexBytes % header.vertexStride) == 0) &&
+		IsSectionValid(header.indexOffset, header.indexCount, sizeof(GLuint), fileSize) &&
+		((header.indexCount % 3) == 0) &&
+		IsSectionValid(header.lodOffset, header.lodCount, sizeof(MESH_LOD), fileSize) &&
+		IsSectionValid(header.meshletOffset, header.meshletCount, sizeof(MESHLET), fileSize);
+
+	if (bValid == false)
+	{
+		std::cout << "INFO: Mesh cache file " << filename << " is out of date or incomplete and will be rebuilt" << std::endl;
+		m_file.Close();
+		return(false);
+	}
+
+	view.format = (VERTEX_FORMAT)header.vertexFormat;
+	view.stride = (GLsizei)header.vertexStride;
+	view.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+	view.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+	view.bounds.minimum = glm::vec3(header.boundsMinimum[0], header.boundsMinimum[1], header.boundsMinimum[2]);
+	view.bounds.maximum = glm::vec3(header.boundsMaximum[0], header.boundsMaximum[1], header.boundsMaximum[2]);
+	view.bounds.center = glm::vec3(header.boundsCenter[0], header.boundsCenter[1], header.boundsCenter[2]);
+	view.bounds.radius = header.boundsRadius;
+	view.vertexData = pData + header.vertexOffset;
+	view.vertexBytes = (size_t)header.vertexBytes;
+	view.indices = (const GLuint*)(pData + header.indexOffset);
+	view.indexCount = (size_t)header.indexCount;
+	view.lods = (const MESH_LOD*)(pData + header.lodOffset);
+	view.lodCount = (size_t)header.lodCount;
+	view.meshlets = (const MESHLET*)(pData + header.meshletOffset);
+	view.meshletCount = (size_t)header.meshletCount;
+
+	// a damaged index or range would read outside the buffers on the GPU
+	GLuint vertexCount = (GLuint)(view.vertexBytes / view.stride);
+	for (size_t i = 0; (i < view.indexCount) && bValid; i++)
+	{
+		bValid = view.indices[i] < vertexCount;
+	}
+	for (size_t i = 0; (i < view.lodCount) && bValid; i++)
+	{
+		bValid = (uint64_t)view.lods[i].firstIndex + view.lods[i].indexCount <= view.indexCount;
+	}
+	for (size_t i = 0; (i < view.meshletCount) && bValid; i++)
+	{
+		bValid = (uint64_t)view.meshlets[i].firstIndex + view.meshlets[i].indexCount <= view.indexCount;
+	}
+	if (bValid == false)
+	{
+		std::cout << "ERROR: Mesh cache file " << filename << " is damaged and will be rebuilt" << std::endl;
+		m_file.Close();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for storing a processed mesh in the
+ *  cache file of a key.  The file is written under a
+ *  temporary name first, so that a partly written file is
+ *  never read.
+ ***********************************************************/
+bool MeshCache::Write(const MESH_CACHE_KEY& key, const PROCESSED_MESH& mesh)
+{
+	CreateCacheDirectory(m_directory);
+
+	MESH_CACHE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, g_CacheMagic, sizeof(g_CacheMagic));
+	header.version = MESH_CACHE_VERSION;
+	header.keyHash = key.hash;
+	header.headerSize = sizeof(MESH_CACHE_HEADER);
+	header.vertexFormat = (uint32_t)mesh.vertices.format;
+	header.vertexStride = (uint32_t)mesh.vertices.stride;
+	header.lodSize = sizeof(MESH_LOD);
+	header.meshletSize = sizeof(MESHLET);
+	for (int i = 0; i < 3; i++)
+	{
+		header.positionOffset[i] = mesh.vertices.positionOffset[i];
+		header.positionScale[i] = mesh.vertices.positionScale[i];
+		header.boundsMinimum[i] = mesh.bounds.minimum[i];
+		header.boundsMaximum[i] = mesh.bounds.maximum[i];
+		header.boundsCenter[i] = mesh.bounds.center[i];
+	}
+	header.boundsRadius = mesh.bounds.radius;
+
+	header.vertexBytes = mesh.vertices.data.size();
+	header.indexCount = mesh.indices.size();
+	header.lodCount = mesh.lods.size();
+	header.meshletCount = mesh.meshlets.size();
+	header.vertexOffset = AlignOffset(sizeof(header));
+	header.indexOffset = AlignOffset(header.vertexOffset + header.vertexBytes);
+	header.lodOffset = AlignOffset(header.indexOffset + header.indexCount * sizeof(GLuint));
+	header.meshletOffset = AlignOffset(header.lodOffset + header.lodCount * sizeof(MESH_LOD));
+
+	std::string filename = GetFilename(key);
+	std::string temporaryName = filename + ".tmp";
+	std::ofstream file(temporaryName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR: Could not create mesh cache file " << temporaryName << std::endl;
+		return(false);
+	}
+
+	uint64_t position = 0;
+	WriteSection(file, position, 0, &header, sizeof(header));
+	WriteSection(file, position, header.vertexOffset, mesh.vertices.data.data(), mesh.vertices.data.size());
+	WriteSection(file, position, header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+	WriteSection(file, position, header.lodOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MESH_LOD));
+	WriteSection(file, position, header.meshletOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(MESHLET));
+	file.close();
+
+	if (!file)
+	{
+		std::cout << "ERROR: Could not write mesh cache file " << temporaryName << std::endl;
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+
+	// rename does not replace an existing file on every platform
+	std::remove(filename.c_str());
+	if (std::rename(temporaryName.c_str(), filename.c_str()) != 0)
+	{
+		std::cout << "ERROR: Could not rename mesh cache file " << temporaryName << std::endl;
+		std::remove(temporaryName.c_str());
+		return(false);
+	}
+
+	return(true);
+}
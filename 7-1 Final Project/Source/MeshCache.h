@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.h
+// ============
+// store processed meshes on disk so they are not rebuilt at every start
+//
+//	Each cache file holds the encoded vertex buffer, the index buffer,
+//	the bounds, the LOD table and the meshlets of one mesh.  The file is
+//	named after a hash of the generator parameters, and is mapped into
+//	memory when read so the buffers can be uploaded straight from it.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MappedFile.h"
+#include "MeshData.h"
+#include "Meshlets.h"
+#include "VertexFormats.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// increase when the generators, the vertex encoding or the mesh
+// processing change, so that older cache files are rebuilt
+const uint32_t MESH_CACHE_VERSION = 2;
+
+/***********************************************************
+ *  MESH_CACHE_KEY
+ *
+ *  Identifies a cached mesh by its name and a hash of every
+ *  parameter that was used to generate and process it.
+ ***********************************************************/
+struct MESH_CACHE_KEY
+{
+	std::string name;
+	uint64_t hash;
+
+	// start a key for the named mesh
+	MESH_CACHE_KEY(const char* meshName);
+
+	// add a generator or processing parameter to the hash
+	void AddParameter(int value);
+	void AddParameter(uint64_t value);
+	void AddParameter(float value);
+	void AddParameter(const char* text);
+};
+
+/***********************************************************
+ *  PROCESSED_MESH
+ *
+ *  Everything that is needed to upload and draw a mesh,
+ *  kept in memory after the mesh was generated.
+ ***********************************************************/
+struct PROCESSED_MESH
+{
+	ENCODED_VERTICES vertices;
+	std::vector<GLuint> indices;
+	MESH_BOUNDS bounds;
+	std::vector<MESH_LOD> lods;
+	std::vector<MESHLET> meshlets;
+};
+
+/***********************************************************
+ *  MESH_CACHE_VIEW
+ *
+ *  Points at the buffers of a processed mesh, either in
+ *  memory or inside a mapped cache file.
+ ***********************************************************/
+struct MESH_CACHE_VIEW
+{
+	VERTEX_FORMAT format;
+	GLsizei stride;
+	glm::vec3 positionOffset;
+	glm::vec3 positionScale;
+	MESH_BOUNDS bounds;
+
+	const unsigned char* vertexData;
+	size_t vertexBytes;
+	const GLuint* indices;
+	size_t indexCount;
+	const MESH_LOD* lods;
+	size_t lodCount;
+	const MESHLET* meshlets;
+	size_t meshletCount;
+};
+
+// point a view at the buffers of a processed mesh in memory
+void GetMeshCacheView(const PROCESSED_MESH& mesh, MESH_CACHE_VIEW& view);
+
+/***********************************************************
+ *  MeshCache
+ *
+ *  This class reads and writes the cache files kept in one
+ *  directory.  Only one file is mapped at a time.
+ ***********************************************************/
+class MeshCache
+{
+public:
+	// constructor
+	MeshCache(const char* directory);
+	// destructor
+	~MeshCache();
+
+	// map the cache file of the key - the view stays valid
+	// until the next call to Read() or Close()
+	bool Read(const MESH_CACHE_KEY& key, MESH_CACHE_VIEW& view);
+	// release the mapped cache file
+	void Close();
+
+	// store the processed mesh under the key
+	bool Write(const MESH_CACHE_KEY& key, const PROCESSED_MESH& mesh);
+
+private:
+	std::string m_directory;
+	MappedFile m_file;
+
+	// get the path of the cache file for a key
+	std::string GetFilename(const MESH_CACHE_KEY& key) const;
+};
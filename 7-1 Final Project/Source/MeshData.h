@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshdata.h
+// ============
+// CPU side storage for generated and processed mesh geometry
+//
+//	Meshes are kept on the CPU as separate position, normal and
+//	UV streams plus a triangle index list, so they can be encoded
+//	into any supported vertex format before they are uploaded.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MESH_BOUNDS
+ *
+ *  Axis aligned box and bounding sphere of a mesh in its
+ *  own object space.
+ ***********************************************************/
+struct MESH_BOUNDS
+{
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+	glm::vec3 center;
+	float radius;
+};
+
+/***********************************************************
+ *  MESH_LOD
+ *
+ *  One level of detail of a mesh - a range of its index
+ *  buffer and the largest object space distance between
+ *  that level and the full detail surface.
+ ***********************************************************/
+struct MESH_LOD
+{
+	GLuint firstIndex;
+	GLuint indexCount;
+	float error;
+};
+
+/***********************************************************
+ *  MESH_DATA
+ *
+ *  Triangle mesh with one position, normal and UV per
+ *  vertex.  Every three indices form one triangle.
+ ***********************************************************/
+struct MESH_DATA
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+
+	// remove all of the stored geometry
+	void Clear()
+	{
+		positions.clear();
+		normals.clear();
+		uvs.clear();
+		indices.clear();
+	}
+
+	// append a vertex and return its index
+	GLuint AddVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+	{
+		positions.push_back(position);
+		normals.push_back(normal);
+		uvs.push_back(uv);
+		return((GLuint)positions.size() - 1);
+	}
+
+	// append a triangle made from three existing vertices
+	void AddTriangle(GLuint a, GLuint b, GLuint c)
+	{
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+};
+
+/***********************************************************
+ *  CalculateMeshBounds()
+ *
+ *  Calculate the bounding box and a bounding sphere that is
+ *  centered on the box for the passed in mesh.
+ ***********************************************************/
+inline MESH_BOUNDS CalculateMeshBounds(const MESH_DATA& mesh)
+{
+	MESH_BOUNDS bounds;
+	bounds.minimum = glm::vec3(0.0f);
+	bounds.maximum = glm::vec3(0.0f);
+	bounds.center = glm::vec3(0.0f);
+	bounds.radius = 0.0f;
+
+	if (mesh.positions.size() == 0)
+	{
+		return(bounds);
+	}
+
+	bounds.minimum = mesh.positions[0];
+	bounds.maximum = mesh.positions[0];
+	for (size_t i = 1; i < mesh.positions.size(); i++)
+	{
+		bounds.minimum = glm::min(bounds.minimum, mesh.positions[i]);
+		bounds.maximum = glm::max(bounds.maximum, mesh.positions[i]);
+	}
+
+	bounds.center = (bounds.minimum + bounds.maximum) * 0.5f;
+	for (size_t i = 0; i < mesh.positions.size(); i++)
+	{
+		bounds.radius = glm::max(bounds.radius, glm::length(mesh.positions[i] - bounds.center));
+	}
+
+	return(bounds);
+}
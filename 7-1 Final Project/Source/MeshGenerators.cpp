@@ -0,0 +1,464 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerators.cpp
+// ============
+// generate the geometry of the basic 3D shapes used in the scene
+//
+//	The cylinders and the torus are built by SIMD kernels that write
+//	four vertices at a time, with the rings and segments split across
+//	the shared thread pool.  The vertex and index arrays are sized up
+//	front so every chunk writes into its own part of them.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshGenerators.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define MESH_GENERATORS_SSE 1
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const float g_TwoPi = 6.28318530717958647692f;
+
+	// smallest number of vertices or segments given to one thread
+	const size_t g_MinimumChunkSize = 256;
+
+	/***********************************************************
+	 *  ANGLE_TABLE
+	 *
+	 *  Sine, cosine and 0 to 1 fraction of every segment angle
+	 *  around a circle.  The last entry repeats the first one
+	 *  exactly so that the UV seam closes without a gap.
+	 ***********************************************************/
+	struct ANGLE_TABLE
+	{
+		std::vector<float> sine;
+		std::vector<float> cosine;
+		std::vector<float> fraction;
+	};
+
+	/***********************************************************
+	 *  BuildAngleTable()
+	 *
+	 *  Fill the angle table for the passed in segment count.
+	 ***********************************************************/
+	void BuildAngleTable(int segments, ANGLE_TABLE& table)
+	{
+		table.sine.resize(segments + 1);
+		table.cosine.resize(segments + 1);
+		table.fraction.resize(segments + 1);
+
+		for (int i = 0; i < segments; i++)
+		{
+			float fraction = (float)i / (float)segments;
+			table.sine[i] = std::sin(g_TwoPi * fraction);
+			table.cosine[i] = std::cos(g_TwoPi * fraction);
+			table.fraction[i] = fraction;
+		}
+		table.sine[segments] = table.sine[0];
+		table.cosine[segments] = table.cosine[0];
+		table.fraction[segments] = 1.0f;
+	}
+
+	/***********************************************************
+	 *  ResizeMesh()
+	 *
+	 *  Size the vertex and index arrays before they are filled
+	 *  in parallel.
+	 ***********************************************************/
+	void ResizeMesh(MESH_DATA& mesh, size_t vertexCount, size_t indexCount)
+	{
+		mesh.Clear();
+		mesh.positions.resize(vertexCount);
+		mesh.normals.resize(vertexCount);
+		mesh.uvs.resize(vertexCount);
+		mesh.indices.resize(indexCount);
+	}
+
+#ifdef MESH_GENERATORS_SSE
+	/***********************************************************
+	 *  StoreVec3x4()
+	 *
+	 *  Interleave four X, Y and Z values and store them as four
+	 *  consecutive vec3 values.
+	 ***********************************************************/
+	inline void StoreVec3x4(float* destination, __m128 x, __m128 y, __m128 z)
+	{
+		__m128 xyLow = _mm_unpacklo_ps(x, y);
+		__m128 xyHigh = _mm_unpackhi_ps(x, y);
+
+		// x0 y0 z0 x1
+		__m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+		_mm_storeu_ps(destination, _mm_shuffle_ps(xyLow, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+		// y1 z1 x2 y2
+		__m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+		_mm_storeu_ps(destination + 4, _mm_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+		// z2 x3 y3 z3
+		__m128 zxy = _mm_shuffle_ps(z, xyHigh, _MM_SHUFFLE(3, 2, 3, 2));
+		_mm_storeu_ps(destination + 8, _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(1, 3, 2, 0)));
+	}
+
+	/***********************************************************
+	 *  StoreVec2x4()
+	 *
+	 *  Interleave four U and V values and store them as four
+	 *  consecutive vec2 values.
+	 ***********************************************************/
+	inline void StoreVec2x4(float* destination, __m128 u, __m128 v)
+	{
+		_mm_storeu_ps(destination, _mm_unpacklo_ps(u, v));
+		_mm_storeu_ps(destination + 4, _mm_unpackhi_ps(u, v));
+	}
+#endif
+
+	/***********************************************************
+	 *  WriteRingVertices()
+	 *
+	 *  Write the vertices [begin, end) of a horizontal ring at
+	 *  the passed in height.  The normal of each vertex is made
+	 *  from a radial part and an upward part.  Side rings map
+	 *  U around the ring and V up, caps map the disc directly.
+	 ***********************************************************/
+	void WriteRingVertices(
+		MESH_DATA& mesh,
+		size_t firstVertex,
+		const ANGLE_TABLE& table,
+		size_t begin,
+		size_t end,
+		float radius,
+		float height,
+		float normalRadial,
+		float normalY,
+		bool bCapUV)
+	{
+		glm::vec3* positions = &mesh.positions[firstVertex];
+		glm::vec3* normals = &mesh.normals[firstVertex];
+		glm::vec2* uvs = &mesh.uvs[firstVertex];
+		size_t i = begin;
+
+#ifdef MESH_GENERATORS_SSE
+		__m128 radius4 = _mm_set1_ps(radius);
+		__m128 height4 = _mm_set1_ps(height);
+		__m128 normalRadial4 = _mm_set1_ps(normalRadial);
+		__m128 normalY4 = _mm_set1_ps(normalY);
+		__m128 half4 = _mm_set1_ps(0.5f);
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 s = _mm_loadu_ps(&table.sine[i]);
+			__m128 c = _mm_loadu_ps(&table.cosine[i]);
+
+			StoreVec3x4(&positions[i].x, _mm_mul_ps(radius4, s), height4, _mm_mul_ps(radius4, c));
+			StoreVec3x4(&normals[i].x, _mm_mul_ps(normalRadial4, s), normalY4, _mm_mul_ps(normalRadial4, c));
+			if (bCapUV)
+			{
+				StoreVec2x4(&uvs[i].x, _mm_add_ps(half4, _mm_mul_ps(half4, s)), _mm_add_ps(half4, _mm_mul_ps(half4, c)));
+			}
+			else
+			{
+				StoreVec2x4(&uvs[i].x, _mm_loadu_ps(&table.fraction[i]), height4);
+			}
+		}
+#endif
+
+		// remaining vertices, or all of them without SSE
+		for (; i < end; i++)
+		{
+			float s = table.sine[i];
+			float c = table.cosine[i];
+			positions[i] = glm::vec3(radius * s, height, radius * c);
+			normals[i] = glm::vec3(normalRadial * s, normalY, normalRadial * c);
+			if (bCapUV)
+			{
+				uvs[i] = glm::vec2(0.5f + 0.5f * s, 0.5f + 0.5f * c);
+			}
+			else
+			{
+				uvs[i] = glm::vec2(table.fraction[i], height);
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  WriteTorusRing()
+	 *
+	 *  Write all of the vertices of one tube ring of a torus.
+	 ***********************************************************/
+	void WriteTorusRing(
+		MESH_DATA& mesh,
+		size_t ring,
+		const ANGLE_TABLE& mainTable,
+		const ANGLE_TABLE& tubeTable,
+		float mainRadius,
+		float thickness)
+	{
+		size_t ringSize = tubeTable.sine.size();
+		glm::vec3* positions = &mesh.positions[ring * ringSize];
+		glm::vec3* normals = &mesh.normals[ring * ringSize];
+		glm::vec2* uvs = &mesh.uvs[ring * ringSize];
+
+		float cosU = mainTable.cosine[ring];
+		float sinU = mainTable.sine[ring];
+		float u = mainTable.fraction[ring];
+		size_t j = 0;
+
+#ifdef MESH_GENERATORS_SSE
+		__m128 cosU4 = _mm_set1_ps(cosU);
+		__m128 sinU4 = _mm_set1_ps(sinU);
+		__m128 u4 = _mm_set1_ps(u);
+		__m128 mainRadius4 = _mm_set1_ps(mainRadius);
+		__m128 thickness4 = _mm_set1_ps(thickness);
+
+		for (; j + 4 <= ringSize; j += 4)
+		{
+			__m128 cosV = _mm_loadu_ps(&tubeTable.cosine[j]);
+			__m128 sinV = _mm_loadu_ps(&tubeTable.sine[j]);
+			__m128 ringRadius = _mm_add_ps(mainRadius4, _mm_mul_ps(thickness4, cosV));
+
+			StoreVec3x4(&positions[j].x,
+				_mm_mul_ps(ringRadius, cosU4),
+				_mm_mul_ps(ringRadius, sinU4),
+				_mm_mul_ps(thickness4, sinV));
+			StoreVec3x4(&normals[j].x,
+				_mm_mul_ps(cosV, cosU4),
+				_mm_mul_ps(cosV, sinU4),
+				sinV);
+			StoreVec2x4(&uvs[j].x, u4, _mm_loadu_ps(&tubeTable.fraction[j]));
+		}
+#endif
+
+		// remaining vertices, or all of them without SSE
+		for (; j < ringSize; j++)
+		{
+			float cosV = tubeTable.cosine[j];
+			float sinV = tubeTable.sine[j];
+			float ringRadius = mainRadius + thickness * cosV;
+
+			positions[j] = glm::vec3(ringRadius * cosU, ringRadius * sinU, thickness * sinV);
+			normals[j] = glm::vec3(cosV * cosU, cosV * sinU, sinV);
+			uvs[j] = glm::vec2(u, tubeTable.fraction[j]);
+		}
+	}
+
+	/***********************************************************
+	 *  AddQuad()
+	 *
+	 *  Add a square face centered on the passed in point, that
+	 *  spans the U and V half axes and faces along U cross V.
+	 ***********************************************************/
+	void AddQuad(MESH_DATA& mesh, glm::vec3 center, glm::vec3 uAxis, glm::vec3 vAxis)
+	{
+		glm::vec3 normal = glm::normalize(glm::cross(uAxis, vAxis));
+
+		GLuint first = mesh.AddVertex(center - uAxis - vAxis, normal, glm::vec2(0.0f, 0.0f));
+		mesh.AddVertex(center + uAxis - vAxis, normal, glm::vec2(1.0f, 0.0f));
+		mesh.AddVertex(center + uAxis + vAxis, normal, glm::vec2(1.0f, 1.0f));
+		mesh.AddVertex(center - uAxis + vAxis, normal, glm::vec2(0.0f, 1.0f));
+
+		mesh.AddTriangle(first, first + 1, first + 2);
+		mesh.AddTriangle(first, first + 2, first + 3);
+	}
+
+	/***********************************************************
+	 *  AddConicalCylinder()
+	 *
+	 *  Generate the sides and caps of a cylinder whose radius
+	 *  changes linearly between the bottom and the top.  The
+	 *  vertices are stored as the bottom side ring, the top
+	 *  side ring, then each cap as a center and a ring.
+	 ***********************************************************/
+	void AddConicalCylinder(MESH_DATA& mesh, float bottomRadius, float topRadius, int segments)
+	{
+		if (segments < 3)
+		{
+			segments = 3;
+		}
+
+		ANGLE_TABLE table;
+		BuildAngleTable(segments, table);
+
+		size_t ringSize = (size_t)segments + 1;
+		size_t bottomSide = 0;
+		size_t topSide = ringSize;
+		size_t topCap = 2 * ringSize;
+		size_t bottomCap = topCap + ringSize + 1;
+		size_t sideIndices = 6 * (size_t)segments;
+		size_t capIndices = 3 * (size_t)segments;
+		ResizeMesh(mesh, bottomCap + ringSize + 1, sideIndices + 2 * capIndices);
+
+		// the side normal leans up as the radius narrows
+		float slope = bottomRadius - topRadius;
+		float normalLength = std::sqrt(1.0f + slope * slope);
+		float normalRadial = 1.0f / normalLength;
+		float normalY = slope / normalLength;
+
+		// cap centers
+		mesh.positions[topCap] = glm::vec3(0.0f, 1.0f, 0.0f);
+		mesh.normals[topCap] = glm::vec3(0.0f, 1.0f, 0.0f);
+		mesh.uvs[topCap] = glm::vec2(0.5f, 0.5f);
+		mesh.positions[bottomCap] = glm::vec3(0.0f, 0.0f, 0.0f);
+		mesh.normals[bottomCap] = glm::vec3(0.0f, -1.0f, 0.0f);
+		mesh.uvs[bottomCap] = glm::vec2(0.5f, 0.5f);
+
+		ThreadPool::GetSharedPool().ParallelFor(ringSize, g_MinimumChunkSize,
+			[&](size_t begin, size_t end)
+			{
+				WriteRingVertices(mesh, bottomSide, table, begin, end, bottomRadius, 0.0f, normalRadial, normalY, false);
+				WriteRingVertices(mesh, topSide, table, begin, end, topRadius, 1.0f, normalRadial, normalY, false);
+				WriteRingVertices(mesh, topCap + 1, table, begin, end, topRadius, 1.0f, 0.0f, 1.0f, true);
+				WriteRingVertices(mesh, bottomCap + 1, table, begin, end, bottomRadius, 0.0f, 0.0f, -1.0f, true);
+			});
+
+		ThreadPool::GetSharedPool().ParallelFor((size_t)segments, g_MinimumChunkSize,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					GLuint* side = &mesh.indices[6 * i];
+					GLuint bottom = (GLuint)(bottomSide + i);
+					GLuint top = (GLuint)(topSide + i);
+					side[0] = bottom;
+					side[1] = bottom + 1;
+					side[2] = top + 1;
+					side[3] = bottom;
+					side[4] = top + 1;
+					side[5] = top;
+
+					GLuint* topTriangle = &mesh.indices[sideIndices + 3 * i];
+					topTriangle[0] = (GLuint)topCap;
+					topTriangle[1] = (GLuint)(topCap + 1 + i);
+					topTriangle[2] = (GLuint)(topCap + 2 + i);
+
+					GLuint* bottomTriangle = &mesh.indices[sideIndices + capIndices + 3 * i];
+					bottomTriangle[0] = (GLuint)bottomCap;
+					bottomTriangle[1] = (GLuint)(bottomCap + 2 + i);
+					bottomTriangle[2] = (GLuint)(bottomCap + 1 + i);
+				}
+			});
+	}
+}
+
+/***********************************************************
+ *  GeneratePlaneMesh()
+ *
+ *  This function is used for generating a flat plane that
+ *  faces up the Y axis.
+ ***********************************************************/
+void GeneratePlaneMesh(MESH_DATA& mesh)
+{
+	mesh.Clear();
+	AddQuad(mesh, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+}
+
+/***********************************************************
+ *  GenerateBoxMesh()
+ *
+ *  This function is used for generating a unit cube.  The
+ *  six sides are stored in order, two triangles per side.
+ ***********************************************************/
+void GenerateBoxMesh(MESH_DATA& mesh)
+{
+	mesh.Clear();
+
+	// back
+	AddQuad(mesh, glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(-0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.5f, 0.0f));
+	// bottom
+	AddQuad(mesh, glm::vec3(0.0f, -0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f));
+	// left
+	AddQuad(mesh, glm::vec3(-0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+	// right
+	AddQuad(mesh, glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -0.5f), glm::vec3(0.0f, 0.5f, 0.0f));
+	// top
+	AddQuad(mesh, glm::vec3(0.0f, 0.5f, 0.0f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -0.5f));
+	// front
+	AddQuad(mesh, glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.5f, 0.0f, 0.0f), glm::vec3(0.0f, 0.5f, 0.0f));
+}
+
+/***********************************************************
+ *  GenerateCylinderMesh()
+ *
+ *  This function is used for generating a cylinder with a
+ *  radius of one that stands one unit tall.
+ ***********************************************************/
+void GenerateCylinderMesh(MESH_DATA& mesh, int segments)
+{
+	AddConicalCylinder(mesh, 1.0f, 1.0f, segments);
+}
+
+/***********************************************************
+ *  GenerateTaperedCylinderMesh()
+ *
+ *  This function is used for generating a cylinder that
+ *  narrows to half of its radius at the top.
+ ***********************************************************/
+void GenerateTaperedCylinderMesh(MESH_DATA& mesh, int segments)
+{
+	AddConicalCylinder(mesh, 1.0f, 0.5f, segments);
+}
+
+/***********************************************************
+ *  GenerateTorusMesh()
+ *
+ *  This function is used for generating a torus around the
+ *  Z axis with the passed in tube thickness.  Each thread
+ *  builds whole tube rings.
+ ***********************************************************/
+void GenerateTorusMesh(MESH_DATA& mesh, float thickness, int mainSegments, int tubeSegments)
+{
+	const float mainRadius = 1.0f;
+
+	if (mainSegments < 3)
+	{
+		mainSegments = 3;
+	}
+	if (tubeSegments < 3)
+	{
+		tubeSegments = 3;
+	}
+
+	ANGLE_TABLE mainTable;
+	ANGLE_TABLE tubeTable;
+	BuildAngleTable(mainSegments, mainTable);
+	BuildAngleTable(tubeSegments, tubeTable);
+
+	size_t ringSize = (size_t)tubeSegments + 1;
+	size_t ringCount = (size_t)mainSegments + 1;
+	ResizeMesh(mesh, ringCount * ringSize, 6 * (size_t)mainSegments * (size_t)tubeSegments);
+
+	// whole rings per chunk, sized so a chunk holds enough vertices
+	size_t ringsPerChunk = g_MinimumChunkSize / ringSize + 1;
+
+	ThreadPool::GetSharedPool().ParallelFor(ringCount, ringsPerChunk,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t ring = begin; ring < end; ring++)
+			{
+				WriteTorusRing(mesh, ring, mainTable, tubeTable, mainRadius, thickness);
+			}
+		});
+
+	ThreadPool::GetSharedPool().ParallelFor((size_t)mainSegments, ringsPerChunk,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				GLuint* triangles = &mesh.indices[6 * i * (size_t)tubeSegments];
+				for (size_t j = 0; j < (size_t)tubeSegments; j++)
+				{
+					GLuint current = (GLuint)(i * ringSize + j);
+					GLuint next = current + (GLuint)ringSize;
+					triangles[0] = current;
+					triangles[1] = next;
+					triangles[2] = next + 1;
+					triangles[3] = current;
+					triangles[4] = next + 1;
+					triangles[5] = current + 1;
+					triangles += 6;
+				}
+			}
+		});
+}
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerators.h
+// ============
+// generate the geometry of the basic 3D shapes used in the scene
+//
+//	The shapes match the dimensions of the ShapeMeshes library: the plane
+//	is 2x2 units on the XZ plane, the box is a unit cube, the cylinders
+//	stand one unit tall on the XZ plane with a radius of one, and the
+//	torus lies on the XY plane with a main radius of one.
+//
+//	The segment counts set the tessellation of the curved shapes, the
+//	curved shapes are generated in parallel on the shared thread pool.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+// tube radius of the scene torus
+const float TORUS_THICKNESS = 0.1f;
+
+// generate a flat plane facing up the Y axis
+void GeneratePlaneMesh(MESH_DATA& mesh);
+
+// generate a box with its sides in the order back, bottom,
+// left, right, top, front so that each side can be drawn alone
+void GenerateBoxMesh(MESH_DATA& mesh);
+
+// generate a cylinder with a top and bottom cap
+void GenerateCylinderMesh(
+	MESH_DATA& mesh,
+	int segments = 36);
+
+// generate a cylinder with a top radius half of the bottom radius
+void GenerateTaperedCylinderMesh(
+	MESH_DATA& mesh,
+	int segments = 36);
+
+// generate a torus with the passed in tube radius
+void GenerateTorusMesh(
+	MESH_DATA& mesh,
+	float thickness = TORUS_THICKNESS,
+	int mainSegments = 30,
+	int tubeSegments = 30);
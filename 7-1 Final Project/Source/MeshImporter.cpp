@@ -0,0 +1,1585 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// import triangle meshes from Wavefront OBJ and binary glTF files
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// declaration of global variables
+namespace
+{
+	// OBJ text is split into chunks of at least this many bytes
+	const size_t g_MinimumChunkBytes = 1 << 20;
+
+	// deepest nesting that is accepted in glTF JSON and node trees
+	const int g_MaximumDepth = 64;
+
+	// binary glTF identifiers
+	const uint32_t g_GLBMagic = 0x46546C67;
+	const uint32_t g_GLBVersion = 2;
+	const uint32_t g_GLBChunkJSON = 0x4E4F534A;
+	const uint32_t g_GLBChunkBIN = 0x004E4942;
+
+	// glTF accessor component types
+	const int g_ComponentByte = 5120;
+	const int g_ComponentUnsignedByte = 5121;
+	const int g_ComponentShort = 5122;
+	const int g_ComponentUnsignedShort = 5123;
+	const int g_ComponentUnsignedInt = 5125;
+	const int g_ComponentFloat = 5126;
+
+	// glTF primitive mode for triangle lists
+	const int g_ModeTriangles = 4;
+
+	const double g_PowersOfTen[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	/***********************************************************
+	 *  SkipSpaces()
+	 *
+	 *  Move past spaces and tabs, but not past the line end.
+	 ***********************************************************/
+	const char* SkipSpaces(const char* p, const char* end)
+	{
+		while ((p < end) && ((*p == ' ') || (*p == '\t')))
+		{
+			p++;
+		}
+		return(p);
+	}
+
+	/***********************************************************
+	 *  SkipLine()
+	 *
+	 *  Move to the first character of the next line.
+	 ***********************************************************/
+	const char* SkipLine(const char* p, const char* end)
+	{
+		while ((p < end) && (*p != '\n'))
+		{
+			p++;
+		}
+		return((p < end) ? p + 1 : end);
+	}
+
+	/***********************************************************
+	 *  ParseInt()
+	 *
+	 *  Read a signed decimal integer.
+	 ***********************************************************/
+	bool ParseInt(const char*& p, const char* end, int& value)
+	{
+		bool bNegative = false;
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		long long result = 0;
+		const char* start = p;
+		while ((p < end) && (*p >= '0') && (*p <= '9'))
+		{
+			if (result < 0x7FFFFFFF)
+			{
+				result = result * 10 + (*p - '0');
+			}
+			p++;
+		}
+		if ((p == start) || (result > 0x7FFFFFFF))
+		{
+			return(false);
+		}
+
+		value = bNegative ? -(int)result : (int)result;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseDouble()
+	 *
+	 *  Read a decimal floating point number.  This does not
+	 *  depend on the locale and is much faster than strtod.
+	 ***********************************************************/
+	bool ParseDouble(const char*& p, const char* end, double& value)
+	{
+		p = SkipSpaces(p, end);
+
+		bool bNegative = false;
+		if ((p < end) && ((*p == '-') || (*p == '+')))
+		{
+			bNegative = (*p == '-');
+			p++;
+		}
+
+		unsigned long long mantissa = 0;
+		int exponent = 0;
+		bool bDigits = false;
+		while ((p < end) && (*p >= '0') && (*p <= '9'))
+		{
+			if (mantissa < 100000000000000000ULL)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+			}
+			else
+			{
+				exponent++;
+			}
+			bDigits = true;
+			p++;
+		}
+		if ((p < end) && (*p == '.'))
+		{
+			p++;
+			while ((p < end) && (*p >= '0') && (*p <= '9'))
+			{
+				if (mantissa < 100000000000000000ULL)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					exponent--;
+				}
+				bDigits = true;
+				p++;
+			}
+		}
+		if (bDigits == false)
+		{
+			return(false);
+		}
+
+		if ((p < end) && ((*p == 'e') || (*p == 'E')))
+		{
+			p++;
+			int power = 0;
+			if (ParseInt(p, end, power) == false)
+			{
+				return(false);
+			}
+			exponent += glm::clamp(power, -400, 400);
+		}
+
+		double result = (double)mantissa;
+		if (exponent < 0)
+		{
+			result = (-exponent <= 22) ? result / g_PowersOfTen[-exponent] : result * std::pow(10.0, exponent);
+		}
+		else if (exponent > 0)
+		{
+			result = (exponent <= 22) ? result * g_PowersOfTen[exponent] : result * std::pow(10.0, exponent);
+		}
+
+		value = bNegative ? -result : result;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseFloat()
+	 *
+	 *  Read a decimal number as a float.
+	 ***********************************************************/
+	bool ParseFloat(const char*& p, const char* end, float& value)
+	{
+		double result = 0.0;
+		if (ParseDouble(p, end, result) == false)
+		{
+			return(false);
+		}
+		value = (float)result;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  OBJ_CORNER
+	 *
+	 *  Zero based position, UV and normal index of one face
+	 *  corner, -1 when the attribute is missing.
+	 ***********************************************************/
+	struct OBJ_CORNER
+	{
+		int attribute[3];
+	};
+
+	enum OBJ_ATTRIBUTE
+	{
+		OBJ_POSITION = 0,
+		OBJ_UV,
+		OBJ_NORMAL
+	};
+
+	/***********************************************************
+	 *  HashCorner()
+	 *
+	 *  Hash the three indices of a face corner.
+	 ***********************************************************/
+	uint32_t HashCorner(const OBJ_CORNER& corner)
+	{
+		uint32_t hash =
+			((uint32_t)corner.attribute[OBJ_POSITION] * 73856093u) ^
+			((uint32_t)corner.attribute[OBJ_UV] * 19349663u) ^
+			((uint32_t)corner.attribute[OBJ_NORMAL] * 83492791u);
+		return(hash ^ (hash >> 13));
+	}
+
+	/***********************************************************
+	 *  OBJ_CHUNK
+	 *
+	 *  The lines of one part of an OBJ file and the values that
+	 *  were read from them.  Relative indices cannot be resolved
+	 *  until the counts of the earlier chunks are known, so they
+	 *  are listed to be fixed up after parsing.
+	 ***********************************************************/
+	struct OBJ_CHUNK
+	{
+		const char* begin;
+		const char* end;
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		// three corners for each triangle
+		std::vector<OBJ_CORNER> corners;
+		// corner * 3 + attribute of every relative index
+		std::vector<size_t> relativeIndices;
+
+		bool bError;
+		const char* errorLine;
+	};
+
+	/***********************************************************
+	 *  ParseFaceCorner()
+	 *
+	 *  Read one v, v/vt, v//vn or v/vt/vn face corner.
+	 ***********************************************************/
+	bool ParseFaceCorner(const char*& p, const char* end, OBJ_CHUNK& chunk, OBJ_CORNER& corner, size_t relative[3], int& relativeCount)
+	{
+		const size_t counts[3] = { chunk.positions.size(), chunk.uvs.size(), chunk.normals.size() };
+
+		corner.attribute[OBJ_POSITION] = -1;
+		corner.attribute[OBJ_UV] = -1;
+		corner.attribute[OBJ_NORMAL] = -1;
+		relativeCount = 0;
+		for (int a = 0; a < 3; a++)
+		{
+			if (a > 0)
+			{
+				if ((p >= end) || (*p != '/'))
+				{
+					break;
+				}
+				p++;
+				// an empty UV index, as in v//vn
+				if ((p < end) && (*p == '/'))
+				{
+					continue;
+				}
+			}
+
+			int index = 0;
+			if ((ParseInt(p, end, index) == false) || (index == 0))
+			{
+				return(false);
+			}
+			if (index > 0)
+			{
+				corner.attribute[a] = index - 1;
+			}
+			else
+			{
+				// counted back from the last value read so far
+				corner.attribute[a] = (int)counts[a] + index;
+				relative[relativeCount++] = (size_t)a;
+			}
+		}
+
+		return((p >= end) || (*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'));
+	}
+
+	/***********************************************************
+	 *  ParseOBJChunk()
+	 *
+	 *  Read the vertex and face lines of one chunk.  Faces with
+	 *  more than three corners are split into a fan.
+	 ***********************************************************/
+	void ParseOBJChunk(OBJ_CHUNK& chunk)
+	{
+		std::vector<OBJ_CORNER> face;
+		std::vector<size_t> faceRelative;
+		const char* end = chunk.end;
+		const char* line = chunk.begin;
+
+		while (line < end)
+		{
+			const char* p = SkipSpaces(line, end);
+			bool bValid = true;
+
+			if ((end - p >= 2) && (p[0] == 'v') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				glm::vec3 position;
+				p += 2;
+				bValid = ParseFloat(p, end, position.x) && ParseFloat(p, end, position.y) && ParseFloat(p, end, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if ((end - p >= 3) && (p[0] == 'v') && (p[1] == 't') && ((p[2] == ' ') || (p[2] == '\t')))
+			{
+				// the second UV value is optional
+				glm::vec2 uv(0.0f);
+				p += 3;
+				bValid = ParseFloat(p, end, uv.x);
+				const char* next = p;
+				if (ParseFloat(next, end, uv.y))
+				{
+					p = next;
+				}
+				chunk.uvs.push_back(uv);
+			}
+			else if ((end - p >= 3) && (p[0] == 'v') && (p[1] == 'n') && ((p[2] == ' ') || (p[2] == '\t')))
+			{
+				glm::vec3 normal;
+				p += 3;
+				bValid = ParseFloat(p, end, normal.x) && ParseFloat(p, end, normal.y) && ParseFloat(p, end, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if ((end - p >= 2) && (p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+			{
+				face.clear();
+				faceRelative.clear();
+				p = SkipSpaces(p + 2, end);
+				while (bValid && (p < end) && (*p != '\r') && (*p != '\n'))
+				{
+					OBJ_CORNER corner;
+					size_t relative[3];
+					int relativeCount = 0;
+					bValid = ParseFaceCorner(p, end, chunk, corner, relative, relativeCount);
+					for (int r = 0; r < relativeCount; r++)
+					{
+						faceRelative.push_back(face.size() * 3 + relative[r]);
+					}
+					face.push_back(corner);
+					p = SkipSpaces(p, end);
+				}
+				bValid = bValid && (face.size() >= 3);
+
+				for (size_t i = 1; bValid && (i + 1 < face.size()); i++)
+				{
+					size_t firstCorner = chunk.corners.size();
+					chunk.corners.push_back(face[0]);
+					chunk.corners.push_back(face[i]);
+					chunk.corners.push_back(face[i + 1]);
+
+					// list the relative indices of the triangle corners
+					for (size_t r = 0; r < faceRelative.size(); r++)
+					{
+						size_t faceCorner = faceRelative[r] / 3;
+						size_t attribute = faceRelative[r] % 3;
+						if (faceCorner == 0)
+						{
+							chunk.relativeIndices.push_back(firstCorner * 3 + attribute);
+						}
+						else if (faceCorner == i)
+						{
+							chunk.relativeIndices.push_back((firstCorner + 1) * 3 + attribute);
+						}
+						else if (faceCorner == i + 1)
+						{
+							chunk.relativeIndices.push_back((firstCorner + 2) * 3 + attribute);
+						}
+					}
+				}
+			}
+
+			if (bValid == false)
+			{
+				chunk.bError = true;
+				chunk.errorLine = line;
+				return;
+			}
+
+			line = SkipLine(p, end);
+		}
+	}
+
+	/***********************************************************
+	 *  JSON_VALUE
+	 *
+	 *  One value of a parsed JSON document.  Objects keep their
+	 *  member names in keys and their values in items.
+	 ***********************************************************/
+	struct JSON_VALUE
+	{
+		enum TYPE
+		{
+			JSON_NULL = 0,
+			JSON_BOOL,
+			JSON_NUMBER,
+			JSON_STRING,
+			JSON_ARRAY,
+			JSON_OBJECT
+		};
+
+		TYPE type;
+		double number;
+		std::string text;
+		std::vector<std::string> keys;
+		std::vector<JSON_VALUE> items;
+
+		JSON_VALUE()
+		{
+			type = JSON_NULL;
+			number = 0.0;
+		}
+
+		// get an object member, NULL when it is missing
+		const JSON_VALUE* Find(const char* key) const
+		{
+			if (type != JSON_OBJECT)
+			{
+				return(NULL);
+			}
+			for (size_t i = 0; i < keys.size(); i++)
+			{
+				if (keys[i] == key)
+				{
+					return(&items[i]);
+				}
+			}
+			return(NULL);
+		}
+
+		// get an array item, NULL when the index is out of range
+		const JSON_VALUE* At(int index) const
+		{
+			if ((type != JSON_ARRAY) || (index < 0) || ((size_t)index >= items.size()))
+			{
+				return(NULL);
+			}
+			return(&items[(size_t)index]);
+		}
+
+		// get a numeric object member, or the default when it is missing
+		double GetNumber(const char* key, double defaultValue) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			if ((NULL == pValue) || (pValue->type != JSON_NUMBER))
+			{
+				return(defaultValue);
+			}
+			return(pValue->number);
+		}
+	};
+
+	/***********************************************************
+	 *  SkipJSONSpace()
+	 *
+	 *  Move past JSON white space.
+	 ***********************************************************/
+	void SkipJSONSpace(const char*& p, const char* end)
+	{
+		while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')))
+		{
+			p++;
+		}
+	}
+
+	/***********************************************************
+	 *  ParseJSONString()
+	 *
+	 *  Read a quoted JSON string and decode its escapes.
+	 ***********************************************************/
+	bool ParseJSONString(const char*& p, const char* end, std::string& text)
+	{
+		text.clear();
+		if ((p >= end) || (*p != '"'))
+		{
+			return(false);
+		}
+		p++;
+
+		while ((p < end) && (*p != '"'))
+		{
+			if (*p != '\\')
+			{
+				text.push_back(*p++);
+				continue;
+			}
+
+			p++;
+			if (p >= end)
+			{
+				return(false);
+			}
+			char escape = *p++;
+			switch (escape)
+			{
+			case 'b': text.push_back('\b'); break;
+			case 'f': text.push_back('\f'); break;
+			case 'n': text.push_back('\n'); break;
+			case 'r': text.push_back('\r'); break;
+			case 't': text.push_back('\t'); break;
+			case 'u':
+			{
+				if (end - p < 4)
+				{
+					return(false);
+				}
+				unsigned int code = 0;
+				for (int i = 0; i < 4; i++)
+				{
+					char c = *p++;
+					code <<= 4;
+					if ((c >= '0') && (c <= '9')) code |= (unsigned int)(c - '0');
+					else if ((c >= 'a') && (c <= 'f')) code |= (unsigned int)(c - 'a' + 10);
+					else if ((c >= 'A') && (c <= 'F')) code |= (unsigned int)(c - 'A' + 10);
+					else return(false);
+				}
+				// stored as UTF-8, the names used by glTF are plain ASCII
+				if (code < 0x80)
+				{
+					text.push_back((char)code);
+				}
+				else if (code < 0x800)
+				{
+					text.push_back((char)(0xC0 | (code >> 6)));
+					text.push_back((char)(0x80 | (code & 0x3F)));
+				}
+				else
+				{
+					text.push_back((char)(0xE0 | (code >> 12)));
+					text.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+					text.push_back((char)(0x80 | (code & 0x3F)));
+				}
+				break;
+			}
+			default:
+				text.push_back(escape);
+				break;
+			}
+		}
+
+		if (p >= end)
+		{
+			return(false);
+		}
+		p++;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseJSONValue()
+	 *
+	 *  Read any JSON value, recursing into arrays and objects.
+	 ***********************************************************/
+	bool ParseJSONValue(const char*& p, const char* end, int depth, JSON_VALUE& value)
+	{
+		SkipJSONSpace(p, end);
+		if ((p >= end) || (depth > g_MaximumDepth))
+		{
+			return(false);
+		}
+
+		if (*p == '{')
+		{
+			value.type = JSON_VALUE::JSON_OBJECT;
+			p++;
+			SkipJSONSpace(p, end);
+			if ((p < end) && (*p == '}'))
+			{
+				p++;
+				return(true);
+			}
+			while (p < end)
+			{
+				std::string key;
+				SkipJSONSpace(p, end);
+				if (ParseJSONString(p, end, key) == false)
+				{
+					return(false);
+				}
+				SkipJSONSpace(p, end);
+				if ((p >= end) || (*p != ':'))
+				{
+					return(false);
+				}
+				p++;
+				value.keys.push_back(key);
+				value.items.push_back(JSON_VALUE());
+				if (ParseJSONValue(p, end, depth + 1, value.items.back()) == false)
+				{
+					return(false);
+				}
+				SkipJSONSpace(p, end);
+				if ((p < end) && (*p == ','))
+				{
+					p++;
+				}
+				else if ((p < end) && (*p == '}'))
+				{
+					p++;
+					return(true);
+				}
+				else
+				{
+					return(false);
+				}
+			}
+			return(false);
+		}
+
+		if (*p == '[')
+		{
+			value.type = JSON_VALUE::JSON_ARRAY;
+			p++;
+			SkipJSONSpace(p, end);
+			if ((p < end) && (*p == ']'))
+			{
+				p++;
+				return(true);
+			}
+			while (p < end)
+			{
+				value.items.push_back(JSON_VALUE());
+				if (ParseJSONValue(p, end, depth + 1, value.items.back()) == false)
+				{
+					return(false);
+				}
+				SkipJSONSpace(p, end);
+				if ((p < end) && (*p == ','))
+				{
+					p++;
+				}
+				else if ((p < end) && (*p == ']'))
+				{
+					p++;
+					return(true);
+				}
+				else
+				{
+					return(false);
+				}
+			}
+			return(false);
+		}
+
+		if (*p == '"')
+		{
+			value.type = JSON_VALUE::JSON_STRING;
+			return(ParseJSONString(p, end, value.text));
+		}
+
+		if ((end - p >= 4) && (strncmp(p, "true", 4) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			value.number = 1.0;
+			p += 4;
+			return(true);
+		}
+		if ((end - p >= 5) && (strncmp(p, "false", 5) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			value.number = 0.0;
+			p += 5;
+			return(true);
+		}
+		if ((end - p >= 4) && (strncmp(p, "null", 4) == 0))
+		{
+			value.type = JSON_VALUE::JSON_NULL;
+			p += 4;
+			return(true);
+		}
+
+		value.type = JSON_VALUE::JSON_NUMBER;
+		return(ParseDouble(p, end, value.number));
+	}
+
+	/***********************************************************
+	 *  GLB_ACCESSOR
+	 *
+	 *  Location and layout of a glTF accessor inside the mapped
+	 *  binary chunk, so that its values are read in place.
+	 ***********************************************************/
+	struct GLB_ACCESSOR
+	{
+		const unsigned char* pData;
+		size_t count;
+		size_t stride;
+		int componentType;
+		int componentCount;
+		bool bNormalized;
+	};
+
+	/***********************************************************
+	 *  GetComponentSize()
+	 *
+	 *  Get the size in bytes of a glTF component type.
+	 ***********************************************************/
+	size_t GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case g_ComponentByte:
+		case g_ComponentUnsignedByte:
+			return(1);
+		case g_ComponentShort:
+		case g_ComponentUnsignedShort:
+			return(2);
+		case g_ComponentUnsignedInt:
+		case g_ComponentFloat:
+			return(4);
+		}
+		return(0);
+	}
+
+	/***********************************************************
+	 *  GetComponentCount()
+	 *
+	 *  Get the number of components of a glTF accessor type.
+	 ***********************************************************/
+	int GetComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return(1);
+		if (type == "VEC2") return(2);
+		if (type == "VEC3") return(3);
+		if (type == "VEC4") return(4);
+		return(0);
+	}
+
+	/***********************************************************
+	 *  GetAccessor()
+	 *
+	 *  Find an accessor and check that all of its elements lie
+	 *  inside its buffer view and the binary chunk.
+	 ***********************************************************/
+	bool GetAccessor(
+		const JSON_VALUE& root,
+		int index,
+		const unsigned char* pBinary,
+		size_t binarySize,
+		GLB_ACCESSOR& accessor)
+	{
+		const JSON_VALUE* pAccessors = root.Find("accessors");
+		const JSON_VALUE* pViews = root.Find("bufferViews");
+		const JSON_VALUE* pAccessor = (NULL != pAccessors) ? pAccessors->At(index) : NULL;
+		if (NULL == pAccessor)
+		{
+			return(false);
+		}
+
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		accessor.componentType = (int)pAccessor->GetNumber("componentType", 0.0);
+		accessor.componentCount = (NULL != pType) ? GetComponentCount(pType->text) : 0;
+		accessor.count = (size_t)pAccessor->GetNumber("count", 0.0);
+		const JSON_VALUE* pNormalized = pAccessor->Find("normalized");
+		accessor.bNormalized = (NULL != pNormalized) && (pNormalized->number != 0.0);
+
+		size_t componentSize = GetComponentSize(accessor.componentType);
+		size_t elementSize = componentSize * (size_t)accessor.componentCount;
+		const JSON_VALUE* pView = (NULL != pViews) ? pViews->At((int)pAccessor->GetNumber("bufferView", -1.0)) : NULL;
+		if ((elementSize == 0) || (NULL == pView) || (NULL != pAccessor->Find("sparse")) ||
+			(pView->GetNumber("buffer", 0.0) != 0.0) || (NULL == pBinary))
+		{
+			return(false);
+		}
+
+		size_t viewOffset = (size_t)pView->GetNumber("byteOffset", 0.0);
+		size_t viewLength = (size_t)pView->GetNumber("byteLength", 0.0);
+		size_t accessorOffset = (size_t)pAccessor->GetNumber("byteOffset", 0.0);
+		accessor.stride = (size_t)pView->GetNumber("byteStride", 0.0);
+		if (accessor.stride == 0)
+		{
+			accessor.stride = elementSize;
+		}
+
+		if ((viewOffset > binarySize) || (viewLength > binarySize - viewOffset) || (accessor.stride < elementSize) ||
+			((accessorOffset % componentSize) != 0) || ((viewOffset % componentSize) != 0))
+		{
+			return(false);
+		}
+		if ((accessor.count > 0) &&
+			((accessorOffset > viewLength) ||
+			((viewLength - accessorOffset - elementSize) / accessor.stride < accessor.count - 1) ||
+			(viewLength - accessorOffset < elementSize)))
+		{
+			return(false);
+		}
+
+		accessor.pData = pBinary + viewOffset + accessorOffset;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ReadComponent()
+	 *
+	 *  Read one component of an accessor element as a float.
+	 ***********************************************************/
+	float ReadComponent(const GLB_ACCESSOR& accessor, size_t element, int component)
+	{
+		const unsigned char* p = accessor.pData + element * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case g_ComponentFloat:
+		{
+			float value;
+			memcpy(&value, p + component * 4, 4);
+			return(value);
+		}
+		case g_ComponentUnsignedByte:
+		{
+			float value = (float)p[component];
+			return(accessor.bNormalized ? value / 255.0f : value);
+		}
+		case g_ComponentByte:
+		{
+			float value = (float)(signed char)p[component];
+			return(accessor.bNormalized ? glm::max(value / 127.0f, -1.0f) : value);
+		}
+		case g_ComponentUnsignedShort:
+		{
+			uint16_t value;
+			memcpy(&value, p + component * 2, 2);
+			return(accessor.bNormalized ? (float)value / 65535.0f : (float)value);
+		}
+		case g_ComponentShort:
+		{
+			int16_t value;
+			memcpy(&value, p + component * 2, 2);
+			return(accessor.bNormalized ? glm::max((float)value / 32767.0f, -1.0f) : (float)value);
+		}
+		case g_ComponentUnsignedInt:
+		{
+			uint32_t value;
+			memcpy(&value, p + component * 4, 4);
+			return((float)value);
+		}
+		}
+		return(0.0f);
+	}
+
+	/***********************************************************
+	 *  ReadIndex()
+	 *
+	 *  Read one element of an index accessor.
+	 ***********************************************************/
+	GLuint ReadIndex(const GLB_ACCESSOR& accessor, size_t element)
+	{
+		const unsigned char* p = accessor.pData + element * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case g_ComponentUnsignedByte:
+			return(p[0]);
+		case g_ComponentUnsignedShort:
+		{
+			uint16_t value;
+			memcpy(&value, p, 2);
+			return(value);
+		}
+		case g_ComponentUnsignedInt:
+		{
+			uint32_t value;
+			memcpy(&value, p, 4);
+			return(value);
+		}
+		}
+		return(0xFFFFFFFF);
+	}
+
+	/***********************************************************
+	 *  GetNodeMatrix()
+	 *
+	 *  Get the local transform of a glTF node, either from its
+	 *  matrix or from its translation, rotation and scale.
+	 ***********************************************************/
+	glm::mat4 GetNodeMatrix(const JSON_VALUE& node)
+	{
+		glm::mat4 matrix(1.0f);
+
+		const JSON_VALUE* pMatrix = node.Find("matrix");
+		if ((NULL != pMatrix) && (pMatrix->items.size() == 16))
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					matrix[c][r] = (float)pMatrix->items[c * 4 + r].number;
+				}
+			}
+			return(matrix);
+		}
+
+		const JSON_VALUE* pTranslation = node.Find("translation");
+		const JSON_VALUE* pRotation = node.Find("rotation");
+		const JSON_VALUE* pScale = node.Find("scale");
+
+		if ((NULL != pRotation) && (pRotation->items.size() == 4))
+		{
+			float x = (float)pRotation->items[0].number;
+			float y = (float)pRotation->items[1].number;
+			float z = (float)pRotation->items[2].number;
+			float w = (float)pRotation->items[3].number;
+			matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f);
+			matrix[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f);
+			matrix[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+		}
+		if ((NULL != pScale) && (pScale->items.size() == 3))
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				matrix[c] = matrix[c] * (float)pScale->items[c].number;
+			}
+		}
+		if ((NULL != pTranslation) && (pTranslation->items.size() == 3))
+		{
+			matrix[3] = glm::vec4(
+				(float)pTranslation->items[0].number,
+				(float)pTranslation->items[1].number,
+				(float)pTranslation->items[2].number,
+				1.0f);
+		}
+
+		return(matrix);
+	}
+
+	/***********************************************************
+	 *  GenerateNormals()
+	 *
+	 *  Give every vertex in a range the area weighted average
+	 *  normal of the triangles in an index range that use it.
+	 ***********************************************************/
+	void GenerateNormals(MESH_DATA& mesh, size_t firstVertex, size_t firstIndex)
+	{
+		for (size_t i = firstVertex; i < mesh.normals.size(); i++)
+		{
+			mesh.normals[i] = glm::vec3(0.0f);
+		}
+		for (size_t i = firstIndex; i + 2 < mesh.indices.size(); i += 3)
+		{
+			GLuint a = mesh.indices[i];
+			GLuint b = mesh.indices[i + 1];
+			GLuint c = mesh.indices[i + 2];
+			glm::vec3 normal = glm::cross(mesh.positions[b] - mesh.positions[a], mesh.positions[c] - mesh.positions[a]);
+			mesh.normals[a] += normal;
+			mesh.normals[b] += normal;
+			mesh.normals[c] += normal;
+		}
+		for (size_t i = firstVertex; i < mesh.normals.size(); i++)
+		{
+			float length = glm::length(mesh.normals[i]);
+			mesh.normals[i] = (length > 0.0f) ? mesh.normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		}
+	}
+
+	/***********************************************************
+	 *  AppendPrimitive()
+	 *
+	 *  Add one glTF triangle primitive to the mesh, reading its
+	 *  accessors from the mapped file and transforming it into
+	 *  the space of the scene.
+	 ***********************************************************/
+	bool AppendPrimitive(
+		const JSON_VALUE& root,
+		const JSON_VALUE& primitive,
+		const glm::mat4& transform,
+		const unsigned char* pBinary,
+		size_t binarySize,
+		MESH_DATA& mesh)
+	{
+		if ((int)primitive.GetNumber("mode", g_ModeTriangles) != g_ModeTriangles)
+		{
+			std::cout << "INFO: Skipping a glTF primitive that is not a triangle list" << std::endl;
+			return(true);
+		}
+
+		const JSON_VALUE* pAttributes = primitive.Find("attributes");
+		if (NULL == pAttributes)
+		{
+			return(false);
+		}
+
+		GLB_ACCESSOR positions;
+		GLB_ACCESSOR normals;
+		GLB_ACCESSOR uvs;
+		GLB_ACCESSOR indices;
+		if ((GetAccessor(root, (int)pAttributes->GetNumber("POSITION", -1.0), pBinary, binarySize, positions) == false) ||
+			(positions.componentCount != 3) || (positions.count == 0))
+		{
+			return(false);
+		}
+		bool bNormals = GetAccessor(root, (int)pAttributes->GetNumber("NORMAL", -1.0), pBinary, binarySize, normals) &&
+			(normals.componentCount == 3) && (normals.count == positions.count);
+		bool bUVs = GetAccessor(root, (int)pAttributes->GetNumber("TEXCOORD_0", -1.0), pBinary, binarySize, uvs) &&
+			(uvs.componentCount == 2) && (uvs.count == positions.count);
+		bool bIndices = (NULL != primitive.Find("indices"));
+		if (bIndices &&
+			((GetAccessor(root, (int)primitive.GetNumber("indices", -1.0), pBinary, binarySize, indices) == false) ||
+			(indices.componentCount != 1) || (indices.componentType == g_ComponentFloat)))
+		{
+			return(false);
+		}
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+		bool bMirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+		size_t firstVertex = mesh.positions.size();
+		size_t firstIndex = mesh.indices.size();
+		size_t vertexCount = positions.count;
+		mesh.positions.resize(firstVertex + vertexCount);
+		mesh.normals.resize(firstVertex + vertexCount);
+		mesh.uvs.resize(firstVertex + vertexCount);
+
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			glm::vec4 position(ReadComponent(positions, i, 0), ReadComponent(positions, i, 1), ReadComponent(positions, i, 2), 1.0f);
+			position = transform * position;
+			mesh.positions[firstVertex + i] = glm::vec3(position.x, position.y, position.z);
+
+			if (bNormals)
+			{
+				glm::vec3 normal(ReadComponent(normals, i, 0), ReadComponent(normals, i, 1), ReadComponent(normals, i, 2));
+				normal = normalMatrix * normal;
+				float length = glm::length(normal);
+				mesh.normals[firstVertex + i] = (length > 0.0f) ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+
+			// glTF UVs start at the top of the image, the textures
+			// of the scene are flipped when they are loaded
+			if (bUVs)
+			{
+				mesh.uvs[firstVertex + i] = glm::vec2(ReadComponent(uvs, i, 0), 1.0f - ReadComponent(uvs, i, 1));
+			}
+			else
+			{
+				mesh.uvs[firstVertex + i] = glm::vec2(0.0f);
+			}
+		}
+
+		size_t indexCount = bIndices ? indices.count : vertexCount;
+		indexCount -= indexCount % 3;
+		mesh.indices.reserve(firstIndex + indexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			GLuint triangle[3];
+			for (int k = 0; k < 3; k++)
+			{
+				triangle[k] = bIndices ? ReadIndex(indices, i + k) : (GLuint)(i + k);
+				if (triangle[k] >= vertexCount)
+				{
+					return(false);
+				}
+				triangle[k] += (GLuint)firstVertex;
+			}
+			if (bMirrored)
+			{
+				mesh.AddTriangle(triangle[0], triangle[2], triangle[1]);
+			}
+			else
+			{
+				mesh.AddTriangle(triangle[0], triangle[1], triangle[2]);
+			}
+		}
+
+		if (bNormals == false)
+		{
+			GenerateNormals(mesh, firstVertex, firstIndex);
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  AppendNode()
+	 *
+	 *  Add the mesh of a glTF node and of all of its children.
+	 ***********************************************************/
+	bool AppendNode(
+		const JSON_VALUE& root,
+		int nodeIndex,
+		const glm::mat4& parentTransform,
+		int depth,
+		const unsigned char* pBinary,
+		size_t binarySize,
+		MESH_DATA& mesh)
+	{
+		const JSON_VALUE* pNodes = root.Find("nodes");
+		const JSON_VALUE* pNode = (NULL != pNodes) ? pNodes->At(nodeIndex) : NULL;
+		if ((NULL == pNode) || (depth > g_MaximumDepth))
+		{
+			return(false);
+		}
+
+		glm::mat4 transform = parentTransform * GetNodeMatrix(*pNode);
+
+		if (NULL != pNode->Find("mesh"))
+		{
+			const JSON_VALUE* pMeshes = root.Find("meshes");
+			const JSON_VALUE* pMesh = (NULL != pMeshes) ? pMeshes->At((int)pNode->GetNumber("mesh", -1.0)) : NULL;
+			const JSON_VALUE* pPrimitives = (NULL != pMesh) ? pMesh->Find("primitives") : NULL;
+			if (NULL == pPrimitives)
+			{
+				return(false);
+			}
+			for (size_t i = 0; i < pPrimitives->items.size(); i++)
+			{
+				if (AppendPrimitive(root, pPrimitives->items[i], transform, pBinary, binarySize, mesh) == false)
+				{
+					return(false);
+				}
+			}
+		}
+
+		const JSON_VALUE* pChildren = pNode->Find("children");
+		if (NULL != pChildren)
+		{
+			for (size_t i = 0; i < pChildren->items.size(); i++)
+			{
+				if (AppendNode(root, (int)pChildren->items[i].number, transform, depth + 1, pBinary, binarySize, mesh) == false)
+				{
+					return(false);
+				}
+			}
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ImportMeshFile()
+	 *
+	 *  Import a mesh file with the importer that matches its
+	 *  extension.
+	 ***********************************************************/
+	bool ImportMeshFile(const char* filename, MESH_DATA& mesh)
+	{
+		std::string extension = filename;
+		size_t dot = extension.find_last_of('.');
+		extension = (dot == std::string::npos) ? "" : extension.substr(dot);
+		for (size_t i = 0; i < extension.size(); i++)
+		{
+			extension[i] = (char)std::tolower((unsigned char)extension[i]);
+		}
+
+		if (extension == ".obj")
+		{
+			return(ImportOBJ(filename, mesh));
+		}
+		if (extension == ".glb")
+		{
+			return(ImportGLB(filename, mesh));
+		}
+
+		std::cout << "ERROR: Mesh file " << filename << " is not an OBJ or GLB file" << std::endl;
+		return(false);
+	}
+}
+
+/***********************************************************
+ *  ImportMesh()
+ *
+ *  This function is used for importing a mesh file with the
+ *  importer that matches its extension.  The import speed is
+ *  printed in megabytes of the file per second, so a large
+ *  file shows how close the parser comes to the disk speed.
+ ***********************************************************/
+bool ImportMesh(const char* filename, MESH_DATA& mesh)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool bImported = ImportMeshFile(filename, mesh);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t fileSize = 0;
+	uint64_t writeTime = 0;
+	if (bImported && GetMeshFileStamp(filename, fileSize, writeTime) && (seconds > 0.0))
+	{
+		double megabytes = (double)fileSize / (1024.0 * 1024.0);
+		std::cout << "INFO: Imported " << megabytes << " MB in " << seconds << " s, "
+			<< megabytes / seconds << " MB/s" << std::endl;
+	}
+
+	return(bImported);
+}
+
+/***********************************************************
+ *  ImportOBJ()
+ *
+ *  This function is used for importing a Wavefront OBJ file.
+ *  The mapped text is split into one chunk per thread at
+ *  line breaks and the chunks are parsed in parallel.  The
+ *  chunk results are then joined, and every unique
+ *  position, UV and normal combination becomes one vertex.
+ *  Normals are generated when the file does not have them.
+ ***********************************************************/
+bool ImportOBJ(const char* filename, MESH_DATA& mesh)
+{
+	mesh.Clear();
+
+	MappedFile file;
+	if (file.Open(filename) == false)
+	{
+		std::cout << "ERROR: Could not open mesh file " << filename << std::endl;
+		return(false);
+	}
+
+	const char* text = (const char*)file.GetData();
+	const char* textEnd = text + file.GetSize();
+
+	// split the text at line breaks
+	ThreadPool& pool = ThreadPool::GetSharedPool();
+	size_t chunkCount = std::max((size_t)1, std::min((size_t)pool.GetThreadCount() * 4, file.GetSize() / g_MinimumChunkBytes));
+	std::vector<OBJ_CHUNK> chunks(chunkCount);
+	const char* chunkStart = text;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const char* chunkEnd = (c + 1 == chunkCount) ? textEnd : text + file.GetSize() / chunkCount * (c + 1);
+		chunkEnd = (chunkEnd <= chunkStart) ? chunkStart : SkipLine(chunkEnd - 1, textEnd);
+		chunks[c].begin = chunkStart;
+		chunks[c].end = chunkEnd;
+		chunks[c].bError = false;
+		chunks[c].errorLine = NULL;
+		chunkStart = chunkEnd;
+	}
+
+	pool.ParallelFor(chunkCount, 1,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+			{
+				ParseOBJChunk(chunks[c]);
+			}
+		});
+
+	// index of the first value of each chunk in the whole file
+	std::vector<size_t> offsets[3];
+	size_t totals[3] = { 0, 0, 0 };
+	size_t cornerCount = 0;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		if (chunks[c].bError)
+		{
+			const char* lineEnd = chunks[c].errorLine;
+			while ((lineEnd < textEnd) && (*lineEnd != '\r') && (*lineEnd != '\n') && (lineEnd - chunks[c].errorLine < 80))
+			{
+				lineEnd++;
+			}
+			std::cout << "ERROR: Could not read the line \"" << std::string(chunks[c].errorLine, lineEnd)
+				<< "\" of mesh file " << filename << std::endl;
+			return(false);
+		}
+
+		offsets[OBJ_POSITION].push_back(totals[OBJ_POSITION]);
+		offsets[OBJ_UV].push_back(totals[OBJ_UV]);
+		offsets[OBJ_NORMAL].push_back(totals[OBJ_NORMAL]);
+		totals[OBJ_POSITION] += chunks[c].positions.size();
+		totals[OBJ_UV] += chunks[c].uvs.size();
+		totals[OBJ_NORMAL] += chunks[c].normals.size();
+		cornerCount += chunks[c].corners.size();
+	}
+
+	if (cornerCount == 0)
+	{
+		std::cout << "ERROR: Mesh file " << filename << " has no faces" << std::endl;
+		return(false);
+	}
+	if ((totals[OBJ_POSITION] >= 0x7FFFFFFF) || (totals[OBJ_UV] >= 0x7FFFFFFF) ||
+		(totals[OBJ_NORMAL] >= 0x7FFFFFFF) || (cornerCount >= 0xFFFFFFFF))
+	{
+		std::cout << "ERROR: Mesh file " << filename << " is too large to import" << std::endl;
+		return(false);
+	}
+
+	// resolve the relative indices and check every index
+	std::vector<glm::vec3> positions(totals[OBJ_POSITION]);
+	std::vector<glm::vec2> uvs(totals[OBJ_UV]);
+	std::vector<glm::vec3> normals(totals[OBJ_NORMAL]);
+	std::vector<char> chunkValid(chunkCount, 1);
+	pool.ParallelFor(chunkCount, 1,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; c++)
+			{
+				OBJ_CHUNK& chunk = chunks[c];
+				std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offsets[OBJ_POSITION][c]);
+				std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + offsets[OBJ_UV][c]);
+				std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offsets[OBJ_NORMAL][c]);
+
+				for (size_t r = 0; r < chunk.relativeIndices.size(); r++)
+				{
+					size_t attribute = chunk.relativeIndices[r] % 3;
+					chunk.corners[chunk.relativeIndices[r] / 3].attribute[attribute] += (int)offsets[attribute][c];
+				}
+
+				for (size_t i = 0; i < chunk.corners.size(); i++)
+				{
+					const OBJ_CORNER& corner = chunk.corners[i];
+					if ((corner.attribute[OBJ_POSITION] < 0) || ((size_t)corner.attribute[OBJ_POSITION] >= totals[OBJ_POSITION]) ||
+						(corner.attribute[OBJ_UV] >= (int)totals[OBJ_UV]) || (corner.attribute[OBJ_NORMAL] >= (int)totals[OBJ_NORMAL]) ||
+						(corner.attribute[OBJ_UV] < -1) || (corner.attribute[OBJ_NORMAL] < -1))
+					{
+						chunkValid[c] = 0;
+						break;
+					}
+				}
+			}
+		});
+
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		if (chunkValid[c] == 0)
+		{
+			std::cout << "ERROR: Mesh file " << filename << " has a face index that is out of range" << std::endl;
+			return(false);
+		}
+	}
+
+	// make one vertex for each unique corner, using an open
+	// addressing hash table that grows at half full
+	size_t tableSize = 1024;
+	while (tableSize < totals[OBJ_POSITION] * 2)
+	{
+		tableSize *= 2;
+	}
+	std::vector<GLuint> table(tableSize, 0xFFFFFFFF);
+	std::vector<OBJ_CORNER> uniqueCorners;
+	uniqueCorners.reserve(totals[OBJ_POSITION]);
+	mesh.indices.reserve(cornerCount);
+
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const std::vector<OBJ_CORNER>& corners = chunks[c].corners;
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			const OBJ_CORNER& corner = corners[i];
+			size_t slot = HashCorner(corner) & (tableSize - 1);
+			while ((table[slot] != 0xFFFFFFFF) && (memcmp(&uniqueCorners[table[slot]], &corner, sizeof(OBJ_CORNER)) != 0))
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] != 0xFFFFFFFF)
+			{
+				mesh.indices.push_back(table[slot]);
+				continue;
+			}
+
+			table[slot] = (GLuint)uniqueCorners.size();
+			mesh.indices.push_back((GLuint)uniqueCorners.size());
+			uniqueCorners.push_back(corner);
+
+			if (uniqueCorners.size() * 2 > tableSize)
+			{
+				tableSize *= 2;
+				table.assign(tableSize, 0xFFFFFFFF);
+				for (GLuint u = 0; u < (GLuint)uniqueCorners.size(); u++)
+				{
+					size_t uniqueSlot = HashCorner(uniqueCorners[u]) & (tableSize - 1);
+					while (table[uniqueSlot] != 0xFFFFFFFF)
+					{
+						uniqueSlot = (uniqueSlot + 1) & (tableSize - 1);
+					}
+					table[uniqueSlot] = u;
+				}
+			}
+		}
+		// the corners are not needed once they have been indexed
+		std::vector<OBJ_CORNER>().swap(chunks[c].corners);
+	}
+
+	// corners without a normal get the smoothed normal of their position
+	std::vector<glm::vec3> smoothNormals;
+	bool bMissingNormals = false;
+	for (size_t u = 0; u < uniqueCorners.size(); u++)
+	{
+		bMissingNormals = bMissingNormals || (uniqueCorners[u].attribute[OBJ_NORMAL] < 0);
+	}
+	if (bMissingNormals)
+	{
+		smoothNormals.assign(positions.size(), glm::vec3(0.0f));
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+		{
+			int a = uniqueCorners[mesh.indices[i]].attribute[OBJ_POSITION];
+			int b = uniqueCorners[mesh.indices[i + 1]].attribute[OBJ_POSITION];
+			int c = uniqueCorners[mesh.indices[i + 2]].attribute[OBJ_POSITION];
+			glm::vec3 normal = glm::cross(positions[b] - positions[a], positions[c] - positions[a]);
+			smoothNormals[a] += normal;
+			smoothNormals[b] += normal;
+			smoothNormals[c] += normal;
+		}
+	}
+
+	mesh.positions.resize(uniqueCorners.size());
+	mesh.normals.resize(uniqueCorners.size());
+	mesh.uvs.resize(uniqueCorners.size());
+	pool.ParallelFor(uniqueCorners.size(), 4096,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t u = begin; u < end; u++)
+			{
+				const OBJ_CORNER& corner = uniqueCorners[u];
+				glm::vec3 normal = (corner.attribute[OBJ_NORMAL] >= 0) ?
+					normals[corner.attribute[OBJ_NORMAL]] : smoothNormals[corner.attribute[OBJ_POSITION]];
+				float length = glm::length(normal);
+
+				mesh.positions[u] = positions[corner.attribute[OBJ_POSITION]];
+				mesh.normals[u] = (length > 0.0f) ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+				mesh.uvs[u] = (corner.attribute[OBJ_UV] >= 0) ? uvs[corner.attribute[OBJ_UV]] : glm::vec2(0.0f);
+			}
+		});
+
+	std::cout << "INFO: Imported " << filename << " - " << mesh.positions.size() << " vertices, "
+		<< mesh.indices.size() / 3 << " triangles" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ImportGLB()
+ *
+ *  This function is used for importing a binary glTF file.
+ *  The JSON chunk is parsed, and the accessors of every
+ *  triangle primitive in the default scene are read in place
+ *  from the mapped binary chunk.  Files that reference
+ *  external buffers are not supported.
+ ***********************************************************/
+bool ImportGLB(const char* filename, MESH_DATA& mesh)
+{
+	mesh.Clear();
+
+	MappedFile file;
+	if (file.Open(filename) == false)
+	{
+		std::cout << "ERROR: Could not open mesh file " << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char* pData = file.GetData();
+	size_t fileSize = file.GetSize();
+
+	uint32_t header[3] = { 0, 0, 0 };
+	if (fileSize >= sizeof(header))
+	{
+		memcpy(header, pData, sizeof(header));
+	}
+	if ((header[0] != g_GLBMagic) || (header[1] != g_GLBVersion) || (header[2] > fileSize))
+	{
+		std::cout << "ERROR: Mesh file " << filename << " is not a version 2 binary glTF file" << std::endl;
+		return(false);
+	}
+
+	// find the JSON and binary chunks
+	const char* pJSON = NULL;
+	size_t jsonSize = 0;
+	const unsigned char* pBinary = NULL;
+	size_t binarySize = 0;
+	size_t offset = sizeof(header);
+	while (offset + 8 <= header[2])
+	{
+		uint32_t chunkHeader[2];
+		memcpy(chunkHeader, pData + offset, sizeof(chunkHeader));
+		offset += 8;
+		if (chunkHeader[0] > header[2] - offset)
+		{
+			break;
+		}
+		if ((chunkHeader[1] == g_GLBChunkJSON) && (NULL == pJSON))
+		{
+			pJSON = (const char*)pData + offset;
+			jsonSize = chunkHeader[0];
+		}
+		else if ((chunkHeader[1] == g_GLBChunkBIN) && (NULL == pBinary))
+		{
+			pBinary = pData + offset;
+			binarySize = chunkHeader[0];
+		}
+		offset += (chunkHeader[0] + 3) & ~3u;
+	}
+
+	JSON_VALUE root;
+	const char* p = pJSON;
+	if ((NULL == pJSON) || (ParseJSONValue(p, pJSON + jsonSize, 0, root) == false) || (root.type != JSON_VALUE::JSON_OBJECT))
+	{
+		std::cout << "ERROR: Mesh file " << filename << " has no valid glTF JSON" << std::endl;
+		return(false);
+	}
+
+	bool bReturn = true;
+	const JSON_VALUE* pScenes = root.Find("scenes");
+	const JSON_VALUE* pScene = (NULL != pScenes) ? pScenes->At((int)root.GetNumber("scene", 0.0)) : NULL;
+	const JSON_VALUE* pSceneNodes = (NULL != pScene) ? pScene->Find("nodes") : NULL;
+	if (NULL != pSceneNodes)
+	{
+		for (size_t i = 0; bReturn && (i < pSceneNodes->items.size()); i++)
+		{
+			bReturn = AppendNode(root, (int)pSceneNodes->items[i].number, glm::mat4(1.0f), 0, pBinary, binarySize, mesh);
+		}
+	}
+	else
+	{
+		// without a scene, every mesh is imported untransformed
+		const JSON_VALUE* pMeshes = root.Find("meshes");
+		for (size_t m = 0; bReturn && (NULL != pMeshes) && (m < pMeshes->items.size()); m++)
+		{
+			const JSON_VALUE* pPrimitives = pMeshes->items[m].Find("primitives");
+			for (size_t i = 0; bReturn && (NULL != pPrimitives) && (i < pPrimitives->items.size()); i++)
+			{
+				bReturn = AppendPrimitive(root, pPrimitives->items[i], glm::mat4(1.0f), pBinary, binarySize, mesh);
+			}
+		}
+	}
+
+	if ((bReturn == false) || (mesh.indices.size() == 0))
+	{
+		std::cout << "ERROR: Mesh file " << filename << " has no valid triangle primitives" << std::endl;
+		mesh.Clear();
+		return(false);
+	}
+
+	// primitives that share vertices are joined
+	DeduplicateVertices(mesh);
+
+	std::cout << "INFO: Imported " << filename << " - " << mesh.positions.size() << " vertices, "
+		<< mesh.indices.size() / 3 << " triangles" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetMeshFileStamp()
+ *
+ *  This function is used for getting the size and the last
+ *  write time of a file, so that a cached import can be
+ *  rebuilt when the file changes.
+ ***********************************************************/
+bool GetMeshFileStamp(const char* filename, uint64_t& size, uint64_t& writeTime)
+{
+#ifdef _WIN32
+	struct _stat64 fileStatus;
+	if (_stat64(filename, &fileStatus) != 0)
+	{
+		return(false);
+	}
+#else
+	struct stat fileStatus;
+	if (stat(filename, &fileStatus) != 0)
+	{
+		return(false);
+	}
+#endif
+
+	size = (uint64_t)fileStatus.st_size;
+	writeTime = (uint64_t)fileStatus.st_mtime;
+	return(true);
+}
@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// import triangle meshes from Wavefront OBJ and binary glTF files
+//
+//	Files are mapped into memory.  OBJ text is split into chunks at line
+//	breaks and the chunks are parsed in parallel.  GLB accessors are read
+//	directly from the mapped binary chunk.  Both produce a MESH_DATA with
+//	unique vertices, ready to be processed like the generated meshes.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <cstdint>
+
+// import an OBJ or GLB file, chosen by the file extension
+bool ImportMesh(const char* filename, MESH_DATA& mesh);
+
+// import every face of a Wavefront OBJ file into one mesh
+bool ImportOBJ(const char* filename, MESH_DATA& mesh);
+
+// import every triangle primitive of a binary glTF file into one
+// mesh, with the node transforms of the default scene applied
+bool ImportGLB(const char* filename, MESH_DATA& mesh);
+
+// get the size and last write time of a file, used to detect changes
+bool GetMeshFileStamp(const char* filename, uint64_t& size, uint64_t& writeTime);
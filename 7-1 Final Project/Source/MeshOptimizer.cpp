@@ -0,0 +1,307 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// weld duplicate vertices and reorder meshes for faster GPU vertex work
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <cstdint>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	const GLuint g_EmptySlot = 0xFFFFFFFF;
+
+	/***********************************************************
+	 *  HashVertex()
+	 *
+	 *  Hash the bits of the position, normal and UV of a vertex.
+	 ***********************************************************/
+	uint32_t HashVertex(const MESH_DATA& mesh, GLuint vertex)
+	{
+		uint32_t values[8];
+		memcpy(&values[0], &mesh.positions[vertex], sizeof(float) * 3);
+		memcpy(&values[3], &mesh.normals[vertex], sizeof(float) * 3);
+		memcpy(&values[6], &mesh.uvs[vertex], sizeof(float) * 2);
+
+		uint32_t hash = 2166136261u;
+		for (int i = 0; i < 8; i++)
+		{
+			hash = (hash ^ values[i]) * 16777619u;
+		}
+		return(hash ^ (hash >> 15));
+	}
+
+	/***********************************************************
+	 *  IsSameVertex()
+	 *
+	 *  Check that two vertices have the same bits.
+	 ***********************************************************/
+	bool IsSameVertex(const MESH_DATA& mesh, GLuint a, GLuint b)
+	{
+		return(
+			(memcmp(&mesh.positions[a], &mesh.positions[b], sizeof(glm::vec3)) == 0) &&
+			(memcmp(&mesh.normals[a], &mesh.normals[b], sizeof(glm::vec3)) == 0) &&
+			(memcmp(&mesh.uvs[a], &mesh.uvs[b], sizeof(glm::vec2)) == 0));
+	}
+
+	/***********************************************************
+	 *  RemapVertices()
+	 *
+	 *  Move every vertex to its new place and rewrite the
+	 *  indices.  Vertices without a new place are dropped.
+	 ***********************************************************/
+	void RemapVertices(MESH_DATA& mesh, const std::vector<GLuint>& remap, size_t newCount)
+	{
+		std::vector<glm::vec3> positions(newCount);
+		std::vector<glm::vec3> normals(newCount);
+		std::vector<glm::vec2> uvs(newCount);
+		for (size_t i = 0; i < remap.size(); i++)
+		{
+			if (remap[i] != g_EmptySlot)
+			{
+				positions[remap[i]] = mesh.positions[i];
+				normals[remap[i]] = mesh.normals[i];
+				uvs[remap[i]] = mesh.uvs[i];
+			}
+		}
+		mesh.positions.swap(positions);
+		mesh.normals.swap(normals);
+		mesh.uvs.swap(uvs);
+
+		for (size_t i = 0; i < mesh.indices.size(); i++)
+		{
+			mesh.indices[i] = remap[mesh.indices[i]];
+		}
+	}
+}
+
+/***********************************************************
+ *  DeduplicateVertices()
+ *
+ *  This function is used for merging every group of vertices
+ *  with bit identical attributes into a single vertex, using
+ *  an open addressing hash table.
+ ***********************************************************/
+void DeduplicateVertices(MESH_DATA& mesh)
+{
+	size_t vertexCount = mesh.positions.size();
+	if (vertexCount == 0)
+	{
+		return;
+	}
+
+	size_t tableSize = 1;
+	while (tableSize < vertexCount * 2)
+	{
+		tableSize *= 2;
+	}
+	std::vector<GLuint> table(tableSize, g_EmptySlot);
+	std::vector<GLuint> remap(vertexCount);
+
+	size_t uniqueCount = 0;
+	for (GLuint i = 0; i < (GLuint)vertexCount; i++)
+	{
+		size_t slot = HashVertex(mesh, i) & (tableSize - 1);
+		while ((table[slot] != g_EmptySlot) && !IsSameVertex(mesh, table[slot], i))
+		{
+			slot = (slot + 1) & (tableSize - 1);
+		}
+		if (table[slot] == g_EmptySlot)
+		{
+			table[slot] = i;
+			remap[i] = (GLuint)uniqueCount++;
+		}
+		else
+		{
+			remap[i] = remap[table[slot]];
+		}
+	}
+
+	if (uniqueCount < vertexCount)
+	{
+		RemapVertices(mesh, remap, uniqueCount);
+	}
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This function is used for reordering the triangles with
+ *  the Tipsify method.  Triangles are emitted as fans around
+ *  one vertex, and the next fan vertex is the neighbour that
+ *  is still in the cache and will not fall out of it before
+ *  its remaining triangles are drawn.
+ ***********************************************************/
+void OptimizeVertexCache(MESH_DATA& mesh, size_t cacheSize)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	size_t vertexCount = mesh.positions.size();
+	if ((triangleCount == 0) || (vertexCount == 0))
+	{
+		return;
+	}
+
+	// list the triangles that use each vertex
+	std::vector<GLuint> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacencyOffsets[mesh.indices[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+	std::vector<GLuint> adjacency(triangleCount * 3);
+	std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacency[fill[mesh.indices[i]]++] = (GLuint)(i / 3);
+	}
+
+	// triangles that still have to be emitted for each vertex
+	std::vector<GLuint> liveTriangles(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		liveTriangles[i] = adjacencyOffsets[i + 1] - adjacencyOffsets[i];
+	}
+
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<GLuint> deadEnd;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> reordered;
+	reordered.reserve(triangleCount * 3);
+
+	size_t timeStamp = cacheSize + 1;
+	size_t cursor = 0;
+	long long fanVertex = 0;
+
+	while (fanVertex >= 0)
+	{
+		candidates.clear();
+
+		// emit every remaining triangle around the fan vertex
+		for (GLuint a = adjacencyOffsets[(size_t)fanVertex]; a < adjacencyOffsets[(size_t)fanVertex + 1]; a++)
+		{
+			GLuint triangle = adjacency[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				GLuint vertex = mesh.indices[triangle * 3 + k];
+				reordered.push_back(vertex);
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				liveTriangles[vertex]--;
+				if (timeStamp - cacheTime[vertex] > cacheSize)
+				{
+					cacheTime[vertex] = timeStamp++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// the next fan is the oldest candidate that is still cached
+		fanVertex = -1;
+		size_t bestPriority = 0;
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			GLuint vertex = candidates[c];
+			if (liveTriangles[vertex] == 0)
+			{
+				continue;
+			}
+			size_t priority = 0;
+			if (timeStamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+			{
+				priority = timeStamp - cacheTime[vertex];
+			}
+			if ((fanVertex < 0) || (priority > bestPriority))
+			{
+				bestPriority = priority;
+				fanVertex = vertex;
+			}
+		}
+
+		// at a dead end, go back to a recently used vertex or
+		// continue with the next vertex in the original order
+		while ((fanVertex < 0) && (deadEnd.size() > 0))
+		{
+			GLuint vertex = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[vertex] > 0)
+			{
+				fanVertex = vertex;
+			}
+		}
+		while ((fanVertex < 0) && (cursor < vertexCount))
+		{
+			if (liveTriangles[cursor] > 0)
+			{
+				fanVertex = (long long)cursor;
+			}
+			cursor++;
+		}
+	}
+
+	mesh.indices.swap(reordered);
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This function is used for renumbering the vertices in the
+ *  order that the index buffer first uses them.  Vertices
+ *  that are not used by any triangle are removed.
+ ***********************************************************/
+void OptimizeVertexFetch(MESH_DATA& mesh)
+{
+	std::vector<GLuint> remap(mesh.positions.size(), g_EmptySlot);
+	size_t usedCount = 0;
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+	{
+		if (remap[mesh.indices[i]] == g_EmptySlot)
+		{
+			remap[mesh.indices[i]] = (GLuint)usedCount++;
+		}
+	}
+
+	RemapVertices(mesh, remap, usedCount);
+}
+
+/***********************************************************
+ *  CalculateCacheMissRatio()
+ *
+ *  This function is used for simulating a FIFO vertex cache
+ *  and returning the number of vertices that are shaded for
+ *  each triangle - 0.5 is ideal for a large regular grid and
+ *  3 means no reuse at all.
+ ***********************************************************/
+float CalculateCacheMissRatio(const MESH_DATA& mesh, size_t cacheSize)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	if ((triangleCount == 0) || (cacheSize == 0))
+	{
+		return(0.0f);
+	}
+
+	std::vector<size_t> cacheTime(mesh.positions.size(), 0);
+	size_t timeStamp = cacheSize + 1;
+	size_t misses = 0;
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		GLuint vertex = mesh.indices[i];
+		if (timeStamp - cacheTime[vertex] > cacheSize)
+		{
+			cacheTime[vertex] = timeStamp++;
+			misses++;
+		}
+	}
+
+	return((float)misses / (float)triangleCount);
+}
@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// weld duplicate vertices and reorder meshes for faster GPU vertex work
+//
+//	OptimizeVertexCache reorders the triangles with the Tipsify method so
+//	that recently shaded vertices are reused, then OptimizeVertexFetch
+//	puts the vertices in the order they are first used so that they are
+//	read from memory in sequence.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+// size of the post transform vertex cache that is optimized for
+const size_t MESH_OPTIMIZER_CACHE_SIZE = 16;
+
+// merge the vertices that have identical position, normal and UV
+void DeduplicateVertices(MESH_DATA& mesh);
+
+// reorder the triangles to reuse the post transform vertex cache
+void OptimizeVertexCache(MESH_DATA& mesh, size_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
+
+// reorder the vertices in the order they are first used
+void OptimizeVertexFetch(MESH_DATA& mesh);
+
+// average transformed vertex cache misses per triangle
+float CalculateCacheMissRatio(const MESH_DATA& mesh, size_t cacheSize = MESH_OPTIMIZER_CACHE_SIZE);
@@ -0,0 +1,544 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.cpp
+// ============
+// build lower detail versions of a mesh with quadric error edge collapses
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	const GLuint g_EmptySlot = 0xFFFFFFFF;
+
+	// a level that removes fewer triangles than this fraction of the
+	// previous level is not worth storing
+	const float g_MinimumLevelGain = 0.1f;
+
+	// weight of the normal change of a collapse, as a fraction of
+	// the mesh radius for normals that point in opposite directions
+	const float g_NormalWeight = 0.05f;
+
+	// a collapse may not turn a kept triangle further than 60 degrees
+	const float g_MinimumFacingCosine = 0.5f;
+
+	/***********************************************************
+	 *  QUADRIC
+	 *
+	 *  Sum of the weighted squared distances to a set of planes,
+	 *  stored as the upper half of a symmetric 4x4 matrix.
+	 ***********************************************************/
+	struct QUADRIC
+	{
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		void Clear()
+		{
+			memset(this, 0, sizeof(QUADRIC));
+		}
+
+		// add a plane through a point with a unit normal
+		void AddPlane(glm::vec3 normal, glm::vec3 point, double planeWeight)
+		{
+			double nx = normal.x;
+			double ny = normal.y;
+			double nz = normal.z;
+			double d = -(nx * point.x + ny * point.y + nz * point.z);
+			a00 += planeWeight * nx * nx;
+			a01 += planeWeight * nx * ny;
+			a02 += planeWeight * nx * nz;
+			a11 += planeWeight * ny * ny;
+			a12 += planeWeight * ny * nz;
+			a22 += planeWeight * nz * nz;
+			b0 += planeWeight * nx * d;
+			b1 += planeWeight * ny * d;
+			b2 += planeWeight * nz * d;
+			c += planeWeight * d * d;
+			weight += planeWeight;
+		}
+
+		void Add(const QUADRIC& other)
+		{
+			a00 += other.a00;
+			a01 += other.a01;
+			a02 += other.a02;
+			a11 += other.a11;
+			a12 += other.a12;
+			a22 += other.a22;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// weighted sum of the squared plane distances of a point
+		double Evaluate(glm::vec3 point) const
+		{
+			double x = point.x;
+			double y = point.y;
+			double z = point.z;
+			return(
+				a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z +
+				a11 * y * y + 2.0 * a12 * y * z + a22 * z * z +
+				2.0 * (b0 * x + b1 * y + b2 * z) + c);
+		}
+	};
+
+	/***********************************************************
+	 *  COLLAPSE
+	 *
+	 *  Move of one vertex onto a neighbouring vertex, and the
+	 *  squared object space error that it causes.
+	 ***********************************************************/
+	struct COLLAPSE
+	{
+		GLuint source;
+		GLuint target;
+		float cost;
+
+		bool operator<(const COLLAPSE& other) const
+		{
+			return(cost < other.cost);
+		}
+	};
+
+	/***********************************************************
+	 *  SIMPLIFIER
+	 *
+	 *  State that is kept from one level to the next, so that
+	 *  every level continues from the previous one and its
+	 *  error includes the error of the earlier collapses.
+	 ***********************************************************/
+	struct SIMPLIFIER
+	{
+		const MESH_DATA* pMesh;
+		std::vector<GLuint> indices;
+		// first vertex with the same position as each vertex
+		std::vector<GLuint> positionGroup;
+		// vertices on seams and borders cannot be moved
+		std::vector<bool> locked;
+		// quadric of each position group
+		std::vector<QUADRIC> quadrics;
+		// largest error of any collapse so far
+		float error;
+		float maxErrorSquared;
+		float normalScale;
+	};
+
+	/***********************************************************
+	 *  GroupPositions()
+	 *
+	 *  Give every vertex the index of the first vertex with a
+	 *  bit identical position.
+	 ***********************************************************/
+	void GroupPositions(const MESH_DATA& mesh, std::vector<GLuint>& positionGroup)
+	{
+		size_t vertexCount = mesh.positions.size();
+		size_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+		{
+			tableSize *= 2;
+		}
+		std::vector<GLuint> table(tableSize, g_EmptySlot);
+		positionGroup.resize(vertexCount);
+
+		for (GLuint v = 0; v < (GLuint)vertexCount; v++)
+		{
+			uint32_t bits[3];
+			memcpy(bits, &mesh.positions[v], sizeof(bits));
+			uint32_t hash = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+			size_t slot = (hash ^ (hash >> 15)) & (tableSize - 1);
+			while ((table[slot] != g_EmptySlot) &&
+				(memcmp(&mesh.positions[table[slot]], &mesh.positions[v], sizeof(glm::vec3)) != 0))
+			{
+				slot = (slot + 1) & (tableSize - 1);
+			}
+			if (table[slot] == g_EmptySlot)
+			{
+				table[slot] = v;
+			}
+			positionGroup[v] = table[slot];
+		}
+	}
+
+	/***********************************************************
+	 *  LockSeamsAndBorders()
+	 *
+	 *  Lock the vertices that share their position with another
+	 *  vertex, and the vertices of edges that are not shared by
+	 *  exactly two triangles.
+	 ***********************************************************/
+	void LockSeamsAndBorders(SIMPLIFIER& simplifier)
+	{
+		const std::vector<GLuint>& group = simplifier.positionGroup;
+		size_t vertexCount = group.size();
+		simplifier.locked.assign(vertexCount, false);
+
+		for (GLuint v = 0; v < (GLuint)vertexCount; v++)
+		{
+			if (group[v] != v)
+			{
+				simplifier.locked[v] = true;
+				simplifier.locked[group[v]] = true;
+			}
+		}
+
+		// count the triangles on each edge between position groups
+		std::vector<uint64_t> edges;
+		edges.reserve(simplifier.indices.size());
+		for (size_t i = 0; i < simplifier.indices.size(); i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				uint64_t a = group[simplifier.indices[i + k]];
+				uint64_t b = group[simplifier.indices[i + (k + 1) % 3]];
+				edges.push_back((a < b) ? ((a << 32) | b) : ((b << 32) | a));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		std::vector<bool> lockedGroups(vertexCount, false);
+		for (size_t i = 0; i < edges.size();)
+		{
+			size_t next = i + 1;
+			while ((next < edges.size()) && (edges[next] == edges[i]))
+			{
+				next++;
+			}
+			if (next - i != 2)
+			{
+				lockedGroups[(size_t)(edges[i] >> 32)] = true;
+				lockedGroups[(size_t)(edges[i] & 0xFFFFFFFF)] = true;
+			}
+			i = next;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			if (lockedGroups[group[v]])
+			{
+				simplifier.locked[v] = true;
+			}
+		}
+	}
+
+	/***********************************************************
+	 *  IsCollapseValid()
+	 *
+	 *  Check that moving the source vertex onto the target does
+	 *  not flip or sharply turn any of the triangles that are
+	 *  kept.
+	 ***********************************************************/
+	bool IsCollapseValid(
+		const SIMPLIFIER& simplifier,
+		const std::vector<GLuint>& adjacencyOffsets,
+		const std::vector<GLuint>& adjacency,
+		GLuint source,
+		GLuint target)
+	{
+		const std::vector<glm::vec3>& positions = simplifier.pMesh->positions;
+		const std::vector<GLuint>& indices = simplifier.indices;
+		const std::vector<GLuint>& group = simplifier.positionGroup;
+
+		for (GLuint a = adjacencyOffsets[source]; a < adjacencyOffsets[source + 1]; a++)
+		{
+			const GLuint* triangle = &indices[adjacency[a] * 3];
+			if ((group[triangle[0]] == group[target]) || (group[triangle[1]] == group[target]) || (group[triangle[2]] == group[target]))
+			{
+				// removed by the collapse
+				continue;
+			}
+
+			glm::vec3 before[3];
+			glm::vec3 after[3];
+			for (int k = 0; k < 3; k++)
+			{
+				before[k] = positions[triangle[k]];
+				after[k] = (triangle[k] == source) ? positions[target] : before[k];
+			}
+			glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+			if ((lengths <= 0.0f) || (glm::dot(normalBefore, normalAfter) < g_MinimumFacingCosine * lengths))
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+
+	/***********************************************************
+	 *  Simplify()
+	 *
+	 *  Collapse vertices until the index list has no more than
+	 *  the target number of triangles, or until every remaining
+	 *  collapse is over the error limit.  Each pass sorts all
+	 *  of the possible collapses by cost and applies the ones
+	 *  that do not touch the neighbourhood of an earlier
+	 *  collapse in the same pass.
+	 ***********************************************************/
+	void Simplify(SIMPLIFIER& simplifier, size_t targetTriangles)
+	{
+		const MESH_DATA& mesh = *simplifier.pMesh;
+		const std::vector<GLuint>& group = simplifier.positionGroup;
+		size_t vertexCount = mesh.positions.size();
+
+		std::vector<GLuint> adjacencyOffsets;
+		std::vector<GLuint> adjacency;
+		std::vector<COLLAPSE> collapses;
+		std::vector<bool> passLocked;
+		std::vector<GLuint> remap(vertexCount);
+
+		while (simplifier.indices.size() / 3 > targetTriangles)
+		{
+			std::vector<GLuint>& indices = simplifier.indices;
+			size_t triangleCount = indices.size() / 3;
+
+			// list the triangles that use each vertex
+			adjacencyOffsets.assign(vertexCount + 1, 0);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacencyOffsets[indices[i] + 1]++;
+			}
+			for (size_t v = 0; v < vertexCount; v++)
+			{
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			}
+			adjacency.resize(indices.size());
+			std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); i++)
+			{
+				adjacency[fill[indices[i]]++] = (GLuint)(i / 3);
+			}
+
+			// find the cheapest collapse of every free vertex
+			collapses.clear();
+			for (GLuint v = 0; v < (GLuint)vertexCount; v++)
+			{
+				if (simplifier.locked[v] || (adjacencyOffsets[v] == adjacencyOffsets[v + 1]))
+				{
+					continue;
+				}
+
+				COLLAPSE best;
+				best.source = v;
+				best.target = g_EmptySlot;
+				best.cost = 0.0f;
+				for (GLuint a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					const GLuint* triangle = &indices[adjacency[a] * 3];
+					for (int k = 0; k < 3; k++)
+					{
+						GLuint target = triangle[k];
+						if (group[target] == group[v])
+						{
+							continue;
+						}
+
+						QUADRIC quadric = simplifier.quadrics[group[v]];
+						quadric.Add(simplifier.quadrics[group[target]]);
+						double distance = glm::max(quadric.Evaluate(mesh.positions[target]), 0.0) / glm::max(quadric.weight, 1e-20);
+						double normalError = (1.0 - glm::dot(mesh.normals[v], mesh.normals[target])) * simplifier.normalScale;
+						float cost = (float)(distance + normalError * normalError);
+						if ((best.target == g_EmptySlot) || (cost < best.cost))
+						{
+							best.target = target;
+							best.cost = cost;
+						}
+					}
+				}
+				if ((best.target != g_EmptySlot) && (best.cost <= simplifier.maxErrorSquared))
+				{
+					collapses.push_back(best);
+				}
+			}
+			if (collapses.size() == 0)
+			{
+				break;
+			}
+			std::sort(collapses.begin(), collapses.end());
+
+			// apply the collapses that do not overlap
+			passLocked.assign(vertexCount, false);
+			for (GLuint v = 0; v < (GLuint)vertexCount; v++)
+			{
+				remap[v] = v;
+			}
+			size_t removedTriangles = 0;
+			size_t neededTriangles = triangleCount - targetTriangles;
+			for (size_t c = 0; (c < collapses.size()) && (removedTriangles < neededTriangles); c++)
+			{
+				GLuint source = collapses[c].source;
+				GLuint target = collapses[c].target;
+				if (passLocked[source] || passLocked[target] ||
+					(IsCollapseValid(simplifier, adjacencyOffsets, adjacency, source, target) == false))
+				{
+					continue;
+				}
+
+				remap[source] = target;
+				simplifier.quadrics[group[target]].Add(simplifier.quadrics[group[source]]);
+				simplifier.error = glm::max(simplifier.error, std::sqrt(collapses[c].cost));
+
+				// the neighbourhood of the collapse changed, so its
+				// other collapses wait for the next pass
+				for (GLuint a = adjacencyOffsets[source]; a < adjacencyOffsets[source + 1]; a++)
+				{
+					const GLuint* triangle = &indices[adjacency[a] * 3];
+					bool bRemoved = false;
+					for (int k = 0; k < 3; k++)
+					{
+						passLocked[triangle[k]] = true;
+						bRemoved = bRemoved || (group[triangle[k]] == group[target]);
+					}
+					if (bRemoved)
+					{
+						removedTriangles++;
+					}
+				}
+			}
+
+			// rewrite the indices and drop the collapsed triangles
+			size_t keep = 0;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				GLuint a = remap[indices[i]];
+				GLuint b = remap[indices[i + 1]];
+				GLuint c = remap[indices[i + 2]];
+				if ((group[a] == group[b]) || (group[b] == group[c]) || (group[a] == group[c]))
+				{
+					continue;
+				}
+				indices[keep++] = a;
+				indices[keep++] = b;
+				indices[keep++] = c;
+			}
+			indices.resize(keep);
+
+			if (removedTriangles == 0)
+			{
+				break;
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetDefaultLODSettings()
+ *
+ *  This function is used for getting the LOD settings that
+ *  are used for the scene meshes.
+ ***********************************************************/
+LOD_SETTINGS GetDefaultLODSettings()
+{
+	LOD_SETTINGS settings;
+	settings.maxLevels = 4;
+	settings.reduction = 0.5f;
+	settings.maxError = 0.02f;
+	settings.minimumTriangles = 1024;
+	return(settings);
+}
+
+/***********************************************************
+ *  BuildLODChain()
+ *
+ *  This function is used for building the lower detail
+ *  levels of a mesh.  Each level is simplified from the one
+ *  before it and its indices are appended to the mesh.  The
+ *  error of a level is the largest quadric distance of any
+ *  collapse that led to it, in object space units.
+ ***********************************************************/
+void BuildLODChain(MESH_DATA& mesh, const LOD_SETTINGS& settings, std::vector<MESH_LOD>& lods)
+{
+	MESH_LOD fullDetail;
+	fullDetail.firstIndex = 0;
+	fullDetail.indexCount = (GLuint)mesh.indices.size();
+	fullDetail.error = 0.0f;
+	lods.assign(1, fullDetail);
+
+	size_t triangleCount = mesh.indices.size() / 3;
+	if ((settings.maxLevels <= 1) || (triangleCount < settings.minimumTriangles) || (mesh.positions.size() == 0))
+	{
+		return;
+	}
+
+	MESH_BOUNDS bounds = CalculateMeshBounds(mesh);
+
+	SIMPLIFIER simplifier;
+	simplifier.pMesh = &mesh;
+	simplifier.indices = mesh.indices;
+	simplifier.error = 0.0f;
+	simplifier.maxErrorSquared = (settings.maxError * bounds.radius) * (settings.maxError * bounds.radius);
+	simplifier.normalScale = g_NormalWeight * bounds.radius;
+	GroupPositions(mesh, simplifier.positionGroup);
+	LockSeamsAndBorders(simplifier);
+
+	// every position starts with the planes of its triangles,
+	// weighted by their area
+	simplifier.quadrics.resize(mesh.positions.size());
+	for (size_t v = 0; v < simplifier.quadrics.size(); v++)
+	{
+		simplifier.quadrics[v].Clear();
+	}
+	for (size_t i = 0; i < mesh.indices.size(); i += 3)
+	{
+		glm::vec3 p0 = mesh.positions[mesh.indices[i]];
+		glm::vec3 normal = glm::cross(mesh.positions[mesh.indices[i + 1]] - p0, mesh.positions[mesh.indices[i + 2]] - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+		{
+			continue;
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			simplifier.quadrics[simplifier.positionGroup[mesh.indices[i + k]]].AddPlane(normal / length, p0, length * 0.5);
+		}
+	}
+
+	for (int level = 1; level < settings.maxLevels; level++)
+	{
+		size_t previousTriangles = simplifier.indices.size() / 3;
+		Simplify(simplifier, (size_t)(previousTriangles * settings.reduction));
+
+		size_t levelTriangles = simplifier.indices.size() / 3;
+		if ((levelTriangles == 0) || ((float)levelTriangles > (float)previousTriangles * (1.0f - g_MinimumLevelGain)))
+		{
+			break;
+		}
+
+		MESH_LOD lod;
+		lod.firstIndex = (GLuint)mesh.indices.size();
+		lod.indexCount = (GLuint)simplifier.indices.size();
+		lod.error = simplifier.error;
+		lods.push_back(lod);
+		mesh.indices.insert(mesh.indices.end(), simplifier.indices.begin(), simplifier.indices.end());
+	}
+}
+
+/***********************************************************
+ *  SelectLOD()
+ *
+ *  This function is used for choosing the coarsest level
+ *  whose error covers no more than the allowed number of
+ *  pixels on the screen.
+ ***********************************************************/
+size_t SelectLOD(const std::vector<MESH_LOD>& lods, float pixelsPerUnit, float maxPixelError)
+{
+	for (size_t i = lods.size(); i > 1; i--)
+	{
+		if (lods[i - 1].error * pixelsPerUnit <= maxPixelError)
+		{
+			return(i - 1);
+		}
+	}
+	return(0);
+}
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshsimplifier.h
+// ============
+// build lower detail versions of a mesh with quadric error edge collapses
+//
+//	Every level reuses the vertices of the full mesh and only has its own
+//	indices, so all levels share one vertex buffer and the levels are
+//	stored one after another in the index buffer.  Vertices on UV or
+//	normal seams and on open borders are never moved, which keeps the
+//	texture mapping and the hard edges of the mesh intact.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <vector>
+
+/***********************************************************
+ *  LOD_SETTINGS
+ *
+ *  Controls how many levels are built and how far each one
+ *  may move from the full detail surface.
+ ***********************************************************/
+struct LOD_SETTINGS
+{
+	// most levels to build, including the full detail level
+	int maxLevels;
+	// each level keeps this fraction of the previous level triangles
+	float reduction;
+	// largest error of any level, as a fraction of the mesh radius
+	float maxError;
+	// meshes with fewer triangles only get the full detail level
+	size_t minimumTriangles;
+};
+
+// default settings used for the scene meshes
+LOD_SETTINGS GetDefaultLODSettings();
+
+// append the lower detail levels to the mesh indices and describe
+// every level, including the full detail level, in the LOD table
+void BuildLODChain(MESH_DATA& mesh, const LOD_SETTINGS& settings, std::vector<MESH_LOD>& lods);
+
+// get the level to draw when the mesh is projected so that one object
+// space unit at its bounding sphere covers the passed in pixel count
+size_t SelectLOD(const std::vector<MESH_LOD>& lods, float pixelsPerUnit, float maxPixelError);
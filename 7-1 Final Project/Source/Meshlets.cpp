@@ -0,0 +1,356 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlets.cpp
+// ============
+// split large meshes into small clusters that can be culled one by one
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Meshlets.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// a normal cone wider than this cannot be used for culling
+	const float g_MinimumConeDot = 0.1f;
+
+	/***********************************************************
+	 *  CalculateMeshletBounds()
+	 *
+	 *  Calculate the bounding sphere and normal cone of the
+	 *  triangles in a meshlet.
+	 ***********************************************************/
+	void CalculateMeshletBounds(const MESH_DATA& mesh, const GLuint* indices, MESHLET& meshlet)
+	{
+		glm::vec3 minimum = mesh.positions[indices[0]];
+		glm::vec3 maximum = minimum;
+		for (GLuint i = 1; i < meshlet.indexCount; i++)
+		{
+			minimum = glm::min(minimum, mesh.positions[indices[i]]);
+			maximum = glm::max(maximum, mesh.positions[indices[i]]);
+		}
+
+		meshlet.center = (minimum + maximum) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (GLuint i = 0; i < meshlet.indexCount; i++)
+		{
+			meshlet.radius = glm::max(meshlet.radius, glm::length(mesh.positions[indices[i]] - meshlet.center));
+		}
+
+		// average the facing of the triangles to get the cone axis
+		std::vector<glm::vec3> triangleNormals;
+		glm::vec3 axis(0.0f);
+		for (GLuint i = 0; i < meshlet.indexCount; i += 3)
+		{
+			glm::vec3 p0 = mesh.positions[indices[i]];
+			glm::vec3 normal = glm::cross(mesh.positions[indices[i + 1]] - p0, mesh.positions[indices[i + 2]] - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+			{
+				triangleNormals.push_back(normal / length);
+				axis += normal / length;
+			}
+		}
+
+		// no culling unless every triangle faces close to the axis
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = 1.0f;
+
+		float axisLength = glm::length(axis);
+		if ((axisLength <= 0.0f) || (triangleNormals.size() == 0))
+		{
+			return;
+		}
+		axis = axis / axisLength;
+
+		float minimumDot = 1.0f;
+		for (size_t i = 0; i < triangleNormals.size(); i++)
+		{
+			minimumDot = glm::min(minimumDot, glm::dot(triangleNormals[i], axis));
+		}
+
+		if (minimumDot > g_MinimumConeDot)
+		{
+			meshlet.coneAxis = axis;
+			// sine of the cone half angle
+			meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildMeshlets()
+ *
+ *  This function is used for splitting a mesh into meshlets.
+ *  Each meshlet grows from its first triangle by taking the
+ *  neighbouring triangle that adds the fewest new vertices,
+ *  until the vertex or triangle limit is reached.  The mesh
+ *  indices are rewritten in meshlet order.
+ ***********************************************************/
+void BuildMeshlets(
+	MESH_DATA& mesh,
+	std::vector<MESHLET>& meshlets,
+	size_t maxVertices,
+	size_t maxTriangles)
+{
+	meshlets.clear();
+
+	size_t triangleCount = mesh.indices.size() / 3;
+	size_t vertexCount = mesh.positions.size();
+	if ((triangleCount == 0) || (maxVertices < 3) || (maxTriangles < 1))
+	{
+		return;
+	}
+
+	// list the triangles that use each vertex
+	std::vector<GLuint> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacencyOffsets[mesh.indices[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+	std::vector<GLuint> adjacency(triangleCount * 3);
+	std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		adjacency[fill[mesh.indices[i]]++] = (GLuint)(i / 3);
+	}
+
+	std::vector<bool> usedTriangles(triangleCount, false);
+	// the meshlet that each vertex was last added to
+	std::vector<int> vertexMeshlet(vertexCount, -1);
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> reordered;
+	reordered.reserve(mesh.indices.size());
+
+	size_t nextUnused = 0;
+	size_t placedTriangles = 0;
+
+	while (placedTriangles < triangleCount)
+	{
+		MESHLET meshlet;
+		meshlet.firstIndex = (GLuint)reordered.size();
+		meshlet.indexCount = 0;
+		meshlet.vertexCount = 0;
+		int meshletID = (int)meshlets.size();
+		candidates.clear();
+
+		while (meshlet.indexCount / 3 < maxTriangles)
+		{
+			// pick the candidate that needs the fewest new vertices
+			int bestTriangle = -1;
+			GLuint bestNewVertices = 4;
+			size_t keep = 0;
+			for (size_t c = 0; c < candidates.size(); c++)
+			{
+				GLuint triangle = candidates[c];
+				if (usedTriangles[triangle])
+				{
+					continue;
+				}
+				candidates[keep++] = triangle;
+
+				GLuint newVertices = 0;
+				for (int k = 0; k < 3; k++)
+				{
+					if (vertexMeshlet[mesh.indices[triangle * 3 + k]] != meshletID)
+					{
+						newVertices++;
+					}
+				}
+				if (newVertices < bestNewVertices)
+				{
+					bestNewVertices = newVertices;
+					bestTriangle = (int)triangle;
+				}
+			}
+			candidates.resize(keep);
+
+			// with no connected triangle left, continue with the next
+			// unused triangle in the original order
+			if (bestTriangle < 0)
+			{
+				while ((nextUnused < triangleCount) && usedTriangles[nextUnused])
+				{
+					nextUnused++;
+				}
+				if (nextUnused == triangleCount)
+				{
+					break;
+				}
+				bestTriangle = (int)nextUnused;
+				bestNewVertices = 0;
+				for (int k = 0; k < 3; k++)
+				{
+					if (vertexMeshlet[mesh.indices[bestTriangle * 3 + k]] != meshletID)
+					{
+						bestNewVertices++;
+					}
+				}
+			}
+
+			if (meshlet.vertexCount + bestNewVertices > maxVertices)
+			{
+				break;
+			}
+
+			// add the triangle and queue its neighbours
+			usedTriangles[bestTriangle] = true;
+			placedTriangles++;
+			for (int k = 0; k < 3; k++)
+			{
+				GLuint vertex = mesh.indices[bestTriangle * 3 + k];
+				reordered.push_back(vertex);
+				if (vertexMeshlet[vertex] != meshletID)
+				{
+					vertexMeshlet[vertex] = meshletID;
+					meshlet.vertexCount++;
+				}
+				for (GLuint a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+				{
+					if (!usedTriangles[adjacency[a]])
+					{
+						candidates.push_back(adjacency[a]);
+					}
+				}
+			}
+			meshlet.indexCount += 3;
+		}
+
+		CalculateMeshletBounds(mesh, &reordered[meshlet.firstIndex], meshlet);
+		meshlets.push_back(meshlet);
+	}
+
+	mesh.indices.swap(reordered);
+}
+
+/***********************************************************
+ *  ExtractFrustumPlanes()
+ *
+ *  This function is used for getting the left, right,
+ *  bottom, top, near and far planes from a clip matrix.
+ *  For a projection * view * model matrix the planes are in
+ *  object space.  Each plane is normalized so that
+ *  dot(plane.xyz, point) + plane.w is a distance.
+ ***********************************************************/
+void ExtractFrustumPlanes(const glm::mat4& matrix, glm::vec4 planes[6])
+{
+	glm::vec4 row0(matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0]);
+	glm::vec4 row1(matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1]);
+	glm::vec4 row2(matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]);
+	glm::vec4 row3(matrix[0][3], matrix[1][3], matrix[2][3], matrix[3][3]);
+
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(planes[i].x, planes[i].y, planes[i].z));
+		if (length > 0.0f)
+		{
+			planes[i] = planes[i] / length;
+		}
+	}
+}
+
+/***********************************************************
+ *  CullMeshlets()
+ *
+ *  This function is used for testing every meshlet against
+ *  the view frustum and its normal cone, in the object space
+ *  of the mesh.  The visible meshlets are returned as index
+ *  ranges for glMultiDrawElementsBaseVertex, placed where
+ *  the mesh is stored in the shared buffers.
+ ***********************************************************/
+void CullMeshlets(
+	const std::vector<MESHLET>& meshlets,
+	const glm::mat4& model,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	MESHLET_DRAW_LIST& drawList,
+	GLuint firstIndex,
+	GLint baseVertex)
+{
+	drawList.counts.clear();
+	drawList.offsets.clear();
+	drawList.baseVertices.clear();
+	drawList.visibleMeshlets = 0;
+	drawList.visibleIndices = 0;
+
+	glm::vec4 planes[6];
+	ExtractFrustumPlanes(projection * view * model, planes);
+
+	// the viewer in object space - a point for a perspective
+	// projection, a direction for an orthographic projection
+	glm::mat4 inverseModelView = glm::inverse(view * model);
+	bool bOrthographic = (projection[2][3] == 0.0f);
+	glm::vec3 viewer;
+	if (bOrthographic)
+	{
+		glm::vec4 direction = inverseModelView * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+		viewer = glm::normalize(glm::vec3(direction.x, direction.y, direction.z));
+	}
+	else
+	{
+		glm::vec4 position = inverseModelView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		viewer = glm::vec3(position.x, position.y, position.z);
+	}
+
+	GLuint rangeEnd = 0;
+	for (size_t i = 0; i < meshlets.size(); i++)
+	{
+		const MESHLET& meshlet = meshlets[i];
+
+		bool bVisible = true;
+		for (int p = 0; (p < 6) && bVisible; p++)
+		{
+			glm::vec3 normal(planes[p].x, planes[p].y, planes[p].z);
+			if (glm::dot(normal, meshlet.center) + planes[p].w < -meshlet.radius)
+			{
+				bVisible = false;
+			}
+		}
+
+		if (bVisible && (meshlet.coneCutoff < 1.0f))
+		{
+			if (bOrthographic)
+			{
+				bVisible = glm::dot(viewer, meshlet.coneAxis) < meshlet.coneCutoff;
+			}
+			else
+			{
+				glm::vec3 toMeshlet = meshlet.center - viewer;
+				float distance = glm::length(toMeshlet);
+				bVisible = glm::dot(toMeshlet, meshlet.coneAxis) < meshlet.coneCutoff * distance + meshlet.radius;
+			}
+		}
+
+		if (bVisible == false)
+		{
+			continue;
+		}
+
+		drawList.visibleMeshlets++;
+		drawList.visibleIndices += meshlet.indexCount;
+
+		// extend the previous range when this meshlet follows it
+		if ((drawList.counts.size() > 0) && (rangeEnd == meshlet.firstIndex))
+		{
+			drawList.counts.back() += meshlet.indexCount;
+		}
+		else
+		{
+			drawList.counts.push_back(meshlet.indexCount);
+			drawList.offsets.push_back((const void*)((firstIndex + meshlet.firstIndex) * sizeof(GLuint)));
+			drawList.baseVertices.push_back(baseVertex);
+		}
+		rangeEnd = meshlet.firstIndex + meshlet.indexCount;
+	}
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlets.h
+// ============
+// split large meshes into small clusters that can be culled one by one
+//
+//	BuildMeshlets reorders the index buffer of a mesh so that every
+//	meshlet is a contiguous range of triangles.  CullMeshlets then drops
+//	the meshlets that are outside the view frustum or that face away
+//	from the viewer, and returns the remaining ranges ready for
+//	glMultiDrawElementsBaseVertex.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <vector>
+
+// default meshlet limits
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+/***********************************************************
+ *  MESHLET
+ *
+ *  One cluster of triangles with the bounds that are used
+ *  to cull it, all in the object space of the mesh.
+ ***********************************************************/
+struct MESHLET
+{
+	// range of the meshlet triangles in the reordered index buffer
+	GLuint firstIndex;
+	GLuint indexCount;
+	// number of unique vertices used by the meshlet
+	GLuint vertexCount;
+	// bounding sphere of the meshlet vertices
+	glm::vec3 center;
+	float radius;
+	// normal cone - the meshlet faces away from a viewer when
+	// dot(center - viewer, coneAxis) >= coneCutoff * distance + radius
+	glm::vec3 coneAxis;
+	float coneCutoff;
+};
+
+/***********************************************************
+ *  MESHLET_DRAW_LIST
+ *
+ *  Index ranges of the visible meshlets, neighbouring ranges
+ *  are merged into a single draw.
+ ***********************************************************/
+struct MESHLET_DRAW_LIST
+{
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	std::vector<GLint> baseVertices;
+	size_t visibleMeshlets;
+	size_t visibleIndices;
+};
+
+// split the mesh into meshlets and reorder its indices to match
+void BuildMeshlets(
+	MESH_DATA& mesh,
+	std::vector<MESHLET>& meshlets,
+	size_t maxVertices = MESHLET_MAX_VERTICES,
+	size_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+// get the six frustum planes of a projection * view * model matrix
+void ExtractFrustumPlanes(const glm::mat4& matrix, glm::vec4 planes[6]);
+
+// find the meshlets that can be seen with the passed in matrices - the
+// mesh indices start at firstIndex in the bound index buffer and refer
+// to vertices starting at baseVertex
+void CullMeshlets(
+	const std::vector<MESHLET>& meshlets,
+	const glm::mat4& model,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	MESHLET_DRAW_LIST& drawList,
+	GLuint firstIndex = 0,
+	GLint baseVertex = 0);
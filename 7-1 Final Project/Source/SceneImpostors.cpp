@@ -0,0 +1,272 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneimpostors.cpp
+// ============
+// draw curved shapes as ray cast impostors
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneImpostors.h"
+#include "MeshGenerators.h"
+#include "ShaderProgram.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	const char* g_ImpostorVertexShader = "./Shaders/impostorVertexShader.glsl";
+	const char* g_ImpostorFragmentShader = "./Shaders/impostorFragmentShader.glsl";
+
+	const char* g_ShapeName = "impostorShape";
+	const char* g_ShapeRadiiName = "shapeRadii";
+	const char* g_BoundsMinimumName = "boundsMinimum";
+	const char* g_BoundsMaximumName = "boundsMaximum";
+
+	// corners of the unit cube, the bits of the index are X, Y and Z
+	const GLfloat g_CubeVertices[] =
+	{
+		0.0f, 0.0f, 0.0f,
+		1.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f,
+		1.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 1.0f,
+		0.0f, 1.0f, 1.0f,
+		1.0f, 1.0f, 1.0f
+	};
+
+	// counter clockwise when the face is seen from outside the cube
+	const GLuint g_CubeIndices[] =
+	{
+		0, 4, 6, 0, 6, 2,	// -X
+		1, 3, 7, 1, 7, 5,	// +X
+		0, 1, 5, 0, 5, 4,	// -Y
+		2, 6, 7, 2, 7, 3,	// +Y
+		0, 2, 3, 0, 3, 1,	// -Z
+		4, 5, 7, 4, 7, 6	// +Z
+	};
+	const GLsizei g_CubeIndexCount = sizeof(g_CubeIndices) / sizeof(g_CubeIndices[0]);
+}
+
+/***********************************************************
+ *  SceneImpostors()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneImpostors::SceneImpostors()
+{
+	m_pShaderManager = NULL;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+}
+
+/***********************************************************
+ *  ~SceneImpostors()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneImpostors::~SceneImpostors()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the impostor shader
+ *  program and creating the unit cube that is stretched
+ *  over the bounds of every shape.  The current program is
+ *  not changed.
+ ***********************************************************/
+bool SceneImpostors::Create()
+{
+	Destroy();
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	m_pShaderManager = new ShaderManager();
+	GLuint programID = LoadShaderProgram(m_pShaderManager, g_ImpostorVertexShader, g_ImpostorFragmentShader);
+
+	GLint linkStatus = GL_FALSE;
+	if (programID != 0)
+	{
+		glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+	}
+	if (linkStatus != GL_TRUE)
+	{
+		std::cout << "ERROR: Could not load the impostor shaders " << g_ImpostorVertexShader << " and " << g_ImpostorFragmentShader << std::endl;
+		Destroy();
+		glUseProgram((GLuint)currentProgram);
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(g_CubeVertices), g_CubeVertices, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(g_CubeIndices), g_CubeIndices, GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the objects are drawn with the texture in slot zero until
+	// the first texture is set
+	m_pShaderManager->use();
+	m_pShaderManager->setSampler2DValue("objectTexture", 0);
+	glUseProgram((GLuint)currentProgram);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program and
+ *  the buffers of the bounding box.
+ ***********************************************************/
+void SceneImpostors::Destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+
+	if (NULL != m_pShaderManager)
+	{
+		if (m_pShaderManager->m_programID != 0)
+		{
+			glDeleteProgram(m_pShaderManager->m_programID);
+		}
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used for making the impostor program the
+ *  current program, so that its values can be set.
+ ***********************************************************/
+void SceneImpostors::Use()
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->use();
+	}
+}
+
+/***********************************************************
+ *  DrawCylinder()
+ *
+ *  This method is used for drawing a cylinder with a radius
+ *  of one, standing on the XZ plane with a height of one.
+ ***********************************************************/
+void SceneImpostors::DrawCylinder()
+{
+	DrawShape(
+		IMPOSTOR_SHAPE_CONE,
+		glm::vec2(1.0f, 1.0f),
+		glm::vec3(-1.0f, 0.0f, -1.0f),
+		glm::vec3(1.0f, 1.0f, 1.0f));
+}
+
+/***********************************************************
+ *  DrawTaperedCylinder()
+ *
+ *  This method is used for drawing a cylinder whose radius
+ *  goes from one at the bottom to one half at the top.
+ ***********************************************************/
+void SceneImpostors::DrawTaperedCylinder()
+{
+	DrawShape(
+		IMPOSTOR_SHAPE_CONE,
+		glm::vec2(1.0f, 0.5f),
+		glm::vec3(-1.0f, 0.0f, -1.0f),
+		glm::vec3(1.0f, 1.0f, 1.0f));
+}
+
+/***********************************************************
+ *  DrawTorus()
+ *
+ *  This method is used for drawing a torus with a main
+ *  radius of one around the Z axis, with the same tube
+ *  thickness as the torus mesh.
+ ***********************************************************/
+void SceneImpostors::DrawTorus()
+{
+	float outerRadius = 1.0f + TORUS_THICKNESS;
+
+	DrawShape(
+		IMPOSTOR_SHAPE_TORUS,
+		glm::vec2(1.0f, TORUS_THICKNESS),
+		glm::vec3(-outerRadius, -outerRadius, -TORUS_THICKNESS),
+		glm::vec3(outerRadius, outerRadius, TORUS_THICKNESS));
+}
+
+/***********************************************************
+ *  DrawSphere()
+ *
+ *  This method is used for drawing a sphere with a radius
+ *  of one at the origin.
+ ***********************************************************/
+void SceneImpostors::DrawSphere()
+{
+	DrawShape(
+		IMPOSTOR_SHAPE_SPHERE,
+		glm::vec2(1.0f, 1.0f),
+		glm::vec3(-1.0f, -1.0f, -1.0f),
+		glm::vec3(1.0f, 1.0f, 1.0f));
+}
+
+/***********************************************************
+ *  DrawShape()
+ *
+ *  This method is used for drawing the bounding box of a
+ *  shape with the impostor program, which must be current.
+ *  Only the back faces are drawn, so the shape is still
+ *  drawn when the camera is inside its bounding box, and
+ *  every pixel is shaded once.
+ ***********************************************************/
+void SceneImpostors::DrawShape(IMPOSTOR_SHAPE shape, glm::vec2 radii, glm::vec3 boundsMinimum, glm::vec3 boundsMaximum)
+{
+	if ((NULL == m_pShaderManager) || (m_vao == 0))
+	{
+		return;
+	}
+
+	m_pShaderManager->setIntValue(g_ShapeName, shape);
+	m_pShaderManager->setVec2Value(g_ShapeRadiiName, radii);
+	m_pShaderManager->setVec3Value(g_BoundsMinimumName, boundsMinimum);
+	m_pShaderManager->setVec3Value(g_BoundsMaximumName, boundsMaximum);
+
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+
+	glBindVertexArray(m_vao);
+	glDrawElements(GL_TRIANGLES, g_CubeIndexCount, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(0);
+
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneimpostors.h
+// ============
+// draw curved shapes as ray cast impostors
+//
+//	An impostor draws the bounding box of a cylinder, cone, torus or
+//	sphere, and the fragment shader intersects the ray through every
+//	pixel with the exact shape, writing its depth and normal.  Every
+//	shape costs twelve triangles no matter how close it is, and the
+//	silhouette is exact at any distance.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  IMPOSTOR_SHAPE
+ *
+ *  The shapes the impostor fragment shader can intersect,
+ *  with the same values as the constants in the shader.
+ ***********************************************************/
+enum IMPOSTOR_SHAPE
+{
+	IMPOSTOR_SHAPE_CONE = 0,
+	IMPOSTOR_SHAPE_TORUS,
+	IMPOSTOR_SHAPE_SPHERE
+};
+
+/***********************************************************
+ *  SceneImpostors
+ *
+ *  This class holds the impostor shader program and the
+ *  bounding box that is drawn for every impostor.  The
+ *  object, material and light values are set on the program
+ *  returned by GetShaderManager() with the same names as the
+ *  scene shader.
+ ***********************************************************/
+class SceneImpostors
+{
+public:
+	// constructor
+	SceneImpostors();
+	// destructor
+	~SceneImpostors();
+
+	// load the impostor shaders and create the bounding box
+	bool Create();
+	// free the shader program and the bounding box
+	void Destroy();
+
+	// make the impostor program the current program
+	void Use();
+	ShaderManager* GetShaderManager() { return(m_pShaderManager); }
+
+	// the shapes have the same size and placement as the meshes
+	// of SceneMeshes, so the same transformations can be used
+	void DrawCylinder();
+	void DrawTaperedCylinder();
+	void DrawTorus();
+	void DrawSphere();
+
+private:
+	ShaderManager* m_pShaderManager;
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+
+	// draw the bounding box of a shape with the current program
+	void DrawShape(IMPOSTOR_SHAPE shape, glm::vec2 radii, glm::vec3 boundsMinimum, glm::vec3 boundsMaximum);
+
+	// the shader program cannot be shared between two objects
+	SceneImpostors(const SceneImpostors&);
+	SceneImpostors& operator=(const SceneImpostors&);
+};
@@ -14,8 +14,12 @@
 #include "stb_image.h"
 #endif
 
+#include "MeshGenerators.h"
+
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+
 // declaration of global variables
 namespace
 {
@@ -24,6 +28,60 @@ namespace
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	const char* g_UVScaleName = "UVscale";
+	const char* g_DepthOnlyName = "bDepthOnly";
+	const char* g_UseLightmapName = "bUseLightmap";
+	const char* g_LightmapRectName = "lightmapRect";
+	const char* g_GeometryPassName = "bGeometryPass";
+	const char* g_TransparencyPassName = "bTransparencyPass";
+	const char* g_AlphaCutoutName = "bAlphaCutout";
+	const char* g_MaterialIndexName = "materialIndex";
+	const char* g_ObjectLightCountName = "objectLightCount";
+	const char* g_ObjectLightNames[MAX_OBJECT_LIGHTS] = {
+		"objectLights[0]", "objectLights[1]", "objectLights[2]", "objectLights[3]",
+		"objectLights[4]", "objectLights[5]", "objectLights[6]", "objectLights[7]" };
+
+	// object space bounds of the basic shapes, which the lights
+	// of each draw are found with
+	const glm::vec3 g_PlaneMinimum = glm::vec3(-1.0f, 0.0f, -1.0f);
+	const glm::vec3 g_PlaneMaximum = glm::vec3(1.0f, 0.0f, 1.0f);
+	const glm::vec3 g_BoxMinimum = glm::vec3(-0.5f, -0.5f, -0.5f);
+	const glm::vec3 g_BoxMaximum = glm::vec3(0.5f, 0.5f, 0.5f);
+	const glm::vec3 g_CylinderMinimum = glm::vec3(-1.0f, 0.0f, -1.0f);
+	const glm::vec3 g_CylinderMaximum = glm::vec3(1.0f, 1.0f, 1.0f);
+	const glm::vec3 g_TorusMinimum = glm::vec3(-1.0f - TORUS_THICKNESS, -1.0f - TORUS_THICKNESS, -TORUS_THICKNESS);
+	const glm::vec3 g_TorusMaximum = glm::vec3(1.0f + TORUS_THICKNESS, 1.0f + TORUS_THICKNESS, TORUS_THICKNESS);
+
+	// the imported mesh is scaled to this size and stood on the
+	// right of the desk
+	const char* g_ImportedMeshTag = "imported";
+	const float g_ImportedMeshSize = 3.0f;
+	const glm::vec3 g_ImportedMeshPosition = glm::vec3(5.0f, 0.0f, 4.0f);
+
+	// the baked lighting is kept here between runs
+	const char* g_LightmapCacheDirectory = "./LightmapCache";
+	// texture unit of the lightmap, below the shadow maps
+	const int g_LightmapTextureUnit = 14;
+	// the bounced light keeps some of its energy at every object
+	const float g_MaximumAlbedo = 0.95f;
+
+	// the probes cover the desk in front of the wall, about two
+	// units apart
+	const glm::vec3 g_ProbeGridMinimum = glm::vec3(-10.0f, 0.25f, 0.25f);
+	const glm::vec3 g_ProbeGridMaximum = glm::vec3(10.0f, 8.25f, 10.25f);
+	const int g_ProbeCounts[3] = { 11, 5, 6 };
+
+	// the occlusion covers the same space a quarter unit apart,
+	// and objects further than a unit away do not darken a point
+	const glm::vec3 g_OcclusionMinimum = glm::vec3(-10.0f, 0.125f, 0.125f);
+	const glm::vec3 g_OcclusionMaximum = glm::vec3(10.0f, 8.125f, 10.125f);
+	const int g_OcclusionCounts[3] = { 81, 33, 41 };
+	const float g_OcclusionDistance = 1.0f;
+
+	// the environment is prefiltered into the same cache, and is
+	// dimmed to the brightness of the room
+	const char* g_EnvironmentFile = "./Textures/environment.hdr";
+	const float g_EnvironmentIntensity = 0.3f;
 }
 
 /***********************************************************
@@ -34,7 +92,40 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_basicMeshes = new SceneMeshes(pShaderManager);
+	m_impostors = new SceneImpostors();
+	m_bImpostorRendering = false;
+	m_tessellation = new SceneTessellation();
+	m_bTessellatedRendering = false;
+	m_lights = new ClusteredLights();
+	m_shadows = new ShadowCascades();
+	m_frameFences = new FrameFences();
+	// none of the objects of the scene move yet
+	m_bDynamicShadowCasters = false;
+	m_pLightmapBaker = NULL;
+	m_lightmapTexture = 0;
+	m_planeIndex = 0;
+	m_probes = new IrradianceProbes();
+	m_occlusion = new AmbientOcclusion();
+	m_environment = new ImageBasedLighting();
+	m_deferred = new DeferredShading();
+	m_transparency = new WeightedTransparency();
+	m_bDeferredRendering = false;
+	m_bSortedTransparency = false;
+	m_bQueueTransparent = false;
+	m_renderPass = RENDER_PASS_ALL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewportHeight = 1;
+
+	m_objectValues.model = glm::mat4(1.0f);
+	m_objectValues.color = glm::vec4(1.0f);
+	m_objectValues.bUseTexture = false;
+	m_objectValues.textureSlot = 0;
+	m_objectValues.UVscale = glm::vec2(1.0f, 1.0f);
+	m_objectValues.bUseMaterial = false;
+	m_objectValues.materialIndex = 0;
+	m_objectValues.lightCount = -1;
 }
 
 /***********************************************************
@@ -47,6 +138,32 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_impostors;
+	m_impostors = NULL;
+	delete m_tessellation;
+	m_tessellation = NULL;
+	delete m_lights;
+	m_lights = NULL;
+	delete m_shadows;
+	m_shadows = NULL;
+	delete m_frameFences;
+	m_frameFences = NULL;
+	delete m_probes;
+	m_probes = NULL;
+	delete m_occlusion;
+	m_occlusion = NULL;
+	delete m_environment;
+	m_environment = NULL;
+	delete m_deferred;
+	m_deferred = NULL;
+	delete m_transparency;
+	m_transparency = NULL;
+
+	if (m_lightmapTexture != 0)
+	{
+		glDeleteTextures(1, &m_lightmapTexture);
+		m_lightmapTexture = 0;
+	}
 }
 
 /***********************************************************
@@ -105,6 +222,16 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		// generate the texture mipmaps for mapping textures to lower resolutions
 		glGenerateMipmap(GL_TEXTURE_2D);
 
+		// the lightmap baker bounces the light with the average color
+		glm::vec3 averageColor(0.0f);
+		size_t pixelCount = (size_t)width * (size_t)height;
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			const unsigned char* pixel = image + i * colorChannels;
+			averageColor += glm::vec3(pixel[0], pixel[1], pixel[2]);
+		}
+		averageColor /= 255.0f * (float)std::max(pixelCount, (size_t)1);
+
 		// free the image data from local memory
 		stbi_image_free(image);
 		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
@@ -112,6 +239,7 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
 		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].averageColor = averageColor;
 		m_loadedTextures++;
 
 		return true;
@@ -240,6 +368,27 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	return(true);
 }
 
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the position of the
+ *  material associated with the passed in tag in the defined
+ *  materials list, which is also its index in the material
+ *  table of the deferred lighting pass.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	for (size_t index = 0; index < m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			return((int)index);
+		}
+	}
+
+	return(-1);
+}
+
 /***********************************************************
  *  SetTransformations()
  *
@@ -279,6 +428,857 @@ void SceneManager::SetTransformations(
 	{
 		m_pShaderManager->setMat4Value(g_ModelName, modelView);
 	}
+
+	// the meshes need the model matrix to cull their meshlets
+	m_basicMeshes->SetModelMatrix(modelView);
+	m_objectValues.model = modelView;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  The buffers
+ *  rewritten every frame have a region for each frame in
+ *  flight, and the region of this frame is only handed out
+ *  once the GPU has finished the frame that last used it,
+ *  so the CPU can build this frame while the GPU is still
+ *  drawing the ones before.
+ ***********************************************************/
+void SceneManager::BeginFrame()
+{
+	m_frameFences->BeginFrame();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for ending a frame, after which the
+ *  region of the frame stays in use until the GPU is done.
+ ***********************************************************/
+void SceneManager::EndFrame()
+{
+	m_frameFences->EndFrame();
+}
+
+/***********************************************************
+ *  SetViewParameters()
+ *
+ *  This method is used for passing the view and projection
+ *  matrices of the current frame to the scene, so that the
+ *  meshes can skip the parts that are out of view and use
+ *  less detail for the parts that are far away.
+ ***********************************************************/
+void SceneManager::SetViewParameters(const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewportHeight = viewportHeight;
+	m_basicMeshes->SetViewParameters(view, projection, viewportHeight);
+
+	// the impostors cast their rays from the camera position, and
+	// the tessellation measures the patch edges in pixels
+	ShaderManager* shaderManagers[] = { m_impostors->GetShaderManager(), m_tessellation->GetShaderManager() };
+	for (int i = 0; i < 2; i++)
+	{
+		ShaderManager* pShaderManager = shaderManagers[i];
+		if (NULL == pShaderManager)
+		{
+			continue;
+		}
+		pShaderManager->use();
+		pShaderManager->setMat4Value("view", view);
+		pShaderManager->setMat4Value("projection", projection);
+		pShaderManager->setVec3Value("viewPosition", glm::vec3(glm::inverse(view)[3]));
+		pShaderManager->setFloatValue("viewportHeight", (float)viewportHeight);
+	}
+	m_pShaderManager->use();
+
+	// the lighting pass turns the depth back into positions
+	m_deferred->SetViewParameters(view, projection);
+
+	// every program reads the same light clusters
+	m_lights->Update(view, projection, viewportHeight, m_frameFences->GetFrameIndex());
+}
+
+/***********************************************************
+ *  SetImpostorRendering()
+ *
+ *  This method is used for choosing whether the cylinders
+ *  and the torus are drawn as ray cast impostors or as
+ *  triangle meshes.
+ ***********************************************************/
+void SceneManager::SetImpostorRendering(bool bEnabled)
+{
+	m_bImpostorRendering = bEnabled;
+}
+
+/***********************************************************
+ *  SetTessellatedRendering()
+ *
+ *  This method is used for choosing whether the cylinders
+ *  and the torus are drawn with hardware tessellation, so
+ *  their detail follows their size on the screen.
+ ***********************************************************/
+void SceneManager::SetTessellatedRendering(bool bEnabled)
+{
+	m_bTessellatedRendering = bEnabled;
+}
+
+/***********************************************************
+ *  SetDeferredRendering()
+ *
+ *  This method is used for choosing whether the opaque
+ *  objects are drawn into the G-buffer and lit once per
+ *  pixel, or lit while they are drawn.
+ ***********************************************************/
+void SceneManager::SetDeferredRendering(bool bEnabled)
+{
+	m_bDeferredRendering = bEnabled;
+}
+
+/***********************************************************
+ *  SetSortedTransparency()
+ *
+ *  This method is used for choosing whether the transparent
+ *  objects are sorted from the farthest to the nearest and
+ *  blended exactly, or accumulated in any order with the
+ *  weighted blended transparency.
+ ***********************************************************/
+void SceneManager::SetSortedTransparency(bool bEnabled)
+{
+	m_bSortedTransparency = bEnabled;
+}
+
+/***********************************************************
+ *  SetProceduralShapes()
+ *
+ *  This method is used for choosing whether the plane, box
+ *  and cylinders are built by the vertex shader, or drawn
+ *  from their stored meshes with the compact vertex formats,
+ *  meshlets and levels of detail.
+ ***********************************************************/
+void SceneManager::SetProceduralShapes(bool bEnabled)
+{
+	m_basicMeshes->SetProceduralMeshes(bEnabled);
+}
+
+/***********************************************************
+ *  SetImportedMeshFile()
+ *
+ *  This method is used for choosing an OBJ or GLB file to
+ *  import into the scene.  It is loaded with the other
+ *  meshes, so it must be set before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetImportedMeshFile(const char* filename)
+{
+	m_importedMeshFile = (NULL != filename) ? filename : "";
+}
+
+/***********************************************************
+ *  InvalidateStaticShadows()
+ *
+ *  This method is used for drawing the static shadow maps
+ *  again on the next frame, after an object drawn by
+ *  RenderStaticObjects() is moved or changed.
+ ***********************************************************/
+void SceneManager::InvalidateStaticShadows()
+{
+	m_shadows->InvalidateStaticShadows();
+}
+
+/***********************************************************
+ *  SetShadowPassView()
+ *
+ *  This method is used for setting the light view of a
+ *  shadow cascade into the scene shader, and into the meshes
+ *  so that they cull against the cascade instead of the
+ *  camera.
+ ***********************************************************/
+void SceneManager::SetShadowPassView(int cascade)
+{
+	glm::mat4 lightView = m_shadows->GetLightView();
+	glm::mat4 lightProjection = m_shadows->GetLightProjection(cascade);
+
+	m_pShaderManager->setMat4Value("view", lightView);
+	m_pShaderManager->setMat4Value("projection", lightProjection);
+	m_basicMeshes->SetViewParameters(lightView, lightProjection, m_shadows->GetResolution());
+}
+
+/***********************************************************
+ *  RenderShadows()
+ *
+ *  This method is used for drawing the depth of the objects
+ *  into the shadow cascades of the directional light.  The
+ *  static objects are only drawn into the cascades whose
+ *  cached depth is no longer valid, and the moving objects
+ *  are drawn into every cascade over a copy of it.  The
+ *  scene shader draws the depth, so the curved shapes are
+ *  drawn as meshes during the passes.
+ ***********************************************************/
+void SceneManager::RenderShadows()
+{
+	m_shadows->Update(m_viewMatrix, m_projectionMatrix);
+
+	bool bImpostorRendering = m_bImpostorRendering;
+	bool bTessellatedRendering = m_bTessellatedRendering;
+	m_bImpostorRendering = false;
+	m_bTessellatedRendering = false;
+	m_pShaderManager->setBoolValue(g_DepthOnlyName, true);
+
+	for (int i = 0; i < ShadowCascades::CASCADE_COUNT; i++)
+	{
+		if (m_shadows->BeginStaticPass(i))
+		{
+			SetShadowPassView(i);
+			RenderStaticObjects();
+			m_shadows->EndPass();
+		}
+	}
+
+	if (m_bDynamicShadowCasters)
+	{
+		for (int i = 0; i < ShadowCascades::CASCADE_COUNT; i++)
+		{
+			if (m_shadows->BeginDynamicPass(i))
+			{
+				SetShadowPassView(i);
+				RenderDynamicObjects();
+				m_shadows->EndPass();
+			}
+		}
+	}
+
+	m_shadows->Publish(m_bDynamicShadowCasters, m_frameFences->GetFrameIndex());
+
+	// put the camera view back for the scene
+	m_pShaderManager->setBoolValue(g_DepthOnlyName, false);
+	m_pShaderManager->setMat4Value("view", m_viewMatrix);
+	m_pShaderManager->setMat4Value("projection", m_projectionMatrix);
+	m_basicMeshes->SetViewParameters(m_viewMatrix, m_projectionMatrix, m_viewportHeight);
+	m_bImpostorRendering = bImpostorRendering;
+	m_bTessellatedRendering = bTessellatedRendering;
+}
+
+/***********************************************************
+ *  ApplyObjectValues()
+ *
+ *  This method is used for setting the object values of the
+ *  next draw into the passed in shader, so that a second
+ *  program draws the object the same way as the scene shader.
+ ***********************************************************/
+void SceneManager::ApplyObjectValues(ShaderManager* pShaderManager)
+{
+	pShaderManager->setMat4Value(g_ModelName, m_objectValues.model);
+	pShaderManager->setIntValue(g_UseTextureName, m_objectValues.bUseTexture);
+	pShaderManager->setVec4Value(g_ColorValueName, m_objectValues.color);
+	pShaderManager->setSampler2DValue(g_TextureValueName, m_objectValues.textureSlot);
+	pShaderManager->setVec2Value(g_UVScaleName, m_objectValues.UVscale);
+	pShaderManager->setIntValue(g_MaterialIndexName, m_objectValues.materialIndex);
+	pShaderManager->setIntValue(g_ObjectLightCountName, m_objectValues.lightCount);
+	for (int i = 0; i < m_objectValues.lightCount; i++)
+	{
+		pShaderManager->setIntValue(g_ObjectLightNames[i], m_objectValues.lights[i]);
+	}
+
+	if (m_objectValues.bUseMaterial == true)
+	{
+		pShaderManager->setVec3Value("material.ambientColor", m_objectValues.material.ambientColor);
+		pShaderManager->setFloatValue("material.ambientStrength", m_objectValues.material.ambientStrength);
+		pShaderManager->setVec3Value("material.diffuseColor", m_objectValues.material.diffuseColor);
+		pShaderManager->setVec3Value("material.specularColor", m_objectValues.material.specularColor);
+		pShaderManager->setFloatValue("material.shininess", m_objectValues.material.shininess);
+	}
+}
+
+/***********************************************************
+ *  BeginProgramDraw()
+ *
+ *  This method is used for making the passed in shader the
+ *  current program, with the values of the next object.
+ ***********************************************************/
+bool SceneManager::BeginProgramDraw(ShaderManager* pShaderManager)
+{
+	if (NULL == pShaderManager)
+	{
+		return(false);
+	}
+
+	pShaderManager->use();
+	ApplyObjectValues(pShaderManager);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndProgramDraw()
+ *
+ *  This method is used for making the scene shader the
+ *  current program again after a curved shape is drawn.
+ ***********************************************************/
+void SceneManager::EndProgramDraw()
+{
+	m_pShaderManager->use();
+	// the curved shape bound its own vertex array object
+	m_basicMeshes->InvalidateBindings();
+}
+
+/***********************************************************
+ *  IsDrawnInPass()
+ *
+ *  This method is used for getting whether the next object
+ *  is drawn by the current pass.  The objects with a
+ *  see-through color are drawn after all of the opaque
+ *  objects, into the transparency targets.
+ ***********************************************************/
+bool SceneManager::IsDrawnInPass() const
+{
+	if (m_renderPass == RENDER_PASS_ALL)
+	{
+		return(true);
+	}
+
+	bool bTransparent = (m_objectValues.bUseTexture == false) && (m_objectValues.color.a < 1.0f);
+	return(bTransparent == (m_renderPass == RENDER_PASS_TRANSPARENT));
+}
+
+/***********************************************************
+ *  SetObjectLights()
+ *
+ *  This method is used for finding the lights whose range
+ *  touches the bounds of the next object, so that its
+ *  fragments only loop over those lights.  When more lights
+ *  touch it than a draw can hold, the object goes back to
+ *  the light clusters.
+ ***********************************************************/
+void SceneManager::SetObjectLights(const glm::vec3& minimum, const glm::vec3& maximum)
+{
+	if (NULL != m_pLightmapBaker)
+	{
+		return;
+	}
+
+	int lightCount = m_lights->FindObjectLights(
+		m_objectValues.model,
+		minimum,
+		maximum,
+		m_objectValues.lights,
+		MAX_OBJECT_LIGHTS);
+	m_objectValues.lightCount = (lightCount <= MAX_OBJECT_LIGHTS) ? lightCount : -1;
+
+	m_pShaderManager->setIntValue(g_ObjectLightCountName, m_objectValues.lightCount);
+	for (int i = 0; i < m_objectValues.lightCount; i++)
+	{
+		m_pShaderManager->setIntValue(g_ObjectLightNames[i], m_objectValues.lights[i]);
+	}
+}
+
+/***********************************************************
+ *  SetPassFlag()
+ *
+ *  This method is used for setting a pass uniform of the
+ *  scene shader and the curved shape shaders, which makes
+ *  them write the G-buffer or the transparency targets
+ *  instead of the lit color.  The scene shader is left as
+ *  the current program.
+ ***********************************************************/
+void SceneManager::SetPassFlag(const char* name, bool bEnabled)
+{
+	ShaderManager* shaderManagers[] = { m_impostors->GetShaderManager(), m_tessellation->GetShaderManager(), m_pShaderManager };
+	for (int i = 0; i < 3; i++)
+	{
+		ShaderManager* pShaderManager = shaderManagers[i];
+		if (NULL == pShaderManager)
+		{
+			continue;
+		}
+		pShaderManager->use();
+		pShaderManager->setBoolValue(name, bEnabled);
+	}
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  QueueTransparentDraw()
+ *
+ *  This method is used for keeping the values of the next
+ *  object while the transparent objects are queued, with the
+ *  view depth of the center of its box to sort it by.
+ ***********************************************************/
+bool SceneManager::QueueTransparentDraw(
+	DRAW_SHAPE shape,
+	int shapeIndex,
+	const glm::vec3& minimum,
+	const glm::vec3& maximum)
+{
+	if (m_bQueueTransparent == false)
+	{
+		return(false);
+	}
+
+	TRANSPARENT_DRAW draw;
+	draw.values = m_objectValues;
+	draw.shape = shape;
+	draw.shapeIndex = shapeIndex;
+	m_transparentDraws.push_back(draw);
+
+	glm::vec4 center = m_objectValues.model * glm::vec4((minimum + maximum) * 0.5f, 1.0f);
+	m_transparentDepths.push_back(-(m_viewMatrix * center).z);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawTransparentQueue()
+ *
+ *  This method is used for drawing the queued transparent
+ *  objects in the order of a radix sort by view depth, so
+ *  every one blends over the ones behind it.  The objects
+ *  test the depth of the opaque ones but do not write it,
+ *  and the queue is emptied for the next frame.
+ ***********************************************************/
+void SceneManager::DrawTransparentQueue()
+{
+	if (m_transparentDraws.size() == 0)
+	{
+		return;
+	}
+
+	const std::vector<uint32_t>& order = m_depthSorter.SortBackToFront(m_transparentDepths.data(), m_transparentDepths.size());
+
+	GLboolean bDepthMask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &bDepthMask);
+	glDepthMask(GL_FALSE);
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const TRANSPARENT_DRAW& draw = m_transparentDraws[order[i]];
+		m_objectValues = draw.values;
+		ApplyObjectValues(m_pShaderManager);
+		// the meshes pick their detail and cull their meshlets
+		// with the model matrix of the object being drawn
+		m_basicMeshes->SetModelMatrix(draw.values.model);
+
+		switch (draw.shape)
+		{
+		case DRAW_SHAPE_CYLINDER:
+			DrawCylinder();
+			break;
+		case DRAW_SHAPE_TAPERED_CYLINDER:
+			DrawTaperedCylinder();
+			break;
+		case DRAW_SHAPE_TORUS:
+			DrawTorus();
+			break;
+		case DRAW_SHAPE_PLANE:
+			// the plane takes its atlas rectangle from the count
+			m_planeIndex = (size_t)draw.shapeIndex;
+			DrawPlane();
+			break;
+		case DRAW_SHAPE_BOX:
+			DrawBox();
+			break;
+		case DRAW_SHAPE_BOX_SIDE:
+			DrawBoxSide((SceneMeshes::BoxSide)draw.shapeIndex);
+			break;
+		case DRAW_SHAPE_IMPORTED:
+			DrawImportedMesh();
+			break;
+		}
+	}
+
+	glDepthMask(bDepthMask);
+	m_transparentDraws.clear();
+	m_transparentDepths.clear();
+}
+
+/***********************************************************
+ *  DrawCylinder()
+ *
+ *  This method is used for drawing a cylinder with the
+ *  current object values.
+ ***********************************************************/
+void SceneManager::DrawCylinder()
+{
+	if ((NULL == m_pLightmapBaker) && (IsDrawnInPass() == false))
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_CYLINDER, 0, g_CylinderMinimum, g_CylinderMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_CylinderMinimum, g_CylinderMaximum);
+
+	if (NULL != m_pLightmapBaker)
+	{
+		MESH_DATA mesh;
+		GenerateCylinderMesh(mesh);
+		m_pLightmapBaker->AddOccluder(mesh, m_objectValues.model, GetObjectAlbedo());
+	}
+	else if (m_bTessellatedRendering && BeginProgramDraw(m_tessellation->GetShaderManager()))
+	{
+		m_tessellation->DrawCylinder();
+		EndProgramDraw();
+	}
+	else if (m_bImpostorRendering && BeginProgramDraw(m_impostors->GetShaderManager()))
+	{
+		m_impostors->DrawCylinder();
+		EndProgramDraw();
+	}
+	else
+	{
+		m_basicMeshes->DrawCylinderMesh();
+	}
+}
+
+/***********************************************************
+ *  DrawTaperedCylinder()
+ *
+ *  This method is used for drawing a tapered cylinder with
+ *  the current object values.
+ ***********************************************************/
+void SceneManager::DrawTaperedCylinder()
+{
+	if ((NULL == m_pLightmapBaker) && (IsDrawnInPass() == false))
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_TAPERED_CYLINDER, 0, g_CylinderMinimum, g_CylinderMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_CylinderMinimum, g_CylinderMaximum);
+
+	if (NULL != m_pLightmapBaker)
+	{
+		MESH_DATA mesh;
+		GenerateTaperedCylinderMesh(mesh);
+		m_pLightmapBaker->AddOccluder(mesh, m_objectValues.model, GetObjectAlbedo());
+	}
+	else if (m_bTessellatedRendering && BeginProgramDraw(m_tessellation->GetShaderManager()))
+	{
+		m_tessellation->DrawTaperedCylinder();
+		EndProgramDraw();
+	}
+	else if (m_bImpostorRendering && BeginProgramDraw(m_impostors->GetShaderManager()))
+	{
+		m_impostors->DrawTaperedCylinder();
+		EndProgramDraw();
+	}
+	else
+	{
+		m_basicMeshes->DrawTaperedCylinderMesh();
+	}
+}
+
+/***********************************************************
+ *  DrawTorus()
+ *
+ *  This method is used for drawing a torus with the current
+ *  object values.
+ ***********************************************************/
+void SceneManager::DrawTorus()
+{
+	if ((NULL == m_pLightmapBaker) && (IsDrawnInPass() == false))
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_TORUS, 0, g_TorusMinimum, g_TorusMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_TorusMinimum, g_TorusMaximum);
+
+	if (NULL != m_pLightmapBaker)
+	{
+		MESH_DATA mesh;
+		GenerateTorusMesh(mesh);
+		m_pLightmapBaker->AddOccluder(mesh, m_objectValues.model, GetObjectAlbedo());
+	}
+	else if (m_bTessellatedRendering && BeginProgramDraw(m_tessellation->GetShaderManager()))
+	{
+		m_tessellation->DrawTorus();
+		EndProgramDraw();
+	}
+	else if (m_bImpostorRendering && BeginProgramDraw(m_impostors->GetShaderManager()))
+	{
+		m_impostors->DrawTorus();
+		EndProgramDraw();
+	}
+	else
+	{
+		m_basicMeshes->DrawTorusMesh();
+	}
+}
+
+/***********************************************************
+ *  DrawPlane()
+ *
+ *  This method is used for drawing a plane with the current
+ *  object values.  The planes are the only objects whose UVs
+ *  cover them once, so they get the baked lighting and the
+ *  other objects are lit by the shader.
+ ***********************************************************/
+void SceneManager::DrawPlane()
+{
+	if (NULL != m_pLightmapBaker)
+	{
+		MESH_DATA mesh;
+		GeneratePlaneMesh(mesh);
+		m_pLightmapBaker->AddReceiver(
+			mesh,
+			m_objectValues.model,
+			GetObjectAlbedo(),
+			m_objectValues.material.ambientColor * m_objectValues.material.ambientStrength,
+			m_objectValues.material.diffuseColor);
+		return;
+	}
+
+	// the planes are counted in every pass, so that each one
+	// keeps its atlas rectangle
+	size_t planeIndex = m_planeIndex++;
+	if (IsDrawnInPass() == false)
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_PLANE, (int)planeIndex, g_PlaneMinimum, g_PlaneMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_PlaneMinimum, g_PlaneMaximum);
+
+	bool bUseLightmap = (m_lightmapTexture != 0) && (planeIndex < m_lightmapRects.size());
+	if (bUseLightmap)
+	{
+		m_pShaderManager->setBoolValue(g_UseLightmapName, true);
+		m_pShaderManager->setVec4Value(g_LightmapRectName, m_lightmapRects[planeIndex]);
+	}
+
+	m_basicMeshes->DrawPlaneMesh();
+
+	if (bUseLightmap)
+	{
+		m_pShaderManager->setBoolValue(g_UseLightmapName, false);
+	}
+}
+
+/***********************************************************
+ *  DrawBox()
+ *
+ *  This method is used for drawing a box with the current
+ *  object values.
+ ***********************************************************/
+void SceneManager::DrawBox()
+{
+	if (NULL != m_pLightmapBaker)
+	{
+		MESH_DATA mesh;
+		GenerateBoxMesh(mesh);
+		m_pLightmapBaker->AddOccluder(mesh, m_objectValues.model, GetObjectAlbedo());
+		return;
+	}
+	if (IsDrawnInPass() == false)
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_BOX, 0, g_BoxMinimum, g_BoxMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_BoxMinimum, g_BoxMaximum);
+
+	m_basicMeshes->DrawBoxMesh();
+}
+
+/***********************************************************
+ *  DrawBoxSide()
+ *
+ *  This method is used for drawing one side of a box with
+ *  the current object values.  The sides are drawn over a
+ *  whole box, so the baker already has them.
+ ***********************************************************/
+void SceneManager::DrawBoxSide(SceneMeshes::BoxSide side)
+{
+	if ((NULL != m_pLightmapBaker) || (IsDrawnInPass() == false))
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_BOX_SIDE, (int)side, g_BoxMinimum, g_BoxMaximum))
+	{
+		return;
+	}
+	SetObjectLights(g_BoxMinimum, g_BoxMaximum);
+
+	m_basicMeshes->DrawBoxSideMesh(side);
+}
+
+/***********************************************************
+ *  DrawImportedMesh()
+ *
+ *  This method is used for drawing the imported mesh with
+ *  the current object values.  The mesh is loaded after the
+ *  lighting is baked, so it is not part of the baked light.
+ ***********************************************************/
+void SceneManager::DrawImportedMesh()
+{
+	MESH_BOUNDS bounds;
+	if ((NULL != m_pLightmapBaker) || (IsDrawnInPass() == false) ||
+		(m_basicMeshes->GetImportedMeshBounds(g_ImportedMeshTag, bounds) == false))
+	{
+		return;
+	}
+	if (QueueTransparentDraw(DRAW_SHAPE_IMPORTED, 0, bounds.minimum, bounds.maximum))
+	{
+		return;
+	}
+	SetObjectLights(bounds.minimum, bounds.maximum);
+
+	m_basicMeshes->DrawImportedMesh(g_ImportedMeshTag);
+}
+
+/***********************************************************
+ *  GetObjectAlbedo()
+ *
+ *  This method is used for getting the color that the next
+ *  object bounces the light with - the average color of its
+ *  texture, or its color, times the diffuse color of its
+ *  material.
+ ***********************************************************/
+glm::vec3 SceneManager::GetObjectAlbedo() const
+{
+	glm::vec3 albedo(m_objectValues.color.r, m_objectValues.color.g, m_objectValues.color.b);
+	if (m_objectValues.bUseTexture && (m_objectValues.textureSlot >= 0) && (m_objectValues.textureSlot < m_loadedTextures))
+	{
+		albedo = m_textureIDs[m_objectValues.textureSlot].averageColor;
+	}
+	if (m_objectValues.bUseMaterial)
+	{
+		albedo = albedo * m_objectValues.material.diffuseColor;
+	}
+
+	return(glm::min(albedo, glm::vec3(g_MaximumAlbedo)));
+}
+
+/***********************************************************
+ *  BakeLightmaps()
+ *
+ *  This method is used for baking the lighting of the
+ *  planes, or reading it from the cache when the scene did
+ *  not change, and uploading the atlas for the shader.
+ ***********************************************************/
+void SceneManager::BakeLightmaps()
+{
+	if (NULL == m_pLightmapBaker)
+	{
+		return;
+	}
+
+	LIGHTMAP_ATLAS atlas;
+	if (m_pLightmapBaker->Bake(g_LightmapCacheDirectory, atlas) == false)
+	{
+		std::cout << "ERROR: The lightmaps could not be baked, the planes are lit by the shader" << std::endl;
+		return;
+	}
+
+	glGenTextures(1, &m_lightmapTexture);
+	glBindTexture(GL_TEXTURE_2D, m_lightmapTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, atlas.width, atlas.height, 0, GL_RGB, GL_FLOAT, atlas.texels.data());
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// the scene textures stay bound below the lightmap
+	glActiveTexture(GL_TEXTURE0 + g_LightmapTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_lightmapTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_lightmapRects = atlas.receiverRects;
+}
+
+/***********************************************************
+ *  BakeIrradianceProbes()
+ *
+ *  This method is used for baking the probes that give the
+ *  objects without a lightmap their ambient light, or
+ *  reading them from the cache, and uploading them for the
+ *  shaders.
+ ***********************************************************/
+void SceneManager::BakeIrradianceProbes()
+{
+	if (NULL == m_pLightmapBaker)
+	{
+		return;
+	}
+
+	IRRADIANCE_PROBE_GRID grid;
+	grid.minimum = g_ProbeGridMinimum;
+	grid.maximum = g_ProbeGridMaximum;
+	grid.countX = g_ProbeCounts[0];
+	grid.countY = g_ProbeCounts[1];
+	grid.countZ = g_ProbeCounts[2];
+	if (m_pLightmapBaker->BakeProbes(g_LightmapCacheDirectory, grid) == false)
+	{
+		std::cout << "ERROR: The irradiance probes could not be baked, the objects keep the flat ambient light" << std::endl;
+		return;
+	}
+
+	m_probes->Upload(grid);
+}
+
+/***********************************************************
+ *  BakeAmbientOcclusion()
+ *
+ *  This method is used for baking how much of the space
+ *  around every point over the desk is closed off by the
+ *  static objects, or reading it from the cache, and
+ *  uploading it for the shaders to dim the ambient light.
+ ***********************************************************/
+void SceneManager::BakeAmbientOcclusion()
+{
+	if (NULL == m_pLightmapBaker)
+	{
+		return;
+	}
+
+	OCCLUSION_VOLUME volume;
+	volume.minimum = g_OcclusionMinimum;
+	volume.maximum = g_OcclusionMaximum;
+	volume.countX = g_OcclusionCounts[0];
+	volume.countY = g_OcclusionCounts[1];
+	volume.countZ = g_OcclusionCounts[2];
+	volume.distance = g_OcclusionDistance;
+	if (m_pLightmapBaker->BakeOcclusion(g_LightmapCacheDirectory, volume) == false)
+	{
+		std::cout << "ERROR: The ambient occlusion could not be baked, the ambient light is not dimmed" << std::endl;
+		return;
+	}
+
+	m_occlusion->Upload(volume);
+}
+
+/***********************************************************
+ *  UploadDeferredMaterials()
+ *
+ *  This method is used for uploading the defined materials
+ *  in their order, so that the index of a material in the
+ *  G-buffer finds it in the lighting pass.
+ ***********************************************************/
+void SceneManager::UploadDeferredMaterials()
+{
+	std::vector<DEFERRED_MATERIAL> materials;
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		DEFERRED_MATERIAL deferredMaterial;
+		deferredMaterial.ambientColor = glm::vec4(material.ambientColor * material.ambientStrength, 1.0f);
+		deferredMaterial.diffuseColor = glm::vec4(material.diffuseColor, 1.0f);
+		deferredMaterial.specularShininess = glm::vec4(material.specularColor, material.shininess);
+		materials.push_back(deferredMaterial);
+	}
+
+	m_deferred->SetMaterials(materials);
 }
 
 /***********************************************************
@@ -301,6 +1301,9 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
+	m_objectValues.bUseTexture = false;
+	m_objectValues.color = currentColor;
+
 	if (NULL != m_pShaderManager)
 	{
 		m_pShaderManager->setIntValue(g_UseTextureName, false);
@@ -324,6 +1327,9 @@ void SceneManager::SetShaderTexture(
 		int textureID = -1;
 		textureID = FindTextureSlot(textureTag);
 		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+
+		m_objectValues.bUseTexture = true;
+		m_objectValues.textureSlot = textureID;
 	}
 }
 
@@ -337,8 +1343,9 @@ void SceneManager::SetTextureUVScale(float u, float v)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pShaderManager->setVec2Value(g_UVScaleName, glm::vec2(u, v));
 	}
+	m_objectValues.UVscale = glm::vec2(u, v);
 }
 
 /***********************************************************
@@ -363,6 +1370,11 @@ void SceneManager::SetShaderMaterial(
 			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
 			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
 			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+
+			m_objectValues.bUseMaterial = true;
+			m_objectValues.material = material;
+			m_objectValues.materialIndex = std::max(FindMaterialIndex(materialTag), 0);
+			m_pShaderManager->setIntValue(g_MaterialIndexName, m_objectValues.materialIndex);
 		}
 	}
 }
@@ -498,24 +1510,56 @@ void SceneManager::DefineObjectMaterials()
 // Method to add light sources and to adjust to each light source's attribute
 void SceneManager::SetupSceneLights()
 {
-	/* this line of code tells the shaders to render the 3d scene with custom lighting 
-	   - to use the default rendered lighting comment out the following line*/
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// sets main directional light to mimic a ceiling light placement
-	m_pShaderManager->setVec3Value("directionalLight.direction", 0.0f, 12.0f, 10.0f); // sets position for directional light
-	m_pShaderManager->setVec3Value("directionalLight.ambient", 0.1, 0.1, 0.1); //sets ambient light color
-	m_pShaderManager->setVec3Value("directionalLight.diffuse", 0.82f, 0.93f, 0.96f);//sets diffuse light color to light blue
-	m_pShaderManager->setVec3Value("directionalLight.specular", 0.1f, 0.1f, 0.1f); //sets specular light color
-	m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
-	// sets point light to add extra light in the scene
-	m_pShaderManager->setVec3Value("pointLights[0].position", 0.0f, 3.0f, 8.0f); // sets position for pointLight
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", 0.05f, 0.05f, 0.05f); //sets ambient light color
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", 0.9f, 0.9f, 0.9f); //sets diffuse light color
-	m_pShaderManager->setVec3Value("pointLights[0].specular", 0.1f, 0.1f, 0.1f); //sets specular light color
-	m_pShaderManager->setBoolValue("pointLights[0].bActive", true);
-
+	// the lights are set into the scene shader and the curved
+	// shape shaders, the scene shader is left as the current program
+	ShaderManager* shaderManagers[] = { m_impostors->GetShaderManager(), m_tessellation->GetShaderManager(), m_deferred->GetShaderManager(), m_pShaderManager };
+	// the direction is also used for the shadows of the light
+	glm::vec3 lightDirection = glm::vec3(0.0f, 12.0f, 10.0f);
+	// the colors are also baked into the lightmaps
+	glm::vec3 lightAmbient = glm::vec3(0.1f, 0.1f, 0.1f);
+	glm::vec3 lightDiffuse = glm::vec3(0.82f, 0.93f, 0.96f);
+	for (int i = 0; i < 4; i++)
+	{
+		ShaderManager* pShaderManager = shaderManagers[i];
+		if (NULL == pShaderManager)
+		{
+			continue;
+		}
+		pShaderManager->use();
+
+		/* this line of code tells the shaders to render the 3d scene with custom lighting 
+		   - to use the default rendered lighting comment out the following line*/
+		pShaderManager->setBoolValue(g_UseLightingName, true);
+
+		// sets main directional light to mimic a ceiling light placement
+		pShaderManager->setVec3Value("directionalLight.direction", lightDirection); // sets position for directional light
+		pShaderManager->setVec3Value("directionalLight.ambient", lightAmbient); //sets ambient light color
+		pShaderManager->setVec3Value("directionalLight.diffuse", lightDiffuse);//sets diffuse light color to light blue
+		pShaderManager->setVec3Value("directionalLight.specular", 0.1f, 0.1f, 0.1f); //sets specular light color
+		pShaderManager->setBoolValue("directionalLight.bActive", true);
+	}
+	m_shadows->SetLightDirection(lightDirection);
+
+	// sets point light to add extra light in the scene - the point
+	// and spot lights are shared by all of the programs through the
+	// light clusters, and fade out at their range
+	m_lights->ClearLights();
+	m_lights->AddPointLight(
+		glm::vec3(0.0f, 3.0f, 8.0f), // position
+		100.0f, // range
+		glm::vec3(0.05f, 0.05f, 0.05f), // ambient light color
+		glm::vec3(0.9f, 0.9f, 0.9f), // diffuse light color
+		glm::vec3(0.1f, 0.1f, 0.1f)); // specular light color
+
+	// the lightmap baker gets the same lights while it is set
+	if (NULL != m_pLightmapBaker)
+	{
+		m_pLightmapBaker->SetDirectionalLight(lightDirection, lightAmbient, lightDiffuse);
+		for (size_t i = 0; i < m_lights->GetLightCount(); i++)
+		{
+			m_pLightmapBaker->AddLight(m_lights->GetLight(i));
+		}
+	}
 }
 
 /***********************************************************
@@ -527,24 +1571,65 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
+	// load the impostor, tessellation and deferred lighting
+	// shaders first, so that the lights are also set into them
+	m_impostors->Create();
+	m_tessellation->Create();
+	m_deferred->Create();
+	m_transparency->Create();
+	m_lights->Create();
+	m_shadows->Create();
+	m_probes->Create();
+	m_occlusion->Create();
+	m_environment->Create(g_EnvironmentFile, g_LightmapCacheDirectory, g_EnvironmentIntensity);
+
 	// load the textures for the 3D scene
 	LoadSceneTextures();
 	
 	// run function to define object material
 	DefineObjectMaterials();
+	UploadDeferredMaterials();
+
+	// the lights and the static objects are collected into the
+	// baker while it is set, so that the lighting of the planes
+	// can be baked
+	LightmapBaker lightmapBaker;
+	m_pLightmapBaker = &lightmapBaker;
 
 	// add and defile the light sources for the 3D scene
 	SetupSceneLights();
 
+	// the static objects are collected instead of drawn
+	RenderStaticObjects();
+
+	// bake the lighting of the planes, the probes for the other
+	// objects and the ambient occlusion around all of them, or
+	// read them from the cache
+	BakeLightmaps();
+	BakeIrradianceProbes();
+	BakeAmbientOcclusion();
+	m_pLightmapBaker = NULL;
+
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadTorusMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
+	// the compact vertex formats use half of the vertex memory -
+	// the plane, box and cylinders are also set up to be built by
+	// the vertex shader, which is drawn instead while procedural
+	// shapes are on
+	m_basicMeshes->LoadPlaneMesh(VERTEX_FORMAT_HALF);
+	m_basicMeshes->LoadCylinderMesh(VERTEX_FORMAT_SNORM16);
+	m_basicMeshes->LoadBoxMesh(VERTEX_FORMAT_HALF);
+	m_basicMeshes->LoadTaperedCylinderMesh(VERTEX_FORMAT_SNORM16);
+	m_basicMeshes->LoadTorusMesh(VERTEX_FORMAT_SNORM16);
+	if (m_importedMeshFile.empty() == false)
+	{
+		m_basicMeshes->LoadImportedMesh(g_ImportedMeshTag, m_importedMeshFile.c_str(), VERTEX_FORMAT_SNORM16);
+	}
+
+	// the meshes missing from the cache are built in parallel
+	m_basicMeshes->LoadPendingMeshes();
 }
 	
 
@@ -556,6 +1641,97 @@ void SceneManager::PrepareScene()
  ***********************************************************/
 void SceneManager::RenderScene()
 {
+	// the shadows are drawn first so that the objects can
+	// read them
+	RenderShadows();
+
+	// the opaque objects are drawn into the G-buffer and lit
+	// once per pixel, or lit forward as they are drawn
+	m_renderPass = RENDER_PASS_OPAQUE;
+	if (m_bDeferredRendering && m_deferred->BeginGeometryPass())
+	{
+		SetPassFlag(g_GeometryPassName, true);
+		RenderStaticObjects();
+		RenderDynamicObjects();
+		SetPassFlag(g_GeometryPassName, false);
+		m_deferred->EndGeometryPass();
+
+		m_deferred->LightScene();
+		// the lighting pass bound its own vertex array object
+		m_basicMeshes->InvalidateBindings();
+	}
+	else
+	{
+		// nothing shows through the opaque objects, so they are
+		// drawn without blending and the see-through texels of
+		// the decals are cut out
+		GLboolean bBlendEnabled = glIsEnabled(GL_BLEND);
+		glDisable(GL_BLEND);
+		SetPassFlag(g_AlphaCutoutName, true);
+		RenderStaticObjects();
+		RenderDynamicObjects();
+		SetPassFlag(g_AlphaCutoutName, false);
+		if (bBlendEnabled)
+		{
+			glEnable(GL_BLEND);
+		}
+	}
+
+	// the transparent objects are then blended over the opaque
+	// ones, either accumulated in any order and blended over
+	// the screen at once, or sorted from the farthest to the
+	// nearest and blended exactly
+	m_renderPass = RENDER_PASS_TRANSPARENT;
+	if ((m_bSortedTransparency == false) && m_transparency->BeginAccumulation())
+	{
+		SetPassFlag(g_TransparencyPassName, true);
+		RenderStaticObjects();
+		RenderDynamicObjects();
+		SetPassFlag(g_TransparencyPassName, false);
+		m_transparency->EndAccumulation();
+
+		m_transparency->Composite();
+		// the composite step bound its own vertex array object
+		m_basicMeshes->InvalidateBindings();
+	}
+	else
+	{
+		m_bQueueTransparent = true;
+		RenderStaticObjects();
+		RenderDynamicObjects();
+		m_bQueueTransparent = false;
+		DrawTransparentQueue();
+	}
+	m_renderPass = RENDER_PASS_ALL;
+}
+
+/***********************************************************
+ *  RenderDynamicObjects()
+ *
+ *  This method is used for drawing the objects that move.
+ *  Their shadows are drawn every frame, while the shadows of
+ *  the static objects are cached, so m_bDynamicShadowCasters
+ *  must be set when objects are added here.  The render loop
+ *  only draws after input, so moving objects would also have
+ *  to keep it drawing every frame.
+ ***********************************************************/
+void SceneManager::RenderDynamicObjects()
+{
+}
+
+/***********************************************************
+ *  RenderStaticObjects()
+ *
+ *  This method is used for drawing the objects that never
+ *  move.  It is also used to draw their depth into the
+ *  shadow maps and to collect them for the lightmaps, so it
+ *  only sets the object values and draws.
+ ***********************************************************/
+void SceneManager::RenderStaticObjects()
+{
+	// the planes find their lightmap rectangles by their order
+	m_planeIndex = 0;
+
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
 	// Sets Default rotation values to 0
@@ -578,7 +1754,7 @@ void SceneManager::RenderScene()
 
 	SetShaderTexture("table"); // uses the table texture for the PLANE GROUND
 	SetShaderMaterial("table");
-	m_basicMeshes->DrawPlaneMesh(); // draw the mesh with given transformation values
+	DrawPlane(); // draw the mesh with given transformation values
 	/****************************************************************/
 
 	//PLANE BACKWALL
@@ -591,7 +1767,7 @@ void SceneManager::RenderScene()
 
 	SetShaderTexture("wall"); // uses the wall texture for the PLANE BACKWALL
 	SetShaderMaterial("backwall");
-	m_basicMeshes->DrawPlaneMesh(); // draw the mesh with given transformation values
+	DrawPlane(); // draw the mesh with given transformation values
 	//****************************************************************
 
 	//MASKING TAPE
@@ -603,7 +1779,7 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, -20.0f, YrotationDegrees, ZrotationDegrees, positionXYZ);
 
 	SetShaderTexture("maskingTape"); // uses the wall texture for the MASKING TAPE
-	m_basicMeshes->DrawTorusMesh(); // draw the mesh with given transformation values
+	DrawTorus(); // draw the mesh with given transformation values
 	//****************************************************************
 
 	//offsett vector for SMALL BOTTLE to adjust position
@@ -621,7 +1797,7 @@ void SceneManager::RenderScene()
 
 	SetShaderColor(0.57, 0.70, 1.00, 0.25); // SMALL BOTTLE BASE Color = Light Blue
 	SetShaderMaterial("glass");
-	m_basicMeshes->DrawCylinderMesh(); // draw the mesh with given transformation values
+	DrawCylinder(); // draw the mesh with given transformation values
 	//****************************************************************
 	
 	//SMALL BOTTLE NECK 
@@ -636,7 +1812,7 @@ void SceneManager::RenderScene()
 
 	SetShaderColor(0.57, 0.70, 1.00, 0.5); // SMALL BOTTLE NECK Color = Light Blue
 	SetShaderMaterial("glass");
-	m_basicMeshes->DrawTaperedCylinderMesh(); // draw the mesh with given transformation values
+	DrawTaperedCylinder(); // draw the mesh with given transformation values
 	//****************************************************************
 	//SetShaderMaterial("placeHolder");//*********
 	//SMALL BOTTLE CAP 
@@ -650,7 +1826,7 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ, smallBottleOffsetVector);
 
 	SetShaderTexture("smallBottleCap"); // uses the smallBottleCap texture for the SMALL BOTTLE CAP
-	m_basicMeshes->DrawCylinderMesh(); // draw the mesh with given transformation values
+	DrawCylinder(); // draw the mesh with given transformation values
 	//****************************************************************
 	
 	//offsett vector for PERFUME BOTTLE to adjust position
@@ -668,11 +1844,11 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, -15.0f, ZrotationDegrees, positionXYZ, perfumeBottleOffsetVector);
 
 	SetShaderTexture("perfumeBottleBaseText"); // uses the perfumeBottleBaseText texture for the PERFUME BOTTLE BASE
-	m_basicMeshes->DrawBoxSideMesh(ShapeMeshes::BoxSide::front); // Draw only the front side of box so that the text is only on the front
+	DrawBoxSide(SceneMeshes::BoxSide::front); // Draw only the front side of box so that the text is only on the front
 	
 	SetShaderTexture("perfumeBottleBase"); // uses the perfumeBottleBase texture for the PERFUME BOTTLE BASE
 	SetShaderMaterial("perfumeBottle");
-	m_basicMeshes->DrawBoxMesh(); // draw the mesh with given transformation values
+	DrawBox(); // draw the mesh with given transformation values
 	//****************************************************************
 
 	//PERFUME BOTTLE CAP
@@ -687,7 +1863,7 @@ void SceneManager::RenderScene()
 
 	SetShaderTexture("perfumeBottleCap"); // uses the perfumeBottleCap texture for the PERFUME BOTTLE CAP
 	SetShaderMaterial("copper");
-	m_basicMeshes->DrawCylinderMesh(); // draw the mesh with given transformation values
+	DrawCylinder(); // draw the mesh with given transformation values
 	//****************************************************************
 	
 	//offsett vector for SWITCH DOCK to adjust position
@@ -705,10 +1881,10 @@ void SceneManager::RenderScene()
 	SetTransformations(scaleXYZ, XrotationDegrees, -20.0f, ZrotationDegrees, positionXYZ, switchDockOffsetVector);
 
 	SetShaderTexture("switchDockFrontText");// uses the switchDockText texture for the front of the SWITCH DOCK
-	m_basicMeshes->DrawBoxSideMesh(ShapeMeshes::BoxSide::front); // draw the mesh with given transformation values
+	DrawBoxSide(SceneMeshes::BoxSide::front); // draw the mesh with given transformation values
 	SetShaderTexture("switchDock");// uses the switchDockTexture texture for the rest of the SWITCH DOCK FRONT
 	SetShaderMaterial("dock");
-	m_basicMeshes->DrawBoxMesh(); // draw the mesh with given transformation values
+	DrawBox(); // draw the mesh with given transformation values
 	//****************************************************************
 
 	//SWITCH DOCK MIDDLE
@@ -724,7 +1900,7 @@ void SceneManager::RenderScene()
 
 	SetShaderTexture("switchDock");// uses the switchDockTexture texture for SWITCH DOCK MIDDLE
 	SetShaderMaterial("dock");
-	m_basicMeshes->DrawBoxMesh(); // draw the mesh with given transformation values
+	DrawBox(); // draw the mesh with given transformation values
 
 	//SWITCH DOCK BACK
 	// set the XYZ scale for the SWITCH DOCK BACK mesh
@@ -739,6 +1915,26 @@ void SceneManager::RenderScene()
 
 	SetShaderTexture("switchDock");// uses the switchDockTexture texture for SWITCH DOCK BACK
 	SetShaderMaterial("dock");
-	m_basicMeshes->DrawBoxMesh(); // draw the mesh with given transformation values
-	
+	DrawBox(); // draw the mesh with given transformation values
+	//****************************************************************
+
+	//IMPORTED MESH
+	// the mesh from the command line is scaled so its largest side
+	// fits the desk space, and stood on the desk by its lowest point
+	MESH_BOUNDS importedBounds;
+	if (m_basicMeshes->GetImportedMeshBounds(g_ImportedMeshTag, importedBounds))
+	{
+		glm::vec3 size = importedBounds.maximum - importedBounds.minimum;
+		float largestSide = std::max(size.x, std::max(size.y, size.z));
+		float scale = (largestSide > 0.0f) ? g_ImportedMeshSize / largestSide : 1.0f;
+		glm::vec3 base = glm::vec3(importedBounds.center.x, importedBounds.minimum.y, importedBounds.center.z);
+
+		scaleXYZ = glm::vec3(scale);
+		positionXYZ = g_ImportedMeshPosition - base * scale;
+		SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, positionXYZ);
+
+		SetShaderColor(0.8f, 0.8f, 0.8f, 1.0f); // IMPORTED MESH Color = Light Gray
+		SetShaderMaterial("dock");
+		DrawImportedMesh(); // draw the mesh with given transformation values
+	}
 }
@@ -10,7 +10,19 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "SceneMeshes.h"
+#include "SceneImpostors.h"
+#include "SceneTessellation.h"
+#include "ClusteredLights.h"
+#include "ShadowCascades.h"
+#include "FrameFences.h"
+#include "LightmapBaker.h"
+#include "IrradianceProbes.h"
+#include "AmbientOcclusion.h"
+#include "DeferredShading.h"
+#include "WeightedTransparency.h"
+#include "DepthSorter.h"
+#include "ImageBasedLighting.h"
 
 #include <string>
 #include <vector>
@@ -33,6 +45,9 @@ public:
 	{
 		std::string tag;
 		uint32_t ID;
+		// average color of the image, which the lightmap baker
+		// bounces the light with
+		glm::vec3 averageColor;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,17 +60,122 @@ public:
 		std::string tag;
 	};
 
+	// the object values last set into the scene shader, set
+	// again into the impostor or tessellation shader before
+	// each curved shape drawn with them
+	struct OBJECT_VALUES
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		bool bUseTexture;
+		int textureSlot;
+		glm::vec2 UVscale;
+		bool bUseMaterial;
+		OBJECT_MATERIAL material;
+		// index of the material in the deferred material table
+		int materialIndex;
+		// lights that touch the bounds of the object, or a
+		// negative count when the light clusters are used
+		int lightCount;
+		GLint lights[MAX_OBJECT_LIGHTS];
+	};
+
+	// the objects drawn by a pass of RenderScene()
+	enum RENDER_PASS
+	{
+		RENDER_PASS_ALL,
+		RENDER_PASS_OPAQUE,
+		RENDER_PASS_TRANSPARENT
+	};
+
+	// the shapes that a queued draw can replay
+	enum DRAW_SHAPE
+	{
+		DRAW_SHAPE_CYLINDER,
+		DRAW_SHAPE_TAPERED_CYLINDER,
+		DRAW_SHAPE_TORUS,
+		DRAW_SHAPE_PLANE,
+		DRAW_SHAPE_BOX,
+		DRAW_SHAPE_BOX_SIDE,
+		DRAW_SHAPE_IMPORTED
+	};
+
+	// a transparent object kept to be drawn once it is sorted
+	struct TRANSPARENT_DRAW
+	{
+		OBJECT_VALUES values;
+		DRAW_SHAPE shape;
+		// the side of a box side, or the atlas rectangle of a plane
+		int shapeIndex;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
+	SceneMeshes* m_basicMeshes;
+	// pointer to the ray cast impostors of the curved shapes
+	SceneImpostors* m_impostors;
+	// true when the curved shapes are drawn as impostors
+	bool m_bImpostorRendering;
+	// pointer to the tessellated patches of the curved shapes
+	SceneTessellation* m_tessellation;
+	// true when the curved shapes are tessellated
+	bool m_bTessellatedRendering;
+	// pointer to the point and spot lights, culled into view clusters
+	ClusteredLights* m_lights;
+	// pointer to the cascaded shadow maps of the directional light
+	ShadowCascades* m_shadows;
+	// pointer to the fences that keep the frames in flight apart
+	FrameFences* m_frameFences;
+	// true when RenderDynamicObjects() draws objects that move
+	bool m_bDynamicShadowCasters;
+	// set only while the lights and the static objects are
+	// collected for the lightmaps, the objects are not drawn then
+	LightmapBaker* m_pLightmapBaker;
+	// baked lighting of the planes, and the atlas rectangle of
+	// each plane in the order they are drawn
+	GLuint m_lightmapTexture;
+	std::vector<glm::vec4> m_lightmapRects;
+	// number of planes drawn so far in the current pass
+	size_t m_planeIndex;
+	// pointer to the baked probes that light the other objects
+	IrradianceProbes* m_probes;
+	// pointer to the baked occlusion that dims the ambient light
+	AmbientOcclusion* m_occlusion;
+	// pointer to the prefiltered environment for the reflections
+	ImageBasedLighting* m_environment;
+	// pointer to the G-buffer that lights the opaque objects
+	DeferredShading* m_deferred;
+	// pointer to the targets that blend the transparent objects
+	WeightedTransparency* m_transparency;
+	// true when the opaque objects are lit from the G-buffer
+	bool m_bDeferredRendering;
+	// true when the transparent objects are sorted back to front
+	// and blended exactly, instead of accumulated in any order
+	bool m_bSortedTransparency;
+	// true while the transparent objects are queued instead of drawn
+	bool m_bQueueTransparent;
+	// OBJ or GLB file imported into the scene, empty for none
+	std::string m_importedMeshFile;
+	// the queued transparent objects and their view depths
+	std::vector<TRANSPARENT_DRAW> m_transparentDraws;
+	std::vector<float> m_transparentDepths;
+	DepthSorter m_depthSorter;
+	// the objects that the draw methods draw
+	RENDER_PASS m_renderPass;
+	// object values of the next draw
+	OBJECT_VALUES m_objectValues;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// view and projection matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	int m_viewportHeight;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -72,6 +192,8 @@ private:
 
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// find the index of a defined material by tag, or -1
+	int FindMaterialIndex(std::string tag);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -109,8 +231,107 @@ private:
 	// method to add and define the light sources before rendering
 	void SetupSceneLights();
 
+	// set the object values into the shader of the passed in
+	// shader manager, which must be the current program
+	void ApplyObjectValues(ShaderManager* pShaderManager);
+	// switch to another shader with the values of the next
+	// object, returning false when it was not loaded
+	bool BeginProgramDraw(ShaderManager* pShaderManager);
+	// switch back to the scene shader after a curved shape
+	void EndProgramDraw();
+	// get whether the next object is drawn by the current pass
+	bool IsDrawnInPass() const;
+	// find the lights that touch the passed in object space box
+	// of the next object and set them into the scene shader
+	void SetObjectLights(const glm::vec3& minimum, const glm::vec3& maximum);
+	// turn a pass uniform of the scene shaders on or off, to fill
+	// the G-buffer or the transparency targets
+	void SetPassFlag(const char* name, bool bEnabled);
+	// keep the next object to be drawn after sorting while the
+	// transparent objects are queued, returning true when it
+	// was queued - the shape index is the box side or the index
+	// of the plane, and the box holds the object in object space
+	bool QueueTransparentDraw(
+		DRAW_SHAPE shape,
+		int shapeIndex,
+		const glm::vec3& minimum,
+		const glm::vec3& maximum);
+	// draw the queued transparent objects from the farthest to
+	// the nearest
+	void DrawTransparentQueue();
+	// upload the defined materials for the lighting pass
+	void UploadDeferredMaterials();
+
+	// draw the depth of the objects into the shadow cascades
+	void RenderShadows();
+	// set the light view of a shadow cascade into the scene
+	// shader and the mesh culling
+	void SetShadowPassView(int cascade);
+	// draw the objects that never move, which are cached in the
+	// static shadow maps
+	void RenderStaticObjects();
+	// draw the objects that move, which cast their shadows every
+	// frame
+	void RenderDynamicObjects();
+
+	// draw the curved shapes tessellated, as impostors, or as
+	// triangle meshes
+	void DrawCylinder();
+	void DrawTaperedCylinder();
+	void DrawTorus();
+	// draw the plane with its baked lighting, and the box
+	void DrawPlane();
+	void DrawBox();
+	void DrawBoxSide(SceneMeshes::BoxSide side);
+	// draw the mesh imported from the command line, once it is
+	// loaded
+	void DrawImportedMesh();
+
+	// color that the next object bounces the light with
+	glm::vec3 GetObjectAlbedo() const;
+	// bake the lighting of the planes, or read it from the cache,
+	// with the lights and static objects collected before
+	void BakeLightmaps();
+	// bake the probes for the ambient light of the other objects
+	void BakeIrradianceProbes();
+	// bake the occlusion of the ambient light around the objects
+	void BakeAmbientOcclusion();
+
 public:
 
+	// start a frame, waiting when the GPU is still drawing the
+	// frame that last used its buffers - called before anything of
+	// the frame is set
+	void BeginFrame();
+	// end a frame after its last command
+	void EndFrame();
+
+	// set the view and projection matrices and the viewport height
+	// in pixels of the current frame
+	void SetViewParameters(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+
+	// draw the curved shapes as ray cast impostors when true,
+	// or as triangle meshes when false
+	void SetImpostorRendering(bool bEnabled);
+	// tessellate the curved shapes by their size on the screen
+	// when true, this is used before the impostors
+	void SetTessellatedRendering(bool bEnabled);
+	// light the opaque objects from a G-buffer when true, or
+	// while they are drawn when false
+	void SetDeferredRendering(bool bEnabled);
+	// sort the transparent objects back to front when true, or
+	// accumulate them in any order when false
+	void SetSortedTransparency(bool bEnabled);
+	// build the plane, box and cylinders in the vertex shader when
+	// true, or draw them from their stored meshes when false
+	void SetProceduralShapes(bool bEnabled);
+	// import an OBJ or GLB file and stand it on the desk - called
+	// before PrepareScene()
+	void SetImportedMeshFile(const char* filename);
+	// draw the cached static shadows again after a static object
+	// is changed
+	void InvalidateStaticShadows();
+
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
@@ -0,0 +1,862 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.cpp
+// ============
+// manage the GPU meshes of the basic 3D shapes drawn in the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneMeshes.h"
+#include "MeshGenerators.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	const char* g_VertexFormatName = "vertexFormat";
+	const char* g_PositionOffsetName = "positionOffset";
+	const char* g_PositionScaleName = "positionScale";
+	const char* g_ProceduralShapeName = "proceduralShape";
+	const char* g_ProceduralSegmentsName = "proceduralSegments";
+	const char* g_ProceduralRadiiName = "proceduralRadii";
+
+	// number of indices used by each side of the box mesh
+	const GLsizei g_BoxSideIndices = 6;
+
+	// meshes with fewer triangles are always drawn whole
+	const size_t g_MeshletMinimumTriangles = 512;
+
+	// folder that holds the processed mesh files
+	const char* g_MeshCacheDirectory = "./MeshCache";
+
+	// largest screen error of a level of detail, in pixels
+	const float g_DefaultLODPixelError = 1.0f;
+	const int g_DefaultViewportHeight = 800;
+}
+
+/***********************************************************
+ *  SceneMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneMeshes::SceneMeshes(ShaderManager* pShaderManager) :
+	m_meshCache(g_MeshCacheDirectory)
+{
+	m_pShaderManager = pShaderManager;
+
+	GLMesh emptyMesh = {};
+	emptyMesh.format = VERTEX_FORMAT_FLOAT32;
+	emptyMesh.positionScale = glm::vec3(1.0f);
+	emptyMesh.proceduralShape = PROCEDURAL_SHAPE_NONE;
+	emptyMesh.proceduralRadii = glm::vec2(1.0f);
+
+	m_planeMesh = emptyMesh;
+	m_boxMesh = emptyMesh;
+	m_cylinderMesh = emptyMesh;
+	m_taperedCylinderMesh = emptyMesh;
+	m_torusMesh = emptyMesh;
+	m_proceduralPlaneMesh = emptyMesh;
+	m_proceduralBoxMesh = emptyMesh;
+	m_proceduralCylinderMesh = emptyMesh;
+	m_proceduralTaperedCylinderMesh = emptyMesh;
+
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_modelMatrix = glm::mat4(1.0f);
+	m_viewportHeight = g_DefaultViewportHeight;
+	m_bMeshletCulling = true;
+	m_lodPixelError = g_DefaultLODPixelError;
+	m_lodSettings = GetDefaultLODSettings();
+	m_boundLayout = VERTEX_LAYOUT_COUNT;
+	m_proceduralVAO = 0;
+	m_bProceduralMeshes = false;
+}
+
+/***********************************************************
+ *  ~SceneMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneMeshes::~SceneMeshes()
+{
+	DestroyMesh(m_planeMesh);
+	DestroyMesh(m_boxMesh);
+	DestroyMesh(m_cylinderMesh);
+	DestroyMesh(m_taperedCylinderMesh);
+	DestroyMesh(m_torusMesh);
+	DestroyMesh(m_proceduralPlaneMesh);
+	DestroyMesh(m_proceduralBoxMesh);
+	DestroyMesh(m_proceduralCylinderMesh);
+	DestroyMesh(m_proceduralTaperedCylinderMesh);
+	for (std::map<std::string, GLMesh>::iterator it = m_importedMeshes.begin(); it != m_importedMeshes.end(); ++it)
+	{
+		DestroyMesh(it->second);
+	}
+	m_importedMeshes.clear();
+	for (int layout = 0; layout < VERTEX_LAYOUT_COUNT; layout++)
+	{
+		m_meshBuffers[layout].Destroy();
+	}
+	if (m_proceduralVAO != 0)
+	{
+		glDeleteVertexArrays(1, &m_proceduralVAO);
+		m_proceduralVAO = 0;
+	}
+	m_pShaderManager = NULL;
+}
+
+/***********************************************************
+ *  QueueMesh()
+ *
+ *  This method is used for adding a mesh to the list that is
+ *  loaded by LoadPendingMeshes().  The settings used to
+ *  process the mesh are added to its cache key.
+ ***********************************************************/
+void SceneMeshes::QueueMesh(
+	const MESH_CACHE_KEY& key,
+	const std::function<void(MESH_DATA& mesh)>& generator,
+	VERTEX_FORMAT format,
+	GLMesh& glMesh)
+{
+	PendingMesh pending(key);
+	pending.key.AddParameter((int)g_MeshletMinimumTriangles);
+	pending.key.AddParameter(m_lodSettings.maxLevels);
+	pending.key.AddParameter(m_lodSettings.reduction);
+	pending.key.AddParameter(m_lodSettings.maxError);
+	pending.key.AddParameter((int)m_lodSettings.minimumTriangles);
+	pending.generator = generator;
+	pending.format = format;
+	pending.pGLMesh = &glMesh;
+	pending.bFallback = false;
+	pending.bProcessed = false;
+
+	m_pendingMeshes.push_back(pending);
+}
+
+/***********************************************************
+ *  LoadPendingMeshes()
+ *
+ *  This method is used for loading every queued mesh.  The
+ *  meshes with a valid cache file are uploaded from it.  The
+ *  others are generated and processed in parallel, one mesh
+ *  per task, then uploaded and written to the cache for the
+ *  next run.  Only the upload uses OpenGL, so it stays on
+ *  this thread.
+ ***********************************************************/
+void SceneMeshes::LoadPendingMeshes()
+{
+	std::vector<PendingMesh*> misses;
+	MESH_CACHE_VIEW view;
+
+	// the shared buffers are created with the first meshes, and
+	// the shader in use is checked against their vertex layouts
+	if (m_meshBuffers[VERTEX_LAYOUT_FLOAT32].GetVAO() == 0)
+	{
+		GLint program = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+		ValidateVertexShaderInputs((GLuint)program);
+
+		for (int layout = 0; layout < VERTEX_LAYOUT_COUNT; layout++)
+		{
+			m_meshBuffers[layout].Create((VERTEX_LAYOUT)layout);
+		}
+	}
+
+	for (size_t i = 0; i < m_pendingMeshes.size(); i++)
+	{
+		PendingMesh& pending = m_pendingMeshes[i];
+		if (m_meshCache.Read(pending.key, view))
+		{
+			UploadMesh(view, *pending.pGLMesh);
+			m_meshCache.Close();
+			std::cout << "INFO: Mesh " << pending.key.name << " loaded from the mesh cache" << std::endl;
+		}
+		else
+		{
+			misses.push_back(&pending);
+		}
+	}
+
+	ThreadPool::GetSharedPool().ParallelFor(misses.size(), 1,
+		[&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				ProcessMesh(*misses[i]);
+			}
+		});
+
+	for (size_t i = 0; i < misses.size(); i++)
+	{
+		PendingMesh& pending = *misses[i];
+		const char* meshName = pending.key.name.c_str();
+
+		if (pending.report.vertexBytes > 0)
+		{
+			PrintQuantizationReport(meshName, pending.format, pending.report);
+		}
+		if (pending.bFallback)
+		{
+			std::cout << "INFO: Mesh " << meshName << " falls back to vertex format "
+				<< GetVertexFormatName(VERTEX_FORMAT_FLOAT32) << std::endl;
+		}
+		if (pending.bProcessed == false)
+		{
+			std::cout << "ERROR: Mesh " << meshName << " could not be loaded" << std::endl;
+
+			// a failed import is removed so it is not drawn
+			for (std::map<std::string, GLMesh>::iterator it = m_importedMeshes.begin(); it != m_importedMeshes.end(); ++it)
+			{
+				if (&it->second == pending.pGLMesh)
+				{
+					DestroyMesh(it->second);
+					m_importedMeshes.erase(it);
+					break;
+				}
+			}
+			continue;
+		}
+
+		const PROCESSED_MESH& processed = pending.processed;
+		if (processed.meshlets.size() > 0)
+		{
+			std::cout << "INFO: Mesh " << meshName << " split into " << processed.meshlets.size() << " meshlets" << std::endl;
+		}
+		for (size_t lod = 1; lod < processed.lods.size(); lod++)
+		{
+			std::cout << "INFO: Mesh " << meshName << " LOD " << lod << " has "
+				<< processed.lods[lod].indexCount / 3 << " triangles, error " << processed.lods[lod].error << std::endl;
+		}
+
+		GetMeshCacheView(processed, view);
+		UploadMesh(view, *pending.pGLMesh);
+		m_meshCache.Write(pending.key, processed);
+	}
+
+	m_pendingMeshes.clear();
+
+	// growing a shared buffer unbinds its vertex array object
+	glBindVertexArray(0);
+	m_boundLayout = VERTEX_LAYOUT_COUNT;
+}
+
+/***********************************************************
+ *  ProcessMesh()
+ *
+ *  This method is used for generating a queued mesh and
+ *  encoding its vertices into the requested vertex format.
+ *  If the mesh cannot be stored in that format, the full
+ *  precision format is used instead.  Large meshes are split
+ *  into meshlets, which reorders their indices, and then get
+ *  their lower levels of detail.  Nothing is printed here,
+ *  because several meshes are processed at the same time.
+ ***********************************************************/
+void SceneMeshes::ProcessMesh(PendingMesh& pending)
+{
+	MESH_DATA mesh;
+	PROCESSED_MESH& processed = pending.processed;
+	QUANTIZATION_REPORT fallbackReport;
+
+	pending.report.vertexBytes = 0;
+	pending.generator(mesh);
+	if (mesh.indices.size() == 0)
+	{
+		return;
+	}
+
+	bool bEncoded = EncodeVertices(mesh, pending.format, processed.vertices, pending.report);
+	if ((bEncoded == false) && (pending.format != VERTEX_FORMAT_FLOAT32))
+	{
+		pending.bFallback = true;
+		bEncoded = EncodeVertices(mesh, VERTEX_FORMAT_FLOAT32, processed.vertices, fallbackReport);
+	}
+	if (bEncoded == false)
+	{
+		return;
+	}
+
+	processed.meshlets.clear();
+	if (mesh.indices.size() / 3 >= g_MeshletMinimumTriangles)
+	{
+		BuildMeshlets(mesh, processed.meshlets);
+	}
+
+	BuildLODChain(mesh, m_lodSettings, processed.lods);
+	processed.bounds = CalculateMeshBounds(mesh);
+	processed.indices.swap(mesh.indices);
+
+	pending.bProcessed = true;
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for copying the vertex and index
+ *  buffers of a processed mesh into new GPU buffers.  The
+ *  buffers may be inside a mapped cache file, so they are
+ *  passed to the GPU without another copy.
+ ***********************************************************/
+void SceneMeshes::UploadMesh(const MESH_CACHE_VIEW& view, GLMesh& glMesh)
+{
+	DestroyMesh(glMesh);
+
+	glMesh.format = view.format;
+	glMesh.positionOffset = view.positionOffset;
+	glMesh.positionScale = view.positionScale;
+	glMesh.bounds = view.bounds;
+	// the lower levels of detail follow the full mesh indices
+	glMesh.nIndices = (GLsizei)((view.lodCount > 0) ? view.lods[0].indexCount : view.indexCount);
+	glMesh.lods.assign(view.lods, view.lods + view.lodCount);
+	glMesh.meshlets.assign(view.meshlets, view.meshlets + view.meshletCount);
+
+	MeshBuffer& meshBuffer = m_meshBuffers[GetVertexLayout(view.format)];
+	bool bAdded = meshBuffer.Add(
+		view.vertexData,
+		view.vertexBytes / view.stride,
+		view.indices,
+		view.indexCount,
+		glMesh.range);
+	if (bAdded == false)
+	{
+		std::cout << "ERROR: Could not add a mesh to the shared mesh buffers" << std::endl;
+		DestroyMesh(glMesh);
+	}
+}
+
+/***********************************************************
+ *  DestroyMesh()
+ *
+ *  This method is used for releasing the space that a mesh
+ *  uses in the shared GPU buffers.
+ ***********************************************************/
+void SceneMeshes::DestroyMesh(GLMesh& glMesh)
+{
+	m_meshBuffers[GetVertexLayout(glMesh.format)].Remove(glMesh.range);
+	glMesh.nIndices = 0;
+	glMesh.proceduralShape = PROCEDURAL_SHAPE_NONE;
+	glMesh.lods.clear();
+	glMesh.meshlets.clear();
+}
+
+/***********************************************************
+ *  SetViewParameters()
+ *
+ *  This method is used for setting the view and projection
+ *  matrices that the meshlets are culled against, and the
+ *  viewport height in pixels used to measure the screen
+ *  error of the levels of detail.
+ ***********************************************************/
+void SceneMeshes::SetViewParameters(const glm::mat4& view, const glm::mat4& projection, int viewportHeight)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewportHeight = viewportHeight;
+}
+
+/***********************************************************
+ *  SetModelMatrix()
+ *
+ *  This method is used for setting the model matrix of the
+ *  next mesh that is drawn.
+ ***********************************************************/
+void SceneMeshes::SetModelMatrix(const glm::mat4& model)
+{
+	m_modelMatrix = model;
+}
+
+/***********************************************************
+ *  SetMeshletCulling()
+ *
+ *  This method is used for turning the culling of meshlets
+ *  on or off.
+ ***********************************************************/
+void SceneMeshes::SetMeshletCulling(bool bEnabled)
+{
+	m_bMeshletCulling = bEnabled;
+}
+
+/***********************************************************
+ *  SetLODPixelError()
+ *
+ *  This method is used for setting how many pixels a level
+ *  of detail may move the surface of a mesh on the screen.
+ ***********************************************************/
+void SceneMeshes::SetLODPixelError(float pixels)
+{
+	m_lodPixelError = pixels;
+}
+
+/***********************************************************
+ *  SelectMeshLOD()
+ *
+ *  This method is used for finding how many pixels one
+ *  object space unit covers at the front of the bounding
+ *  sphere of a mesh, and choosing the coarsest level of
+ *  detail whose error fits in the allowed pixel error.
+ ***********************************************************/
+size_t SceneMeshes::SelectMeshLOD(const GLMesh& glMesh) const
+{
+	if ((glMesh.lods.size() <= 1) || (m_lodPixelError <= 0.0f))
+	{
+		return(0);
+	}
+
+	// the largest scale of the model matrix
+	float scale = glm::max(
+		glm::length(glm::vec3(m_modelMatrix[0])),
+		glm::max(glm::length(glm::vec3(m_modelMatrix[1])), glm::length(glm::vec3(m_modelMatrix[2]))));
+
+	// pixels covered by one view space unit at a distance of one
+	float pixelsPerUnit = m_projectionMatrix[1][1] * (float)m_viewportHeight * 0.5f * scale;
+
+	// a perspective projection shrinks the error with distance
+	if (m_projectionMatrix[2][3] != 0.0f)
+	{
+		glm::vec4 center = m_viewMatrix * m_modelMatrix * glm::vec4(glMesh.bounds.center, 1.0f);
+		float distance = -center.z - glMesh.bounds.radius * scale;
+		if (distance <= 0.0f)
+		{
+			return(0);
+		}
+		pixelsPerUnit /= distance;
+	}
+
+	return(SelectLOD(glMesh.lods, pixelsPerUnit, m_lodPixelError));
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for passing the vertex decoding
+ *  values into the shader and drawing a range of triangles.
+ *  When the whole of a mesh is drawn, a lower level of detail
+ *  is used if it is small enough on the screen.  When the
+ *  full detail level of a split mesh is drawn, only its
+ *  visible meshlets are sent to the GPU.  The vertex array
+ *  object stays bound after the draw, and is only changed
+ *  when the next mesh uses another vertex layout.
+ ***********************************************************/
+void SceneMeshes::DrawMesh(const GLMesh& glMesh, GLsizei firstIndex, GLsizei indexCount)
+{
+	if (glMesh.proceduralShape != PROCEDURAL_SHAPE_NONE)
+	{
+		DrawProceduralMesh(glMesh, firstIndex, indexCount);
+		return;
+	}
+	if (glMesh.range.indexCount == 0)
+	{
+		return;
+	}
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setIntValue(g_ProceduralShapeName, PROCEDURAL_SHAPE_NONE);
+		m_pShaderManager->setIntValue(g_VertexFormatName, (int)glMesh.format);
+		m_pShaderManager->setVec3Value(g_PositionOffsetName, glMesh.positionOffset);
+		m_pShaderManager->setVec3Value(g_PositionScaleName, glMesh.positionScale);
+	}
+
+	bool bWholeMesh = (firstIndex == 0) && (indexCount == glMesh.nIndices);
+	size_t lod = bWholeMesh ? SelectMeshLOD(glMesh) : 0;
+
+	VERTEX_LAYOUT layout = GetVertexLayout(glMesh.format);
+	if (layout != m_boundLayout)
+	{
+		m_meshBuffers[layout].Bind();
+		m_boundLayout = layout;
+	}
+
+	const MESH_BUFFER_RANGE& range = glMesh.range;
+	if (lod > 0)
+	{
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			(GLsizei)glMesh.lods[lod].indexCount,
+			GL_UNSIGNED_INT,
+			(void*)((range.firstIndex + glMesh.lods[lod].firstIndex) * sizeof(GLuint)),
+			range.baseVertex);
+	}
+	else if (m_bMeshletCulling && (glMesh.meshlets.size() > 0) && bWholeMesh)
+	{
+		CullMeshlets(
+			glMesh.meshlets,
+			m_modelMatrix,
+			m_viewMatrix,
+			m_projectionMatrix,
+			m_drawList,
+			range.firstIndex,
+			range.baseVertex);
+		if (m_drawList.counts.size() > 0)
+		{
+			glMultiDrawElementsBaseVertex(
+				GL_TRIANGLES,
+				m_drawList.counts.data(),
+				GL_UNSIGNED_INT,
+				m_drawList.offsets.data(),
+				(GLsizei)m_drawList.counts.size(),
+				m_drawList.baseVertices.data());
+		}
+	}
+	else
+	{
+		glDrawElementsBaseVertex(
+			GL_TRIANGLES,
+			indexCount,
+			GL_UNSIGNED_INT,
+			(void*)((range.firstIndex + firstIndex) * sizeof(GLuint)),
+			range.baseVertex);
+	}
+}
+
+/***********************************************************
+ *  SetProceduralMeshes()
+ *
+ *  This method is used for choosing whether the plane, box
+ *  and cylinders are drawn procedural.  A procedural shape
+ *  is not generated, cached or uploaded, and only has a
+ *  vertex count, so it is set up next to the stored mesh
+ *  and either one can be drawn from the next draw on.
+ ***********************************************************/
+void SceneMeshes::SetProceduralMeshes(bool bEnabled)
+{
+	m_bProceduralMeshes = bEnabled;
+}
+
+/***********************************************************
+ *  SetProceduralSegments()
+ *
+ *  This method is used for changing the number of segments
+ *  around the procedural cylinders.  Only their vertex count
+ *  changes, so this can be called before any draw.
+ ***********************************************************/
+void SceneMeshes::SetProceduralSegments(int segments)
+{
+	GLMesh* cylinders[] = { &m_proceduralCylinderMesh, &m_proceduralTaperedCylinderMesh };
+	for (int i = 0; i < 2; i++)
+	{
+		if (cylinders[i]->proceduralShape == PROCEDURAL_SHAPE_CYLINDER)
+		{
+			SetupProceduralMesh(*cylinders[i], PROCEDURAL_SHAPE_CYLINDER, segments, cylinders[i]->proceduralRadii.y);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetupProceduralMesh()
+ *
+ *  This method is used for turning a mesh into a shape built
+ *  by the vertex shader.  The vertices are not indexed, so
+ *  the index count of the mesh is its vertex count and the
+ *  sides of the box keep the same ranges.
+ ***********************************************************/
+void SceneMeshes::SetupProceduralMesh(GLMesh& glMesh, PROCEDURAL_SHAPE shape, int segments, float topRadius)
+{
+	DestroyMesh(glMesh);
+
+	segments = std::max(segments, 3);
+	glMesh.proceduralShape = shape;
+	glMesh.proceduralSegments = segments;
+	glMesh.proceduralRadii = glm::vec2(1.0f, topRadius);
+
+	switch (shape)
+	{
+	case PROCEDURAL_SHAPE_PLANE:
+		glMesh.nIndices = 6;
+		break;
+	case PROCEDURAL_SHAPE_BOX:
+		glMesh.nIndices = 6 * g_BoxSideIndices;
+		break;
+	case PROCEDURAL_SHAPE_CYLINDER:
+		// a quad on the side and a triangle on each cap per segment
+		glMesh.nIndices = 12 * segments;
+		break;
+	default:
+		glMesh.nIndices = 0;
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawProceduralMesh()
+ *
+ *  This method is used for drawing a range of the vertices
+ *  of a procedural shape.  Nothing is read from a buffer, so
+ *  a vertex array object without attributes is bound.
+ ***********************************************************/
+void SceneMeshes::DrawProceduralMesh(const GLMesh& glMesh, GLint firstVertex, GLsizei vertexCount)
+{
+	if (vertexCount <= 0)
+	{
+		return;
+	}
+
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setIntValue(g_ProceduralShapeName, (int)glMesh.proceduralShape);
+		m_pShaderManager->setIntValue(g_ProceduralSegmentsName, glMesh.proceduralSegments);
+		m_pShaderManager->setVec2Value(g_ProceduralRadiiName, glMesh.proceduralRadii);
+	}
+
+	if (m_proceduralVAO == 0)
+	{
+		glGenVertexArrays(1, &m_proceduralVAO);
+	}
+	glBindVertexArray(m_proceduralVAO);
+	// the next mesh has to bind its vertex array object again
+	m_boundLayout = VERTEX_LAYOUT_COUNT;
+
+	glDrawArrays(GL_TRIANGLES, firstVertex, vertexCount);
+}
+
+/***********************************************************
+ *  GetShapeMesh()
+ *
+ *  This method is used for choosing which version of a
+ *  shape is drawn.  A shape that was not loaded procedural
+ *  is always drawn from its stored mesh.
+ ***********************************************************/
+const SceneMeshes::GLMesh& SceneMeshes::GetShapeMesh(const GLMesh& storedMesh, const GLMesh& proceduralMesh) const
+{
+	if (m_bProceduralMeshes && (proceduralMesh.proceduralShape != PROCEDURAL_SHAPE_NONE))
+	{
+		return(proceduralMesh);
+	}
+	return(storedMesh);
+}
+
+/***********************************************************
+ *  LoadPlaneMesh()
+ *
+ *  This method is used for queueing the plane mesh, and
+ *  setting up its procedural version.
+ ***********************************************************/
+void SceneMeshes::LoadPlaneMesh(VERTEX_FORMAT format)
+{
+	SetupProceduralMesh(m_proceduralPlaneMesh, PROCEDURAL_SHAPE_PLANE, 0, 1.0f);
+
+	MESH_CACHE_KEY key("plane");
+	key.AddParameter((int)format);
+	QueueMesh(key, [](MESH_DATA& mesh) { GeneratePlaneMesh(mesh); }, format, m_planeMesh);
+}
+
+/***********************************************************
+ *  LoadBoxMesh()
+ *
+ *  This method is used for queueing the box mesh, and
+ *  setting up its procedural version.
+ ***********************************************************/
+void SceneMeshes::LoadBoxMesh(VERTEX_FORMAT format)
+{
+	SetupProceduralMesh(m_proceduralBoxMesh, PROCEDURAL_SHAPE_BOX, 0, 1.0f);
+
+	MESH_CACHE_KEY key("box");
+	key.AddParameter((int)format);
+	QueueMesh(key, [](MESH_DATA& mesh) { GenerateBoxMesh(mesh); }, format, m_boxMesh);
+}
+
+/***********************************************************
+ *  LoadCylinderMesh()
+ *
+ *  This method is used for queueing the cylinder mesh with
+ *  the passed in number of segments around it, and setting
+ *  up its procedural version.
+ ***********************************************************/
+void SceneMeshes::LoadCylinderMesh(VERTEX_FORMAT format, int segments)
+{
+	SetupProceduralMesh(m_proceduralCylinderMesh, PROCEDURAL_SHAPE_CYLINDER, segments, 1.0f);
+
+	MESH_CACHE_KEY key("cylinder");
+	key.AddParameter((int)format);
+	key.AddParameter(segments);
+	QueueMesh(key, [segments](MESH_DATA& mesh) { GenerateCylinderMesh(mesh, segments); }, format, m_cylinderMesh);
+}
+
+/***********************************************************
+ *  LoadTaperedCylinderMesh()
+ *
+ *  This method is used for queueing the tapered cylinder
+ *  mesh, and setting up its procedural version.
+ ***********************************************************/
+void SceneMeshes::LoadTaperedCylinderMesh(VERTEX_FORMAT format, int segments)
+{
+	SetupProceduralMesh(m_proceduralTaperedCylinderMesh, PROCEDURAL_SHAPE_CYLINDER, segments, 0.5f);
+
+	MESH_CACHE_KEY key("taperedCylinder");
+	key.AddParameter((int)format);
+	key.AddParameter(segments);
+	QueueMesh(key, [segments](MESH_DATA& mesh) { GenerateTaperedCylinderMesh(mesh, segments); }, format, m_taperedCylinderMesh);
+}
+
+/***********************************************************
+ *  LoadTorusMesh()
+ *
+ *  This method is used for queueing the torus mesh with the
+ *  passed in number of segments around the torus and tube.
+ ***********************************************************/
+void SceneMeshes::LoadTorusMesh(VERTEX_FORMAT format, int mainSegments, int tubeSegments)
+{
+	const float thickness = TORUS_THICKNESS;
+
+	MESH_CACHE_KEY key("torus");
+	key.AddParameter((int)format);
+	key.AddParameter(thickness);
+	key.AddParameter(mainSegments);
+	key.AddParameter(tubeSegments);
+	QueueMesh(
+		key,
+		[thickness, mainSegments, tubeSegments](MESH_DATA& mesh) { GenerateTorusMesh(mesh, thickness, mainSegments, tubeSegments); },
+		format,
+		m_torusMesh);
+}
+
+/***********************************************************
+ *  LoadImportedMesh()
+ *
+ *  This method is used for queueing a mesh to be imported
+ *  from an OBJ or GLB file.  The mesh is reordered for the
+ *  vertex cache and for sequential vertex reads before it is
+ *  processed.  The cache key holds the size and write time
+ *  of the file, so the cached copy is rebuilt when the file
+ *  changes.
+ ***********************************************************/
+bool SceneMeshes::LoadImportedMesh(const char* tag, const char* filename, VERTEX_FORMAT format)
+{
+	uint64_t fileSize = 0;
+	uint64_t writeTime = 0;
+	if (GetMeshFileStamp(filename, fileSize, writeTime) == false)
+	{
+		std::cout << "ERROR: Could not find mesh file " << filename << std::endl;
+		return(false);
+	}
+
+	MESH_CACHE_KEY key(tag);
+	key.AddParameter((int)format);
+	key.AddParameter(filename);
+	key.AddParameter(fileSize);
+	key.AddParameter(writeTime);
+	key.AddParameter((int)MESH_OPTIMIZER_CACHE_SIZE);
+
+	GLMesh& glMesh = m_importedMeshes[tag];
+	if (glMesh.range.indexCount == 0)
+	{
+		glMesh.format = VERTEX_FORMAT_FLOAT32;
+		glMesh.positionScale = glm::vec3(1.0f);
+	}
+
+	// the file name is copied, it is used after this call returns
+	std::string path = filename;
+	QueueMesh(
+		key,
+		[path](MESH_DATA& mesh)
+		{
+			if (ImportMesh(path.c_str(), mesh))
+			{
+				OptimizeVertexCache(mesh);
+				OptimizeVertexFetch(mesh);
+			}
+		},
+		format,
+		glMesh);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DrawPlaneMesh()
+ *
+ *  This method is used for drawing the plane mesh.
+ ***********************************************************/
+void SceneMeshes::DrawPlaneMesh()
+{
+	const GLMesh& planeMesh = GetShapeMesh(m_planeMesh, m_proceduralPlaneMesh);
+	DrawMesh(planeMesh, 0, planeMesh.nIndices);
+}
+
+/***********************************************************
+ *  DrawBoxMesh()
+ *
+ *  This method is used for drawing all sides of the box mesh.
+ ***********************************************************/
+void SceneMeshes::DrawBoxMesh()
+{
+	const GLMesh& boxMesh = GetShapeMesh(m_boxMesh, m_proceduralBoxMesh);
+	DrawMesh(boxMesh, 0, boxMesh.nIndices);
+}
+
+/***********************************************************
+ *  DrawBoxSideMesh()
+ *
+ *  This method is used for drawing a single side of the box
+ *  mesh, so that it can use a different texture.
+ ***********************************************************/
+void SceneMeshes::DrawBoxSideMesh(BoxSide side)
+{
+	DrawMesh(GetShapeMesh(m_boxMesh, m_proceduralBoxMesh), (GLsizei)side * g_BoxSideIndices, g_BoxSideIndices);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing the cylinder mesh.
+ ***********************************************************/
+void SceneMeshes::DrawCylinderMesh()
+{
+	const GLMesh& cylinderMesh = GetShapeMesh(m_cylinderMesh, m_proceduralCylinderMesh);
+	DrawMesh(cylinderMesh, 0, cylinderMesh.nIndices);
+}
+
+/***********************************************************
+ *  DrawTaperedCylinderMesh()
+ *
+ *  This method is used for drawing the tapered cylinder mesh.
+ ***********************************************************/
+void SceneMeshes::DrawTaperedCylinderMesh()
+{
+	const GLMesh& taperedCylinderMesh = GetShapeMesh(m_taperedCylinderMesh, m_proceduralTaperedCylinderMesh);
+	DrawMesh(taperedCylinderMesh, 0, taperedCylinderMesh.nIndices);
+}
+
+/***********************************************************
+ *  DrawTorusMesh()
+ *
+ *  This method is used for drawing the torus mesh.
+ ***********************************************************/
+void SceneMeshes::DrawTorusMesh()
+{
+	DrawMesh(m_torusMesh, 0, m_torusMesh.nIndices);
+}
+
+/***********************************************************
+ *  DrawImportedMesh()
+ *
+ *  This method is used for drawing the imported mesh that
+ *  was loaded with the passed in tag.
+ ***********************************************************/
+void SceneMeshes::DrawImportedMesh(const char* tag)
+{
+	std::map<std::string, GLMesh>::const_iterator it = m_importedMeshes.find(tag);
+	if (it != m_importedMeshes.end())
+	{
+		DrawMesh(it->second, 0, it->second.nIndices);
+	}
+}
+
+/***********************************************************
+ *  GetImportedMeshBounds()
+ *
+ *  This method is used for getting the bounds of an imported
+ *  mesh, which are only known once it has been loaded.
+ ***********************************************************/
+bool SceneMeshes::GetImportedMeshBounds(const char* tag, MESH_BOUNDS& bounds) const
+{
+	std::map<std::string, GLMesh>::const_iterator it = m_importedMeshes.find(tag);
+	if ((it == m_importedMeshes.end()) || (it->second.nIndices == 0))
+	{
+		return(false);
+	}
+
+	bounds = it->second.bounds;
+	return(true);
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.h
+// ============
+// manage the GPU meshes of the basic 3D shapes drawn in the scene
+//
+//	Replaces ShapeMeshes for this scene so that every mesh can be stored
+//	in its own vertex format.  The compact formats are decoded by the
+//	vertex shader in the Shaders folder.
+//
+//	Large meshes are split into meshlets when they are loaded, and the
+//	meshlets outside the view or facing away are skipped when drawn.
+//
+//	Processed meshes are stored in the MeshCache folder and uploaded
+//	from there on later runs, instead of being generated again.
+//
+//	Meshes imported from OBJ and GLB files are optimized for the vertex
+//	cache and drawn by the tag they were loaded with.
+//
+//	The Load functions only queue a mesh.  LoadPendingMeshes generates
+//	and simplifies all of the queued meshes in parallel, then uploads
+//	them.  Each draw of a whole mesh picks the coarsest level of detail
+//	whose error stays under the allowed number of pixels.
+//
+//	All meshes read with the same vertex layout share one vertex array
+//	object and one pair of buffers, so drawing a different mesh only
+//	changes the base vertex and first index of the draw call.
+//
+//	The plane, box and cylinders can also be drawn procedural.  They then
+//	read no vertex or index data at all, the vertex shader builds each
+//	vertex from gl_VertexID, so their tessellation can change without any
+//	work.  Both versions are loaded, so they can be switched at any time.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+#include "MeshData.h"
+#include "VertexFormats.h"
+#include "Meshlets.h"
+#include "MeshCache.h"
+#include "MeshSimplifier.h"
+#include "MeshBuffer.h"
+
+#include <functional>
+#include <map>
+#include <string>
+
+/***********************************************************
+ *  PROCEDURAL_SHAPE
+ *
+ *  The shapes the vertex shader can build from gl_VertexID,
+ *  with the same values as the constants in the shader.
+ ***********************************************************/
+enum PROCEDURAL_SHAPE
+{
+	PROCEDURAL_SHAPE_NONE = 0,
+	PROCEDURAL_SHAPE_PLANE,
+	PROCEDURAL_SHAPE_BOX,
+	PROCEDURAL_SHAPE_CYLINDER
+};
+
+/***********************************************************
+ *  SceneMeshes
+ *
+ *  This class generates, uploads and draws the basic shape
+ *  meshes used by the scene.
+ ***********************************************************/
+class SceneMeshes
+{
+public:
+	// constructor
+	SceneMeshes(ShaderManager* pShaderManager);
+	// destructor
+	~SceneMeshes();
+
+	enum BoxSide
+	{
+		back,
+		bottom,
+		left,
+		right,
+		top,
+		front
+	};
+
+	// queue the shape meshes to be loaded in the passed in vertex format
+	void LoadPlaneMesh(VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32);
+	void LoadBoxMesh(VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32);
+	void LoadCylinderMesh(VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32, int segments = 36);
+	void LoadTaperedCylinderMesh(VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32, int segments = 36);
+	void LoadTorusMesh(VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32, int mainSegments = 30, int tubeSegments = 30);
+	// queue a mesh to be imported from an OBJ or GLB file - the tag is
+	// used to draw it and to name its cache file, so it must be a valid
+	// file name.  Returns false when the file does not exist.
+	bool LoadImportedMesh(const char* tag, const char* filename, VERTEX_FORMAT format = VERTEX_FORMAT_FLOAT32);
+	// load, process and upload all of the queued meshes
+	void LoadPendingMeshes();
+
+	// draw the loaded shape meshes
+	void DrawPlaneMesh();
+	void DrawBoxMesh();
+	void DrawBoxSideMesh(BoxSide side);
+	void DrawCylinderMesh();
+	void DrawTaperedCylinderMesh();
+	void DrawTorusMesh();
+	void DrawImportedMesh(const char* tag);
+	// get the object space bounds of a loaded imported mesh, false
+	// when no mesh was loaded with the passed in tag
+	bool GetImportedMeshBounds(const char* tag, MESH_BOUNDS& bounds) const;
+
+	// set the view, projection and viewport height used to cull
+	// meshlets and select the levels of detail
+	void SetViewParameters(const glm::mat4& view, const glm::mat4& projection, int viewportHeight);
+	// set the model matrix of the next draw
+	void SetModelMatrix(const glm::mat4& model);
+	// turn the culling of meshlets on or off
+	void SetMeshletCulling(bool bEnabled);
+	// set the largest error in pixels allowed for a level of detail,
+	// zero always draws the full detail meshes
+	void SetLODPixelError(float pixels);
+	// forget the bound vertex array object, for when other code
+	// has bound its own between two draws
+	void InvalidateBindings() { m_boundLayout = VERTEX_LAYOUT_COUNT; }
+
+	// draw the plane, box and cylinders built in the vertex shader
+	// instead of from their stored vertices
+	void SetProceduralMeshes(bool bEnabled);
+	// change the number of segments around the procedural cylinders
+	void SetProceduralSegments(int segments);
+
+private:
+	struct GLMesh
+	{
+		// place of the mesh in the shared buffers of its vertex layout
+		MESH_BUFFER_RANGE range;
+		GLsizei nIndices;
+		VERTEX_FORMAT format;
+		glm::vec3 positionOffset;
+		glm::vec3 positionScale;
+		MESH_BOUNDS bounds;
+		// levels of detail, the first one is the full mesh
+		std::vector<MESH_LOD> lods;
+		// empty when the mesh is too small to be split
+		std::vector<MESHLET> meshlets;
+		// shape built by the vertex shader, with no vertex data
+		PROCEDURAL_SHAPE proceduralShape;
+		// bottom and top radius of a procedural cylinder
+		glm::vec2 proceduralRadii;
+		GLint proceduralSegments;
+	};
+
+	struct PendingMesh
+	{
+		MESH_CACHE_KEY key;
+		std::function<void(MESH_DATA& mesh)> generator;
+		VERTEX_FORMAT format;
+		GLMesh* pGLMesh;
+
+		// filled in when the mesh is not in the cache
+		PROCESSED_MESH processed;
+		QUANTIZATION_REPORT report;
+		bool bFallback;
+		bool bProcessed;
+
+		PendingMesh(const MESH_CACHE_KEY& meshKey) : key(meshKey) {}
+	};
+
+	// pointer to shader manager object
+	ShaderManager* m_pShaderManager;
+
+	GLMesh m_planeMesh;
+	GLMesh m_boxMesh;
+	GLMesh m_cylinderMesh;
+	GLMesh m_taperedCylinderMesh;
+	GLMesh m_torusMesh;
+	// the plane, box and cylinders built by the vertex shader
+	GLMesh m_proceduralPlaneMesh;
+	GLMesh m_proceduralBoxMesh;
+	GLMesh m_proceduralCylinderMesh;
+	GLMesh m_proceduralTaperedCylinderMesh;
+	// imported meshes by their tag
+	std::map<std::string, GLMesh> m_importedMeshes;
+
+	// matrices used to cull the meshlets of the next draw
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::mat4 m_modelMatrix;
+	int m_viewportHeight;
+	bool m_bMeshletCulling;
+	float m_lodPixelError;
+	// reused between draws to avoid allocations
+	MESHLET_DRAW_LIST m_drawList;
+
+	// shared buffers for every vertex layout, and the layout
+	// whose vertex array object is bound
+	MeshBuffer m_meshBuffers[VERTEX_LAYOUT_COUNT];
+	VERTEX_LAYOUT m_boundLayout;
+	// vertex array object without attributes for the procedural
+	// shapes, and whether they are drawn instead of the stored ones
+	GLuint m_proceduralVAO;
+	bool m_bProceduralMeshes;
+
+	// processed meshes stored on disk
+	MeshCache m_meshCache;
+	LOD_SETTINGS m_lodSettings;
+	// meshes waiting for LoadPendingMeshes()
+	std::vector<PendingMesh> m_pendingMeshes;
+
+	// queue a mesh to be loaded from the cache, or generated,
+	// processed and cached
+	void QueueMesh(
+		const MESH_CACHE_KEY& key,
+		const std::function<void(MESH_DATA& mesh)>& generator,
+		VERTEX_FORMAT format,
+		GLMesh& glMesh);
+	// generate, encode and simplify a queued mesh
+	void ProcessMesh(PendingMesh& pending);
+	// copy the processed mesh buffers into the shared GPU buffers
+	void UploadMesh(const MESH_CACHE_VIEW& view, GLMesh& glMesh);
+	// release the space of a mesh in the shared GPU buffers
+	void DestroyMesh(GLMesh& glMesh);
+	// choose the level of detail of a mesh for the next draw
+	size_t SelectMeshLOD(const GLMesh& glMesh) const;
+	// draw a range of triangles from a mesh
+	void DrawMesh(const GLMesh& glMesh, GLsizei firstIndex, GLsizei indexCount);
+	// set up a mesh to be built by the vertex shader
+	void SetupProceduralMesh(GLMesh& glMesh, PROCEDURAL_SHAPE shape, int segments, float topRadius);
+	// draw a range of vertices of a procedural shape
+	void DrawProceduralMesh(const GLMesh& glMesh, GLint firstVertex, GLsizei vertexCount);
+	// get the procedural version of a shape when it is drawn, or
+	// else the stored one
+	const GLMesh& GetShapeMesh(const GLMesh& storedMesh, const GLMesh& proceduralMesh) const;
+};
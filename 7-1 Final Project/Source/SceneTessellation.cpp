@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenetessellation.cpp
+// ============
+// draw curved shapes with hardware tessellation
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneTessellation.h"
+#include "MeshGenerators.h"
+#include "ShaderProgram.h"
+
+#include <algorithm>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const char* g_VertexShaderFile = "./Shaders/tessellationVertexShader.glsl";
+	const char* g_ControlShaderFile = "./Shaders/tessellationControlShader.glsl";
+	const char* g_EvaluationShaderFile = "./Shaders/tessellationEvaluationShader.glsl";
+	// the tessellated shapes are lit by the scene fragment shader
+	const char* g_FragmentShaderFile = "./Shaders/fragmentShader.glsl";
+
+	const char* g_ShapeRadiiName = "shapeRadii";
+	const char* g_EdgePixelsName = "edgePixels";
+	const char* g_MaxLevelName = "maxTessellationLevel";
+
+	// corners of a patch
+	const GLint g_PatchVertices = 4;
+	// patches around the cylinders and the torus, and around the
+	// torus tube - each one spans a small enough arc to be measured
+	// by the distance between its corners
+	const int g_AroundPatches = 8;
+	const int g_TubePatches = 4;
+
+	/***********************************************************
+	 *  AddPatch()
+	 *
+	 *  Add the four corners of the patch that covers the passed
+	 *  in ranges of surface parameters.
+	 ***********************************************************/
+	void AddPatch(std::vector<GLfloat>& vertices, float u0, float u1, float v0, float v1, TESSELLATION_PART part)
+	{
+		const float corners[4][2] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+		for (int i = 0; i < 4; i++)
+		{
+			vertices.push_back(corners[i][0]);
+			vertices.push_back(corners[i][1]);
+			vertices.push_back((GLfloat)part);
+		}
+	}
+
+	/***********************************************************
+	 *  LoadTessellationProgram()
+	 *
+	 *  Compile and link the four stages of the tessellation
+	 *  program.  Zero is returned when any stage fails.
+	 ***********************************************************/
+	GLuint LoadTessellationProgram()
+	{
+		const GLenum types[] =
+		{
+			GL_VERTEX_SHADER,
+			GL_TESS_CONTROL_SHADER,
+			GL_TESS_EVALUATION_SHADER,
+			GL_FRAGMENT_SHADER
+		};
+		const char* filenames[] =
+		{
+			g_VertexShaderFile,
+			g_ControlShaderFile,
+			g_EvaluationShaderFile,
+			g_FragmentShaderFile
+		};
+
+		return(LinkShaderProgram(types, filenames, 4));
+	}
+}
+
+/***********************************************************
+ *  SceneTessellation()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneTessellation::SceneTessellation()
+{
+	m_pShaderManager = NULL;
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_firstCylinderVertex = 0;
+	m_cylinderVertexCount = 0;
+	m_firstTorusVertex = 0;
+	m_torusVertexCount = 0;
+}
+
+/***********************************************************
+ *  ~SceneTessellation()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneTessellation::~SceneTessellation()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the tessellation shader
+ *  program and creating the patches.  The cylinder patches
+ *  cover the side and both caps, the caps are wedges whose
+ *  first edge is the center.  The current program is not
+ *  changed.
+ ***********************************************************/
+bool SceneTessellation::Create()
+{
+	Destroy();
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	GLuint programID = LoadTessellationProgram();
+	if (programID == 0)
+	{
+		std::cout << "ERROR: The tessellated shapes are not available" << std::endl;
+		return(false);
+	}
+	m_pShaderManager = new ShaderManager();
+	m_pShaderManager->m_programID = programID;
+
+	std::vector<GLfloat> vertices;
+	for (int i = 0; i < g_AroundPatches; i++)
+	{
+		float u0 = (float)i / (float)g_AroundPatches;
+		float u1 = (float)(i + 1) / (float)g_AroundPatches;
+		AddPatch(vertices, u0, u1, 0.0f, 1.0f, TESSELLATION_PART_SIDE);
+		AddPatch(vertices, u0, u1, 0.0f, 1.0f, TESSELLATION_PART_TOP);
+		AddPatch(vertices, u0, u1, 0.0f, 1.0f, TESSELLATION_PART_BOTTOM);
+	}
+	m_firstCylinderVertex = 0;
+	m_cylinderVertexCount = (GLsizei)(vertices.size() / 3);
+
+	for (int i = 0; i < g_AroundPatches; i++)
+	{
+		for (int j = 0; j < g_TubePatches; j++)
+		{
+			AddPatch(
+				vertices,
+				(float)i / (float)g_AroundPatches,
+				(float)(i + 1) / (float)g_AroundPatches,
+				(float)j / (float)g_TubePatches,
+				(float)(j + 1) / (float)g_TubePatches,
+				TESSELLATION_PART_TORUS);
+		}
+	}
+	m_firstTorusVertex = m_cylinderVertexCount;
+	m_torusVertexCount = (GLsizei)(vertices.size() / 3) - m_cylinderVertexCount;
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the levels are clamped to what the driver can generate
+	GLint maxLevel = 64;
+	glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &maxLevel);
+	m_pShaderManager->use();
+	m_pShaderManager->setFloatValue(g_MaxLevelName, (float)maxLevel);
+	m_pShaderManager->setSampler2DValue("objectTexture", 0);
+	glUseProgram((GLuint)currentProgram);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program and
+ *  the patches.
+ ***********************************************************/
+void SceneTessellation::Destroy()
+{
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+	}
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_firstCylinderVertex = 0;
+	m_cylinderVertexCount = 0;
+	m_firstTorusVertex = 0;
+	m_torusVertexCount = 0;
+
+	if (NULL != m_pShaderManager)
+	{
+		if (m_pShaderManager->m_programID != 0)
+		{
+			glDeleteProgram(m_pShaderManager->m_programID);
+		}
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Use()
+ *
+ *  This method is used for making the tessellation program
+ *  the current program, so that its values can be set.
+ ***********************************************************/
+void SceneTessellation::Use()
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->use();
+	}
+}
+
+/***********************************************************
+ *  SetEdgePixels()
+ *
+ *  This method is used for setting how long a tessellated
+ *  edge segment may be on the screen.  Smaller values give
+ *  smoother shapes.  The tessellation program must be the
+ *  current program.
+ ***********************************************************/
+void SceneTessellation::SetEdgePixels(float pixels)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_pShaderManager->setFloatValue(g_EdgePixelsName, std::max(pixels, 1.0f));
+	}
+}
+
+/***********************************************************
+ *  DrawCylinder()
+ *
+ *  This method is used for drawing a cylinder with a radius
+ *  of one, standing on the XZ plane with a height of one.
+ ***********************************************************/
+void SceneTessellation::DrawCylinder()
+{
+	DrawPatches(glm::vec2(1.0f, 1.0f), m_firstCylinderVertex, m_cylinderVertexCount);
+}
+
+/***********************************************************
+ *  DrawTaperedCylinder()
+ *
+ *  This method is used for drawing a cylinder whose radius
+ *  goes from one at the bottom to one half at the top.
+ ***********************************************************/
+void SceneTessellation::DrawTaperedCylinder()
+{
+	DrawPatches(glm::vec2(1.0f, 0.5f), m_firstCylinderVertex, m_cylinderVertexCount);
+}
+
+/***********************************************************
+ *  DrawTorus()
+ *
+ *  This method is used for drawing a torus with a main
+ *  radius of one around the Z axis, with the same tube
+ *  thickness as the torus mesh.
+ ***********************************************************/
+void SceneTessellation::DrawTorus()
+{
+	DrawPatches(glm::vec2(1.0f, TORUS_THICKNESS), m_firstTorusVertex, m_torusVertexCount);
+}
+
+/***********************************************************
+ *  DrawPatches()
+ *
+ *  This method is used for drawing a range of patches with
+ *  the tessellation program, which must be current.
+ ***********************************************************/
+void SceneTessellation::DrawPatches(glm::vec2 radii, GLint firstVertex, GLsizei vertexCount)
+{
+	if ((NULL == m_pShaderManager) || (m_vao == 0))
+	{
+		return;
+	}
+
+	m_pShaderManager->setVec2Value(g_ShapeRadiiName, radii);
+
+	glPatchParameteri(GL_PATCH_VERTICES, g_PatchVertices);
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_PATCHES, firstVertex, vertexCount);
+	glBindVertexArray(0);
+}
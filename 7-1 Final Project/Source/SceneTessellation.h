@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenetessellation.h
+// ============
+// draw curved shapes with hardware tessellation
+//
+//	Every curved shape is a few coarse patches over its surface
+//	parameters.  The control shader splits each patch edge by its length
+//	on the screen, and the evaluation shader places every new vertex on
+//	the exact surface.  Near shapes stay smooth and far shapes are cheap,
+//	without storing a level of detail chain for them.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  TESSELLATION_PART
+ *
+ *  The surfaces a patch can lie on, with the same values as
+ *  the constants in the tessellation shaders.
+ ***********************************************************/
+enum TESSELLATION_PART
+{
+	TESSELLATION_PART_SIDE = 0,
+	TESSELLATION_PART_TOP,
+	TESSELLATION_PART_BOTTOM,
+	TESSELLATION_PART_TORUS
+};
+
+/***********************************************************
+ *  SceneTessellation
+ *
+ *  This class holds the tessellation shader program and the
+ *  patches of the cylinders and the torus.  The program uses
+ *  the scene fragment shader, so the object, material and
+ *  light values are set on the program returned by
+ *  GetShaderManager() with the same names as the scene shader.
+ ***********************************************************/
+class SceneTessellation
+{
+public:
+	// constructor
+	SceneTessellation();
+	// destructor
+	~SceneTessellation();
+
+	// load the tessellation shaders and create the patches
+	bool Create();
+	// free the shader program and the patches
+	void Destroy();
+
+	// make the tessellation program the current program
+	void Use();
+	ShaderManager* GetShaderManager() { return(m_pShaderManager); }
+
+	// set the length in pixels of one tessellated edge segment
+	void SetEdgePixels(float pixels);
+
+	// the shapes have the same size and placement as the meshes
+	// of SceneMeshes, so the same transformations can be used
+	void DrawCylinder();
+	void DrawTaperedCylinder();
+	void DrawTorus();
+
+private:
+	ShaderManager* m_pShaderManager;
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	// ranges of the patch vertices of each shape
+	GLint m_firstCylinderVertex;
+	GLsizei m_cylinderVertexCount;
+	GLint m_firstTorusVertex;
+	GLsizei m_torusVertexCount;
+
+	// draw a range of patches with the current program
+	void DrawPatches(glm::vec2 radii, GLint firstVertex, GLsizei vertexCount);
+
+	// the shader program cannot be shared between two objects
+	SceneTessellation(const SceneTessellation&);
+	SceneTessellation& operator=(const SceneTessellation&);
+};
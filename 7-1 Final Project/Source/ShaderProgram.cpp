@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.cpp
+// ============
+// compile and link the shader programs of the scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderProgram.h"
+#include "VertexLayout.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// start of a line that is replaced by the named file
+	const char* g_IncludeDirective = "#include \"";
+	// an included file can include others, up to this depth
+	const int g_MaximumIncludeDepth = 4;
+
+	/***********************************************************
+	 *  GENERATED_SOURCE
+	 *
+	 *  An include that is written by the program instead of
+	 *  read from the Shaders folder.
+	 ***********************************************************/
+	struct GENERATED_SOURCE
+	{
+		const char* name;
+		std::string (*generate)();
+	};
+
+	// the vertex shader inputs are written from the vertex layouts,
+	// so the shader cannot declare inputs that they do not feed
+	const GENERATED_SOURCE g_GeneratedSources[] =
+	{
+		{ "vertexInputs.glsl", GetVertexShaderInputDeclarations }
+	};
+
+	/***********************************************************
+	 *  ReadShaderSource()
+	 *
+	 *  Read a GLSL file into the passed in string, replacing
+	 *  every #include "file" line with the named file from the
+	 *  same folder, or with the generated source of that name.
+	 ***********************************************************/
+	bool ReadShaderSource(const std::string& filename, std::string& source, int depth)
+	{
+		std::ifstream file(filename.c_str());
+		if (!file.is_open())
+		{
+			std::cout << "ERROR: Could not open shader file " << filename << std::endl;
+			return(false);
+		}
+
+		std::string folder;
+		size_t slash = filename.find_last_of("/\\");
+		if (slash != std::string::npos)
+		{
+			folder = filename.substr(0, slash + 1);
+		}
+
+		const size_t directiveLength = std::string(g_IncludeDirective).size();
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t nameEnd = line.find('"', directiveLength);
+			if ((line.compare(0, directiveLength, g_IncludeDirective) != 0) || (nameEnd == std::string::npos))
+			{
+				source += line;
+				source += '\n';
+				continue;
+			}
+
+			if (depth >= g_MaximumIncludeDepth)
+			{
+				std::cout << "ERROR: Shader includes are nested too deep in " << filename << std::endl;
+				return(false);
+			}
+			std::string includeName = line.substr(directiveLength, nameEnd - directiveLength);
+			bool bGenerated = false;
+			for (size_t i = 0; i < sizeof(g_GeneratedSources) / sizeof(g_GeneratedSources[0]); i++)
+			{
+				if (includeName == g_GeneratedSources[i].name)
+				{
+					source += g_GeneratedSources[i].generate();
+					bGenerated = true;
+				}
+			}
+			if ((bGenerated == false) && (ReadShaderSource(folder + includeName, source, depth + 1) == false))
+			{
+				return(false);
+			}
+		}
+
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  CompileShaderFile()
+ *
+ *  This function is used for reading a GLSL file with its
+ *  includes and compiling it.
+ ***********************************************************/
+GLuint CompileShaderFile(GLenum type, const char* filename)
+{
+	std::string source;
+	if (ReadShaderSource(filename, source, 0) == false)
+	{
+		return(0);
+	}
+	const char* sourceText = source.c_str();
+
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &sourceText, NULL);
+	glCompileShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE)
+	{
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cout << "ERROR: Could not compile shader " << filename << "\n" << log << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  LinkShaderProgram()
+ *
+ *  This function is used for compiling the stages of a
+ *  program and linking them.  The compiled stages are freed
+ *  once the program is linked.
+ ***********************************************************/
+GLuint LinkShaderProgram(
+	const GLenum* types,
+	const char* const* filenames,
+	int stageCount)
+{
+	std::vector<GLuint> shaders(stageCount, 0);
+	bool bCompiled = true;
+	for (int i = 0; i < stageCount; i++)
+	{
+		shaders[i] = CompileShaderFile(types[i], filenames[i]);
+		bCompiled = bCompiled && (shaders[i] != 0);
+	}
+
+	GLuint program = 0;
+	if (bCompiled)
+	{
+		program = glCreateProgram();
+		for (int i = 0; i < stageCount; i++)
+		{
+			glAttachShader(program, shaders[i]);
+		}
+		glLinkProgram(program);
+
+		GLint status = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		if (status != GL_TRUE)
+		{
+			char log[1024];
+			glGetProgramInfoLog(program, sizeof(log), NULL, log);
+			std::cout << "ERROR: Could not link the shaders of " << filenames[0] << "\n" << log << std::endl;
+			glDeleteProgram(program);
+			program = 0;
+		}
+	}
+
+	for (int i = 0; i < stageCount; i++)
+	{
+		if (shaders[i] != 0)
+		{
+			glDeleteShader(shaders[i]);
+		}
+	}
+
+	return(program);
+}
+
+/***********************************************************
+ *  LoadShaderProgram()
+ *
+ *  This function is used for loading a vertex and fragment
+ *  shader in place of ShaderManager::LoadShaders(), so that
+ *  their includes are read.  The current program is not
+ *  changed.
+ ***********************************************************/
+GLuint LoadShaderProgram(
+	ShaderManager* pShaderManager,
+	const char* vertexShaderFile,
+	const char* fragmentShaderFile)
+{
+	const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	const char* filenames[] = { vertexShaderFile, fragmentShaderFile };
+
+	GLuint program = LinkShaderProgram(types, filenames, 2);
+	pShaderManager->m_programID = program;
+
+	return(program);
+}
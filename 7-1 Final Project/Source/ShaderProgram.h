@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderprogram.h
+// ============
+// compile and link the shader programs of the scene
+//
+//	The GLSL files are read with their #include "file" lines replaced by
+//	the named file from the same folder, so the lit fragment shaders all
+//	share the one copy of the lighting code in Shaders/lighting.glsl.  A
+//	few includes, such as the vertex shader inputs, are written by the
+//	program instead of read from a file.  A linked program is handed to
+//	a ShaderManager, which sets its uniforms like those of a program it
+//	loaded itself.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+// compile a GLSL file, returning zero and printing the log when
+// it does not compile
+GLuint CompileShaderFile(GLenum type, const char* filename);
+
+// compile and link the passed in stages into a program,
+// returning zero when any stage fails
+GLuint LinkShaderProgram(
+	const GLenum* types,
+	const char* const* filenames,
+	int stageCount);
+
+// compile and link a vertex and fragment shader into the program
+// of the passed in shader manager, returning zero when they fail
+GLuint LoadShaderProgram(
+	ShaderManager* pShaderManager,
+	const char* vertexShaderFile,
+	const char* fragmentShaderFile);
@@ -0,0 +1,517 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowcascades.cpp
+// ============
+// cascaded shadow maps for the directional light
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowCascades.h"
+#include "FrameFences.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// binding points declared by the shaders
+	const GLuint g_CascadeBinding = 1;
+	const GLuint g_ShadowTextureUnit = 15;
+
+	// shadows are only drawn up to this view depth
+	const float g_ShadowDistance = 40.0f;
+	// blend of logarithmic and even cascade ranges
+	const float g_SplitLambda = 0.75f;
+	// the first cascade starts here even when the projection
+	// reaches closer
+	const float g_MinimumNearDepth = 0.05f;
+	// a cached map covers this much more than its range, so it
+	// stays valid while the camera moves a little
+	const float g_CachePadding = 1.25f;
+	// objects this far toward the light from a cascade still
+	// cast shadows into it
+	const float g_CasterDistance = 50.0f;
+	// depth bias of the shadow passes
+	const float g_SlopeBias = 2.0f;
+	const float g_ConstantBias = 4.0f;
+
+	/***********************************************************
+	 *  CASCADE_BLOCK
+	 *
+	 *  The std140 ShadowCascades block of the shaders.
+	 ***********************************************************/
+	struct CASCADE_BLOCK
+	{
+		// world space to shadow map texture coordinates and depth
+		glm::mat4 shadowMatrices[ShadowCascades::CASCADE_COUNT];
+		// far view depth of each cascade
+		GLfloat cascadeSplits[4];
+		// world size of a texel in each cascade
+		GLfloat texelSizes[4];
+		// number of cascades and the size of a texel in texture
+		// coordinates
+		GLfloat parameters[4];
+	};
+
+	/***********************************************************
+	 *  UnprojectPoint()
+	 *
+	 *  Turn a point in normalized device coordinates into a
+	 *  view space point.
+	 ***********************************************************/
+	glm::vec3 UnprojectPoint(const glm::mat4& inverseProjection, float x, float y, float z)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+		return(glm::vec3(point.x / point.w, point.y / point.w, point.z / point.w));
+	}
+
+	/***********************************************************
+	 *  PointAtDepth()
+	 *
+	 *  Find the point at a view depth on the line through two
+	 *  view space points.
+	 ***********************************************************/
+	glm::vec3 PointAtDepth(glm::vec3 nearPoint, glm::vec3 farPoint, float depth)
+	{
+		float t = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+		return(nearPoint + t * (farPoint - nearPoint));
+	}
+
+	/***********************************************************
+	 *  IsSameMatrix()
+	 *
+	 *  Compare every element of two matrices.
+	 ***********************************************************/
+	bool IsSameMatrix(const glm::mat4& a, const glm::mat4& b)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				if (a[i][j] != b[i][j])
+				{
+					return(false);
+				}
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  ShadowCascades()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowCascades::ShadowCascades()
+{
+	m_framebuffer = 0;
+	m_staticMaps = 0;
+	m_dynamicMaps = 0;
+	m_resolution = 0;
+	m_lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_lightView = glm::lookAt(glm::vec3(0.0f), m_lightDirection, glm::vec3(0.0f, 0.0f, 1.0f));
+	m_splitProjection = glm::mat4(1.0f);
+	m_bSplitsValid = false;
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		m_cascades[i].viewCenter = glm::vec3(0.0f);
+		m_cascades[i].radius = 0.0f;
+		m_cascades[i].center = glm::vec3(0.0f);
+		m_cascades[i].halfSize = 0.0f;
+		m_cascades[i].projection = glm::mat4(1.0f);
+		m_cascades[i].splitDepth = 0.0f;
+		m_cascades[i].bStaticDirty = true;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~ShadowCascades()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowCascades::~ShadowCascades()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the static and dynamic
+ *  shadow maps, one layer per cascade, and the cascade
+ *  block.  The block is created and bound even when the maps
+ *  fail, so the shaders read zero cascades and skip shadows.
+ ***********************************************************/
+bool ShadowCascades::Create(int resolution)
+{
+	Destroy();
+
+	CASCADE_BLOCK block = {};
+	m_cascadeBuffer.Create(GL_UNIFORM_BUFFER, sizeof(block));
+	for (int frame = 0; frame < FRAMES_IN_FLIGHT; frame++)
+	{
+		m_cascadeBuffer.Upload(frame, g_CascadeBinding, &block, sizeof(block));
+	}
+
+	m_resolution = std::max(resolution, 256);
+
+	// the maps compare the depth when sampled, so the shaders
+	// get filtered shadows from a single lookup
+	const GLfloat border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	GLuint* maps[] = { &m_staticMaps, &m_dynamicMaps };
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, maps[i]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, *maps[i]);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, m_resolution, m_resolution, CASCADE_COUNT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_staticMaps, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: The shadow map framebuffer is not complete" << std::endl;
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(1, &m_staticMaps);
+		glDeleteTextures(1, &m_dynamicMaps);
+		m_framebuffer = 0;
+		m_staticMaps = 0;
+		m_dynamicMaps = 0;
+		return(false);
+	}
+
+	m_bSplitsValid = false;
+	InvalidateStaticShadows();
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shadow maps and the
+ *  cascade block.
+ ***********************************************************/
+void ShadowCascades::Destroy()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+	}
+	if (m_staticMaps != 0)
+	{
+		glDeleteTextures(1, &m_staticMaps);
+	}
+	if (m_dynamicMaps != 0)
+	{
+		glDeleteTextures(1, &m_dynamicMaps);
+	}
+	m_cascadeBuffer.Destroy();
+	m_framebuffer = 0;
+	m_staticMaps = 0;
+	m_dynamicMaps = 0;
+	m_resolution = 0;
+	m_bSplitsValid = false;
+}
+
+/***********************************************************
+ *  SetLightDirection()
+ *
+ *  This method is used for setting the direction that the
+ *  light travels in.  Turning the light fits every cascade
+ *  again.
+ ***********************************************************/
+void ShadowCascades::SetLightDirection(glm::vec3 direction)
+{
+	if (glm::dot(direction, direction) <= 0.0f)
+	{
+		return;
+	}
+	direction = glm::normalize(direction);
+	if (glm::dot(direction, m_lightDirection) > 0.99999f)
+	{
+		return;
+	}
+
+	m_lightDirection = direction;
+	glm::vec3 up = (std::fabs(direction.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	m_lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+	InvalidateStaticShadows();
+}
+
+/***********************************************************
+ *  InvalidateStaticShadows()
+ *
+ *  This method is used for fitting every cascade again and
+ *  drawing its static depth on the next frame.
+ ***********************************************************/
+void ShadowCascades::InvalidateStaticShadows()
+{
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		m_cascades[i].halfSize = 0.0f;
+		m_cascades[i].bStaticDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SplitCascades()
+ *
+ *  This method is used for splitting the view depth into the
+ *  cascade ranges and finding the sphere around each range.
+ *  The spheres are found in view space, so they only change
+ *  with the projection and not while the camera turns.
+ ***********************************************************/
+void ShadowCascades::SplitCascades(const glm::mat4& projection)
+{
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	float nearDepth = std::max(-UnprojectPoint(inverseProjection, 0.0f, 0.0f, -1.0f).z, g_MinimumNearDepth);
+	float farDepth = std::min(-UnprojectPoint(inverseProjection, 0.0f, 0.0f, 1.0f).z, g_ShadowDistance);
+	farDepth = std::max(farDepth, nearDepth * 2.0f);
+
+	// lines through the corners of the view
+	glm::vec3 nearCorners[4];
+	glm::vec3 farCorners[4];
+	for (int i = 0; i < 4; i++)
+	{
+		float x = (i & 1) ? 1.0f : -1.0f;
+		float y = (i & 2) ? 1.0f : -1.0f;
+		nearCorners[i] = UnprojectPoint(inverseProjection, x, y, -1.0f);
+		farCorners[i] = UnprojectPoint(inverseProjection, x, y, 1.0f);
+	}
+
+	float startDepth = nearDepth;
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		float fraction = (float)(i + 1) / (float)CASCADE_COUNT;
+		float logDepth = nearDepth * std::pow(farDepth / nearDepth, fraction);
+		float evenDepth = nearDepth + (farDepth - nearDepth) * fraction;
+		float endDepth = g_SplitLambda * logDepth + (1.0f - g_SplitLambda) * evenDepth;
+
+		glm::vec3 points[8];
+		glm::vec3 center(0.0f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			points[corner] = PointAtDepth(nearCorners[corner & 3], farCorners[corner & 3], (corner < 4) ? startDepth : endDepth);
+			center += points[corner];
+		}
+		center /= 8.0f;
+
+		float radius = 0.0f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			radius = std::max(radius, glm::length(points[corner] - center));
+		}
+
+		Cascade& cascade = m_cascades[i];
+		cascade.viewCenter = center;
+		// rounded so that tiny changes do not change the texel size
+		cascade.radius = std::ceil(radius * 16.0f) / 16.0f;
+		cascade.splitDepth = endDepth;
+
+		startDepth = endDepth;
+	}
+
+	m_splitProjection = projection;
+	m_bSplitsValid = true;
+	InvalidateStaticShadows();
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for fitting the cascades to the
+ *  passed in view.  A cascade keeps its cached map while its
+ *  sphere stays inside the map, otherwise the map is centered
+ *  on the sphere again, snapped to whole texels, and its
+ *  static depth is drawn again.
+ ***********************************************************/
+void ShadowCascades::Update(const glm::mat4& view, const glm::mat4& projection)
+{
+	if (m_staticMaps == 0)
+	{
+		return;
+	}
+
+	if (!m_bSplitsValid || !IsSameMatrix(projection, m_splitProjection))
+	{
+		SplitCascades(projection);
+	}
+
+	glm::mat4 inverseView = glm::inverse(view);
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		Cascade& cascade = m_cascades[i];
+
+		glm::vec4 worldCenter = inverseView * glm::vec4(cascade.viewCenter, 1.0f);
+		glm::vec3 lightCenter = glm::vec3(m_lightView * worldCenter);
+
+		glm::vec3 offset = lightCenter - cascade.center;
+		float reach = cascade.halfSize - cascade.radius;
+		if ((cascade.halfSize > 0.0f) &&
+			(std::fabs(offset.x) <= reach) &&
+			(std::fabs(offset.y) <= reach) &&
+			(std::fabs(offset.z) <= reach))
+		{
+			continue;
+		}
+
+		cascade.halfSize = cascade.radius * g_CachePadding;
+		float texelSize = 2.0f * cascade.halfSize / (float)m_resolution;
+		cascade.center.x = std::floor(lightCenter.x / texelSize) * texelSize;
+		cascade.center.y = std::floor(lightCenter.y / texelSize) * texelSize;
+		cascade.center.z = lightCenter.z;
+
+		// the light looks down its negative Z axis, so the near
+		// plane is pulled toward the light to catch the casters
+		// in front of the cascade
+		cascade.projection = glm::ortho(
+			cascade.center.x - cascade.halfSize,
+			cascade.center.x + cascade.halfSize,
+			cascade.center.y - cascade.halfSize,
+			cascade.center.y + cascade.halfSize,
+			-(cascade.center.z + cascade.halfSize + g_CasterDistance),
+			-(cascade.center.z - cascade.halfSize));
+		cascade.bStaticDirty = true;
+	}
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for binding one layer of the passed
+ *  in shadow maps for drawing, saving the screen viewport.
+ ***********************************************************/
+void ShadowCascades::BeginPass(GLuint maps, int cascade)
+{
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, maps, 0, cascade);
+	glViewport(0, 0, m_resolution, m_resolution);
+
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(g_SlopeBias, g_ConstantBias);
+}
+
+/***********************************************************
+ *  BeginStaticPass()
+ *
+ *  This method is used for starting to draw the static depth
+ *  of a cascade.  False is returned, and nothing is bound,
+ *  when the cached depth is still valid.
+ ***********************************************************/
+bool ShadowCascades::BeginStaticPass(int cascade)
+{
+	if ((m_staticMaps == 0) || !m_cascades[cascade].bStaticDirty)
+	{
+		return(false);
+	}
+
+	BeginPass(m_staticMaps, cascade);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	m_cascades[cascade].bStaticDirty = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BeginDynamicPass()
+ *
+ *  This method is used for starting to draw the moving
+ *  objects of a cascade.  The static depth is copied first,
+ *  so the moving objects are tested against it and only the
+ *  closer parts are added.
+ ***********************************************************/
+bool ShadowCascades::BeginDynamicPass(int cascade)
+{
+	if (m_dynamicMaps == 0)
+	{
+		return(false);
+	}
+
+	glCopyImageSubData(
+		m_staticMaps, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade,
+		m_dynamicMaps, GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade,
+		m_resolution, m_resolution, 1);
+	BeginPass(m_dynamicMaps, cascade);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for finishing a shadow pass and
+ *  drawing to the screen again.
+ ***********************************************************/
+void ShadowCascades::EndPass()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  Publish()
+ *
+ *  This method is used for uploading the cascades into the
+ *  region of the passed in frame and binding the shadow maps
+ *  for the shaders.  The static maps are read directly when
+ *  no moving objects were drawn.
+ ***********************************************************/
+void ShadowCascades::Publish(bool bDynamicCasters, int frame)
+{
+	if (m_staticMaps == 0)
+	{
+		return;
+	}
+
+	// maps the light projection into texture coordinates and depth
+	const glm::mat4 bias(
+		glm::vec4(0.5f, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.5f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 0.0f, 0.5f, 0.0f),
+		glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
+
+	CASCADE_BLOCK block;
+	for (int i = 0; i < CASCADE_COUNT; i++)
+	{
+		block.shadowMatrices[i] = bias * m_cascades[i].projection * m_lightView;
+		block.cascadeSplits[i] = m_cascades[i].splitDepth;
+		block.texelSizes[i] = 2.0f * m_cascades[i].halfSize / (float)m_resolution;
+	}
+	block.parameters[0] = (float)CASCADE_COUNT;
+	block.parameters[1] = 1.0f / (float)m_resolution;
+	block.parameters[2] = 0.0f;
+	block.parameters[3] = 0.0f;
+
+	m_cascadeBuffer.Upload(frame, g_CascadeBinding, &block, sizeof(block));
+
+	glActiveTexture(GL_TEXTURE0 + g_ShadowTextureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, bDynamicCasters ? m_dynamicMaps : m_staticMaps);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowcascades.h
+// ============
+// cascaded shadow maps for the directional light
+//
+//	The view frustum is split into depth ranges, and each range gets its
+//	own orthographic shadow map from the light, so near shadows have
+//	small texels and far shadows still fit.  Each cascade covers a sphere
+//	around its range with some room to spare, snapped to whole texels,
+//	so the shadow edges do not swim while the camera moves and the map
+//	only has to be fitted again when the range leaves the sphere.
+//
+//	The depth of the static objects is kept in its own maps and only
+//	drawn again when a cascade is fitted again, the light turns or the
+//	static objects change.  Objects that move are drawn every frame over
+//	a copy of the static depth.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "StreamBuffer.h"
+
+/***********************************************************
+ *  ShadowCascades
+ *
+ *  This class holds the shadow maps of the directional light
+ *  and the light space cascades of the current view.  The
+ *  shaders read the cascades from a fixed uniform block and
+ *  texture unit, so every program that declares them sees
+ *  the same shadows.
+ ***********************************************************/
+class ShadowCascades
+{
+public:
+	// the shader block holds four cascades
+	static const int CASCADE_COUNT = 4;
+
+	// constructor
+	ShadowCascades();
+	// destructor
+	~ShadowCascades();
+
+	// create the shadow maps with the passed in size in texels
+	bool Create(int resolution = 2048);
+	// free the shadow maps
+	void Destroy();
+
+	// set the direction that the light travels in
+	void SetLightDirection(glm::vec3 direction);
+	// draw the static depth of every cascade again, after a static
+	// object changes
+	void InvalidateStaticShadows();
+
+	// fit the cascades to the passed in view
+	void Update(const glm::mat4& view, const glm::mat4& projection);
+
+	// start drawing the static depth of a cascade, returning false
+	// when the cached depth is still valid
+	bool BeginStaticPass(int cascade);
+	// start drawing the moving objects of a cascade over a copy of
+	// its static depth
+	bool BeginDynamicPass(int cascade);
+	// finish a pass and restore the screen framebuffer
+	void EndPass();
+
+	// light view and projection of a cascade, used by the passes
+	glm::mat4 GetLightView() const { return(m_lightView); }
+	glm::mat4 GetLightProjection(int cascade) const { return(m_cascades[cascade].projection); }
+	int GetResolution() const { return(m_resolution); }
+
+	// upload the cascades for the passed in frame in flight and
+	// bind the shadow maps for the shaders, with the dynamic maps
+	// when moving objects were drawn
+	void Publish(bool bDynamicCasters, int frame);
+
+private:
+	struct Cascade
+	{
+		// view space sphere around the depth range
+		glm::vec3 viewCenter;
+		float radius;
+		// light space center and half size of the cached map
+		glm::vec3 center;
+		float halfSize;
+		glm::mat4 projection;
+		// far view depth of the range
+		float splitDepth;
+		// the static depth has to be drawn again
+		bool bStaticDirty;
+	};
+
+	GLuint m_framebuffer;
+	// static depth, and static with moving objects
+	GLuint m_staticMaps;
+	GLuint m_dynamicMaps;
+	// the cascade block, written again every frame
+	StreamBuffer m_cascadeBuffer;
+	int m_resolution;
+
+	glm::vec3 m_lightDirection;
+	glm::mat4 m_lightView;
+	Cascade m_cascades[CASCADE_COUNT];
+	// projection the cascade ranges were split for
+	glm::mat4 m_splitProjection;
+	bool m_bSplitsValid;
+
+	// viewport saved while a pass draws into a shadow map
+	GLint m_savedViewport[4];
+
+	// split the view depth into the cascade ranges
+	void SplitCascades(const glm::mat4& projection);
+	// bind a layer of a shadow map for drawing
+	void BeginPass(GLuint maps, int cascade);
+
+	// the shadow maps cannot be shared between two objects
+	ShadowCascades(const ShadowCascades&);
+	ShadowCascades& operator=(const ShadowCascades&);
+};
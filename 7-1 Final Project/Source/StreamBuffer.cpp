@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.cpp
+// ============
+// a buffer rewritten every frame while earlier frames may still read it
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StreamBuffer.h"
+#include "FrameFences.h"
+
+#include <algorithm>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// smallest region, so that the buffer can always be bound
+	const size_t g_MinimumRegionBytes = 256;
+}
+
+/***********************************************************
+ *  StreamBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StreamBuffer::StreamBuffer()
+{
+	m_target = GL_UNIFORM_BUFFER;
+	m_buffer = 0;
+	m_regionBytes = 0;
+	m_pMapped = NULL;
+}
+
+/***********************************************************
+ *  ~StreamBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StreamBuffer::~StreamBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the buffer.  The
+ *  regions are not bound until their first upload.
+ ***********************************************************/
+void StreamBuffer::Create(GLenum target, size_t regionBytes)
+{
+	Destroy();
+
+	m_target = target;
+	Allocate(regionBytes);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the buffer.  The driver
+ *  keeps it alive until the frames that read it are done.
+ ***********************************************************/
+void StreamBuffer::Destroy()
+{
+	if (m_buffer != 0)
+	{
+		if (m_pMapped != NULL)
+		{
+			glBindBuffer(m_target, m_buffer);
+			glUnmapBuffer(m_target);
+			glBindBuffer(m_target, 0);
+		}
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+	m_regionBytes = 0;
+	m_pMapped = NULL;
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for creating the storage of the
+ *  buffer.  The storage cannot be resized, so a buffer that
+ *  grows is replaced by a new one, while the frames in
+ *  flight keep reading the old one.  The mapping is coherent,
+ *  so the copies are seen by the commands issued after them
+ *  without being flushed.
+ ***********************************************************/
+void StreamBuffer::Allocate(size_t regionBytes)
+{
+	GLenum target = m_target;
+	Destroy();
+	m_target = target;
+
+	GLint alignment = 0;
+	glGetIntegerv((target == GL_SHADER_STORAGE_BUFFER) ?
+		GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	size_t step = (size_t)std::max(alignment, 1);
+	regionBytes = std::max(regionBytes, g_MinimumRegionBytes);
+	m_regionBytes = ((regionBytes + step - 1) / step) * step;
+
+	GLsizeiptr totalBytes = (GLsizeiptr)(m_regionBytes * FRAMES_IN_FLIGHT);
+	GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(target, m_buffer);
+	glBufferStorage(target, totalBytes, NULL, mapFlags | GL_DYNAMIC_STORAGE_BIT);
+	m_pMapped = (GLubyte*)glMapBufferRange(target, 0, totalBytes, mapFlags);
+	if (m_pMapped != NULL)
+	{
+		std::memset(m_pMapped, 0, (size_t)totalBytes);
+	}
+	glBindBuffer(target, 0);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for writing the data of a frame into
+ *  its own region and binding that region, so the shaders
+ *  of the frame read what was written for it.
+ ***********************************************************/
+void StreamBuffer::Upload(int frame, GLuint binding, const void* data, size_t bytes)
+{
+	if (m_buffer == 0)
+	{
+		return;
+	}
+	if (bytes > m_regionBytes)
+	{
+		Allocate(std::max(bytes, m_regionBytes * 2));
+	}
+
+	size_t offset = (size_t)frame * m_regionBytes;
+	if (bytes > 0)
+	{
+		if (m_pMapped != NULL)
+		{
+			std::memcpy(m_pMapped + offset, data, bytes);
+		}
+		else
+		{
+			glBindBuffer(m_target, m_buffer);
+			glBufferSubData(m_target, (GLintptr)offset, (GLsizeiptr)bytes, data);
+			glBindBuffer(m_target, 0);
+		}
+	}
+
+	glBindBufferRange(m_target, binding, m_buffer, (GLintptr)offset, (GLsizeiptr)m_regionBytes);
+}
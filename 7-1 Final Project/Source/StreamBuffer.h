@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+// streambuffer.h
+// ============
+// a buffer rewritten every frame while earlier frames may still read it
+//
+//	The buffer holds one region for every frame in flight, and each frame
+//	writes and binds only its own region.  The GPU can still be reading the
+//	regions of the frames before, so the region of a frame is only written
+//	again once FrameFences has seen that frame finish, which is what lets
+//	the writes skip the wait the driver would otherwise add for a buffer
+//	in use.  The buffer stays mapped for its whole life, so a write is a
+//	plain copy into memory the GPU reads from.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  StreamBuffer
+ *
+ *  This class holds a uniform or storage buffer with one
+ *  region per frame in flight.
+ ***********************************************************/
+class StreamBuffer
+{
+public:
+	// constructor
+	StreamBuffer();
+	// destructor
+	~StreamBuffer();
+
+	// create the buffer for the passed in target, with regions of
+	// at least the passed in size
+	void Create(GLenum target, size_t regionBytes);
+	// free the buffer
+	void Destroy();
+
+	// copy data into the region of the passed in frame and bind
+	// the region to the passed in binding point - every region
+	// grows when the data does not fit
+	void Upload(int frame, GLuint binding, const void* data, size_t bytes);
+
+private:
+	GLenum m_target;
+	GLuint m_buffer;
+	// size in bytes of each region, a multiple of the offset
+	// alignment of the target
+	size_t m_regionBytes;
+	// the mapped regions, or NULL when the mapping failed and
+	// the regions are written through the driver instead
+	GLubyte* m_pMapped;
+
+	// replace the buffer with one of the passed in region size
+	void Allocate(size_t regionBytes);
+
+	// the buffer cannot be shared between two objects
+	StreamBuffer(const StreamBuffer&);
+	StreamBuffer& operator=(const StreamBuffer&);
+};
@@ -0,0 +1,227 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadpool.cpp
+// ============
+// run CPU work in parallel across all of the processor cores
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+
+// declaration of global variables
+namespace
+{
+	// number of chunks each thread gets, so uneven work still balances
+	const size_t g_ChunksPerThread = 4;
+
+	/***********************************************************
+	 *  PARALLEL_JOB
+	 *
+	 *  Shared state of one ParallelFor call.  Helpers that start
+	 *  after all chunks are taken simply find nothing to do.
+	 ***********************************************************/
+	struct PARALLEL_JOB
+	{
+		std::function<void(size_t, size_t)> function;
+		size_t count;
+		size_t chunkSize;
+		size_t chunkCount;
+		std::atomic<size_t> nextChunk;
+		std::atomic<size_t> completedChunks;
+		std::mutex mutex;
+		std::condition_variable condition;
+	};
+
+	/***********************************************************
+	 *  RunChunks()
+	 *
+	 *  Take chunks from the job until none are left.
+	 ***********************************************************/
+	void RunChunks(PARALLEL_JOB& job)
+	{
+		size_t chunk = job.nextChunk.fetch_add(1);
+		while (chunk < job.chunkCount)
+		{
+			size_t begin = chunk * job.chunkSize;
+			size_t end = begin + job.chunkSize;
+			if (end > job.count)
+			{
+				end = job.count;
+			}
+			job.function(begin, end);
+
+			if (job.completedChunks.fetch_add(1) + 1 == job.chunkCount)
+			{
+				std::lock_guard<std::mutex> lock(job.mutex);
+				job.condition.notify_all();
+			}
+			chunk = job.nextChunk.fetch_add(1);
+		}
+	}
+}
+
+/***********************************************************
+ *  ThreadPool()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	m_bStopping = false;
+
+	if (threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+	}
+
+	// the thread that calls ParallelFor also does work
+	for (unsigned int i = 1; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+/***********************************************************
+ *  ~ThreadPool()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
+
+/***********************************************************
+ *  GetSharedPool()
+ *
+ *  This method is used for getting the thread pool that is
+ *  shared by the whole application.
+ ***********************************************************/
+ThreadPool& ThreadPool::GetSharedPool()
+{
+	static ThreadPool sharedPool;
+	return(sharedPool);
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that work on a ParallelFor, including the caller.
+ ***********************************************************/
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return((unsigned int)m_workers.size() + 1);
+}
+
+/***********************************************************
+ *  Enqueue()
+ *
+ *  This method is used for adding a task to the queue that
+ *  the worker threads run from.
+ ***********************************************************/
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	if (m_workers.size() == 0)
+	{
+		task();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(task));
+	}
+	m_condition.notify_one();
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting the range [0, count)
+ *  into chunks and running the passed in function on the
+ *  chunks across all of the threads.
+ ***********************************************************/
+void ThreadPool::ParallelFor(
+	size_t count,
+	size_t minimumChunkSize,
+	const std::function<void(size_t begin, size_t end)>& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (minimumChunkSize == 0)
+	{
+		minimumChunkSize = 1;
+	}
+
+	size_t threadCount = GetThreadCount();
+	size_t chunkSize = count / (threadCount * g_ChunksPerThread);
+	if (chunkSize < minimumChunkSize)
+	{
+		chunkSize = minimumChunkSize;
+	}
+	size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// small ranges are not worth waking up the workers
+	if ((chunkCount == 1) || (threadCount == 1))
+	{
+		function(0, count);
+		return;
+	}
+
+	std::shared_ptr<PARALLEL_JOB> job = std::make_shared<PARALLEL_JOB>();
+	job->function = function;
+	job->count = count;
+	job->chunkSize = chunkSize;
+	job->chunkCount = chunkCount;
+	job->nextChunk = 0;
+	job->completedChunks = 0;
+
+	size_t helperCount = (chunkCount - 1 < threadCount - 1) ? chunkCount - 1 : threadCount - 1;
+	for (size_t i = 0; i < helperCount; i++)
+	{
+		Enqueue([job]() { RunChunks(*job); });
+	}
+
+	RunChunks(*job);
+
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->condition.wait(lock, [&job]() { return job->completedChunks == job->chunkCount; });
+}
+
+/***********************************************************
+ *  WorkerLoop()
+ *
+ *  This method is run by each worker thread, it waits for
+ *  tasks and runs them until the pool is destroyed.
+ ***********************************************************/
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_bStopping || !m_tasks.empty(); });
+			if (m_bStopping && m_tasks.empty())
+			{
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		task();
+	}
+}
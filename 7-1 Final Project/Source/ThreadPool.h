@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+// threadpool.h
+// ============
+// run CPU work in parallel across all of the processor cores
+//
+//	One pool is shared by the whole application.  ParallelFor splits an
+//	index range into chunks; the calling thread works on chunks too, so
+//	a ParallelFor can safely be started from inside another one.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ThreadPool
+ *
+ *  This class owns a set of worker threads that run the
+ *  tasks placed in its queue.
+ ***********************************************************/
+class ThreadPool
+{
+public:
+	// constructor - zero threads uses one per processor core
+	ThreadPool(unsigned int threadCount = 0);
+	// destructor
+	~ThreadPool();
+
+	// get the pool that is shared by the whole application
+	static ThreadPool& GetSharedPool();
+
+	// number of threads that run work, including the caller
+	unsigned int GetThreadCount() const;
+
+	// call the function for every [begin, end) chunk of the range
+	// and return when all of the chunks have been completed
+	void ParallelFor(
+		size_t count,
+		size_t minimumChunkSize,
+		const std::function<void(size_t begin, size_t end)>& function);
+
+	// add a task to the queue without waiting for it
+	void Enqueue(std::function<void()> task);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_bStopping;
+
+	// loop that is run by each worker thread
+	void WorkerLoop();
+};
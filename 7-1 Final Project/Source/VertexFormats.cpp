@@ -0,0 +1,427 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexformats.cpp
+// ============
+// encode mesh vertices into full precision or compact GPU vertex formats
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VertexFormats.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// largest finite value that a half float can hold
+	const float g_MaxHalfValue = 65504.0f;
+	// UVs may drift this far outside of the 0 to 1 range
+	const float g_UVRangeTolerance = 0.0001f;
+
+	/***********************************************************
+	 *  PackSnorm16()
+	 *
+	 *  Convert a value in the -1 to 1 range into a normalized
+	 *  signed short.
+	 ***********************************************************/
+	int16_t PackSnorm16(float value)
+	{
+		value = glm::clamp(value, -1.0f, 1.0f);
+		return((int16_t)std::lround(value * 32767.0f));
+	}
+
+	/***********************************************************
+	 *  UnpackSnorm16()
+	 *
+	 *  Convert a normalized signed short back into a float the
+	 *  same way that OpenGL does for normalized attributes.
+	 ***********************************************************/
+	float UnpackSnorm16(int16_t value)
+	{
+		return(glm::max((float)value / 32767.0f, -1.0f));
+	}
+
+	/***********************************************************
+	 *  PackUnorm16()
+	 *
+	 *  Convert a value in the 0 to 1 range into a normalized
+	 *  unsigned short.
+	 ***********************************************************/
+	uint16_t PackUnorm16(float value)
+	{
+		value = glm::clamp(value, 0.0f, 1.0f);
+		return((uint16_t)std::lround(value * 65535.0f));
+	}
+
+	/***********************************************************
+	 *  UnpackUnorm16()
+	 *
+	 *  Convert a normalized unsigned short back into a float.
+	 ***********************************************************/
+	float UnpackUnorm16(uint16_t value)
+	{
+		return((float)value / 65535.0f);
+	}
+
+	/***********************************************************
+	 *  IsFinite()
+	 *
+	 *  Check that all of the components of a vector are finite.
+	 ***********************************************************/
+	bool IsFinite(glm::vec3 value)
+	{
+		return(std::isfinite(value.x) && std::isfinite(value.y) && std::isfinite(value.z));
+	}
+}
+
+/***********************************************************
+ *  GetVertexFormatName()
+ *
+ *  This function is used for getting the display name of
+ *  the passed in vertex format.
+ ***********************************************************/
+const char* GetVertexFormatName(VERTEX_FORMAT format)
+{
+	switch (format)
+	{
+	case VERTEX_FORMAT_FLOAT32:
+		return("FLOAT32");
+	case VERTEX_FORMAT_HALF:
+		return("HALF");
+	case VERTEX_FORMAT_SNORM16:
+		return("SNORM16");
+	}
+	return("UNKNOWN");
+}
+
+/***********************************************************
+ *  GetVertexStride()
+ *
+ *  This function is used for getting the size in bytes of
+ *  one vertex stored in the passed in vertex format.
+ ***********************************************************/
+GLsizei GetVertexStride(VERTEX_FORMAT format)
+{
+	if (format == VERTEX_FORMAT_FLOAT32)
+	{
+		return(sizeof(VERTEX_FLOAT32));
+	}
+	return(sizeof(VERTEX_COMPACT));
+}
+
+/***********************************************************
+ *  GetVertexLayout()
+ *
+ *  This function is used for getting the vertex layout that
+ *  the passed in vertex format is read with.
+ ***********************************************************/
+VERTEX_LAYOUT GetVertexLayout(VERTEX_FORMAT format)
+{
+	if (format == VERTEX_FORMAT_FLOAT32)
+	{
+		return(VERTEX_LAYOUT_FLOAT32);
+	}
+	return(VERTEX_LAYOUT_COMPACT);
+}
+
+/***********************************************************
+ *  FloatToHalf()
+ *
+ *  This function is used for converting a 32-bit float into
+ *  the bits of a 16-bit half float, rounding to nearest even.
+ ***********************************************************/
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+	int exponent = (int)floatExponent - 127 + 15;
+
+	// infinity and NaN keep their class
+	if (floatExponent == 0xff)
+	{
+		return((uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0)));
+	}
+	// too large for a half, so it becomes infinity
+	if (exponent >= 31)
+	{
+		return((uint16_t)(sign | 0x7c00));
+	}
+	// too small for a normal half, so it becomes subnormal or zero
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return((uint16_t)sign);
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if ((remainder > halfway) || ((remainder == halfway) && (half & 1)))
+		{
+			half++;
+		}
+		return((uint16_t)(sign | half));
+	}
+
+	uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1fff;
+	// a carry out of the mantissa correctly bumps the exponent
+	if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+	{
+		half++;
+	}
+	return((uint16_t)(sign | half));
+}
+
+/***********************************************************
+ *  HalfToFloat()
+ *
+ *  This function is used for converting the bits of a 16-bit
+ *  half float back into a 32-bit float.
+ ***********************************************************/
+float HalfToFloat(uint16_t value)
+{
+	uint32_t sign = ((uint32_t)value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+	uint32_t bits = 0;
+
+	if (exponent == 0)
+	{
+		// zero and subnormal values
+		float result = std::ldexp((float)mantissa, -24);
+		return(sign ? -result : result);
+	}
+	else if (exponent == 31)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float result = 0.0f;
+	memcpy(&result, &bits, sizeof(result));
+	return(result);
+}
+
+/***********************************************************
+ *  EncodeOctahedralNormal()
+ *
+ *  This function is used for projecting a unit normal onto
+ *  an octahedron and unfolding it into two normalized shorts.
+ ***********************************************************/
+void EncodeOctahedralNormal(glm::vec3 normal, int16_t encoded[2])
+{
+	float sum = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (sum <= 0.0f)
+	{
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+
+	float x = normal.x / sum;
+	float y = normal.y / sum;
+
+	// fold the lower hemisphere over the diagonals
+	if (normal.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = PackSnorm16(x);
+	encoded[1] = PackSnorm16(y);
+}
+
+/***********************************************************
+ *  DecodeOctahedralNormal()
+ *
+ *  This function is used for decoding an octahedral normal,
+ *  it matches the decoding done in the vertex shader.
+ ***********************************************************/
+glm::vec3 DecodeOctahedralNormal(const int16_t encoded[2])
+{
+	float x = UnpackSnorm16(encoded[0]);
+	float y = UnpackSnorm16(encoded[1]);
+	glm::vec3 normal(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+
+	float fold = glm::max(-normal.z, 0.0f);
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+
+	return(glm::normalize(normal));
+}
+
+/***********************************************************
+ *  EncodeVertices()
+ *
+ *  This function is used for encoding the vertices of the
+ *  passed in mesh into the requested vertex format.  The
+ *  report describes the precision that was lost, or why the
+ *  mesh cannot be stored in that format.
+ ***********************************************************/
+bool EncodeVertices(
+	const MESH_DATA& mesh,
+	VERTEX_FORMAT format,
+	ENCODED_VERTICES& encoded,
+	QUANTIZATION_REPORT& report)
+{
+	size_t vertexCount = mesh.positions.size();
+
+	report.bSuccess = false;
+	report.error.clear();
+	report.maxPositionError = 0.0f;
+	report.maxNormalError = 0.0f;
+	report.maxUVError = 0.0f;
+	report.vertexBytes = 0;
+	report.float32Bytes = vertexCount * sizeof(VERTEX_FLOAT32);
+
+	encoded.format = format;
+	encoded.data.clear();
+	encoded.stride = GetVertexStride(format);
+	encoded.positionOffset = glm::vec3(0.0f);
+	encoded.positionScale = glm::vec3(1.0f);
+
+	if ((mesh.normals.size() != vertexCount) || (mesh.uvs.size() != vertexCount))
+	{
+		report.error = "vertex streams have different lengths";
+		return(false);
+	}
+
+	// check the source data before anything is encoded
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		if (!IsFinite(mesh.positions[i]) || !IsFinite(mesh.normals[i]) ||
+			!std::isfinite(mesh.uvs[i].x) || !std::isfinite(mesh.uvs[i].y))
+		{
+			report.error = "vertex " + std::to_string(i) + " contains a value that is not finite";
+			return(false);
+		}
+	}
+
+	encoded.data.resize(vertexCount * encoded.stride);
+	report.vertexBytes = encoded.data.size();
+
+	if (format == VERTEX_FORMAT_FLOAT32)
+	{
+		VERTEX_FLOAT32* vertices = (VERTEX_FLOAT32*)encoded.data.data();
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			memcpy(vertices[i].position, &mesh.positions[i].x, sizeof(vertices[i].position));
+			memcpy(vertices[i].normal, &mesh.normals[i].x, sizeof(vertices[i].normal));
+			memcpy(vertices[i].uv, &mesh.uvs[i].x, sizeof(vertices[i].uv));
+		}
+		report.bSuccess = true;
+		return(true);
+	}
+
+	// the compact formats store the positions relative to the
+	// center of the bounding box so they keep the most precision
+	MESH_BOUNDS bounds = CalculateMeshBounds(mesh);
+	glm::vec3 halfExtent = (bounds.maximum - bounds.minimum) * 0.5f;
+	encoded.positionOffset = bounds.center;
+
+	if (format == VERTEX_FORMAT_SNORM16)
+	{
+		// a flat axis can use any scale, since every value is zero
+		for (int axis = 0; axis < 3; axis++)
+		{
+			encoded.positionScale[axis] = (halfExtent[axis] > 0.0f) ? halfExtent[axis] : 1.0f;
+		}
+	}
+	else if ((halfExtent.x > g_MaxHalfValue) || (halfExtent.y > g_MaxHalfValue) || (halfExtent.z > g_MaxHalfValue))
+	{
+		report.error = "mesh is too large for half float positions";
+		encoded.data.clear();
+		report.vertexBytes = 0;
+		return(false);
+	}
+
+	VERTEX_COMPACT* vertices = (VERTEX_COMPACT*)encoded.data.data();
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 relative = mesh.positions[i] - encoded.positionOffset;
+		glm::vec3 decodedPosition;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (format == VERTEX_FORMAT_SNORM16)
+			{
+				int16_t packed = PackSnorm16(relative[axis] / encoded.positionScale[axis]);
+				vertices[i].position[axis] = (uint16_t)packed;
+				decodedPosition[axis] = UnpackSnorm16(packed) * encoded.positionScale[axis];
+			}
+			else
+			{
+				vertices[i].position[axis] = FloatToHalf(relative[axis]);
+				decodedPosition[axis] = HalfToFloat(vertices[i].position[axis]);
+			}
+		}
+		vertices[i].position[3] = 0;
+
+		glm::vec2 uv = mesh.uvs[i];
+		if ((uv.x < -g_UVRangeTolerance) || (uv.x > 1.0f + g_UVRangeTolerance) ||
+			(uv.y < -g_UVRangeTolerance) || (uv.y > 1.0f + g_UVRangeTolerance))
+		{
+			report.error = "vertex " + std::to_string(i) + " has a UV outside of the 0 to 1 range";
+			encoded.data.clear();
+			report.vertexBytes = 0;
+			return(false);
+		}
+		vertices[i].uv[0] = PackUnorm16(uv.x);
+		vertices[i].uv[1] = PackUnorm16(uv.y);
+
+		EncodeOctahedralNormal(mesh.normals[i], vertices[i].normal);
+
+		// measure the error of the decoded vertex
+		report.maxPositionError = glm::max(report.maxPositionError, glm::length(decodedPosition - relative));
+
+		glm::vec2 decodedUV(UnpackUnorm16(vertices[i].uv[0]), UnpackUnorm16(vertices[i].uv[1]));
+		report.maxUVError = glm::max(report.maxUVError, glm::max(std::fabs(decodedUV.x - uv.x), std::fabs(decodedUV.y - uv.y)));
+
+		float normalLength = glm::length(mesh.normals[i]);
+		if (normalLength > 0.0f)
+		{
+			float cosAngle = glm::dot(DecodeOctahedralNormal(vertices[i].normal), mesh.normals[i] / normalLength);
+			float angle = glm::degrees(std::acos(glm::clamp(cosAngle, -1.0f, 1.0f)));
+			report.maxNormalError = glm::max(report.maxNormalError, angle);
+		}
+	}
+
+	report.bSuccess = true;
+	return(true);
+}
+
+/***********************************************************
+ *  PrintQuantizationReport()
+ *
+ *  This function is used for displaying the result of
+ *  encoding the vertices of a mesh.
+ ***********************************************************/
+void PrintQuantizationReport(const char* meshName, VERTEX_FORMAT format, const QUANTIZATION_REPORT& report)
+{
+	if (report.bSuccess == false)
+	{
+		std::cout << "ERROR: Mesh " << meshName << " cannot use vertex format " << GetVertexFormatName(format)
+			<< ": " << report.error << std::endl;
+		return;
+	}
+
+	std::cout << "INFO: Mesh " << meshName << " vertex format:" << GetVertexFormatName(format)
+		<< ", bytes:" << report.vertexBytes << " of " << report.float32Bytes
+		<< ", max position error:" << report.maxPositionError
+		<< ", max normal error:" << report.maxNormalError << " deg"
+		<< ", max UV error:" << report.maxUVError << std::endl;
+}
\ No newline at end of file
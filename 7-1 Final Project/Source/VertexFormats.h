@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexformats.h
+// ============
+// encode mesh vertices into full precision or compact GPU vertex formats
+//
+//	FLOAT32 stores 32 bytes per vertex: float position, normal and UV.
+//	HALF and SNORM16 store 16 bytes per vertex: a 16-bit position
+//	(half float or normalized short), an octahedral normal in two
+//	normalized shorts and a normalized unsigned short UV.
+//
+//	HALF and SNORM16 share the COMPACT vertex layout: their positions are
+//	read as raw shorts and decoded by the vertex shader, so meshes in both
+//	formats can be drawn from one vertex array object.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshData.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum VERTEX_FORMAT
+{
+	VERTEX_FORMAT_FLOAT32 = 0,
+	VERTEX_FORMAT_HALF,
+	VERTEX_FORMAT_SNORM16
+};
+
+// the attribute types read by the GPU, shared by several formats
+enum VERTEX_LAYOUT
+{
+	VERTEX_LAYOUT_FLOAT32 = 0,
+	VERTEX_LAYOUT_COMPACT,
+	VERTEX_LAYOUT_COUNT
+};
+
+// all vertex attributes are read from this vertex buffer binding
+const GLuint VERTEX_BUFFER_BINDING = 0;
+
+// full precision vertex - 32 bytes
+struct VERTEX_FLOAT32
+{
+	float position[3];
+	float normal[3];
+	float uv[2];
+};
+
+// compact vertex - 16 bytes, the fourth position value is padding
+struct VERTEX_COMPACT
+{
+	uint16_t position[4];
+	int16_t normal[2];
+	uint16_t uv[2];
+};
+
+/***********************************************************
+ *  QUANTIZATION_REPORT
+ *
+ *  Describes the precision lost when a mesh was encoded,
+ *  and the reason when the format could not be used.
+ ***********************************************************/
+struct QUANTIZATION_REPORT
+{
+	bool bSuccess;
+	std::string error;
+	// largest object space distance between source and decoded position
+	float maxPositionError;
+	// largest angle in degrees between source and decoded normal
+	float maxNormalError;
+	// largest difference between source and decoded UV
+	float maxUVError;
+	// size of the encoded vertex data in bytes
+	size_t vertexBytes;
+	// size the vertex data would have in the FLOAT32 format
+	size_t float32Bytes;
+};
+
+/***********************************************************
+ *  ENCODED_VERTICES
+ *
+ *  Vertex data ready to be copied into a vertex buffer, with
+ *  the values needed by the vertex shader to decode it.
+ ***********************************************************/
+struct ENCODED_VERTICES
+{
+	VERTEX_FORMAT format;
+	std::vector<unsigned char> data;
+	GLsizei stride;
+	// decoded position = positionOffset + positionScale * stored position
+	glm::vec3 positionOffset;
+	glm::vec3 positionScale;
+};
+
+// get the display name of a vertex format
+const char* GetVertexFormatName(VERTEX_FORMAT format);
+// get the size in bytes of one vertex in a vertex format
+GLsizei GetVertexStride(VERTEX_FORMAT format);
+// get the vertex layout that a vertex format is read with
+VERTEX_LAYOUT GetVertexLayout(VERTEX_FORMAT format);
+
+// encode the mesh vertices into the requested vertex format
+bool EncodeVertices(
+	const MESH_DATA& mesh,
+	VERTEX_FORMAT format,
+	ENCODED_VERTICES& encoded,
+	QUANTIZATION_REPORT& report);
+
+// print the quantization report for a mesh to the console
+void PrintQuantizationReport(const char* meshName, VERTEX_FORMAT format, const QUANTIZATION_REPORT& report);
+
+
+// conversions between 32-bit and 16-bit floating point values
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// octahedral normal encoding into two normalized shorts
+void EncodeOctahedralNormal(glm::vec3 normal, int16_t encoded[2]);
+glm::vec3 DecodeOctahedralNormal(const int16_t encoded[2]);
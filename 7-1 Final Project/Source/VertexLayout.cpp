@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexlayout.cpp
+// ============
+// compile time descriptions of the vertex layouts read by the vertex shader
+///////////////////////////////////////////////////////////////////////////////
+
+#include "VertexLayout.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	/***********************************************************
+	 *  SetupAttributes()
+	 *
+	 *  Declare every attribute of a layout table on the bound
+	 *  vertex array object, reading from the shared binding.
+	 ***********************************************************/
+	template <size_t Count>
+	void SetupAttributes(const VERTEX_ATTRIBUTE (&attributes)[Count])
+	{
+		for (size_t i = 0; i < Count; i++)
+		{
+			const VERTEX_ATTRIBUTE& attribute = attributes[i];
+			glVertexAttribFormat(attribute.location, attribute.size, attribute.type, attribute.bNormalized, attribute.offset);
+			glVertexAttribBinding(attribute.location, VERTEX_BUFFER_BINDING);
+			glEnableVertexAttribArray(attribute.location);
+		}
+	}
+
+	/***********************************************************
+	 *  GetFloatVectorType()
+	 *
+	 *  Get the OpenGL type of a float vector input.
+	 ***********************************************************/
+	GLenum GetFloatVectorType(GLint components)
+	{
+		switch (components)
+		{
+		case 1:
+			return(GL_FLOAT);
+		case 2:
+			return(GL_FLOAT_VEC2);
+		case 3:
+			return(GL_FLOAT_VEC3);
+		}
+		return(GL_FLOAT_VEC4);
+	}
+
+	/***********************************************************
+	 *  GetFloatVectorName()
+	 *
+	 *  Get the GLSL type name of a float vector input.
+	 ***********************************************************/
+	const char* GetFloatVectorName(GLint components)
+	{
+		switch (components)
+		{
+		case 1:
+			return("float");
+		case 2:
+			return("vec2");
+		case 3:
+			return("vec3");
+		}
+		return("vec4");
+	}
+}
+
+/***********************************************************
+ *  GetVertexLayoutStride()
+ *
+ *  This function is used for getting the size in bytes of
+ *  one vertex read with the passed in vertex layout.
+ ***********************************************************/
+GLsizei GetVertexLayoutStride(VERTEX_LAYOUT layout)
+{
+	if (layout == VERTEX_LAYOUT_FLOAT32)
+	{
+		return(sizeof(VERTEX_FLOAT32));
+	}
+	return(sizeof(VERTEX_COMPACT));
+}
+
+/***********************************************************
+ *  SetupVertexFormat()
+ *
+ *  This function is used for declaring the attribute formats
+ *  of the passed in vertex layout on the currently bound
+ *  vertex array object, from its compile time description.
+ *  Every attribute is read from the same buffer binding, so
+ *  meshes are switched by binding a different vertex buffer
+ *  without touching the formats.
+ ***********************************************************/
+void SetupVertexFormat(VERTEX_LAYOUT layout)
+{
+	if (layout == VERTEX_LAYOUT_FLOAT32)
+	{
+		SetupAttributes(VERTEX_FLOAT32_ATTRIBUTES);
+	}
+	else
+	{
+		SetupAttributes(VERTEX_COMPACT_ATTRIBUTES);
+	}
+}
+
+/***********************************************************
+ *  GetVertexShaderInputDeclarations()
+ *
+ *  This function is used for writing the GLSL declarations
+ *  of the vertex shader inputs that every vertex layout is
+ *  built to feed.
+ ***********************************************************/
+std::string GetVertexShaderInputDeclarations()
+{
+	std::string declarations;
+	for (GLuint i = 0; i < VERTEX_SHADER_INPUT_COUNT; i++)
+	{
+		const VERTEX_SHADER_INPUT& input = VERTEX_SHADER_INPUTS[i];
+		declarations += "layout (location = " + std::to_string(input.location) + ") in " +
+			GetFloatVectorName(input.components) + " " + input.name + ";\n";
+	}
+	return(declarations);
+}
+
+/***********************************************************
+ *  ValidateVertexShaderInputs()
+ *
+ *  This function is used for checking that every active
+ *  input of the passed in program is one of the vertex
+ *  shader inputs, at the same location and with the same
+ *  type.  Inputs that the compiler removed are not active
+ *  and are not checked.
+ ***********************************************************/
+bool ValidateVertexShaderInputs(GLuint program)
+{
+	if (program == 0)
+	{
+		return(false);
+	}
+
+	GLint activeCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &activeCount);
+	glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+
+	bool bValid = true;
+	std::string name(maxNameLength + 1, '\0');
+	for (GLint i = 0; i < activeCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+		glGetActiveAttrib(program, (GLuint)i, (GLsizei)name.size(), &nameLength, &arraySize, &type, &name[0]);
+		std::string attributeName(name.c_str(), nameLength);
+
+		// built in inputs such as gl_VertexID have no location
+		if (attributeName.compare(0, 3, "gl_") == 0)
+		{
+			continue;
+		}
+
+		GLint location = glGetAttribLocation(program, attributeName.c_str());
+		bool bFound = false;
+		for (GLuint j = 0; j < VERTEX_SHADER_INPUT_COUNT; j++)
+		{
+			const VERTEX_SHADER_INPUT& input = VERTEX_SHADER_INPUTS[j];
+			if (attributeName == input.name)
+			{
+				bFound = ((GLuint)location == input.location) && (type == GetFloatVectorType(input.components));
+			}
+		}
+		if (bFound == false)
+		{
+			std::cout << "ERROR: Vertex shader input " << attributeName << " at location " << location
+				<< " does not match the vertex layouts" << std::endl;
+			bValid = false;
+		}
+	}
+
+	if (bValid == false)
+	{
+		std::cout << "INFO: The vertex layouts expect these vertex shader inputs:" << std::endl
+			<< GetVertexShaderInputDeclarations();
+	}
+
+	return(bValid);
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexlayout.h
+// ============
+// compile time descriptions of the vertex layouts read by the vertex shader
+//
+//	VERTEX_SHADER_INPUTS lists the inputs of the scene vertex shader,
+//	whose declarations are generated from it when the shader is loaded.
+//	Every vertex layout is a constexpr table of VERTEX_ATTRIBUTE entries
+//	built with DECLARE_VERTEX_ATTRIBUTE, which takes the offset from the
+//	vertex struct and checks the component type and count against the
+//	struct member and the shader input.  A member that is read as another
+//	type of the same size must say so with
+//	DECLARE_REINTERPRETED_VERTEX_ATTRIBUTE.  The static_asserts
+//	below stop the build when a layout reads the wrong bytes of a vertex,
+//	misses a shader input or feeds one twice, so a vertex format can be
+//	changed without the GL calls and the shader silently disagreeing.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "VertexFormats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+/***********************************************************
+ *  VERTEX_SHADER_INPUT
+ *
+ *  One float vector input of the vertex shader.
+ ***********************************************************/
+struct VERTEX_SHADER_INPUT
+{
+	GLuint location;
+	GLint components;
+	const char* name;
+};
+
+// the inputs of Shaders/vertexShader.glsl, indexed by location
+constexpr VERTEX_SHADER_INPUT VERTEX_SHADER_INPUTS[] =
+{
+	{ 0, 3, "inVertexPosition" },
+	{ 1, 3, "inVertexNormal" },
+	{ 2, 2, "inTextureCoordinate" }
+};
+constexpr GLuint VERTEX_SHADER_INPUT_COUNT = sizeof(VERTEX_SHADER_INPUTS) / sizeof(VERTEX_SHADER_INPUTS[0]);
+
+/***********************************************************
+ *  VERTEX_ATTRIBUTE
+ *
+ *  One attribute of a vertex layout, with the values passed
+ *  to glVertexAttribFormat.
+ ***********************************************************/
+struct VERTEX_ATTRIBUTE
+{
+	GLuint location;
+	GLint size;
+	GLenum type;
+	GLboolean bNormalized;
+	GLuint offset;
+	// bytes read for one vertex
+	GLuint bytes;
+};
+
+// OpenGL type of each component type that an attribute can read
+template <typename T> struct VERTEX_COMPONENT_TYPE;
+template <> struct VERTEX_COMPONENT_TYPE<float> { static constexpr GLenum value = GL_FLOAT; };
+template <> struct VERTEX_COMPONENT_TYPE<int16_t> { static constexpr GLenum value = GL_SHORT; };
+template <> struct VERTEX_COMPONENT_TYPE<uint16_t> { static constexpr GLenum value = GL_UNSIGNED_SHORT; };
+
+/***********************************************************
+ *  MakeVertexAttribute()
+ *
+ *  Build an attribute that reads Size components from a
+ *  vertex member, checking it against the member and the
+ *  shader input at compile time.  The component type must
+ *  be the type of the member, or only its size when the
+ *  attribute reinterprets the member.
+ ***********************************************************/
+template <typename Component, typename Member, GLuint Location, GLint Size, bool bNormalized, size_t Offset, bool bReinterpreted>
+constexpr VERTEX_ATTRIBUTE MakeVertexAttribute()
+{
+	typedef typename std::remove_extent<Member>::type MemberComponent;
+	static_assert(std::is_array<Member>::value, "vertex members must be arrays of components");
+	static_assert(bReinterpreted || std::is_same<Component, MemberComponent>::value, "the component type does not match the vertex member");
+	static_assert(sizeof(Component) == sizeof(MemberComponent), "the component type is not the size of the vertex member components");
+	static_assert((Size > 0) && (Size * sizeof(Component) <= sizeof(Member)), "the attribute reads past the end of the vertex member");
+	static_assert(Location < VERTEX_SHADER_INPUT_COUNT, "the vertex shader has no input at this location");
+	static_assert(Size <= VERTEX_SHADER_INPUTS[Location].components, "the attribute has more components than the shader input");
+
+	return(VERTEX_ATTRIBUTE{
+		Location,
+		Size,
+		VERTEX_COMPONENT_TYPE<Component>::value,
+		(GLboolean)(bNormalized ? GL_TRUE : GL_FALSE),
+		(GLuint)Offset,
+		(GLuint)(Size * sizeof(Component)) });
+}
+
+// describe an attribute that reads a member of a vertex struct
+#define DECLARE_VERTEX_ATTRIBUTE(vertex, member, component, location, size, bNormalized) \
+	MakeVertexAttribute<component, decltype(vertex::member), location, size, bNormalized, offsetof(vertex, member), false>()
+// describe an attribute that reads the bits of a member of a vertex
+// struct as another component type of the same size
+#define DECLARE_REINTERPRETED_VERTEX_ATTRIBUTE(vertex, member, component, location, size, bNormalized) \
+	MakeVertexAttribute<component, decltype(vertex::member), location, size, bNormalized, offsetof(vertex, member), true>()
+
+// the FLOAT32 vertex format
+constexpr VERTEX_ATTRIBUTE VERTEX_FLOAT32_ATTRIBUTES[] =
+{
+	DECLARE_VERTEX_ATTRIBUTE(VERTEX_FLOAT32, position, float, 0, 3, false),
+	DECLARE_VERTEX_ATTRIBUTE(VERTEX_FLOAT32, normal, float, 1, 3, false),
+	DECLARE_VERTEX_ATTRIBUTE(VERTEX_FLOAT32, uv, float, 2, 2, false)
+};
+
+// the HALF and SNORM16 vertex formats - the positions are stored as
+// unsigned bit patterns, half floats or normalized shorts, and are
+// deliberately read as raw signed shorts that the vertex shader decodes
+constexpr VERTEX_ATTRIBUTE VERTEX_COMPACT_ATTRIBUTES[] =
+{
+	DECLARE_REINTERPRETED_VERTEX_ATTRIBUTE(VERTEX_COMPACT, position, int16_t, 0, 3, false),
+	DECLARE_VERTEX_ATTRIBUTE(VERTEX_COMPACT, normal, int16_t, 1, 2, true),
+	DECLARE_VERTEX_ATTRIBUTE(VERTEX_COMPACT, uv, uint16_t, 2, 2, true)
+};
+
+/***********************************************************
+ *  IsValidVertexLayout()
+ *
+ *  Check that every shader input is read by exactly one
+ *  attribute, and that no two attributes read the same bytes
+ *  or read past the end of the vertex.
+ ***********************************************************/
+template <size_t Count>
+constexpr bool IsValidVertexLayout(const VERTEX_ATTRIBUTE (&attributes)[Count], size_t stride)
+{
+	for (GLuint location = 0; location < VERTEX_SHADER_INPUT_COUNT; location++)
+	{
+		int uses = 0;
+		for (size_t i = 0; i < Count; i++)
+		{
+			uses += (attributes[i].location == location) ? 1 : 0;
+		}
+		if (uses != 1)
+		{
+			return(false);
+		}
+	}
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		if (attributes[i].offset + attributes[i].bytes > stride)
+		{
+			return(false);
+		}
+		for (size_t j = i + 1; j < Count; j++)
+		{
+			if ((attributes[i].offset < attributes[j].offset + attributes[j].bytes) &&
+				(attributes[j].offset < attributes[i].offset + attributes[i].bytes))
+			{
+				return(false);
+			}
+		}
+	}
+
+	return(true);
+}
+
+static_assert(IsValidVertexLayout(VERTEX_FLOAT32_ATTRIBUTES, sizeof(VERTEX_FLOAT32)), "the FLOAT32 layout does not match the vertex shader inputs");
+static_assert(IsValidVertexLayout(VERTEX_COMPACT_ATTRIBUTES, sizeof(VERTEX_COMPACT)), "the compact layout does not match the vertex shader inputs");
+
+// get the size in bytes of one vertex in a vertex layout
+GLsizei GetVertexLayoutStride(VERTEX_LAYOUT layout);
+
+// declare the attribute formats of a vertex layout on the bound VAO
+void SetupVertexFormat(VERTEX_LAYOUT layout);
+
+// get the GLSL declarations of the vertex shader inputs, which
+// the vertex shader includes as vertexInputs.glsl
+std::string GetVertexShaderInputDeclarations();
+
+// check the active inputs of a linked program against the vertex
+// shader inputs, printing the differences
+bool ValidateVertexShaderInputs(GLuint program);
@@ -15,6 +15,8 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <algorithm>
+
 // declaration of the global variables and defines
 namespace
 {
@@ -33,13 +35,57 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
+	// smoothed time between the current frame and the last frame,
+	// steadier to show than the measured time but not used to move
+	// anything
 	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
+	// measured time between the current frame and the last frame
+	float gFrameTime = 0.0f;
+
+	// the camera movement is updated at a fixed rate, so how far
+	// it moves does not depend on the frame rate - the frame time
+	// not yet used up by an update is kept for the next frame
+	const float g_UpdateStep = 1.0f / 120.0f;
+	float gUpdateTime = 0.0f;
+	// most updates in one frame, so a slow frame does not fall
+	// further behind by running more of them
+	const int g_MaximumUpdateSteps = 12;
+	// camera position before the last update, which the drawn
+	// position is blended from
+	glm::vec3 gPreviousPosition(0.0f);
+
+	// the following variable is true when something changed since
+	// the last frame was drawn, it starts true for the first frame
+	bool gRedrawRequested = true;
+	// the following variable is true when every frame is drawn
+	// whether or not anything changed
+	bool bContinuousRendering = false;
+	// the following variable is true while no frames are drawn, so
+	// the frame time starts over when drawing resumes
+	bool bIdle = false;
+	// longest time in seconds to sleep while waiting for events
+	const double g_IdleWaitSeconds = 0.25;
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false; // Starts the camera view in perspective view by default
+
+	// the following variable is true when the curved shapes are
+	// drawn as ray cast impostors instead of triangle meshes
+	bool bImpostorRendering = false;
+	// the following variable is true when the curved shapes are
+	// tessellated by their size on the screen
+	bool bTessellatedRendering = false;
+	// the following variable is true when the opaque objects are
+	// lit from a G-buffer instead of while they are drawn
+	bool bDeferredRendering = false;
+	// the following variable is true when the transparent objects
+	// are sorted back to front instead of accumulated in any order
+	bool bSortedTransparency = false;
+	// the following variable is true when the plane, box and
+	// cylinders are built by the vertex shader instead of read
+	// from their stored meshes
+	bool bProceduralShapes = true;
 }
 
 /***********************************************************
@@ -52,12 +98,15 @@ ViewManager::ViewManager(ShaderManager *pShaderManager)
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
+	gPreviousPosition = g_pCamera->Position;
 }
 
 /***********************************************************
@@ -100,6 +149,9 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	// Sets current window as main GLFW window
 	glfwMakeContextCurrent(window);
+	// wait for the display on every swap unless asked otherwise,
+	// rather than leaving it to the driver default
+	m_framePacer.SetSwapMode(SWAP_MODE_VSYNC);
 	// Locks mouse to center of screen
 	//glfwSetWindowUserPointer(window, this);
 
@@ -113,6 +165,11 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is to capture mouse scroll wheel actions
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
 
+	// these callbacks wake the render loop when a key changes or
+	// the window must be drawn again
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+	glfwSetWindowRefreshCallback(window, &ViewManager::Window_Refresh_Callback);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -150,6 +207,7 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
 
 	// move the 3D camera according to the calculated offsets
 	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+	gRedrawRequested = true;
 }
 
 /* Mouse_Scroll_Wheel_Callback()
@@ -167,6 +225,31 @@ void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double xOffset
 {
 	// uses camera class to process the scroll wheel input 
 	g_pCamera->ProcessMouseScroll(yOffset);
+	gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key is pressed, repeated or released.  The keys are read
+ *  by ProcessKeyboardEvents(), so a frame is only asked for.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the window are damaged, such as after it
+ *  is uncovered or restored.
+ ***********************************************************/
+void ViewManager::Window_Refresh_Callback(GLFWwindow* window)
+{
+	gRedrawRequested = true;
 }
 
 /***********************************************************
@@ -189,61 +272,229 @@ void ViewManager::ProcessKeyboardEvents()
 		return;
 	}
 
+	/* Code to change between perspective and orthographic view*/
+	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+	{
+		// change to a perspective view
+		bOrthographicProjection = false;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+	{
+		// change to a multi-view orthographic projection
+		bOrthographicProjection = true;
+
+		// change the camera settings to show a front orthographic view
+		g_pCamera->Position = glm::vec3(0.0f, 4.0f, 10.0f);
+		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+		// jump to the new position instead of blending into it
+		gPreviousPosition = g_pCamera->Position;
+	}
+
+	/* Code to change between triangle meshes, ray cast impostors and tessellation*/
+	if (glfwGetKey(m_pWindow, GLFW_KEY_I) == GLFW_PRESS)
+	{
+		// draw the curved shapes as impostors
+		bImpostorRendering = true;
+		bTessellatedRendering = false;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_T) == GLFW_PRESS)
+	{
+		// draw the curved shapes tessellated
+		bImpostorRendering = false;
+		bTessellatedRendering = true;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_M) == GLFW_PRESS)
+	{
+		// draw the curved shapes as triangle meshes
+		bImpostorRendering = false;
+		bTessellatedRendering = false;
+	}
+
+	/* Code to change between forward and deferred lighting */
+	if (glfwGetKey(m_pWindow, GLFW_KEY_G) == GLFW_PRESS)
+	{
+		// light the opaque objects from the G-buffer
+		bDeferredRendering = true;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_F) == GLFW_PRESS)
+	{
+		// light the objects while they are drawn
+		bDeferredRendering = false;
+	}
+
+	/* Code to change between sorted and weighted blended transparency */
+	if (glfwGetKey(m_pWindow, GLFW_KEY_B) == GLFW_PRESS)
+	{
+		// blend the transparent objects from back to front
+		bSortedTransparency = true;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_N) == GLFW_PRESS)
+	{
+		// accumulate the transparent objects with no sorting
+		bSortedTransparency = false;
+	}
+
+	/* Code to change between procedural and stored shapes */
+	if (glfwGetKey(m_pWindow, GLFW_KEY_V) == GLFW_PRESS)
+	{
+		// build the plane, box and cylinders in the vertex shader
+		bProceduralShapes = true;
+	}
+
+	if (glfwGetKey(m_pWindow, GLFW_KEY_C) == GLFW_PRESS)
+	{
+		// draw the plane, box and cylinders from their stored meshes
+		bProceduralShapes = false;
+	}
+
+}
+
+/***********************************************************
+ *  UpdateCameraMovement()
+ *
+ *  This method is used for moving the camera by one fixed
+ *  update step for each of the movement keys held down.
+ ***********************************************************/
+void ViewManager::UpdateCameraMovement(float step)
+{
 	// The below code is added so that the user can navigate the 3D scene both horizontally and vertically
 	// process camera zooming in and out
 	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
 	{
 		// Zooms in when W key is pressed
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(FORWARD, step);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
 	{
 		// Zooms out when S key is pressed
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(BACKWARD, step);
 	}
 
 	// process camera panning left and right
 	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
 	{
 		// Pans camera left when A key is pressed
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(LEFT, step);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
 	{
 		// Pans camera right when D key is pressed
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(RIGHT, step);
 	}
 
 	// process camera upward and downward movement
 	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
 	{
 		// Moves camera upward when Q key is pressed
-		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+		g_pCamera->ProcessKeyboard(UP, step);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
 	{
 		// Moves camera downward when E key is pressed
-		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+		g_pCamera->ProcessKeyboard(DOWN, step);
 	}
+}
 
-	/* Code to change between perspective and orthographic view*/
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
+/***********************************************************
+ *  IsCameraMoving()
+ *
+ *  This method is used for getting whether one of the keys
+ *  that move the camera is held down, which moves it a
+ *  little further every frame without sending new events.
+ ***********************************************************/
+bool ViewManager::IsCameraMoving() const
+{
+	const int movementKeys[] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E };
+	for (int i = 0; i < 6; i++)
 	{
-		// change to a perspective view
-		bOrthographicProjection = false;
+		if (glfwGetKey(m_pWindow, movementKeys[i]) == GLFW_PRESS)
+		{
+			return(true);
+		}
 	}
 
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+	return(false);
+}
+
+/***********************************************************
+ *  SetContinuousRendering()
+ *
+ *  This method is used for choosing whether every frame is
+ *  drawn, or only the frames after something changed.
+ ***********************************************************/
+void ViewManager::SetContinuousRendering(bool bEnabled)
+{
+	bContinuousRendering = bEnabled;
+}
+
+/***********************************************************
+ *  SetSwapMode()
+ *
+ *  This method is used for setting whether the buffer swap
+ *  waits for the display, which needs the window to exist.
+ ***********************************************************/
+void ViewManager::SetSwapMode(SWAP_MODE mode)
+{
+	m_framePacer.SetSwapMode(mode);
+}
+
+/***********************************************************
+ *  SetTargetFrameRate()
+ *
+ *  This method is used for setting the frame rate that the
+ *  drawn frames are held to.
+ ***********************************************************/
+void ViewManager::SetTargetFrameRate(double framesPerSecond)
+{
+	m_framePacer.SetTargetFrameRate(framesPerSecond);
+}
+
+/***********************************************************
+ *  WaitForRedraw()
+ *
+ *  This method is used for handling the window events before
+ *  a frame.  When nothing asks for a frame the thread sleeps
+ *  until an event arrives or the wait times out, so an idle
+ *  scene uses almost no processor time.  A frame is drawn
+ *  after input, while the camera keys are held, or when the
+ *  window must be drawn again.  Nothing in the scene moves
+ *  by itself, so an idle frame would be the same as the last.
+ ***********************************************************/
+bool ViewManager::WaitForRedraw()
+{
+	bool bBusy = bContinuousRendering || gRedrawRequested || IsCameraMoving();
+	if (bBusy)
 	{
-		// change to a multi-view orthographic projection
-		bOrthographicProjection = true;
+		glfwPollEvents();
+	}
+	else
+	{
+		glfwWaitEventsTimeout(g_IdleWaitSeconds);
+	}
 
-		// change the camera settings to show a front orthographic view
-		g_pCamera->Position = glm::vec3(0.0f, 4.0f, 10.0f);
-		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+	bool bRequested = gRedrawRequested;
+	gRedrawRequested = false;
+	bool bRedraw = bBusy || bRequested || IsCameraMoving();
+	if (bRedraw == false)
+	{
+		bIdle = true;
+		return(false);
+	}
+
+	// the time spent waiting does not move the camera
+	if (bIdle)
+	{
+		m_framePacer.Restart();
+		bIdle = false;
 	}
 
+	return(true);
 }
 
 /***********************************************************
@@ -258,17 +509,45 @@ void ViewManager::PrepareSceneView()
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	// per-frame timing, waiting first when the frame rate is
+	// limited and the frame is early
+	gDeltaTime = m_framePacer.BeginFrame(gFrameTime);
 
 	// process any keyboard events that may be waiting in the 
 	// event queue
 	ProcessKeyboardEvents();
 
+	// run the fixed updates that the frame time has used up - the
+	// measured time is used, since the smoothed time lags behind a
+	// change of frame rate and would move the camera by the wrong
+	// total distance
+	gUpdateTime += gFrameTime;
+	int updateSteps = 0;
+	while ((gUpdateTime >= g_UpdateStep) && (updateSteps < g_MaximumUpdateSteps))
+	{
+		gPreviousPosition = g_pCamera->Position;
+		UpdateCameraMovement(g_UpdateStep);
+		gUpdateTime -= g_UpdateStep;
+		updateSteps++;
+	}
+	// drop the time of the updates that were not run
+	gUpdateTime = std::min(gUpdateTime, g_UpdateStep);
+	// once the movement keys are let go the camera stops, so it is
+	// drawn where it stopped - the render loop may go idle after this
+	// frame and would otherwise leave the view short of that point
+	if (IsCameraMoving() == false)
+	{
+		gPreviousPosition = g_pCamera->Position;
+	}
+
+	// the frame falls between two updates, so the camera is drawn
+	// blended from the position before the last update by the part
+	// of the next update that has already passed
+	float blend = gUpdateTime / g_UpdateStep;
+	glm::vec3 position = glm::mix(gPreviousPosition, g_pCamera->Position, blend);
+
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	view = glm::lookAt(position, position + g_pCamera->Front, g_pCamera->Up);
 
 	// define the current projection matrix
 	projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
@@ -302,6 +581,10 @@ void ViewManager::PrepareSceneView()
 		}
 	}
 
+	// keep the matrices for the culling done by the scene
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
@@ -310,6 +593,75 @@ void ViewManager::PrepareSceneView()
 		// set the view matrix into the shader for proper rendering
 		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		m_pShaderManager->setVec3Value("viewPosition", position);
 	}
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *  GetViewportHeight()
+ *
+ *  This method is used for getting the height in pixels of
+ *  the display window that the scene is rendered into.
+ ***********************************************************/
+int ViewManager::GetViewportHeight() const
+{
+	return(WINDOW_HEIGHT);
+}
+
+/***********************************************************
+ *  IsImpostorRendering()
+ *
+ *  This method is used for getting whether the curved shapes
+ *  are drawn as impostors, switched with the I and M keys.
+ ***********************************************************/
+bool ViewManager::IsImpostorRendering() const
+{
+	return(bImpostorRendering);
+}
+
+/***********************************************************
+ *  IsTessellatedRendering()
+ *
+ *  This method is used for getting whether the curved shapes
+ *  are tessellated, switched with the T and M keys.
+ ***********************************************************/
+bool ViewManager::IsTessellatedRendering() const
+{
+	return(bTessellatedRendering);
+}
+
+/***********************************************************
+ *  IsDeferredRendering()
+ *
+ *  This method is used for getting whether the opaque
+ *  objects are lit from the G-buffer, switched with the G
+ *  and F keys.
+ ***********************************************************/
+bool ViewManager::IsDeferredRendering() const
+{
+	return(bDeferredRendering);
+}
+
+/***********************************************************
+ *  IsSortedTransparency()
+ *
+ *  This method is used for getting whether the transparent
+ *  objects are sorted back to front, switched with the B
+ *  and N keys.
+ ***********************************************************/
+bool ViewManager::IsSortedTransparency() const
+{
+	return(bSortedTransparency);
+}
+
+/***********************************************************
+ *  IsProceduralShapes()
+ *
+ *  This method is used for getting whether the plane, box
+ *  and cylinders are built by the vertex shader, switched
+ *  with the V and C keys.
+ ***********************************************************/
+bool ViewManager::IsProceduralShapes() const
+{
+	return(bProceduralShapes);
+}
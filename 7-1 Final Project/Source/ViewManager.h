@@ -11,6 +11,7 @@
 
 #include "ShaderManager.h"
 #include "camera.h"
+#include "FramePacer.h"
 
 // GLFW library
 #include "GLFW/glfw3.h" 
@@ -30,14 +31,30 @@ public:
 	// mouse scroll wheel callback to interact with 3D scenes 
 	static void Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double xOffset, double yoffset);
 
+	// key callback that wakes the render loop for a new frame
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+	// window refresh callback for when the contents of the window
+	// are damaged and must be drawn again
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// view and projection matrices of the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// frame limiter and smoothed frame timing
+	FramePacer m_framePacer;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// move the camera by one fixed update for the held down keys
+	void UpdateCameraMovement(float step);
+	// get whether a key that moves the camera is held down
+	bool IsCameraMoving() const;
 
 public:
 	// create the initial OpenGL display window
@@ -45,4 +62,35 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// draw every frame when true, such as for benchmarks, or only
+	// when something changed when false
+	void SetContinuousRendering(bool bEnabled);
+	// handle the waiting window events, sleeping until one arrives
+	// when nothing needs to be drawn, and get whether a frame
+	// should be drawn
+	bool WaitForRedraw();
+
+	// set how the buffer swap waits for the display
+	void SetSwapMode(SWAP_MODE mode);
+	// set the frames per second to hold, zero for no limit
+	void SetTargetFrameRate(double framesPerSecond);
+
+	// get the view and projection matrices of the current frame
+	glm::mat4 GetViewMatrix() const { return(m_viewMatrix); }
+	glm::mat4 GetProjectionMatrix() const { return(m_projectionMatrix); }
+
+	// get the height of the display window in pixels
+	int GetViewportHeight() const;
+
+	// get whether the curved shapes are drawn as impostors
+	bool IsImpostorRendering() const;
+	// get whether the curved shapes are tessellated
+	bool IsTessellatedRendering() const;
+	// get whether the opaque objects are lit from the G-buffer
+	bool IsDeferredRendering() const;
+	// get whether the transparent objects are sorted back to front
+	bool IsSortedTransparency() const;
+	// get whether the plane, box and cylinders are procedural
+	bool IsProceduralShapes() const;
 };
\ No newline at end of file
@@ -0,0 +1,369 @@
+///////////////////////////////////////////////////////////////////////////////
+// weightedtransparency.cpp
+// ============
+// blend the transparent objects without sorting them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "WeightedTransparency.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const char* g_TransparencyVertexShader = "./Shaders/transparencyVertexShader.glsl";
+	const char* g_TransparencyFragmentShader = "./Shaders/transparencyFragmentShader.glsl";
+
+	// binding points declared by the composite shader, shared
+	// with the G-buffer, which is no longer read by then
+	const GLuint g_AccumulationTextureUnit = 9;
+	const GLuint g_RevealageTextureUnit = 10;
+
+	// accumulation and revealage
+	const GLsizei g_ColorTargetCount = 2;
+}
+
+/***********************************************************
+ *  WeightedTransparency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+WeightedTransparency::WeightedTransparency()
+{
+	m_pShaderManager = NULL;
+	m_framebuffer = 0;
+	m_accumulationTexture = 0;
+	m_revealageTexture = 0;
+	m_depthTexture = 0;
+	m_vao = 0;
+	m_width = 0;
+	m_height = 0;
+	m_bBlendEnabled = GL_FALSE;
+	m_bDepthMask = GL_TRUE;
+	for (int i = 0; i < 4; i++)
+	{
+		m_blendFunctions[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~WeightedTransparency()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+WeightedTransparency::~WeightedTransparency()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for loading the composite shader
+ *  program.  The targets are created by the first pass,
+ *  when the size of the viewport is known.  The current
+ *  program is not changed.
+ ***********************************************************/
+bool WeightedTransparency::Create()
+{
+	Destroy();
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	m_pShaderManager = new ShaderManager();
+	GLuint programID = m_pShaderManager->LoadShaders(g_TransparencyVertexShader, g_TransparencyFragmentShader);
+
+	GLint linkStatus = GL_FALSE;
+	if (programID != 0)
+	{
+		glGetProgramiv(programID, GL_LINK_STATUS, &linkStatus);
+	}
+	glUseProgram((GLuint)currentProgram);
+	if (linkStatus != GL_TRUE)
+	{
+		std::cout << "ERROR: Could not load the transparency shaders " << g_TransparencyVertexShader << " and " << g_TransparencyFragmentShader << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	glGenVertexArrays(1, &m_vao);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the targets and the
+ *  composite program.
+ ***********************************************************/
+void WeightedTransparency::Destroy()
+{
+	DestroyTargets();
+
+	if (m_vao != 0)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+	m_vao = 0;
+
+	if (NULL != m_pShaderManager)
+	{
+		if (m_pShaderManager->m_programID != 0)
+		{
+			glDeleteProgram(m_pShaderManager->m_programID);
+		}
+		delete m_pShaderManager;
+		m_pShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  BeginAccumulation()
+ *
+ *  This method is used for binding the targets for the
+ *  transparent objects.  The depth of the opaque objects is
+ *  copied from the screen so they still hide the layers
+ *  behind them, but the layers do not write depth, so none
+ *  of them hides another.  The accumulation target adds up
+ *  and the revealage target multiplies by what each layer
+ *  lets through.
+ ***********************************************************/
+bool WeightedTransparency::BeginAccumulation()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return(false);
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		return(false);
+	}
+	if ((viewport[2] != m_width) || (viewport[3] != m_height) || (m_framebuffer == 0))
+	{
+		if (CreateTargets(viewport[2], viewport[3]) == false)
+		{
+			// the layers are blended in the order they are drawn
+			Destroy();
+			return(false);
+		}
+	}
+
+	// the copy fails when the depth formats do not match
+	while (glGetError() != GL_NO_ERROR)
+	{
+	}
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	if (glGetError() != GL_NO_ERROR)
+	{
+		std::cout << "ERROR: The depth of the screen could not be copied, the transparent objects are blended in the order they are drawn" << std::endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		Destroy();
+		return(false);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	const GLenum drawBuffers[g_ColorTargetCount] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(g_ColorTargetCount, drawBuffers);
+
+	const GLfloat clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const GLfloat clearRevealage[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+	glClearBufferfv(GL_COLOR, 1, clearRevealage);
+
+	m_bBlendEnabled = glIsEnabled(GL_BLEND);
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &m_bDepthMask);
+	glGetIntegerv(GL_BLEND_SRC_RGB, &m_blendFunctions[0]);
+	glGetIntegerv(GL_BLEND_DST_RGB, &m_blendFunctions[1]);
+	glGetIntegerv(GL_BLEND_SRC_ALPHA, &m_blendFunctions[2]);
+	glGetIntegerv(GL_BLEND_DST_ALPHA, &m_blendFunctions[3]);
+
+	glEnable(GL_BLEND);
+	glBlendFunci(0, GL_ONE, GL_ONE);
+	glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+	glDepthMask(GL_FALSE);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndAccumulation()
+ *
+ *  This method is used for going back to the screen
+ *  framebuffer and the blending of the scene.
+ ***********************************************************/
+void WeightedTransparency::EndAccumulation()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glBlendFuncSeparate(
+		(GLenum)m_blendFunctions[0],
+		(GLenum)m_blendFunctions[1],
+		(GLenum)m_blendFunctions[2],
+		(GLenum)m_blendFunctions[3]);
+	if (m_bBlendEnabled == GL_FALSE)
+	{
+		glDisable(GL_BLEND);
+	}
+	glDepthMask(m_bDepthMask);
+}
+
+/***********************************************************
+ *  Composite()
+ *
+ *  This method is used for drawing one triangle over the
+ *  screen with the composite program.  The average color
+ *  of the layers is blended over the scene by one minus
+ *  the revealage, and the depth of the scene is kept.
+ ***********************************************************/
+void WeightedTransparency::Composite()
+{
+	if ((NULL == m_pShaderManager) || (m_framebuffer == 0))
+	{
+		return;
+	}
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+
+	glActiveTexture(GL_TEXTURE0 + g_AccumulationTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_accumulationTexture);
+	glActiveTexture(GL_TEXTURE0 + g_RevealageTextureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_revealageTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	m_pShaderManager->use();
+
+	GLboolean bBlendEnabled = glIsEnabled(GL_BLEND);
+	GLboolean bDepthMask = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &bDepthMask);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_ALWAYS);
+
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+
+	glDepthFunc(GL_LESS);
+	glDepthMask(bDepthMask);
+	glBlendFuncSeparate(
+		(GLenum)m_blendFunctions[0],
+		(GLenum)m_blendFunctions[1],
+		(GLenum)m_blendFunctions[2],
+		(GLenum)m_blendFunctions[3]);
+	if (bBlendEnabled == GL_FALSE)
+	{
+		glDisable(GL_BLEND);
+	}
+
+	glUseProgram((GLuint)currentProgram);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the accumulation and
+ *  revealage targets and the framebuffer that writes them.
+ *  The depth target takes the format of the depth of the
+ *  screen, because the depth can only be copied between
+ *  buffers of the same format.
+ ***********************************************************/
+bool WeightedTransparency::CreateTargets(int width, int height)
+{
+	DestroyTargets();
+
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+
+	GLint depthBits = 0;
+	GLint stencilBits = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+	glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_STENCIL, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+
+	GLenum depthFormat = GL_DEPTH24_STENCIL8;
+	GLenum depthAttachment = GL_DEPTH_STENCIL_ATTACHMENT;
+	if (stencilBits == 0)
+	{
+		depthFormat = (depthBits == 16) ? GL_DEPTH_COMPONENT16 : ((depthBits == 32) ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24);
+		depthAttachment = GL_DEPTH_ATTACHMENT;
+	}
+	else if (depthBits == 32)
+	{
+		depthFormat = GL_DEPTH32F_STENCIL8;
+	}
+
+	// the premultiplied colors need the range of half floats, the
+	// revealage only the share of one
+	const GLenum formats[g_ColorTargetCount] = { GL_RGBA16F, GL_R8 };
+	GLuint* targets[g_ColorTargetCount] = { &m_accumulationTexture, &m_revealageTexture };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	for (int i = 0; i < g_ColorTargetCount; i++)
+	{
+		glGenTextures(1, targets[i]);
+		glBindTexture(GL_TEXTURE_2D, *targets[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, formats[i], width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, *targets[i], 0);
+	}
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, depthFormat, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, depthAttachment, GL_TEXTURE_2D, m_depthTexture, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR: The transparency framebuffer is not complete" << std::endl;
+		DestroyTargets();
+		return(false);
+	}
+
+	m_width = width;
+	m_height = height;
+
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the targets.
+ ***********************************************************/
+void WeightedTransparency::DestroyTargets()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+	}
+	GLuint* targets[] = { &m_accumulationTexture, &m_revealageTexture, &m_depthTexture };
+	for (int i = 0; i < 3; i++)
+	{
+		if (*targets[i] != 0)
+		{
+			glDeleteTextures(1, targets[i]);
+		}
+		*targets[i] = 0;
+	}
+	m_framebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+}
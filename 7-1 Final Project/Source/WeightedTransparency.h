@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+// weightedtransparency.h
+// ============
+// blend the transparent objects without sorting them
+//
+//	The transparent objects are drawn in any order into two targets,
+//	over the depth of the opaque objects.  The accumulation target sums
+//	the premultiplied colors of the layers of a pixel, weighted so that
+//	the nearer layers count for more, and the revealage target keeps the
+//	product of the share of the scene that each layer lets through.  A
+//	composite step over the whole screen then divides the sum by its
+//	weights and blends the average over the scene by the revealage.
+//	Both sums are independent of the order, so the transparent objects
+//	can be batched and instanced like the opaque ones.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+/***********************************************************
+ *  WeightedTransparency
+ *
+ *  This class holds the accumulation and revealage targets
+ *  and the composite program.  The scene shaders write the
+ *  targets while their bTransparencyPass uniform is set.
+ ***********************************************************/
+class WeightedTransparency
+{
+public:
+	// constructor
+	WeightedTransparency();
+	// destructor
+	~WeightedTransparency();
+
+	// load the composite shaders
+	bool Create();
+	// free the targets and the program
+	void Destroy();
+
+	// copy the depth of the screen into the targets, sized to the
+	// current viewport, then bind and clear them, returning false
+	// when they could not be used
+	bool BeginAccumulation();
+	// go back to the screen framebuffer
+	void EndAccumulation();
+	// blend the accumulated layers over the screen, the current
+	// program is not changed
+	void Composite();
+
+private:
+	ShaderManager* m_pShaderManager;
+	GLuint m_framebuffer;
+	GLuint m_accumulationTexture;
+	GLuint m_revealageTexture;
+	GLuint m_depthTexture;
+	// the full screen triangle is built from the vertex index
+	GLuint m_vao;
+	int m_width;
+	int m_height;
+	// the blending and depth writes of the scene, changed while
+	// the layers are accumulated
+	GLboolean m_bBlendEnabled;
+	GLboolean m_bDepthMask;
+	GLint m_blendFunctions[4];
+
+	// create the targets with the passed in size, with a depth
+	// format that the depth of the screen can be copied into
+	bool CreateTargets(int width, int height);
+	// free the targets
+	void DestroyTargets();
+
+	// the targets cannot be shared between two objects
+	WeightedTransparency(const WeightedTransparency&);
+	WeightedTransparency& operator=(const WeightedTransparency&);
+};